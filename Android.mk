@@ -56,14 +56,25 @@ LOCAL_SRC_FILES := \
     ap_interface_impl.cpp \
     client_interface_binder.cpp \
     client_interface_impl.cpp \
+    link_quality_sample.cpp \
+    link_quality_sampler.cpp \
     logging_utils.cpp \
+    scanning/channel_history.cpp \
     scanning/channel_settings.cpp \
     scanning/hidden_network.cpp \
+    scanning/hidden_ssid_scheduler.cpp \
+    scanning/match_set_ranker.cpp \
     scanning/offload_scan_callback_interface_impl.cpp \
+    scanning/partial_scan_settings.cpp \
     scanning/pno_network.cpp \
+    scanning/pno_scan_planner.cpp \
     scanning/pno_settings.cpp \
     scanning/radio_chain_info.cpp \
+    scanning/scan_latency_stats.cpp \
     scanning/scan_result.cpp \
+    scanning/scan_result_buffer.cpp \
+    scanning/scan_result_delta.cpp \
+    scanning/scan_result_filter.cpp \
     scanning/offload/scan_stats.cpp \
     scanning/single_scan_settings.cpp \
     scanning/scan_utils.cpp \
@@ -72,7 +83,9 @@ LOCAL_SRC_FILES := \
     scanning/offload/offload_callback.cpp \
     scanning/offload/offload_service_utils.cpp \
     scanning/offload/offload_scan_utils.cpp \
-    server.cpp
+    server.cpp \
+    time_utils.cpp \
+    wiphy_info_cache.cpp
 LOCAL_SHARED_LIBRARIES := \
     android.hardware.wifi.offload@1.0 \
     libbase \
@@ -99,7 +112,8 @@ LOCAL_SRC_FILES := \
     net/netlink_manager.cpp \
     net/netlink_utils.cpp \
     net/nl80211_attribute.cpp \
-    net/nl80211_packet.cpp
+    net/nl80211_packet.cpp \
+    net/nl80211_policy.cpp
 LOCAL_SHARED_LIBRARIES := \
     libbase
 include $(BUILD_STATIC_LIBRARY)
@@ -129,6 +143,7 @@ LOCAL_C_INCLUDES := $(wificond_includes)
 LOCAL_CPPFLAGS := $(wificond_cpp_flags)
 LOCAL_SRC_FILES := \
     ipc_constants.cpp \
+    link_quality_sample.cpp \
     aidl/android/net/wifi/IApInterface.aidl \
     aidl/android/net/wifi/IApInterfaceEventCallback.aidl \
     aidl/android/net/wifi/IClientInterface.aidl \
@@ -139,10 +154,14 @@ LOCAL_SRC_FILES := \
     aidl/android/net/wifi/IWifiScannerImpl.aidl \
     scanning/channel_settings.cpp \
     scanning/hidden_network.cpp \
+    scanning/partial_scan_settings.cpp \
     scanning/pno_network.cpp \
     scanning/pno_settings.cpp \
     scanning/radio_chain_info.cpp \
     scanning/scan_result.cpp \
+    scanning/scan_result_buffer.cpp \
+    scanning/scan_result_delta.cpp \
+    scanning/scan_result_filter.cpp \
     scanning/single_scan_settings.cpp
 LOCAL_SHARED_LIBRARIES := \
     libbinder
@@ -176,9 +195,14 @@ LOCAL_CPPFLAGS := $(wificond_cpp_flags)
 LOCAL_C_INCLUDES := $(wificond_includes)
 LOCAL_SRC_FILES := \
     tests/ap_interface_impl_unittest.cpp \
+    tests/bounded_lru_map_unittest.cpp \
+    tests/channel_history_unittest.cpp \
     tests/client_interface_impl_unittest.cpp \
+    tests/hidden_ssid_scheduler_unittest.cpp \
+    tests/link_quality_sampler_unittest.cpp \
     tests/looper_backed_event_loop_unittest.cpp \
     tests/main.cpp \
+    tests/match_set_ranker_unittest.cpp \
     tests/mock_client_interface_impl.cpp \
     tests/mock_netlink_manager.cpp \
     tests/mock_netlink_utils.cpp \
@@ -193,17 +217,21 @@ LOCAL_SRC_FILES := \
     tests/netlink_utils_unittest.cpp \
     tests/nl80211_attribute_unittest.cpp \
     tests/nl80211_packet_unittest.cpp \
+    tests/nl80211_policy_unittest.cpp \
     tests/offload_callback_test.cpp \
     tests/offload_hal_test_constants.cpp \
     tests/offload_scan_manager_test.cpp \
     tests/offload_scan_utils_test.cpp \
     tests/offload_test_utils.cpp \
+    tests/pno_scan_planner_unittest.cpp \
+    tests/scan_latency_stats_unittest.cpp \
     tests/scanner_unittest.cpp \
     tests/scan_result_unittest.cpp \
     tests/scan_settings_unittest.cpp \
     tests/scan_stats_unittest.cpp \
     tests/scan_utils_unittest.cpp \
-    tests/server_unittest.cpp
+    tests/server_unittest.cpp \
+    tests/wiphy_info_cache_unittest.cpp
 LOCAL_STATIC_LIBRARIES := \
     libgmock \
     libgtest \
@@ -251,3 +279,22 @@ LOCAL_STATIC_LIBRARIES := \
     libwificond_ipc \
     libwificond_test_utils
 include $(BUILD_NATIVE_TEST)
+
+###
+### wificond benchmarks.
+###
+include $(CLEAR_VARS)
+LOCAL_MODULE := wificond_benchmark
+LOCAL_CPPFLAGS := $(wificond_cpp_flags)
+LOCAL_C_INCLUDES := $(wificond_includes)
+LOCAL_SRC_FILES := \
+    tests/benchmarks/nl80211_parse_benchmark.cpp \
+    tests/benchmarks/scan_result_transport_benchmark.cpp
+LOCAL_STATIC_LIBRARIES := \
+    libwificond_ipc \
+    libwificond_nl
+LOCAL_SHARED_LIBRARIES := \
+    libbase \
+    libbinder \
+    libutils
+include $(BUILD_NATIVE_BENCHMARK)
@@ -46,8 +46,7 @@ ApInterfaceImpl::ApInterfaceImpl(const string& interface_name,
       netlink_utils_(netlink_utils),
       if_tool_(if_tool),
       hostapd_manager_(hostapd_manager),
-      binder_(new ApInterfaceBinder(this)),
-      number_of_associated_stations_(0) {
+      binder_(new ApInterfaceBinder(this)) {
   // This log keeps compiler happy.
   LOG(DEBUG) << "Created ap interface " << interface_name_
              << " with index " << interface_index_;
@@ -79,7 +78,18 @@ void ApInterfaceImpl::Dump(std::stringstream* ss) const {
       << interface_index_ << " and name: " << interface_name_
       << "-------" << endl;
   *ss << "Number of associated stations: "
-      <<  number_of_associated_stations_ << endl;
+      <<  stations_.size() << endl;
+  for (const auto& station : stations_) {
+    const StationInfo& info = station.second;
+    *ss << "Station " << LoggingUtils::GetMacString(station.first)
+        << " rssi: " << static_cast<int>(info.current_rssi)
+        << " average rssi: " << static_cast<int>(info.average_rssi)
+        << " tx bitrate: " << info.station_tx_bitrate
+        << " rx bitrate: " << info.station_rx_bitrate
+        << " tx bytes: " << info.station_tx_bytes
+        << " rx bytes: " << info.station_rx_bytes
+        << " inactive time(ms): " << info.inactive_time_ms << endl;
+  }
   *ss << "------- Dump End -------" << endl;
 }
 
@@ -119,23 +129,42 @@ void ApInterfaceImpl::OnStationEvent(StationEvent event,
     LOG(INFO) << "New station "
               << LoggingUtils::GetMacString(mac_address)
               << " associated with hotspot";
-    number_of_associated_stations_++;
+    // Keep the info of a station that reassociates without a DEL_STATION.
+    if (!stations_.emplace(mac_address, StationInfo()).second) {
+      LOG(WARNING) << "Received NEW_STATION event for a known station";
+      return;
+    }
   } else if (event == DEL_STATION) {
     LOG(INFO) << "Station "
               << LoggingUtils::GetMacString(mac_address)
               << " disassociated from hotspot";
-    if (number_of_associated_stations_ <= 0) {
-      LOG(ERROR) << "Received DEL_STATION event when station counter is: "
-                 << number_of_associated_stations_;
+    if (stations_.erase(mac_address) == 0) {
+      LOG(ERROR) << "Received DEL_STATION event for an unknown station";
       return;
-    } else {
-      number_of_associated_stations_--;
     }
   }
 
   if (event == NEW_STATION || event == DEL_STATION) {
-    binder_->NotifyNumAssociatedStationsChanged(number_of_associated_stations_);
+    binder_->NotifyNumAssociatedStationsChanged(stations_.size());
+  }
+}
+
+bool ApInterfaceImpl::RefreshStationTable() {
+  StationTable stations;
+  if (!netlink_utils_->GetStationTable(interface_index_, &stations)) {
+    LOG(ERROR) << "Failed to get station table";
+    return false;
   }
+  // Membership follows NEW_STATION and DEL_STATION events only. The dump
+  // leaves out stations whose info is incomplete, and it races with those
+  // events, so it only refreshes the info of stations known already.
+  for (auto& station : stations_) {
+    const auto dumped = stations.find(station.first);
+    if (dumped != stations.end()) {
+      station.second = dumped->second;
+    }
+  }
+  return true;
 }
 
 
@@ -147,7 +176,7 @@ void ApInterfaceImpl::OnChannelSwitchEvent(uint32_t frequency,
 }
 
 int ApInterfaceImpl::GetNumberOfAssociatedStations() const {
-  return number_of_associated_stations_;
+  return stations_.size();
 }
 
 }  // namespace wificond
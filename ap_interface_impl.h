@@ -25,6 +25,7 @@
 #include <wifi_system/interface_tool.h>
 
 #include "wificond/net/netlink_manager.h"
+#include "wificond/net/netlink_utils.h"
 
 #include "android/net/wifi/IApInterface.h"
 
@@ -32,7 +33,6 @@ namespace android {
 namespace wificond {
 
 class ApInterfaceBinder;
-class NetlinkUtils;
 
 // Holds the guts of how we control network interfaces capable of exposing an AP
 // via hostapd.  Because remote processes may hold on to the corresponding
@@ -54,6 +54,15 @@ class ApInterfaceImpl {
   bool StopHostapd();
   std::string GetInterfaceName() { return interface_name_; }
   int GetNumberOfAssociatedStations() const;
+  // Dumps the info of all associated stations in a single request and
+  // updates the info of the stations in the station table with it.
+  // This neither adds nor removes stations.
+  // Returns true on success.
+  bool RefreshStationTable();
+  // Returns the associated stations keyed by MAC address.
+  // Station info is only filled in by RefreshStationTable(), which runs
+  // before each dump. Stations that associated since then have zeroed info.
+  const StationTable& GetStationTable() const { return stations_; }
   void Dump(std::stringstream* ss) const;
 
  private:
@@ -64,8 +73,9 @@ class ApInterfaceImpl {
   wifi_system::HostapdManager* const hostapd_manager_;
   const android::sp<ApInterfaceBinder> binder_;
 
-  // Number of associated stations.
-  int number_of_associated_stations_;
+  // Associated stations keyed by MAC address.
+  // This is updated incrementally from NEW_STATION and DEL_STATION events.
+  StationTable stations_;
 
   void OnStationEvent(StationEvent event,
                       const std::vector<uint8_t>& mac_address);
@@ -24,6 +24,7 @@
 
 using android::binder::Status;
 using android::net::wifi::IWifiScannerImpl;
+using com::android::server::wifi::wificond::LinkQualitySample;
 using std::vector;
 
 namespace android {
@@ -86,5 +87,29 @@ Status ClientInterfaceBinder::setMacAddress(const vector<uint8_t>& mac, bool* su
   return Status::ok();
 }
 
+Status ClientInterfaceBinder::startLinkQualitySampling(int32_t interval_ms,
+                                                       bool* out_success) {
+  *out_success = impl_ && interval_ms > 0 &&
+      impl_->StartLinkQualitySampling(interval_ms);
+  return Status::ok();
+}
+
+Status ClientInterfaceBinder::stopLinkQualitySampling() {
+  if (impl_ == nullptr) {
+    return Status::ok();
+  }
+  impl_->StopLinkQualitySampling();
+  return Status::ok();
+}
+
+Status ClientInterfaceBinder::getLinkQualityHistory(
+    vector<LinkQualitySample>* out_samples) {
+  if (impl_ == nullptr) {
+    return Status::ok();
+  }
+  *out_samples = impl_->GetLinkQualityHistory();
+  return Status::ok();
+}
+
 }  // namespace wificond
 }  // namespace android
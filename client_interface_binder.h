@@ -48,6 +48,12 @@ class ClientInterfaceBinder : public android::net::wifi::BnClientInterface {
       ::android::sp<::android::net::wifi::IWifiScannerImpl>* out_wifi_scanner_impl) override;
   ::android::binder::Status setMacAddress(
       const ::std::vector<uint8_t>& mac, bool* success) override;
+  ::android::binder::Status startLinkQualitySampling(
+      int32_t interval_ms, bool* out_success) override;
+  ::android::binder::Status stopLinkQualitySampling() override;
+  ::android::binder::Status getLinkQualityHistory(
+      std::vector<com::android::server::wifi::wificond::LinkQualitySample>*
+          out_samples) override;
  private:
   ClientInterfaceImpl* impl_;
 
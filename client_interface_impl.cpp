@@ -30,13 +30,17 @@
 #include "wificond/scanning/scan_result.h"
 #include "wificond/scanning/scan_utils.h"
 #include "wificond/scanning/scanner_impl.h"
+#include "wificond/time_utils.h"
+#include "wificond/wiphy_info_cache.h"
 
 using android::net::wifi::IClientInterface;
 using com::android::server::wifi::wificond::NativeScanResult;
 using android::sp;
 using android::wifi_system::InterfaceTool;
 
+using com::android::server::wifi::wificond::LinkQualitySample;
 using std::endl;
+using std::placeholders::_1;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -44,6 +48,14 @@ using std::vector;
 namespace android {
 namespace wificond {
 
+namespace {
+
+// Station info is polled by the framework every few seconds, with the signal
+// poll and packet counter queries issued back to back.
+constexpr uint64_t kStationInfoTtlMs = 1000;
+
+}  // namespace
+
 MlmeEventHandlerImpl::MlmeEventHandlerImpl(ClientInterfaceImpl* client_interface)
     : client_interface_(client_interface) {
 }
@@ -56,12 +68,14 @@ void MlmeEventHandlerImpl::OnConnect(unique_ptr<MlmeConnectEvent> event) {
     client_interface_->is_associated_ = true;
     client_interface_->RefreshAssociateFreq();
     client_interface_->bssid_ = event->GetBSSID();
+    client_interface_->OnAssociationChanged();
   } else {
     if (event->IsTimeout()) {
       LOG(INFO) << "Connect timeout";
     }
     client_interface_->is_associated_ = false;
     client_interface_->bssid_.clear();
+    client_interface_->OnAssociationChanged();
   }
 }
 
@@ -69,6 +83,7 @@ void MlmeEventHandlerImpl::OnRoam(unique_ptr<MlmeRoamEvent> event) {
   client_interface_->is_associated_ = true;
   client_interface_->RefreshAssociateFreq();
   client_interface_->bssid_ = event->GetBSSID();
+  client_interface_->OnAssociationChanged();
 }
 
 void MlmeEventHandlerImpl::OnAssociate(unique_ptr<MlmeAssociateEvent> event) {
@@ -76,23 +91,31 @@ void MlmeEventHandlerImpl::OnAssociate(unique_ptr<MlmeAssociateEvent> event) {
     client_interface_->is_associated_ = true;
     client_interface_->RefreshAssociateFreq();
     client_interface_->bssid_ = event->GetBSSID();
+    client_interface_->OnAssociationChanged();
   } else {
     if (event->IsTimeout()) {
       LOG(INFO) << "Associate timeout";
     }
     client_interface_->is_associated_ = false;
     client_interface_->bssid_.clear();
+    client_interface_->OnAssociationChanged();
   }
 }
 
 void MlmeEventHandlerImpl::OnDisconnect(unique_ptr<MlmeDisconnectEvent> event) {
+  client_interface_->scan_utils_->InvalidateScanResultCache(
+      client_interface_->interface_index_);
   client_interface_->is_associated_ = false;
   client_interface_->bssid_.clear();
+  client_interface_->OnAssociationChanged();
 }
 
 void MlmeEventHandlerImpl::OnDisassociate(unique_ptr<MlmeDisassociateEvent> event) {
+  client_interface_->scan_utils_->InvalidateScanResultCache(
+      client_interface_->interface_index_);
   client_interface_->is_associated_ = false;
   client_interface_->bssid_.clear();
+  client_interface_->OnAssociationChanged();
 }
 
 
@@ -103,7 +126,9 @@ ClientInterfaceImpl::ClientInterfaceImpl(
     const std::vector<uint8_t>& interface_mac_addr,
     InterfaceTool* if_tool,
     NetlinkUtils* netlink_utils,
-    ScanUtils* scan_utils)
+    ScanUtils* scan_utils,
+    WiphyInfoCache* wiphy_info_cache,
+    EventLoop* event_loop)
     : wiphy_index_(wiphy_index),
       interface_name_(interface_name),
       interface_index_(interface_index),
@@ -114,16 +139,21 @@ ClientInterfaceImpl::ClientInterfaceImpl(
       offload_service_utils_(new OffloadServiceUtils()),
       mlme_event_handler_(new MlmeEventHandlerImpl(this)),
       binder_(new ClientInterfaceBinder(this)),
-      is_associated_(false) {
+      is_associated_(false),
+      has_station_info_(false),
+      station_info_time_ms_(0),
+      link_quality_sampler_(
+          event_loop,
+          std::bind(&ClientInterfaceImpl::QueryStationInfo, this, _1)),
+      link_quality_sampling_interval_ms_(0) {
   netlink_utils_->SubscribeMlmeEvent(
       interface_index_,
       mlme_event_handler_.get());
-  if (!netlink_utils_->GetWiphyInfo(wiphy_index_,
-                               &band_info_,
-                               &scan_capabilities_,
-                               &wiphy_features_)) {
-    LOG(ERROR) << "Failed to get wiphy info from kernel";
-  }
+  // Logging is done by the cache.
+  wiphy_info_cache->GetWiphyInfo(wiphy_index_,
+                                 &band_info_,
+                                 &scan_capabilities_,
+                                 &wiphy_features_);
   LOG(INFO) << "create scanner for interface with index: "
             << (int)interface_index_;
   scanner_ = new ScannerImpl(interface_index_,
@@ -131,7 +161,8 @@ ClientInterfaceImpl::ClientInterfaceImpl(
                              wiphy_features_,
                              this,
                              scan_utils_,
-                             offload_service_utils_);
+                             offload_service_utils_,
+                             event_loop);
 }
 
 ClientInterfaceImpl::~ClientInterfaceImpl() {
@@ -171,14 +202,16 @@ void ClientInterfaceImpl::Dump(std::stringstream* ss) const {
       << wiphy_features_.supports_high_accuracy_oneshot_scan << endl;
   *ss << "Device supports random MAC for scheduled scan: "
       << wiphy_features_.supports_random_mac_sched_scan << endl;
+  link_quality_sampler_.Dump(ss);
+  if (scanner_ != nullptr) {
+    scanner_->Dump(ss);
+  }
   *ss << "------- Dump End -------" << endl;
 }
 
 bool ClientInterfaceImpl::GetPacketCounters(vector<int32_t>* out_packet_counters) {
   StationInfo station_info;
-  if (!netlink_utils_->GetStationInfo(interface_index_,
-                                      bssid_,
-                                      &station_info)) {
+  if (!GetStationInfo(&station_info)) {
     return false;
   }
   out_packet_counters->push_back(station_info.station_tx_packets);
@@ -194,9 +227,7 @@ bool ClientInterfaceImpl::SignalPoll(vector<int32_t>* out_signal_poll_results) {
   }
 
   StationInfo station_info;
-  if (!netlink_utils_->GetStationInfo(interface_index_,
-                                      bssid_,
-                                      &station_info)) {
+  if (!GetStationInfo(&station_info)) {
     return false;
   }
   out_signal_poll_results->push_back(
@@ -241,16 +272,74 @@ bool ClientInterfaceImpl::SetMacAddress(const ::std::vector<uint8_t>& mac) {
 bool ClientInterfaceImpl::RefreshAssociateFreq() {
   // wpa_supplicant fetches associate frequency using the latest scan result.
   // We should follow the same method here before we find a better solution.
-  std::vector<NativeScanResult> scan_results;
+  // The association changed the status of BSSs in the kernel without a scan
+  // result notification, so cached scan results can't be used.
+  scan_utils_->InvalidateScanResultCache(interface_index_);
+  // The frequency of the previous association is never reported for the
+  // new one, not even if the dump fails.
+  associate_freq_ = 0;
+  vector<NativeScanResult> scan_results;
   if (!scan_utils_->GetScanResult(interface_index_, &scan_results)) {
+    LOG(ERROR) << "Failed to get scan results for associate frequency";
     return false;
   }
-  for (auto& scan_result : scan_results) {
+  for (const auto& scan_result : scan_results) {
     if (scan_result.associated) {
       associate_freq_ = scan_result.frequency;
     }
   }
-  return false;
+  return true;
+}
+
+bool ClientInterfaceImpl::GetStationInfo(StationInfo* out_station_info) {
+  const uint64_t now_ms = TimeUtils::GetBoottimeMs();
+  if (has_station_info_ && now_ms - station_info_time_ms_ < kStationInfoTtlMs) {
+    *out_station_info = station_info_;
+    return true;
+  }
+  return QueryStationInfo(out_station_info);
+}
+
+bool ClientInterfaceImpl::QueryStationInfo(StationInfo* out_station_info) {
+  if (!netlink_utils_->GetStationInfo(interface_index_,
+                                      bssid_,
+                                      &station_info_)) {
+    has_station_info_ = false;
+    return false;
+  }
+  has_station_info_ = true;
+  station_info_time_ms_ = TimeUtils::GetBoottimeMs();
+  *out_station_info = station_info_;
+  return true;
+}
+
+void ClientInterfaceImpl::OnAssociationChanged() {
+  has_station_info_ = false;
+  // The link quality is only sampled while associated.
+  if (is_associated_ && link_quality_sampling_interval_ms_ != 0) {
+    link_quality_sampler_.Start(link_quality_sampling_interval_ms_);
+  } else {
+    link_quality_sampler_.Stop();
+  }
+}
+
+bool ClientInterfaceImpl::StartLinkQualitySampling(uint32_t interval_ms) {
+  if (interval_ms < LinkQualitySampler::kMinIntervalMs) {
+    LOG(ERROR) << "Invalid link quality sampling interval: " << interval_ms;
+    return false;
+  }
+  link_quality_sampling_interval_ms_ = interval_ms;
+  OnAssociationChanged();
+  return true;
+}
+
+void ClientInterfaceImpl::StopLinkQualitySampling() {
+  link_quality_sampling_interval_ms_ = 0;
+  link_quality_sampler_.Stop();
+}
+
+vector<LinkQualitySample> ClientInterfaceImpl::GetLinkQualityHistory() const {
+  return link_quality_sampler_.GetHistory();
 }
 
 bool ClientInterfaceImpl::IsAssociated() const {
@@ -24,6 +24,7 @@
 #include <wifi_system/interface_tool.h>
 
 #include "android/net/wifi/IClientInterface.h"
+#include "wificond/link_quality_sampler.h"
 #include "wificond/net/mlme_event_handler.h"
 #include "wificond/net/netlink_utils.h"
 #include "wificond/scanning/offload/offload_service_utils.h"
@@ -34,7 +35,9 @@ namespace wificond {
 
 class ClientInterfaceBinder;
 class ClientInterfaceImpl;
+class EventLoop;
 class ScanUtils;
+class WiphyInfoCache;
 
 class MlmeEventHandlerImpl : public MlmeEventHandler {
  public:
@@ -65,7 +68,9 @@ class ClientInterfaceImpl {
       const std::vector<uint8_t>& interface_mac_addr,
       android::wifi_system::InterfaceTool* if_tool,
       NetlinkUtils* netlink_utils,
-      ScanUtils* scan_utils);
+      ScanUtils* scan_utils,
+      WiphyInfoCache* wiphy_info_cache,
+      EventLoop* event_loop);
   virtual ~ClientInterfaceImpl();
 
   // Get a pointer to the binder representing this ClientInterfaceImpl.
@@ -78,10 +83,30 @@ class ClientInterfaceImpl {
   const android::sp<ScannerImpl> GetScanner() { return scanner_; };
   bool SetMacAddress(const ::std::vector<uint8_t>& mac);
   virtual bool IsAssociated() const;
+  // Starts sampling the link quality every |interval_ms| milliseconds while
+  // associated. Returns true on success.
+  bool StartLinkQualitySampling(uint32_t interval_ms);
+  void StopLinkQualitySampling();
+  // Returns the link quality samples taken so far, oldest first.
+  std::vector<com::android::server::wifi::wificond::LinkQualitySample>
+      GetLinkQualityHistory() const;
   void Dump(std::stringstream* ss) const;
 
  private:
+  // Updates |associate_freq_| from the scan results. It is 0 if the
+  // dump fails. Returns true on success.
   bool RefreshAssociateFreq();
+  // Gets the info of the station |bssid_|.
+  // Results are reused for kStationInfoTtlMs so that the periodic signal
+  // poll and packet counter queries share a single kernel query.
+  // Returns true on success.
+  bool GetStationInfo(StationInfo* out_station_info);
+  // Queries the info of the station |bssid_| from the kernel and caches it.
+  // Returns true on success.
+  bool QueryStationInfo(StationInfo* out_station_info);
+  // Drops cached station info and starts or stops link quality sampling.
+  // This is called whenever the association or |bssid_| changes.
+  void OnAssociationChanged();
 
   const uint32_t wiphy_index_;
   const std::string interface_name_;
@@ -99,6 +124,16 @@ class ClientInterfaceImpl {
   bool is_associated_;
   std::vector<uint8_t> bssid_;
   uint32_t associate_freq_;
+  // Cached station info of |bssid_|, which is valid if
+  // |has_station_info_| is true.
+  bool has_station_info_;
+  StationInfo station_info_;
+  // Time since boot in milliseconds when |station_info_| was queried.
+  uint64_t station_info_time_ms_;
+  LinkQualitySampler link_quality_sampler_;
+  // Requested link quality sampling interval in milliseconds, or 0 if
+  // sampling is disabled.
+  uint32_t link_quality_sampling_interval_ms_;
 
   // Capability information for this wiphy/interface.
   BandInfo band_info_;
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_LINK_QUALITY_SAMPLE_H_
+#define WIFICOND_LINK_QUALITY_SAMPLE_H_
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// This is the class to represent the link quality of a client interface
+// sampled at one point in time.
+class LinkQualitySample : public ::android::Parcelable {
+ public:
+  LinkQualitySample() = default;
+  LinkQualitySample(int64_t timestamp_ms_,
+                    int32_t rssi_,
+                    int32_t tx_bitrate_mbps_,
+                    int64_t tx_packets_,
+                    int64_t tx_failed_)
+      : timestamp_ms(timestamp_ms_),
+        rssi(rssi_),
+        tx_bitrate_mbps(tx_bitrate_mbps_),
+        tx_packets(tx_packets_),
+        tx_failed(tx_failed_) {}
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // Time since boot in milliseconds when this sample was taken.
+  int64_t timestamp_ms{0};
+  // Signal strength in dBm.
+  int32_t rssi{0};
+  // Transmission bit rate in Mbps.
+  int32_t tx_bitrate_mbps{0};
+  // Number of successfully transmitted packets.
+  int64_t tx_packets{0};
+  // Number of transmission failures.
+  int64_t tx_failed{0};
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_LINK_QUALITY_SAMPLE_H_
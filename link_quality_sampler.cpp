@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "wificond/link_quality_sampler.h"
+
+#include <android-base/logging.h>
+
+#include "wificond/event_loop.h"
+#include "wificond/time_utils.h"
+
+using com::android::server::wifi::wificond::LinkQualitySample;
+using std::endl;
+using std::shared_ptr;
+using std::vector;
+using std::weak_ptr;
+
+namespace android {
+namespace wificond {
+
+constexpr size_t LinkQualitySampler::kMaxNumSamples;
+constexpr uint32_t LinkQualitySampler::kMinIntervalMs;
+
+LinkQualitySampler::LinkQualitySampler(
+    EventLoop* event_loop,
+    const StationInfoGetter& station_info_getter)
+    : event_loop_(event_loop),
+      station_info_getter_(station_info_getter),
+      generation_(new uint64_t(0)) {
+  samples_.reserve(kMaxNumSamples);
+}
+
+bool LinkQualitySampler::Start(uint32_t interval_ms) {
+  if (interval_ms < kMinIntervalMs) {
+    LOG(ERROR) << "Link quality sampling interval is too short: "
+               << interval_ms << " ms";
+    return false;
+  }
+  Stop();
+  interval_ms_ = interval_ms;
+  ScheduleSample();
+  return true;
+}
+
+void LinkQualitySampler::Stop() {
+  interval_ms_ = 0;
+  // Invalidate the pending task.
+  (*generation_)++;
+}
+
+vector<LinkQualitySample> LinkQualitySampler::GetHistory() const {
+  vector<LinkQualitySample> history;
+  history.reserve(samples_.size());
+  history.insert(history.end(),
+                 samples_.begin() + next_sample_index_,
+                 samples_.end());
+  history.insert(history.end(),
+                 samples_.begin(),
+                 samples_.begin() + next_sample_index_);
+  return history;
+}
+
+void LinkQualitySampler::Dump(std::stringstream* ss) const {
+  *ss << "Link quality sampling interval(ms): " << interval_ms_ << endl;
+  *ss << "Number of link quality samples: " << samples_.size() << endl;
+}
+
+void LinkQualitySampler::ScheduleSample() {
+  weak_ptr<uint64_t> weak_generation = generation_;
+  const uint64_t generation = *generation_;
+  event_loop_->PostDelayedTask(
+      [this, weak_generation, generation]() {
+        shared_ptr<uint64_t> current_generation = weak_generation.lock();
+        if (current_generation == nullptr ||
+            *current_generation != generation) {
+          return;
+        }
+        Sample();
+        ScheduleSample();
+      },
+      interval_ms_);
+}
+
+void LinkQualitySampler::Sample() {
+  StationInfo station_info;
+  if (!station_info_getter_(&station_info)) {
+    return;
+  }
+  LinkQualitySample sample(
+      TimeUtils::GetBoottimeMs(),
+      station_info.current_rssi,
+      // Convert from 100kbit/s to Mbps.
+      station_info.station_tx_bitrate / 10,
+      station_info.station_tx_packets,
+      station_info.station_tx_failed);
+  if (samples_.size() < kMaxNumSamples) {
+    samples_.push_back(sample);
+    return;
+  }
+  samples_[next_sample_index_] = sample;
+  next_sample_index_ = (next_sample_index_ + 1) % kMaxNumSamples;
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_LINK_QUALITY_SAMPLER_H_
+#define WIFICOND_LINK_QUALITY_SAMPLER_H_
+
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/link_quality_sample.h"
+#include "wificond/net/netlink_utils.h"
+
+namespace android {
+namespace wificond {
+
+class EventLoop;
+
+// Periodically samples the link quality of a client interface and keeps the
+// most recent samples in a fixed-size ring buffer.
+// Sampling runs as delayed tasks on the event loop, which is also the only
+// thread accessing the samples.
+class LinkQualitySampler {
+ public:
+  // Gets the station info of the current connection.
+  // Returns false if there is no station info to sample.
+  typedef std::function<bool(StationInfo* out_station_info)>
+      StationInfoGetter;
+
+  // Maximum number of samples kept in the history.
+  static constexpr size_t kMaxNumSamples = 120;
+  // Sampling more often than this would keep the driver busy.
+  static constexpr uint32_t kMinIntervalMs = 100;
+
+  LinkQualitySampler(EventLoop* event_loop,
+                     const StationInfoGetter& station_info_getter);
+  ~LinkQualitySampler() = default;
+
+  // Starts taking a sample every |interval_ms| milliseconds.
+  // A running sampler is restarted with the new interval.
+  // Returns false if |interval_ms| is less than kMinIntervalMs.
+  bool Start(uint32_t interval_ms);
+  // Stops sampling. Samples taken so far are kept.
+  void Stop();
+  bool IsRunning() const { return interval_ms_ != 0; }
+  // Returns the samples in the history, oldest first.
+  std::vector<com::android::server::wifi::wificond::LinkQualitySample>
+      GetHistory() const;
+  void Dump(std::stringstream* ss) const;
+
+ private:
+  void ScheduleSample();
+  void Sample();
+
+  EventLoop* const event_loop_;
+  const StationInfoGetter station_info_getter_;
+  // Sampling interval in milliseconds, or 0 if sampling is stopped.
+  uint32_t interval_ms_{0};
+  // Ring buffer of samples. Once it is full, |next_sample_index_| points to
+  // the oldest sample, which is overwritten next.
+  std::vector<com::android::server::wifi::wificond::LinkQualitySample>
+      samples_;
+  size_t next_sample_index_{0};
+  // Pending tasks can't be removed from the event loop. Instead they hold a
+  // weak reference to this generation and only run if it still exists and
+  // hasn't changed since they were posted.
+  std::shared_ptr<uint64_t> generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(LinkQualitySampler);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_LINK_QUALITY_SAMPLER_H_
@@ -147,7 +147,8 @@ int main(int argc, char** argv) {
       unique_ptr<SupplicantManager>(new SupplicantManager()),
       unique_ptr<HostapdManager>(new HostapdManager()),
       &netlink_utils,
-      &scan_utils));
+      &scan_utils,
+      event_dispatcher.get()));
   RegisterServiceOrCrash(server.get());
 
   event_dispatcher->Poll();
@@ -16,6 +16,7 @@
 
 #include "net/netlink_manager.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -43,15 +44,27 @@ namespace wificond {
 
 namespace {
 
+// Default size of the kernel receive queue of each netlink socket.
+// Bursts of multicast scan and MLME events overflow a small queue, which
+// kernel reports as ENOBUFS.
+constexpr int kDefaultSocketReceiveBufferSize = 256 * 1024;
 // netlink.h suggests NLMSG_GOODSIZE to be at most 8192 bytes.
-constexpr int kReceiveBufferSize = 8 * 1024;
+// Larger datagrams make the buffers grow on demand.
+constexpr size_t kDefaultDatagramBufferSize = 8 * 1024;
 constexpr uint32_t kBroadcastSequenceNumber = 0;
 constexpr int kMaximumNetlinkMessageWaitMilliSeconds = 300;
-uint8_t ReceiveBuffer[kReceiveBufferSize];
+// How long a dump which timed out may keep holding the asynchronous socket.
+// Its end can be lost, e.g. to a receive queue overrun, and the queued
+// dumps must not wait for it forever.
+constexpr int kMaximumTimedOutDumpWaitMilliSeconds = 1000;
+// Maximum number of datagrams drained from a socket per wakeup.
+// A NL80211_CMD_GET_SCAN dump on a crowded channel spans many datagrams, so
+// reading them in batches saves a syscall and a poll round trip per datagram.
+constexpr int kMaxDatagramsPerWakeup = 16;
 
 void AppendPacket(vector<unique_ptr<const NL80211Packet>>* vec,
-                  unique_ptr<const NL80211Packet> packet) {
-  vec->push_back(std::move(packet));
+                  const NL80211PacketView& packet) {
+  vec->push_back(packet.ToPacket());
 }
 
 // Convert enum nl80211_chan_width to enum ChannelBandwidth
@@ -77,14 +90,38 @@ ChannelBandwidth getBandwidthType(uint32_t bandwidth) {
 }  // namespace
 
 NetlinkManager::NetlinkManager(EventLoop* event_loop)
+    : NetlinkManager(event_loop,
+                     kDefaultSocketReceiveBufferSize,
+                     kDefaultDatagramBufferSize) {
+}
+
+NetlinkManager::NetlinkManager(EventLoop* event_loop,
+                               int socket_receive_buffer_size,
+                               size_t datagram_buffer_size)
     : started_(false),
       event_loop_(event_loop),
-      sequence_number_(0) {
+      dump_sequence_number_(kBroadcastSequenceNumber),
+      dump_timed_out_(false),
+      sequence_number_(0),
+      socket_receive_buffer_size_(socket_receive_buffer_size),
+      sync_receive_buffers_(kMaxDatagramsPerWakeup),
+      async_receive_buffers_(kMaxDatagramsPerWakeup) {
+  GrowReceiveBuffers(&sync_receive_buffers_, datagram_buffer_size);
+  GrowReceiveBuffers(&async_receive_buffers_, datagram_buffer_size);
 }
 
 NetlinkManager::~NetlinkManager() {
 }
 
+NetlinkManager::PendingDump::PendingDump(
+    const NL80211Packet& packet_,
+    std::function<void(const NL80211PacketView&)> handler_,
+    OnDumpCompleteHandler complete_handler_)
+    : packet(new NL80211Packet(packet_.GetConstData())),
+      handler(handler_),
+      complete_handler(complete_handler_) {
+}
+
 uint32_t NetlinkManager::GetSequenceNumber() {
   if (++sequence_number_ == kBroadcastSequenceNumber) {
     ++sequence_number_;
@@ -93,38 +130,127 @@ uint32_t NetlinkManager::GetSequenceNumber() {
 }
 
 void NetlinkManager::ReceivePacketAndRunHandler(int fd) {
-  ssize_t len = read(fd, ReceiveBuffer, kReceiveBufferSize);
-  if (len == -1) {
-    LOG(ERROR) << "Failed to read packet from buffer";
+  vector<vector<uint8_t>>& buffers =
+      (fd == sync_netlink_fd_.get()) ? sync_receive_buffers_
+                                     : async_receive_buffers_;
+  // Make sure at least the first pending datagram fits in our buffers.
+  size_t pending_size = PeekDatagramSize(fd);
+  if (pending_size > buffers[0].size()) {
+    GrowReceiveBuffers(&buffers, pending_size);
+  }
+
+  struct iovec iov[kMaxDatagramsPerWakeup];
+  struct mmsghdr msgs[kMaxDatagramsPerWakeup];
+  memset(msgs, 0, sizeof(msgs));
+  for (int i = 0; i < kMaxDatagramsPerWakeup; i++) {
+    iov[i].iov_base = buffers[i].data();
+    iov[i].iov_len = buffers[i].size();
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  // We only get here when |fd| is readable, so MSG_WAITFORONE never blocks:
+  // it returns as soon as the socket has no more queued datagrams.
+  // With MSG_TRUNC |msg_len| is the real datagram length, even if it didn't
+  // fit in the buffer.
+  int num_datagrams = TEMP_FAILURE_RETRY(
+      recvmmsg(fd, msgs, kMaxDatagramsPerWakeup,
+               MSG_WAITFORONE | MSG_TRUNC, nullptr));
+  if (num_datagrams == -1) {
+    if (errno == ENOBUFS) {
+      OnReceiveQueueOverrun(fd);
+      return;
+    }
+    LOG(ERROR) << "Failed to read packet from buffer: " << strerror(errno);
     return;
   }
-  if (len == 0) {
+  receive_stats_.num_wakeups++;
+  receive_stats_.num_datagrams += num_datagrams;
+  receive_stats_.last_datagrams_per_wakeup = num_datagrams;
+  if (static_cast<uint32_t>(num_datagrams) >
+      receive_stats_.max_datagrams_per_wakeup) {
+    receive_stats_.max_datagrams_per_wakeup = num_datagrams;
+  }
+  // Dispatch only after the whole batch is read, so handlers that send new
+  // requests do not interleave with datagrams we have already drained.
+  size_t largest_truncated_size = 0;
+  for (int i = 0; i < num_datagrams; i++) {
+    if (msgs[i].msg_len == 0) {
+      continue;
+    }
+    if (msgs[i].msg_len > iov[i].iov_len ||
+        (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+      // Only datagrams behind the first one in a batch can get here, since
+      // we peeked at the size of the first one. Kernel sizes dump replies
+      // to fit our buffers, so this is rare, but the tail of the datagram is
+      // gone. Fail the request it belongs to rather than dispatching the
+      // rest of its reply with a hole in it.
+      receive_stats_.num_truncated_datagrams++;
+      LOG(ERROR) << "Received truncated netlink datagram of size "
+                 << msgs[i].msg_len;
+      largest_truncated_size =
+          std::max(largest_truncated_size, static_cast<size_t>(msgs[i].msg_len));
+      FailTruncatedRequest(static_cast<const uint8_t*>(iov[i].iov_base),
+                           iov[i].iov_len);
+      continue;
+    }
+    HandleDatagram(static_cast<const uint8_t*>(iov[i].iov_base),
+                   msgs[i].msg_len);
+  }
+  if (largest_truncated_size > buffers[0].size()) {
+    GrowReceiveBuffers(&buffers, largest_truncated_size);
+  }
+}
+
+void NetlinkManager::FailTruncatedRequest(const uint8_t* datagram,
+                                          size_t len) {
+  if (len < sizeof(nlmsghdr)) {
     return;
   }
+  const uint32_t sequence_number =
+      reinterpret_cast<const nlmsghdr*>(datagram)->nlmsg_seq;
+  if (sequence_number == kBroadcastSequenceNumber) {
+    LOG(ERROR) << "Lost a netlink event which didn't fit in the buffer";
+    return;
+  }
+  if (sequence_number == dump_sequence_number_) {
+    FinishDump(DUMP_ERROR, EMSGSIZE);
+    return;
+  }
+  // Later replies to this request find no handler and are ignored.
+  if (message_handlers_.erase(sequence_number) > 0) {
+    failed_sequences_.insert(sequence_number);
+  }
+}
+
+void NetlinkManager::HandleDatagram(const uint8_t* datagram, size_t len) {
   // There might be multiple message in one datagram payload.
-  uint8_t* ptr = ReceiveBuffer;
-  while (ptr < ReceiveBuffer + len) {
+  const uint8_t* ptr = datagram;
+  while (ptr < datagram + len) {
     // peek at the header.
-    if (ptr + sizeof(nlmsghdr) > ReceiveBuffer + len) {
+    if (ptr + sizeof(nlmsghdr) > datagram + len) {
       LOG(ERROR) << "payload is broken.";
       return;
     }
     const nlmsghdr* nl_header = reinterpret_cast<const nlmsghdr*>(ptr);
-    unique_ptr<NL80211Packet> packet(
-        new NL80211Packet(vector<uint8_t>(ptr, ptr + nl_header->nlmsg_len)));
+    // Parse the message in place. It is only copied if a handler needs to
+    // keep it beyond this call.
+    NL80211PacketView packet(
+        ptr,
+        std::min(static_cast<size_t>(nl_header->nlmsg_len),
+                 static_cast<size_t>(datagram + len - ptr)));
     ptr += nl_header->nlmsg_len;
-    if (!packet->IsValid()) {
+    if (!packet.IsValid()) {
       LOG(ERROR) << "Receive invalid packet";
       return;
     }
     // Some document says message from kernel should have port id equal 0.
     // However in practice this is not always true so we don't check that.
 
-    uint32_t sequence_number = packet->GetMessageSequence();
+    uint32_t sequence_number = packet.GetMessageSequence();
 
     // Handle multicasts.
     if (sequence_number == kBroadcastSequenceNumber) {
-      BroadcastHandler(std::move(packet));
+      BroadcastHandler(packet.ToPacket());
       continue;
     }
 
@@ -137,14 +263,23 @@ void NetlinkManager::ReceivePacketAndRunHandler(int fd) {
     // A multipart message is terminated by NLMSG_DONE.
     // In this case we don't need to run the handler.
     // NLMSG_NOOP means no operation, message must be discarded.
-    uint32_t message_type =  packet->GetMessageType();
+    uint32_t message_type =  packet.GetMessageType();
     if (message_type == NLMSG_DONE || message_type == NLMSG_NOOP) {
-      message_handlers_.erase(itr);
+      if (sequence_number == dump_sequence_number_) {
+        FinishDump(DUMP_DONE, 0);
+      } else {
+        message_handlers_.erase(itr);
+      }
       return;
     }
     if (message_type == NLMSG_OVERRUN) {
       LOG(ERROR) << "Get message overrun notification";
-      message_handlers_.erase(itr);
+      receive_stats_.num_overruns++;
+      if (sequence_number == dump_sequence_number_) {
+        FinishDump(DUMP_ERROR, ENOBUFS);
+      } else {
+        message_handlers_.erase(itr);
+      }
       return;
     }
 
@@ -156,9 +291,17 @@ void NetlinkManager::ReceivePacketAndRunHandler(int fd) {
     // We should still run handler in this case, leaving it for the caller
     // to decide what to do with the packet.
 
-    bool is_multi = packet->IsMulti();
+    // For an asynchronous dump the error ends the dump, and it is reported
+    // to the completion handler instead.
+    if (message_type == NLMSG_ERROR &&
+        sequence_number == dump_sequence_number_) {
+      FinishDump(DUMP_ERROR, packet.GetErrorCode());
+      continue;
+    }
+
+    bool is_multi = packet.IsMulti();
     // Run the handler.
-    itr->second(std::move(packet));
+    itr->second(packet);
     // Remove handler after processing.
     if (!is_multi) {
       message_handlers_.erase(itr);
@@ -166,6 +309,40 @@ void NetlinkManager::ReceivePacketAndRunHandler(int fd) {
   }
 }
 
+size_t NetlinkManager::PeekDatagramSize(int fd) {
+  ssize_t len = TEMP_FAILURE_RETRY(
+      recv(fd, nullptr, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT));
+  if (len == -1) {
+    if (errno == ENOBUFS) {
+      OnReceiveQueueOverrun(fd);
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      LOG(ERROR) << "Failed to peek netlink datagram: " << strerror(errno);
+    }
+    return 0;
+  }
+  return static_cast<size_t>(len);
+}
+
+void NetlinkManager::OnReceiveQueueOverrun(int fd) {
+  receive_stats_.num_overruns++;
+  LOG(ERROR) << "Netlink socket receive queue overrun, messages are lost";
+  // The lost messages might include the end of the dump in flight, which
+  // would then never finish.
+  if (fd == async_netlink_fd_.get() &&
+      dump_sequence_number_ != kBroadcastSequenceNumber) {
+    FinishDump(DUMP_ERROR, ENOBUFS);
+  }
+}
+
+void NetlinkManager::GrowReceiveBuffers(vector<vector<uint8_t>>* buffers,
+                                        size_t size) {
+  for (auto& buffer : *buffers) {
+    buffer.resize(size);
+  }
+  receive_stats_.datagram_buffer_size =
+      std::max(receive_stats_.datagram_buffer_size, size);
+}
+
 void NetlinkManager::OnNewFamily(unique_ptr<const NL80211Packet> packet) {
   if (packet->GetMessageType() != GENL_ID_CTRL) {
     LOG(ERROR) << "Wrong message type for new family message";
@@ -269,33 +446,173 @@ bool NetlinkManager::RegisterHandlerAndSendMessage(
   if (!SendMessageInternal(packet, async_netlink_fd_.get())) {
     return false;
   }
-  message_handlers_[packet.GetMessageSequence()] = handler;
+  message_handlers_[packet.GetMessageSequence()] =
+      [handler](const NL80211PacketView& response) {
+        handler(response.ToPacket());
+      };
+  return true;
+}
+
+bool NetlinkManager::RegisterHandlerAndSendDumpMessage(
+    const NL80211Packet& packet,
+    std::function<void(const NL80211PacketView&)> handler,
+    OnDumpCompleteHandler complete_handler) {
+  if (!packet.IsDump()) {
+    LOG(ERROR) << "Only dump request can be sent with this interface !";
+    return false;
+  }
+  if (dump_sequence_number_ != kBroadcastSequenceNumber) {
+    pending_dumps_.emplace_back(packet, handler, complete_handler);
+    return true;
+  }
+  return SendDumpInternal(PendingDump(packet, handler, complete_handler));
+}
+
+void NetlinkManager::SendPendingDumps() {
+  while (dump_sequence_number_ == kBroadcastSequenceNumber &&
+         !pending_dumps_.empty()) {
+    PendingDump dump = std::move(pending_dumps_.front());
+    pending_dumps_.pop_front();
+    if (!SendDumpInternal(dump)) {
+      dump.complete_handler(DUMP_ERROR, EIO);
+    }
+  }
+}
+
+bool NetlinkManager::SendDumpInternal(const PendingDump& dump) {
+  if (!SendMessageInternal(*dump.packet, async_netlink_fd_.get())) {
+    return false;
+  }
+  uint32_t sequence_number = dump.packet->GetMessageSequence();
+  message_handlers_[sequence_number] = dump.handler;
+  dump_sequence_number_ = sequence_number;
+  dump_complete_handler_ = dump.complete_handler;
+  event_loop_->PostDelayedTask(
+      std::bind(&NetlinkManager::OnDumpTimeout, this, sequence_number),
+      kMaximumNetlinkMessageWaitMilliSeconds);
   return true;
 }
 
+void NetlinkManager::OnDumpTimeout(uint32_t sequence_number) {
+  // This dump has already finished.
+  if (sequence_number != dump_sequence_number_) {
+    return;
+  }
+  if (dump_timed_out_) {
+    // The end of this dump never came. Give up on it, so that the pending
+    // dumps are sent.
+    LOG(ERROR) << "Timed out netlink dump never ended, releasing socket";
+    FinishDump(DUMP_TIMEOUT, 0);
+    return;
+  }
+  LOG(ERROR) << "Timeout waiting for netlink dump reply messages";
+  // Kernel keeps running the dump on the socket, and would refuse to start
+  // the next one. Late replies are dropped, and the pending dumps are only
+  // sent once kernel ends this one, or once the second deadline passes.
+  dump_timed_out_ = true;
+  message_handlers_[sequence_number] = [](const NL80211PacketView&) {};
+  event_loop_->PostDelayedTask(
+      std::bind(&NetlinkManager::OnDumpTimeout, this, sequence_number),
+      kMaximumTimedOutDumpWaitMilliSeconds);
+  OnDumpCompleteHandler complete_handler = std::move(dump_complete_handler_);
+  dump_complete_handler_ = nullptr;
+  complete_handler(DUMP_TIMEOUT, 0);
+}
+
+void NetlinkManager::FinishDump(DumpResult result, int error_code) {
+  message_handlers_.erase(dump_sequence_number_);
+  dump_sequence_number_ = kBroadcastSequenceNumber;
+  dump_timed_out_ = false;
+  // Move the handler out first, since it might start a new dump.
+  // There is none if the dump already timed out.
+  OnDumpCompleteHandler complete_handler = std::move(dump_complete_handler_);
+  dump_complete_handler_ = nullptr;
+  if (complete_handler) {
+    complete_handler(result, error_code);
+  }
+  SendPendingDumps();
+}
+
 bool NetlinkManager::SendMessageAndGetResponses(
     const NL80211Packet& packet,
     vector<unique_ptr<const NL80211Packet>>* response) {
   if (!SendMessageInternal(packet, sync_netlink_fd_.get())) {
     return false;
   }
-  // Polling netlink socket, waiting for GetFamily reply.
-  struct pollfd netlink_output;
-  memset(&netlink_output, 0, sizeof(netlink_output));
-  netlink_output.fd = sync_netlink_fd_.get();
-  netlink_output.events = POLLIN;
-
   uint32_t sequence = packet.GetMessageSequence();
-
-  int time_remaining = kMaximumNetlinkMessageWaitMilliSeconds;
   // Multipart messages may come with seperated datagrams, ending with a
   // NLMSG_DONE message.
   // ReceivePacketAndRunHandler() will remove the handler after receiving a
   // NLMSG_DONE message.
   message_handlers_[sequence] = std::bind(AppendPacket, response, _1);
+  return WaitForResponses({sequence});
+}
+
+bool NetlinkManager::SendMessageAndHandleResponses(
+    const NL80211Packet& packet,
+    std::function<void(const NL80211PacketView&)> handler) {
+  if (!SendMessageInternal(packet, sync_netlink_fd_.get())) {
+    return false;
+  }
+  uint32_t sequence = packet.GetMessageSequence();
+  message_handlers_[sequence] = handler;
+  return WaitForResponses({sequence});
+}
 
-  while (time_remaining > 0 &&
-      message_handlers_.find(sequence) != message_handlers_.end()) {
+bool NetlinkManager::SendMessagesAndGetResponses(
+    const vector<NL80211Packet>& packets,
+    vector<vector<unique_ptr<const NL80211Packet>>>* responses) {
+  size_t num_dumps = 0;
+  for (const auto& packet : packets) {
+    if (packet.IsDump()) {
+      num_dumps++;
+    }
+  }
+  if (num_dumps > 1) {
+    LOG(ERROR) << "Do not send more than one dump request at once !";
+    return false;
+  }
+  if (!SendMessagesInternal(packets, sync_netlink_fd_.get())) {
+    return false;
+  }
+  // |responses| is not resized after this point, so the handlers can keep
+  // pointers to its elements.
+  responses->clear();
+  responses->resize(packets.size());
+  vector<uint32_t> sequences;
+  for (size_t i = 0; i < packets.size(); i++) {
+    uint32_t sequence = packets[i].GetMessageSequence();
+    message_handlers_[sequence] =
+        std::bind(AppendPacket, &(*responses)[i], _1);
+    sequences.push_back(sequence);
+  }
+  return WaitForResponses(sequences);
+}
+
+bool NetlinkManager::WaitForResponses(const vector<uint32_t>& sequences) {
+  // Polling netlink socket, waiting for replies.
+  struct pollfd netlink_output;
+  memset(&netlink_output, 0, sizeof(netlink_output));
+  netlink_output.fd = sync_netlink_fd_.get();
+  netlink_output.events = POLLIN;
+
+  auto is_pending = [this, &sequences]() {
+    for (uint32_t sequence : sequences) {
+      if (message_handlers_.find(sequence) != message_handlers_.end()) {
+        return true;
+      }
+    }
+    return false;
+  };
+  auto remove_handlers = [this, &sequences]() {
+    for (uint32_t sequence : sequences) {
+      message_handlers_.erase(sequence);
+      failed_sequences_.erase(sequence);
+    }
+  };
+
+  int time_remaining = kMaximumNetlinkMessageWaitMilliSeconds;
+  while (time_remaining > 0 && is_pending()) {
     nsecs_t interval = systemTime(SYSTEM_TIME_MONOTONIC);
     int poll_return = poll(&netlink_output,
                            1,
@@ -303,11 +620,11 @@ bool NetlinkManager::SendMessageAndGetResponses(
 
     if (poll_return == 0) {
       LOG(ERROR) << "Failed to poll netlink fd: time out ";
-      message_handlers_.erase(sequence);
+      remove_handlers();
       return false;
     } else if (poll_return == -1) {
       LOG(ERROR) << "Failed to poll netlink fd: " << strerror(errno);
-      message_handlers_.erase(sequence);
+      remove_handlers();
       return false;
     }
     ReceivePacketAndRunHandler(sync_netlink_fd_.get());
@@ -316,7 +633,17 @@ bool NetlinkManager::SendMessageAndGetResponses(
   }
   if (time_remaining <= 0) {
     LOG(ERROR) << "Timeout waiting for netlink reply messages";
-    message_handlers_.erase(sequence);
+    remove_handlers();
+    return false;
+  }
+  bool lost_reply = false;
+  for (uint32_t sequence : sequences) {
+    if (failed_sequences_.erase(sequence) > 0) {
+      lost_reply = true;
+    }
+  }
+  if (lost_reply) {
+    LOG(ERROR) << "Part of the netlink reply didn't fit in the buffer";
     return false;
   }
   return true;
@@ -396,6 +723,26 @@ bool NetlinkManager::SendMessageInternal(const NL80211Packet& packet, int fd) {
   return true;
 }
 
+bool NetlinkManager::SendMessagesInternal(const vector<NL80211Packet>& packets,
+                                          int fd) {
+  vector<struct iovec> iov(packets.size());
+  for (size_t i = 0; i < packets.size(); i++) {
+    const vector<uint8_t>& data = packets[i].GetConstData();
+    iov[i].iov_base = const_cast<uint8_t*>(data.data());
+    iov[i].iov_len = data.size();
+  }
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov.data();
+  msg.msg_iovlen = iov.size();
+  ssize_t bytes_sent = TEMP_FAILURE_RETRY(sendmsg(fd, &msg, 0));
+  if (bytes_sent == -1) {
+    LOG(ERROR) << "Failed to send netlink messages: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
 bool NetlinkManager::SetupSocket(unique_fd* netlink_fd) {
   struct sockaddr_nl nladdr;
 
@@ -408,13 +755,13 @@ bool NetlinkManager::SetupSocket(unique_fd* netlink_fd) {
     LOG(ERROR) << "Failed to create netlink socket: " << strerror(errno);
     return false;
   }
-  // Set maximum receive buffer size.
-  // Datagram which is larger than this size will be discarded.
+  // Set the size of the kernel receive queue.
+  // Messages which arrive when the queue is full will be dropped.
   if (setsockopt(netlink_fd->get(),
                  SOL_SOCKET,
                  SO_RCVBUFFORCE,
-                 &kReceiveBufferSize,
-                 sizeof(kReceiveBufferSize)) < 0) {
+                 &socket_receive_buffer_size_,
+                 sizeof(socket_receive_buffer_size_)) < 0) {
     LOG(ERROR) << "Failed to set uevent socket SO_RCVBUFFORCE option: " << strerror(errno);
     return false;
   }
@@ -440,6 +787,10 @@ bool NetlinkManager::WatchSocket(unique_fd* netlink_fd) {
   return true;
 }
 
+const NetlinkReceiveStats& NetlinkManager::GetReceiveStats() const {
+  return receive_stats_;
+}
+
 uint16_t NetlinkManager::GetFamilyId() {
   return message_types_[NL80211_GENL_NAME].family_id;
 }
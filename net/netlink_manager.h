@@ -17,9 +17,12 @@
 #ifndef WIFICOND_NET_NETLINK_MANAGER_H_
 #define WIFICOND_NET_NETLINK_MANAGER_H_
 
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
+#include <set>
+#include <vector>
 
 #include <android-base/macros.h>
 #include <android-base/unique_fd.h>
@@ -31,6 +34,7 @@ namespace wificond {
 
 class MlmeEventHandler;
 class NL80211Packet;
+class NL80211PacketView;
 
 // Encapsulates all the different things we know about a specific message
 // type like its name, and its id.
@@ -115,9 +119,61 @@ typedef std::function<void(
     StationEvent event,
     const std::vector<uint8_t>& mac_address)> OnStationEventHandler;
 
+// Enum used for identifying how an asynchronous dump request ended.
+// This is used by function |OnDumpCompleteHandler|.
+enum DumpResult {
+    DUMP_DONE,
+    DUMP_ERROR,
+    DUMP_TIMEOUT
+};
+
+// This describes a type of function handling the end of an asynchronous
+// dump request.
+// |result| specifies how the dump ended.
+// |error_code| is the error code from kernel when |result| is DUMP_ERROR.
+typedef std::function<void(
+    DumpResult result,
+    int error_code)> OnDumpCompleteHandler;
+
+// Counters describing how the netlink sockets have been drained so far.
+struct NetlinkReceiveStats {
+  NetlinkReceiveStats()
+      : num_wakeups(0),
+        num_datagrams(0),
+        last_datagrams_per_wakeup(0),
+        max_datagrams_per_wakeup(0),
+        num_truncated_datagrams(0),
+        num_overruns(0),
+        datagram_buffer_size(0) {}
+  // Number of times ReceivePacketAndRunHandler() read from a socket.
+  uint64_t num_wakeups;
+  // Total number of datagrams received over all wakeups.
+  uint64_t num_datagrams;
+  // Number of datagrams handled by the most recent wakeup.
+  uint32_t last_datagrams_per_wakeup;
+  // Largest number of datagrams handled by a single wakeup.
+  uint32_t max_datagrams_per_wakeup;
+  // Number of datagrams which did not fit in the userspace receive buffer.
+  // The requests they belong to fail instead of getting partial replies.
+  uint64_t num_truncated_datagrams;
+  // Number of times kernel dropped messages because the socket receive
+  // queue was full (ENOBUFS or NLMSG_OVERRUN).
+  uint64_t num_overruns;
+  // Largest size in bytes of the userspace datagram buffers.
+  size_t datagram_buffer_size;
+};
+
 class NetlinkManager {
  public:
   explicit NetlinkManager(EventLoop* event_loop);
+  // |socket_receive_buffer_size| is the size in bytes of the kernel receive
+  // queue of each netlink socket.
+  // |datagram_buffer_size| is the initial size in bytes of each userspace
+  // datagram buffer. These buffers grow on demand when a larger datagram
+  // arrives.
+  NetlinkManager(EventLoop* event_loop,
+                 int socket_receive_buffer_size,
+                 size_t datagram_buffer_size);
   virtual ~NetlinkManager();
   // Initialize netlink manager.
   // This includes setting up socket and requesting nl80211 family id from kernel.
@@ -137,12 +193,48 @@ class NetlinkManager {
   // Returns true on success.
   virtual bool RegisterHandlerAndSendMessage(const NL80211Packet& packet,
       std::function<void(std::unique_ptr<const NL80211Packet>)> handler);
+  // Send dump request |packet| to kernel without blocking.
+  // |handler| will be run for every message of the dump reply. The message
+  // is a view of the receive buffer, and it is only valid during that run.
+  // |complete_handler| will be run once when kernel signals the end of the
+  // dump, when kernel replies an error, or when no complete reply arrives in
+  // time.
+  // Only one asynchronous dump is in flight at a time, because kernel refuses
+  // to start a new dump on a socket in the middle of another one. Requests
+  // made meanwhile are queued and sent in order. A dump which timed out
+  // still holds the socket until kernel ends it, or until a second deadline
+  // passes.
+  // Returns true if the request is sent or queued.
+  virtual bool RegisterHandlerAndSendDumpMessage(
+      const NL80211Packet& packet,
+      std::function<void(const NL80211PacketView&)> handler,
+      OnDumpCompleteHandler complete_handler);
   // Synchronous version of |RegisterHandlerAndSendMessage|.
   // Returns true on successfully receiving an valid reply.
   // Reply packets will be stored in |*response|.
   virtual bool SendMessageAndGetResponses(
       const NL80211Packet& packet,
       std::vector<std::unique_ptr<const NL80211Packet>>* response);
+  // Streaming version of |SendMessageAndGetResponses|.
+  // |handler| will be run for every reply message as soon as it is received,
+  // including a NLMSG_ERROR message. The message is a view of the receive
+  // buffer, and it is only valid during that run.
+  // This avoids holding all reply packets of a large dump at once.
+  // Returns true on successfully receiving an valid reply.
+  virtual bool SendMessageAndHandleResponses(
+      const NL80211Packet& packet,
+      std::function<void(const NL80211PacketView&)> handler);
+  // Pipelined version of |SendMessageAndGetResponses|.
+  // All |packets| are sent to kernel back to back with a single sendmsg()
+  // call, and their replies are collected together.
+  // |packets| must have distinct sequence numbers. At most one of them can
+  // be a dump request, because kernel refuses to start a new dump on a
+  // socket in the middle of another one.
+  // Returns true on successfully receiving valid replies for all |packets|.
+  // Reply packets of |packets[i]| will be stored in |(*responses)[i]|.
+  virtual bool SendMessagesAndGetResponses(
+      const std::vector<NL80211Packet>& packets,
+      std::vector<std::vector<std::unique_ptr<const NL80211Packet>>>* responses);
   // Wrapper of |SendMessageAndGetResponses| for messages with a single
   // response.
   // Returns true on successfully receiving an valid reply.
@@ -255,12 +347,53 @@ class NetlinkManager {
   // Cancel the sign-up of receiving channel events.
   virtual void UnsubscribeChannelSwitchEvent(uint32_t interface_index);
 
+  // Returns the receive counters accumulated since construction.
+  const NetlinkReceiveStats& GetReceiveStats() const;
+
  private:
+  struct PendingDump {
+    PendingDump(const NL80211Packet& packet_,
+                std::function<void(const NL80211PacketView&)> handler_,
+                OnDumpCompleteHandler complete_handler_);
+    std::unique_ptr<NL80211Packet> packet;
+    std::function<void(const NL80211PacketView&)> handler;
+    OnDumpCompleteHandler complete_handler;
+  };
+
   bool SetupSocket(android::base::unique_fd* netlink_fd);
   bool WatchSocket(android::base::unique_fd* netlink_fd);
+  // Drains several pending datagrams from |fd| with a single recvmmsg() call
+  // and dispatches all messages they carry.
   void ReceivePacketAndRunHandler(int fd);
+  // Dispatches every netlink message contained in one datagram payload.
+  void HandleDatagram(const uint8_t* datagram, size_t len);
+  // Fails the request whose reply lost the tail of datagram |datagram|,
+  // of which |len| bytes were received.
+  void FailTruncatedRequest(const uint8_t* datagram, size_t len);
+  // Returns the size of the next datagram queued on |fd|, without consuming
+  // it. Returns 0 if there is no datagram or the size can't be determined.
+  size_t PeekDatagramSize(int fd);
+  // Counts an overrun of the receive queue of |fd|, and fails the
+  // asynchronous dump in flight if the overrun hit its socket.
+  void OnReceiveQueueOverrun(int fd);
+  // Resize every buffer in |buffers| to be able to hold |size| bytes.
+  // Only the buffers of the socket being read are resized, because the
+  // other set might still be referenced by a batch being dispatched.
+  void GrowReceiveBuffers(std::vector<std::vector<uint8_t>>* buffers,
+                          size_t size);
   bool DiscoverFamilyId();
   bool SendMessageInternal(const NL80211Packet& packet, int fd);
+  bool SendMessagesInternal(const std::vector<NL80211Packet>& packets, int fd);
+  // Runs the handlers of replies received on the synchronous socket until
+  // all requests with sequence numbers in |sequences| are complete.
+  // Returns false on timeout or poll() failure.
+  bool WaitForResponses(const std::vector<uint32_t>& sequences);
+  // Send the queued asynchronous dump requests until one of them is in
+  // flight.
+  void SendPendingDumps();
+  bool SendDumpInternal(const PendingDump& dump);
+  void OnDumpTimeout(uint32_t sequence_number);
+  void FinishDump(DumpResult result, int error_code);
   void BroadcastHandler(std::unique_ptr<const NL80211Packet> packet);
   void OnRegChangeEvent(std::unique_ptr<const NL80211Packet> packet);
   void OnMlmeEvent(std::unique_ptr<const NL80211Packet> packet);
@@ -285,7 +418,21 @@ class NetlinkManager {
 
   // This is a collection of message handlers, for each sequence number.
   std::map<uint32_t,
-      std::function<void(std::unique_ptr<const NL80211Packet>)>> message_handlers_;
+      std::function<void(const NL80211PacketView&)>> message_handlers_;
+  // Sequence numbers of synchronous requests which lost part of their reply
+  // to a truncated datagram. WaitForResponses() fails for them.
+  std::set<uint32_t> failed_sequences_;
+
+  // Asynchronous dump requests waiting to be sent.
+  std::deque<PendingDump> pending_dumps_;
+  // Sequence number of the asynchronous dump in flight.
+  // This is kBroadcastSequenceNumber when no dump is in flight.
+  uint32_t dump_sequence_number_;
+  // Whether the dump in flight timed out. Its completion handler has run
+  // already, but kernel is still sending its replies. The socket is released
+  // on the end of the dump or after a second timeout, whichever comes first.
+  bool dump_timed_out_;
+  OnDumpCompleteHandler dump_complete_handler_;
 
   // A mapping from interface index to the handler registered to receive
   // scan results notifications.
@@ -308,6 +455,17 @@ class NetlinkManager {
 
   uint32_t sequence_number_;
 
+  // Size of the kernel receive queue of each netlink socket.
+  int socket_receive_buffer_size_;
+  // Datagram buffers used by recvmmsg(), one set per socket.
+  // Handlers of asynchronous messages may issue synchronous requests, which
+  // read the synchronous socket while a batch from the asynchronous socket
+  // is still being dispatched.
+  std::vector<std::vector<uint8_t>> sync_receive_buffers_;
+  std::vector<std::vector<uint8_t>> async_receive_buffers_;
+
+  NetlinkReceiveStats receive_stats_;
+
   DISALLOW_COPY_AND_ASSIGN(NetlinkManager);
 };
 
@@ -17,22 +17,26 @@
 #include "wificond/net/netlink_utils.h"
 
 #include <bitset>
+#include <limits>
 #include <map>
 #include <string>
 #include <vector>
 
 #include <linux/netlink.h>
+#include <string.h>
 
 #include <android-base/logging.h>
 
 #include "wificond/net/kernel-header-latest/nl80211.h"
 #include "wificond/net/mlme_event_handler.h"
 #include "wificond/net/nl80211_packet.h"
+#include "wificond/net/nl80211_policy.h"
 
-using std::make_pair;
+using std::make_shared;
 using std::make_unique;
 using std::map;
 using std::move;
+using std::pair;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -42,13 +46,21 @@ namespace wificond {
 
 namespace {
 
-uint32_t k2GHzFrequencyLowerBound = 2400;
-uint32_t k2GHzFrequencyUpperBound = 2500;
+constexpr uint32_t k2GHzFrequencyLowerBound = 2400;
+constexpr uint32_t k2GHzFrequencyUpperBound = 2500;
 
-uint32_t k5GHzFrequencyLowerBound = 5000;
+constexpr uint32_t k5GHzFrequencyLowerBound = 5000;
 // This upper bound will exclude any 5.9Ghz channels which belong to 802.11p
 // for "vehicular communication systems".
-uint32_t k5GHzFrequencyUpperBound = 5850;
+constexpr uint32_t k5GHzFrequencyUpperBound = 5850;
+
+// An attribute of a split wiphy dump, whose payload is split among messages.
+struct SplitAttribute {
+  // Payload fragments in message order, as pointers into the messages.
+  vector<pair<const uint8_t*, size_t>> fragments;
+  // Total length of |fragments|.
+  size_t payload_length{0};
+};
 
 bool IsExtFeatureFlagSet(
     const std::vector<uint8_t>& ext_feature_flags_bytes,
@@ -69,6 +81,16 @@ bool IsExtFeatureFlagSet(
 }
 }  // namespace
 
+bool Is2GHzFrequency(uint32_t frequency) {
+  return frequency > k2GHzFrequencyLowerBound &&
+      frequency < k2GHzFrequencyUpperBound;
+}
+
+bool Is5GHzFrequency(uint32_t frequency) {
+  return frequency > k5GHzFrequencyLowerBound &&
+      frequency < k5GHzFrequencyUpperBound;
+}
+
 WiphyFeatures::WiphyFeatures(uint32_t feature_flags,
                              const std::vector<uint8_t>& ext_feature_flags_bytes)
     : supports_random_mac_oneshot_scan(
@@ -84,16 +106,18 @@ WiphyFeatures::WiphyFeatures(uint32_t feature_flags,
   supports_high_accuracy_oneshot_scan =
       IsExtFeatureFlagSet(ext_feature_flags_bytes,
                           NL80211_EXT_FEATURE_HIGH_ACCURACY_SCAN);
+  supports_relative_rssi_sched_scan =
+      IsExtFeatureFlagSet(ext_feature_flags_bytes,
+                          NL80211_EXT_FEATURE_SCHED_SCAN_RELATIVE_RSSI);
 }
 
 NetlinkUtils::NetlinkUtils(NetlinkManager* netlink_manager)
-    : netlink_manager_(netlink_manager) {
+    : supports_split_wiphy_dump_(false),
+      has_protocol_features_(false),
+      netlink_manager_(netlink_manager) {
   if (!netlink_manager_->IsStarted()) {
     netlink_manager_->Start();
   }
-  uint32_t protocol_features = 0;
-  supports_split_wiphy_dump_ = GetProtocolFeatures(&protocol_features) &&
-      (protocol_features & NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP);
 }
 
 NetlinkUtils::~NetlinkUtils() {}
@@ -105,11 +129,41 @@ bool NetlinkUtils::GetWiphyIndex(uint32_t* out_wiphy_index) {
       netlink_manager_->GetSequenceNumber(),
       getpid());
   get_wiphy.AddFlag(NLM_F_DUMP);
+  if (!has_protocol_features_) {
+    // This is the first request of bring-up. The protocol features are
+    // needed by the wiphy info request which follows, so they are asked for
+    // in the same round trip.
+    vector<NL80211Packet> packets;
+    packets.emplace_back(
+        netlink_manager_->GetFamilyId(),
+        NL80211_CMD_GET_PROTOCOL_FEATURES,
+        netlink_manager_->GetSequenceNumber(),
+        getpid());
+    packets.push_back(std::move(get_wiphy));
+    vector<vector<unique_ptr<const NL80211Packet>>> responses;
+    if (!netlink_manager_->SendMessagesAndGetResponses(packets, &responses)) {
+      LOG(ERROR) << "NL80211_CMD_GET_PROTOCOL_FEATURES and "
+                 << "NL80211_CMD_GET_WIPHY dump failed";
+      return false;
+    }
+    if (responses[0].size() == 1) {
+      UpdateProtocolFeatures(*responses[0][0]);
+    } else {
+      LOG(ERROR) << "Unexpected NL80211_CMD_GET_PROTOCOL_FEATURES reply";
+    }
+    return ParseWiphyIndex(responses[1], out_wiphy_index);
+  }
   vector<unique_ptr<const NL80211Packet>> response;
   if (!netlink_manager_->SendMessageAndGetResponses(get_wiphy, &response))  {
     LOG(ERROR) << "NL80211_CMD_GET_WIPHY dump failed";
     return false;
   }
+  return ParseWiphyIndex(response, out_wiphy_index);
+}
+
+bool NetlinkUtils::ParseWiphyIndex(
+    const vector<unique_ptr<const NL80211Packet>>& response,
+    uint32_t* out_wiphy_index) {
   if (response.empty()) {
     LOG(DEBUG) << "No wiphy is found";
     return false;
@@ -160,53 +214,108 @@ bool NetlinkUtils::GetInterfaces(uint32_t wiphy_index,
     return false;
   }
   for (auto& packet : response) {
-    if (packet->GetMessageType() == NLMSG_ERROR) {
-      LOG(ERROR) << "Receive ERROR message: "
-                 << strerror(packet->GetErrorCode());
+    if (!ParseInterfaceInfo(NL80211PacketView(*packet), interface_info)) {
       return false;
     }
-    if (packet->GetMessageType() != netlink_manager_->GetFamilyId()) {
-      LOG(ERROR) << "Wrong message type for new interface message: "
-                 << packet->GetMessageType();
-      return false;
+  }
+
+  return true;
+}
+
+bool NetlinkUtils::GetInterfacesAsync(uint32_t wiphy_index,
+                                      OnInterfacesDumpedHandler handler) {
+  NL80211Packet get_interfaces(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_GET_INTERFACE,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+
+  get_interfaces.AddFlag(NLM_F_DUMP);
+  get_interfaces.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY, wiphy_index));
+
+  auto interface_info = make_shared<vector<InterfaceInfo>>();
+  auto num_messages = make_shared<size_t>(0);
+  auto parse_failed = make_shared<bool>(false);
+  auto message_handler =
+      [this, interface_info, num_messages, parse_failed](
+          const NL80211PacketView& packet) {
+    (*num_messages)++;
+    if (*parse_failed) {
+      return;
     }
-    if (packet->GetCommand() != NL80211_CMD_NEW_INTERFACE) {
-      LOG(ERROR) << "Wrong command in response to "
-                 << "an interface dump request: "
-                 << static_cast<int>(packet->GetCommand());
-      return false;
+    if (!ParseInterfaceInfo(packet, interface_info.get())) {
+      *parse_failed = true;
     }
-
-    // In some situations, it has been observed that the kernel tells us
-    // about a pseudo interface that does not have a real netdev.  In this
-    // case, responses will have a NL80211_ATTR_WDEV, and not the expected
-    // IFNAME/IFINDEX. In this case we just skip these pseudo interfaces.
-    uint32_t if_index;
-    if (!packet->GetAttributeValue(NL80211_ATTR_IFINDEX, &if_index)) {
-      LOG(DEBUG) << "Failed to get interface index";
-      continue;
+  };
+  auto complete_handler =
+      [interface_info, num_messages, parse_failed, handler](
+          DumpResult result, int error_code) {
+    bool success = (result == DUMP_DONE && !*parse_failed);
+    if (result == DUMP_ERROR) {
+      LOG(ERROR) << "NL80211_CMD_GET_INTERFACE dump failed: "
+                 << strerror(error_code);
+    } else if (success && *num_messages == 0) {
+      LOG(ERROR) << "No interface is found";
+      success = false;
     }
+    handler(success, *interface_info);
+  };
+  if (!netlink_manager_->RegisterHandlerAndSendDumpMessage(
+          get_interfaces, message_handler, complete_handler)) {
+    LOG(ERROR) << "Failed to send NL80211_CMD_GET_INTERFACE dump request";
+    return false;
+  }
+  return true;
+}
 
-    // Today we don't check NL80211_ATTR_IFTYPE because at this point of time
-    // driver always reports that interface is in STATION mode. Even when we
-    // are asking interfaces infomation on behalf of tethering, it is still so
-    // because hostapd is supposed to set interface to AP mode later.
+bool NetlinkUtils::ParseInterfaceInfo(const NL80211PacketView& packet,
+                                      vector<InterfaceInfo>* interface_info) {
+  if (packet.GetMessageType() == NLMSG_ERROR) {
+    LOG(ERROR) << "Receive ERROR message: "
+               << strerror(packet.GetErrorCode());
+    return false;
+  }
+  if (packet.GetMessageType() != netlink_manager_->GetFamilyId()) {
+    LOG(ERROR) << "Wrong message type for new interface message: "
+               << packet.GetMessageType();
+    return false;
+  }
+  if (packet.GetCommand() != NL80211_CMD_NEW_INTERFACE) {
+    LOG(ERROR) << "Wrong command in response to "
+               << "an interface dump request: "
+               << static_cast<int>(packet.GetCommand());
+    return false;
+  }
 
-    string if_name;
-    if (!packet->GetAttributeValue(NL80211_ATTR_IFNAME, &if_name)) {
-      LOG(WARNING) << "Failed to get interface name";
-      continue;
-    }
+  // In some situations, it has been observed that the kernel tells us
+  // about a pseudo interface that does not have a real netdev.  In this
+  // case, responses will have a NL80211_ATTR_WDEV, and not the expected
+  // IFNAME/IFINDEX. In this case we just skip these pseudo interfaces.
+  uint32_t if_index;
+  if (!packet.GetAttributeValue(NL80211_ATTR_IFINDEX, &if_index)) {
+    LOG(DEBUG) << "Failed to get interface index";
+    return true;
+  }
 
-    vector<uint8_t> if_mac_addr;
-    if (!packet->GetAttributeValue(NL80211_ATTR_MAC, &if_mac_addr)) {
-      LOG(WARNING) << "Failed to get interface mac address";
-      continue;
-    }
+  // Today we don't check NL80211_ATTR_IFTYPE because at this point of time
+  // driver always reports that interface is in STATION mode. Even when we
+  // are asking interfaces infomation on behalf of tethering, it is still so
+  // because hostapd is supposed to set interface to AP mode later.
 
-    interface_info->emplace_back(if_index, if_name, if_mac_addr);
+  string if_name;
+  if (!packet.GetAttributeValue(NL80211_ATTR_IFNAME, &if_name)) {
+    LOG(WARNING) << "Failed to get interface name";
+    return true;
   }
 
+  vector<uint8_t> if_mac_addr;
+  if (!packet.GetAttributeValue(NL80211_ATTR_MAC, &if_mac_addr)) {
+    LOG(WARNING) << "Failed to get interface mac address";
+    return true;
+  }
+
+  interface_info->emplace_back(if_index, if_name, if_mac_addr);
   return true;
 }
 
@@ -260,6 +369,18 @@ bool NetlinkUtils::GetProtocolFeatures(uint32_t* features) {
   return true;
 }
 
+void NetlinkUtils::UpdateProtocolFeatures(const NL80211Packet& response) {
+  uint32_t features = 0;
+  if (response.GetMessageType() == NLMSG_ERROR ||
+      !response.GetAttributeValue(NL80211_ATTR_PROTOCOL_FEATURES, &features)) {
+    LOG(ERROR) << "Failed to get NL80211_ATTR_PROTOCOL_FEATURES";
+    return;
+  }
+  has_protocol_features_ = true;
+  supports_split_wiphy_dump_ =
+      (features & NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP) != 0;
+}
+
 bool NetlinkUtils::GetWiphyInfo(
     uint32_t wiphy_index,
     BandInfo* out_band_info,
@@ -271,6 +392,13 @@ bool NetlinkUtils::GetWiphyInfo(
       netlink_manager_->GetSequenceNumber(),
       getpid());
   get_wiphy.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY, wiphy_index));
+  // The protocol features normally come along with the wiphy index.
+  uint32_t protocol_features = 0;
+  if (!has_protocol_features_ && GetProtocolFeatures(&protocol_features)) {
+    has_protocol_features_ = true;
+    supports_split_wiphy_dump_ =
+        (protocol_features & NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP) != 0;
+  }
   if (supports_split_wiphy_dump_) {
     get_wiphy.AddFlagAttribute(NL80211_ATTR_SPLIT_WIPHY_DUMP);
     get_wiphy.AddFlag(NLM_F_DUMP);
@@ -320,19 +448,24 @@ bool NetlinkUtils::ParseWiphyInfoFromPacket(
                << static_cast<int>(packet.GetCommand());
     return false;
   }
-  if (!ParseBandInfo(&packet, out_band_info) ||
-      !ParseScanCapabilities(&packet, out_scan_capabilities)) {
+  // Wiphy info carries a lot of attributes, so we index and validate them
+  // once instead of walking through them for every lookup.
+  NL80211AttrSet<NL80211WiphyPolicy> attributes;
+  if (!attributes.Parse(NL80211PacketView(packet))) {
+    LOG(ERROR) << "Failed to parse attributes of wiphy info";
+    return false;
+  }
+  if (!ParseBandInfo(attributes, out_band_info) ||
+      !ParseScanCapabilities(attributes, out_scan_capabilities)) {
     return false;
   }
   uint32_t feature_flags;
-  if (!packet.GetAttributeValue(NL80211_ATTR_FEATURE_FLAGS,
-                                 &feature_flags)) {
+  if (!attributes.Get<NL80211_ATTR_FEATURE_FLAGS>(&feature_flags)) {
     LOG(ERROR) << "Failed to get NL80211_ATTR_FEATURE_FLAGS";
     return false;
   }
   std::vector<uint8_t> ext_feature_flags_bytes;
-  if (!packet.GetAttributeValue(NL80211_ATTR_EXT_FEATURES,
-                                &ext_feature_flags_bytes)) {
+  if (!attributes.Get<NL80211_ATTR_EXT_FEATURES>(&ext_feature_flags_bytes)) {
     LOG(WARNING) << "Failed to get NL80211_ATTR_EXT_FEATURES";
   }
   *out_wiphy_features = WiphyFeatures(feature_flags,
@@ -341,18 +474,17 @@ bool NetlinkUtils::ParseWiphyInfoFromPacket(
 }
 
 bool NetlinkUtils::ParseScanCapabilities(
-    const NL80211Packet* const packet,
+    const NL80211AttrSet<NL80211WiphyPolicy>& attributes,
     ScanCapabilities* out_scan_capabilities) {
   uint8_t max_num_scan_ssids;
-  if (!packet->GetAttributeValue(NL80211_ATTR_MAX_NUM_SCAN_SSIDS,
-                                   &max_num_scan_ssids)) {
+  if (!attributes.Get<NL80211_ATTR_MAX_NUM_SCAN_SSIDS>(&max_num_scan_ssids)) {
     LOG(ERROR) << "Failed to get the capacity of maximum number of scan ssids";
     return false;
   }
 
   uint8_t max_num_sched_scan_ssids;
-  if (!packet->GetAttributeValue(NL80211_ATTR_MAX_NUM_SCHED_SCAN_SSIDS,
-                                 &max_num_sched_scan_ssids)) {
+  if (!attributes.Get<NL80211_ATTR_MAX_NUM_SCHED_SCAN_SSIDS>(
+          &max_num_sched_scan_ssids)) {
     LOG(ERROR) << "Failed to get the capacity of "
                << "maximum number of scheduled scan ssids";
     return false;
@@ -360,18 +492,15 @@ bool NetlinkUtils::ParseScanCapabilities(
 
   // Use default value 0 for scan plan capabilities if attributes are missing.
   uint32_t max_num_scan_plans = 0;
-  packet->GetAttributeValue(NL80211_ATTR_MAX_NUM_SCHED_SCAN_PLANS,
-                            &max_num_scan_plans);
+  attributes.Get<NL80211_ATTR_MAX_NUM_SCHED_SCAN_PLANS>(&max_num_scan_plans);
   uint32_t max_scan_plan_interval = 0;
-  packet->GetAttributeValue(NL80211_ATTR_MAX_SCAN_PLAN_INTERVAL,
-                            &max_scan_plan_interval);
+  attributes.Get<NL80211_ATTR_MAX_SCAN_PLAN_INTERVAL>(&max_scan_plan_interval);
   uint32_t max_scan_plan_iterations = 0;
-  packet->GetAttributeValue(NL80211_ATTR_MAX_SCAN_PLAN_ITERATIONS,
-                            &max_scan_plan_iterations);
+  attributes.Get<NL80211_ATTR_MAX_SCAN_PLAN_ITERATIONS>(
+      &max_scan_plan_iterations);
 
   uint8_t max_match_sets;
-  if (!packet->GetAttributeValue(NL80211_ATTR_MAX_MATCH_SETS,
-                                   &max_match_sets)) {
+  if (!attributes.Get<NL80211_ATTR_MAX_MATCH_SETS>(&max_match_sets)) {
     LOG(ERROR) << "Failed to get the capacity of maximum number of match set"
                << "of a scheduled scan";
     return false;
@@ -385,16 +514,17 @@ bool NetlinkUtils::ParseScanCapabilities(
   return true;
 }
 
-bool NetlinkUtils::ParseBandInfo(const NL80211Packet* const packet,
-                                 BandInfo* out_band_info) {
+bool NetlinkUtils::ParseBandInfo(
+    const NL80211AttrSet<NL80211WiphyPolicy>& attributes,
+    BandInfo* out_band_info) {
 
-  NL80211NestedAttr bands_attr(0);
-  if (!packet->GetAttribute(NL80211_ATTR_WIPHY_BANDS, &bands_attr)) {
+  NL80211AttrView bands_attr;
+  if (!attributes.GetNested<NL80211_ATTR_WIPHY_BANDS>(&bands_attr)) {
     LOG(ERROR) << "Failed to get NL80211_ATTR_WIPHY_BANDS";
     return false;
   }
-  vector<NL80211NestedAttr> bands;
-  if (!bands_attr.GetListOfNestedAttributes(&bands)) {
+  vector<NL80211AttrView> bands;
+  if (!bands_attr.GetListOfAttributes(&bands)) {
     LOG(ERROR) << "Failed to get bands within NL80211_ATTR_WIPHY_BANDS";
     return false;
   }
@@ -402,37 +532,40 @@ bool NetlinkUtils::ParseBandInfo(const NL80211Packet* const packet,
   vector<uint32_t> frequencies_5g;
   vector<uint32_t> frequencies_dfs;
   for (unsigned int band_index = 0; band_index < bands.size(); band_index++) {
-    NL80211NestedAttr freqs_attr(0);
-    if (!bands[band_index].GetAttribute(NL80211_BAND_ATTR_FREQS, &freqs_attr)) {
+    NL80211AttrSet<NL80211BandPolicy> band;
+    NL80211AttrView freqs_attr;
+    if (!band.Parse(bands[band_index]) ||
+        !band.GetNested<NL80211_BAND_ATTR_FREQS>(&freqs_attr)) {
       LOG(DEBUG) << "Failed to get NL80211_BAND_ATTR_FREQS";
       continue;
     }
-    vector<NL80211NestedAttr> freqs;
-    if (!freqs_attr.GetListOfNestedAttributes(&freqs)) {
+    vector<NL80211AttrView> freqs;
+    if (!freqs_attr.GetListOfAttributes(&freqs)) {
       LOG(ERROR) << "Failed to get frequencies within NL80211_BAND_ATTR_FREQS";
       continue;
     }
-    for (auto& freq : freqs) {
+    for (auto& freq_attr : freqs) {
+      NL80211AttrSet<NL80211FrequencyPolicy> freq;
+      if (!freq.Parse(freq_attr)) {
+        LOG(DEBUG) << "Failed to parse frequency attributes";
+        continue;
+      }
       uint32_t frequency_value;
-      if (!freq.GetAttributeValue(NL80211_FREQUENCY_ATTR_FREQ,
-                                  &frequency_value)) {
+      if (!freq.Get<NL80211_FREQUENCY_ATTR_FREQ>(&frequency_value)) {
         LOG(DEBUG) << "Failed to get NL80211_FREQUENCY_ATTR_FREQ";
         continue;
       }
       // Channel is disabled in current regulatory domain.
-      if (freq.HasAttribute(NL80211_FREQUENCY_ATTR_DISABLED)) {
+      if (freq.Has<NL80211_FREQUENCY_ATTR_DISABLED>()) {
         continue;
       }
-      if (frequency_value > k2GHzFrequencyLowerBound &&
-            frequency_value < k2GHzFrequencyUpperBound) {
+      if (Is2GHzFrequency(frequency_value)) {
           frequencies_2g.push_back(frequency_value);
-      } else if (frequency_value > k5GHzFrequencyLowerBound &&
-            frequency_value < k5GHzFrequencyUpperBound) {
+      } else if (Is5GHzFrequency(frequency_value)) {
         // If this is an available/usable DFS frequency, we should save it to
         // DFS frequencies list.
         uint32_t dfs_state;
-        if (freq.GetAttributeValue(NL80211_FREQUENCY_ATTR_DFS_STATE,
-                                   &dfs_state) &&
+        if (freq.Get<NL80211_FREQUENCY_ATTR_DFS_STATE>(&dfs_state) &&
             (dfs_state == NL80211_DFS_AVAILABLE ||
                  dfs_state == NL80211_DFS_USABLE)) {
           frequencies_dfs.push_back(frequency_value);
@@ -441,7 +574,7 @@ bool NetlinkUtils::ParseBandInfo(const NL80211Packet* const packet,
 
         // Put non-dfs passive-only channels into the dfs category.
         // This aligns with what framework always assumes.
-        if (freq.HasAttribute(NL80211_FREQUENCY_ATTR_NO_IR)) {
+        if (freq.Has<NL80211_FREQUENCY_ATTR_NO_IR>()) {
           frequencies_dfs.push_back(frequency_value);
           continue;
         }
@@ -475,44 +608,136 @@ bool NetlinkUtils::GetStationInfo(uint32_t interface_index,
     LOG(ERROR) << "NL80211_CMD_GET_STATION failed";
     return false;
   }
-  if (response->GetCommand() != NL80211_CMD_NEW_STATION) {
+  return ParseStationInfo(NL80211PacketView(*response), out_station_info);
+}
+
+bool NetlinkUtils::GetStationTable(uint32_t interface_index,
+                                   StationTable* out_stations) {
+  NL80211Packet get_station(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_GET_STATION,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  get_station.AddFlag(NLM_F_DUMP);
+  get_station.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX,
+                                                 interface_index));
+
+  StationTable stations;
+  bool success = true;
+  auto handler = [this, &stations, &success](
+      const NL80211PacketView& packet) {
+    if (!success) {
+      return;
+    }
+    if (packet.GetMessageType() == NLMSG_ERROR) {
+      LOG(ERROR) << "Receive ERROR message: "
+                 << strerror(packet.GetErrorCode());
+      success = false;
+      return;
+    }
+    // A station the driver reports partially, e.g. without a tx bitrate
+    // yet, must not hide the other stations. Skip it instead.
+    vector<uint8_t> mac_address;
+    if (!packet.GetAttributeValue(NL80211_ATTR_MAC, &mac_address)) {
+      LOG(WARNING) << "Skip station without NL80211_ATTR_MAC";
+      return;
+    }
+    StationInfo station_info;
+    if (!ParseStationInfo(packet, &station_info)) {
+      LOG(WARNING) << "Skip station with incomplete station info";
+      return;
+    }
+    stations[mac_address] = station_info;
+  };
+  if (!netlink_manager_->SendMessageAndHandleResponses(get_station, handler)) {
+    LOG(ERROR) << "NL80211_CMD_GET_STATION dump failed";
+    return false;
+  }
+  if (!success) {
+    return false;
+  }
+  *out_stations = std::move(stations);
+  return true;
+}
+
+bool NetlinkUtils::ParseStationInfo(const NL80211PacketView& packet,
+                                    StationInfo* out_station_info) {
+  if (packet.GetMessageType() == NLMSG_ERROR) {
+    LOG(ERROR) << "Receive ERROR message: "
+               << strerror(packet.GetErrorCode());
+    return false;
+  }
+  if (packet.GetMessageType() != netlink_manager_->GetFamilyId()) {
+    LOG(ERROR) << "Wrong message type for new station message: "
+               << packet.GetMessageType();
+    return false;
+  }
+  if (packet.GetCommand() != NL80211_CMD_NEW_STATION) {
     LOG(ERROR) << "Wrong command in response to a get station request: "
-               << static_cast<int>(response->GetCommand());
+               << static_cast<int>(packet.GetCommand());
     return false;
   }
-  NL80211NestedAttr sta_info(0);
-  if (!response->GetAttribute(NL80211_ATTR_STA_INFO, &sta_info)) {
+  NL80211AttrView sta_info_attr;
+  NL80211AttrSet<NL80211StaInfoPolicy> sta_info;
+  if (!packet.GetAttribute(NL80211_ATTR_STA_INFO, &sta_info_attr) ||
+      !sta_info.Parse(sta_info_attr)) {
     LOG(ERROR) << "Failed to get NL80211_ATTR_STA_INFO";
     return false;
   }
-  int32_t tx_good, tx_bad;
-  if (!sta_info.GetAttributeValue(NL80211_STA_INFO_TX_PACKETS, &tx_good)) {
+  uint32_t tx_good, tx_bad;
+  if (!sta_info.Get<NL80211_STA_INFO_TX_PACKETS>(&tx_good)) {
     LOG(ERROR) << "Failed to get NL80211_STA_INFO_TX_PACKETS";
     return false;
   }
-  if (!sta_info.GetAttributeValue(NL80211_STA_INFO_TX_FAILED, &tx_bad)) {
+  if (!sta_info.Get<NL80211_STA_INFO_TX_FAILED>(&tx_bad)) {
     LOG(ERROR) << "Failed to get NL80211_STA_INFO_TX_FAILED";
     return false;
   }
   int8_t current_rssi;
-  if (!sta_info.GetAttributeValue(NL80211_STA_INFO_SIGNAL, &current_rssi)) {
+  if (!sta_info.Get<NL80211_STA_INFO_SIGNAL>(&current_rssi)) {
     LOG(ERROR) << "Failed to get NL80211_STA_INFO_SIGNAL";
     return false;
   }
-  NL80211NestedAttr tx_bitrate_attr(0);
-  if (!sta_info.GetAttribute(NL80211_STA_INFO_TX_BITRATE,
-                            &tx_bitrate_attr)) {
+  NL80211AttrView tx_bitrate_attr;
+  NL80211AttrSet<NL80211RateInfoPolicy> tx_bitrate_info;
+  if (!sta_info.GetNested<NL80211_STA_INFO_TX_BITRATE>(&tx_bitrate_attr) ||
+      !tx_bitrate_info.Parse(tx_bitrate_attr)) {
     LOG(ERROR) << "Failed to get NL80211_STA_INFO_TX_BITRATE";
     return false;
   }
   uint32_t tx_bitrate;
-  if (!tx_bitrate_attr.GetAttributeValue(NL80211_RATE_INFO_BITRATE32,
-                                         &tx_bitrate)) {
+  if (!tx_bitrate_info.Get<NL80211_RATE_INFO_BITRATE32>(&tx_bitrate)) {
     LOG(ERROR) << "Failed to get NL80211_RATE_INFO_BITRATE32";
     return false;
   }
 
-  *out_station_info = StationInfo(tx_good, tx_bad, tx_bitrate, current_rssi);
+  StationInfo station_info(tx_good, tx_bad, tx_bitrate, current_rssi);
+  // The remaining attributes are optional.
+  // 64 bit byte counters are preferred because the 32 bit ones wrap around
+  // after 4GB of traffic.
+  uint32_t bytes32;
+  if (!sta_info.Get<NL80211_STA_INFO_RX_BYTES64>(
+          &station_info.station_rx_bytes) &&
+      sta_info.Get<NL80211_STA_INFO_RX_BYTES>(&bytes32)) {
+    station_info.station_rx_bytes = bytes32;
+  }
+  if (!sta_info.Get<NL80211_STA_INFO_TX_BYTES64>(
+          &station_info.station_tx_bytes) &&
+      sta_info.Get<NL80211_STA_INFO_TX_BYTES>(&bytes32)) {
+    station_info.station_tx_bytes = bytes32;
+  }
+  NL80211AttrView rx_bitrate_attr;
+  NL80211AttrSet<NL80211RateInfoPolicy> rx_bitrate_info;
+  if (sta_info.GetNested<NL80211_STA_INFO_RX_BITRATE>(&rx_bitrate_attr) &&
+      rx_bitrate_info.Parse(rx_bitrate_attr)) {
+    rx_bitrate_info.Get<NL80211_RATE_INFO_BITRATE32>(
+        &station_info.station_rx_bitrate);
+  }
+  sta_info.Get<NL80211_STA_INFO_INACTIVE_TIME>(
+      &station_info.inactive_time_ms);
+  sta_info.Get<NL80211_STA_INFO_SIGNAL_AVG>(&station_info.average_rssi);
+
+  *out_station_info = station_info;
   return true;
 }
 
@@ -525,48 +750,78 @@ bool NetlinkUtils::GetStationInfo(uint32_t interface_index,
 // NL80211_ATTR_WIPHY, NL80211_ATTR_IFINDEX, and NL80211_ATTR_WDEV
 // are used for filtering packets so we know which packets should
 // be merged together.
+// The fragments of each attribute are located in place first, so that every
+// byte is copied only once into a buffer of the final size.
 bool NetlinkUtils::MergePacketsForSplitWiphyDump(
     const vector<unique_ptr<const NL80211Packet>>& split_dump_info,
     vector<NL80211Packet>* packet_per_wiphy) {
-  map<uint32_t, map<int, BaseNL80211Attr>> attr_by_wiphy_and_id;
+  map<uint32_t, map<int, SplitAttribute>> attr_by_wiphy_and_id;
 
-  // Construct the map using input packets.
+  // Collect the attribute fragments of each wiphy from input packets.
   for (const auto& packet : split_dump_info) {
     uint32_t wiphy_index;
     if (!packet->GetAttributeValue(NL80211_ATTR_WIPHY, &wiphy_index)) {
       LOG(ERROR) << "Failed to get NL80211_ATTR_WIPHY from wiphy split dump";
       return false;
     }
-    vector<BaseNL80211Attr> attributes;
-    if (!packet->GetAllAttributes(&attributes)) {
-      return false;
-    }
-    for (auto& attr : attributes) {
-      int attr_id = attr.GetAttributeId();
+    map<int, SplitAttribute>& attributes = attr_by_wiphy_and_id[wiphy_index];
+    const vector<uint8_t>& data = packet->GetConstData();
+    const uint8_t* ptr = data.data() + NLMSG_HDRLEN + GENL_HDRLEN;
+    const uint8_t* end_ptr = data.data() + data.size();
+    while (ptr + NLA_HDRLEN <= end_ptr) {
+      auto header = reinterpret_cast<const nlattr*>(ptr);
+      if (header->nla_len < NLA_HDRLEN ||
+          ptr + NLA_ALIGN(header->nla_len) > end_ptr) {
+        LOG(ERROR) << "broken nl80211 atrribute.";
+        return false;
+      }
+      int attr_id = header->nla_type;
       if (attr_id != NL80211_ATTR_WIPHY &&
           attr_id != NL80211_ATTR_IFINDEX &&
-              attr_id != NL80211_ATTR_WDEV) {
-          auto attr_id_and_attr =
-              attr_by_wiphy_and_id[wiphy_index].find(attr_id);
-          if (attr_id_and_attr == attr_by_wiphy_and_id[wiphy_index].end()) {
-            attr_by_wiphy_and_id[wiphy_index].
-                insert(make_pair(attr_id, move(attr)));
-          } else {
-            attr_id_and_attr->second.Merge(attr);
-          }
+          attr_id != NL80211_ATTR_WDEV) {
+        SplitAttribute& attribute = attributes[attr_id];
+        attribute.fragments.emplace_back(ptr + NLA_HDRLEN,
+                                         header->nla_len - NLA_HDRLEN);
+        attribute.payload_length += header->nla_len - NLA_HDRLEN;
       }
+      ptr += NLA_ALIGN(header->nla_len);
     }
   }
 
-  // Generate output packets using the constructed map.
+  // Generate output packets using the collected fragments.
   for (const auto& wiphy_and_attributes : attr_by_wiphy_and_id) {
     NL80211Packet new_wiphy(0, NL80211_CMD_NEW_WIPHY, 0, 0);
     new_wiphy.AddAttribute(
         NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY, wiphy_and_attributes.first));
-    for (const auto& attr : wiphy_and_attributes.second) {
-      new_wiphy.AddAttribute(attr.second);
+    const vector<uint8_t>& header_data = new_wiphy.GetConstData();
+    size_t packet_length = header_data.size();
+    for (const auto& id_and_attr : wiphy_and_attributes.second) {
+      if (NLA_HDRLEN + id_and_attr.second.payload_length >
+          std::numeric_limits<uint16_t>::max()) {
+        LOG(ERROR) << "Merged attribute " << id_and_attr.first
+                   << " is too long";
+        return false;
+      }
+      packet_length +=
+          NLA_ALIGN(NLA_HDRLEN + id_and_attr.second.payload_length);
+    }
+    vector<uint8_t> data(packet_length, 0);
+    memcpy(data.data(), header_data.data(), header_data.size());
+    reinterpret_cast<nlmsghdr*>(data.data())->nlmsg_len = packet_length;
+    uint8_t* ptr = data.data() + header_data.size();
+    for (const auto& id_and_attr : wiphy_and_attributes.second) {
+      const SplitAttribute& attribute = id_and_attr.second;
+      auto header = reinterpret_cast<nlattr*>(ptr);
+      header->nla_type = id_and_attr.first;
+      header->nla_len = NLA_HDRLEN + attribute.payload_length;
+      uint8_t* payload = ptr + NLA_HDRLEN;
+      for (const auto& fragment : attribute.fragments) {
+        memcpy(payload, fragment.first, fragment.second);
+        payload += fragment.second;
+      }
+      ptr += NLA_ALIGN(header->nla_len);
     }
-    packet_per_wiphy->emplace_back(move(new_wiphy));
+    packet_per_wiphy->emplace_back(move(data));
   }
   return true;
 }
@@ -590,6 +845,10 @@ bool NetlinkUtils::GetCountryCode(string* out_country_code) {
   return true;
 }
 
+void NetlinkUtils::GetNetlinkReceiveStats(NetlinkReceiveStats* out_stats) {
+  *out_stats = netlink_manager_->GetReceiveStats();
+}
+
 void NetlinkUtils::SubscribeMlmeEvent(uint32_t interface_index,
                                       MlmeEventHandler* handler) {
   netlink_manager_->SubscribeMlmeEvent(interface_index, handler);
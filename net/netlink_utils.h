@@ -17,6 +17,8 @@
 #ifndef WIFICOND_NET_NETLINK_UTILS_H_
 #define WIFICOND_NET_NETLINK_UTILS_H_
 
+#include <functional>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -44,6 +46,14 @@ struct InterfaceInfo {
   std::vector<uint8_t> mac_address;
 };
 
+// This describes a type of function handling the end of an asynchronous
+// interface dump.
+// |success| is false if the dump failed, timed out or no interface is found.
+// |interface_info| contains information about all existing interfaces.
+typedef std::function<void(
+    bool success,
+    std::vector<InterfaceInfo>& interface_info)> OnInterfacesDumpedHandler;
+
 struct BandInfo {
   BandInfo() = default;
   BandInfo(std::vector<uint32_t>& band_2g_,
@@ -60,6 +70,11 @@ struct BandInfo {
   std::vector<uint32_t> band_dfs;
 };
 
+// Returns true if |frequency| in MHz is a channel of the 2.4 GHz band.
+bool Is2GHzFrequency(uint32_t frequency);
+// Returns true if |frequency| in MHz is a channel of the 5 GHz band.
+bool Is5GHzFrequency(uint32_t frequency);
+
 struct ScanCapabilities {
   ScanCapabilities() = default;
   ScanCapabilities(uint8_t max_num_scan_ssids_,
@@ -96,7 +111,8 @@ struct WiphyFeatures {
         supports_random_mac_sched_scan(false),
         supports_low_span_oneshot_scan(false),
         supports_low_power_oneshot_scan(false),
-        supports_high_accuracy_oneshot_scan(false) {}
+        supports_high_accuracy_oneshot_scan(false),
+        supports_relative_rssi_sched_scan(false) {}
   WiphyFeatures(uint32_t feature_flags,
                 const std::vector<uint8_t>& ext_feature_flags_bytes);
   // This device/driver supports using a random MAC address during scan
@@ -111,6 +127,9 @@ struct WiphyFeatures {
   bool supports_low_power_oneshot_scan;
   // This device/driver supports performing high-accuracy one-shot scans.
   bool supports_high_accuracy_oneshot_scan;
+  // This device/driver supports only reporting BSSs better than the
+  // connected one during scheduled scan.
+  bool supports_relative_rssi_sched_scan;
   // There are other flags included in NL80211_ATTR_FEATURE_FLAGS.
   // We will add them once we find them useful.
 };
@@ -126,20 +145,38 @@ struct StationInfo {
         station_tx_bitrate(station_tx_bitrate_),
         current_rssi(current_rssi_) {}
   // Number of successfully transmitted packets.
-  int32_t station_tx_packets;
+  uint32_t station_tx_packets;
   // Number of tramsmission failures.
-  int32_t station_tx_failed;
+  uint32_t station_tx_failed;
   // Transimission bit rate in 100kbit/s.
   uint32_t station_tx_bitrate;
   // Current signal strength.
   int8_t current_rssi;
+  // The following fields are left as 0 if the driver doesn't report them.
+  // Number of bytes received from the station.
+  uint64_t station_rx_bytes{0};
+  // Number of bytes transmitted to the station.
+  uint64_t station_tx_bytes{0};
+  // Receive bit rate in 100kbit/s.
+  uint32_t station_rx_bitrate{0};
+  // Time since the last activity of the station in milliseconds.
+  uint32_t inactive_time_ms{0};
+  // Average signal strength.
+  int8_t average_rssi{0};
   // There are many other counters/parameters included in station info.
   // We will add them once we find them useful.
 };
 
+// Station info keyed by the MAC address of the station.
+typedef std::map<std::vector<uint8_t>, StationInfo> StationTable;
+
 class MlmeEventHandler;
 class NetlinkManager;
+template <typename Policy>
+class NL80211AttrSet;
 class NL80211Packet;
+class NL80211PacketView;
+struct NL80211WiphyPolicy;
 
 // Provides NL80211 helper functions.
 class NetlinkUtils {
@@ -166,6 +203,13 @@ class NetlinkUtils {
   virtual bool GetInterfaces(uint32_t wiphy_index,
                              std::vector<InterfaceInfo>* interface_info);
 
+  // Asynchronous version of |GetInterfaces|.
+  // This doesn't block the event loop while kernel is dumping interfaces.
+  // |handler| is run once the dump ends.
+  // Returns true if the request is successfully sent.
+  virtual bool GetInterfacesAsync(uint32_t wiphy_index,
+                                  OnInterfacesDumpedHandler handler);
+
   // Set the mode of interface.
   // |interface_index| is the interface index.
   // |mode| is one of the values in |enum InterfaceMode|.
@@ -187,6 +231,14 @@ class NetlinkUtils {
                               const std::vector<uint8_t>& mac_address,
                               StationInfo* out_station_info);
 
+  // Get info of all stations of interface |interface_index| with a single
+  // NL80211_CMD_GET_STATION dump.
+  // |*out_stations| is replaced with the stations in the dump. Stations
+  // with incomplete info are left out.
+  // Returns true on success.
+  virtual bool GetStationTable(uint32_t interface_index,
+                               StationTable* out_stations);
+
   // Get a bitmap for nl80211 protocol features,
   // i.e. features for the nl80211 protocol rather than device features.
   // See enum nl80211_protocol_features in nl80211.h for decoding the bitmap.
@@ -197,6 +249,10 @@ class NetlinkUtils {
   // Returns true on success.
   virtual bool GetCountryCode(std::string* out_country_code);
 
+  // Get the counters of the underlying netlink sockets, including the
+  // number of truncated datagrams and receive queue overruns.
+  virtual void GetNetlinkReceiveStats(NetlinkReceiveStats* out_stats);
+
   // Sign up to be notified when there is MLME event.
   // Only one handler can be registered per interface index.
   // New handler will replace the registered handler if they are for the
@@ -244,17 +300,37 @@ class NetlinkUtils {
 
   // Visible for testing.
   bool supports_split_wiphy_dump_;
+  // Whether |supports_split_wiphy_dump_| was learned from kernel.
+  bool has_protocol_features_;
 
  private:
+  // Gets the index of the first wiphy in |response| to a wiphy dump.
+  // Returns true on success.
+  bool ParseWiphyIndex(
+      const std::vector<std::unique_ptr<const NL80211Packet>>& response,
+      uint32_t* out_wiphy_index);
+  // Updates |supports_split_wiphy_dump_| from |response| to a
+  // NL80211_CMD_GET_PROTOCOL_FEATURES request.
+  void UpdateProtocolFeatures(const NL80211Packet& response);
+  // Appends the interface described by |packet| of an interface dump reply
+  // to |interface_info|. Pseudo interfaces without a netdev are skipped.
+  // Returns false if |packet| is not a valid interface dump reply.
+  bool ParseInterfaceInfo(const NL80211PacketView& packet,
+                          std::vector<InterfaceInfo>* interface_info);
+  // Parses the station info of a NL80211_CMD_NEW_STATION message.
+  // Returns false if |packet| is not a valid station info message.
+  bool ParseStationInfo(const NL80211PacketView& packet,
+                        StationInfo* out_station_info);
   bool ParseWiphyInfoFromPacket(
       const NL80211Packet& packet,
       BandInfo* out_band_info,
       ScanCapabilities* out_scan_capabilities,
       WiphyFeatures* out_wiphy_features);
-  bool ParseBandInfo(const NL80211Packet* const packet,
+  bool ParseBandInfo(const NL80211AttrSet<NL80211WiphyPolicy>& attributes,
                      BandInfo* out_band_info);
-  bool ParseScanCapabilities(const NL80211Packet* const packet,
-                             ScanCapabilities* out_scan_capabilities);
+  bool ParseScanCapabilities(
+      const NL80211AttrSet<NL80211WiphyPolicy>& attributes,
+      ScanCapabilities* out_scan_capabilities);
 
   bool MergePacketsForSplitWiphyDump(
       const std::vector<std::unique_ptr<const NL80211Packet>>& split_dump_info,
@@ -266,5 +266,104 @@ void NL80211NestedAttr::DebugLog() const {
   }
 }
 
+// For NL80211AttrView
+NL80211AttrView::NL80211AttrView(const BaseNL80211Attr& attribute)
+    : data_(attribute.GetConstData().data()),
+      len_(attribute.GetConstData().size()) {
+}
+
+int NL80211AttrView::GetAttributeId() const {
+  return GetHeader()->nla_type;
+}
+
+bool NL80211AttrView::IsValid() const {
+  if (data_ == nullptr || len_ < NLA_HDRLEN) {
+    return false;
+  }
+  return NLA_ALIGN(GetHeader()->nla_len) == len_ &&
+      GetHeader()->nla_len >= NLA_HDRLEN;
+}
+
+const uint8_t* NL80211AttrView::GetPayload() const {
+  return data_ + NLA_HDRLEN;
+}
+
+size_t NL80211AttrView::GetPayloadLength() const {
+  return GetHeader()->nla_len - NLA_HDRLEN;
+}
+
+bool NL80211AttrView::GetValue(vector<uint8_t>* value) const {
+  if (!IsValid()) {
+    return false;
+  }
+  value->assign(GetPayload(), GetPayload() + GetPayloadLength());
+  return true;
+}
+
+bool NL80211AttrView::GetValue(string* value) const {
+  if (!IsValid()) {
+    return false;
+  }
+  size_t str_length = GetPayloadLength();
+  // Remove trailing zeros.
+  while (str_length > 0 && *(GetPayload() + str_length - 1) == 0) {
+    str_length--;
+  }
+  value->assign(reinterpret_cast<const char*>(GetPayload()), str_length);
+  return true;
+}
+
+bool NL80211AttrView::HasAttribute(int id) const {
+  if (!IsValid()) {
+    return false;
+  }
+  return BaseNL80211Attr::GetAttributeImpl(data_ + NLA_HDRLEN,
+                                           len_ - NLA_HDRLEN,
+                                           id, nullptr, nullptr);
+}
+
+bool NL80211AttrView::GetAttribute(int id, NL80211AttrView* attribute) const {
+  if (!IsValid()) {
+    return false;
+  }
+  uint8_t* start = nullptr;
+  uint8_t* end = nullptr;
+  if (!BaseNL80211Attr::GetAttributeImpl(data_ + NLA_HDRLEN,
+                                         len_ - NLA_HDRLEN,
+                                         id, &start, &end) ||
+      start == nullptr ||
+      end == nullptr) {
+    return false;
+  }
+  *attribute = NL80211AttrView(start, end - start);
+  return attribute->IsValid();
+}
+
+bool NL80211AttrView::GetListOfAttributes(
+    vector<NL80211AttrView>* value) const {
+  if (!IsValid()) {
+    return false;
+  }
+  const uint8_t* ptr = data_ + NLA_HDRLEN;
+  const uint8_t* end_ptr = data_ + len_;
+  vector<NL80211AttrView> attr_list;
+  while (ptr + NLA_HDRLEN <= end_ptr) {
+    const nlattr* header = reinterpret_cast<const nlattr*>(ptr);
+    if (ptr + NLA_ALIGN(header->nla_len) > end_ptr ||
+        header->nla_len < NLA_HDRLEN) {
+      LOG(ERROR) << "Failed to get list of attributes: invalid nla_len.";
+      return false;
+    }
+    attr_list.emplace_back(ptr, NLA_ALIGN(header->nla_len));
+    ptr += NLA_ALIGN(header->nla_len);
+  }
+  *value = std::move(attr_list);
+  return true;
+}
+
+NL80211NestedAttr NL80211AttrView::ToNestedAttr() const {
+  return NL80211NestedAttr(vector<uint8_t>(data_, data_ + len_));
+}
+
 }  // namespace wificond
 }  // namespace android
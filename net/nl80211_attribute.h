@@ -17,6 +17,8 @@
 #ifndef WIFICOND_NET_NL80211_ATTRIBUTE_H_
 #define WIFICOND_NET_NL80211_ATTRIBUTE_H_
 
+#include <array>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -265,6 +267,220 @@ class NL80211NestedAttr : public BaseNL80211Attr {
 
 };
 
+template <int kMaxAttributeId>
+class NL80211AttrIndex;
+
+// A non-owning view of an attribute stored in a buffer owned by someone else,
+// e.g. a netlink receive buffer or a NL80211Packet.
+// This allows parsing attributes without copying them into new buffers.
+// A view must not be used after the buffer it refers to is released or
+// modified. Use ToNestedAttr() to keep a copy of the attribute.
+class NL80211AttrView {
+ public:
+  NL80211AttrView() : data_(nullptr), len_(0) {}
+  // |data| points to the attribute header.
+  // |len| is the length of the attribute, including padding.
+  NL80211AttrView(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+  explicit NL80211AttrView(const BaseNL80211Attr& attribute);
+
+  int GetAttributeId() const;
+  // Returns true if this view refers to an internally consistent attribute.
+  bool IsValid() const;
+  // Payload of this attribute, without header and padding.
+  const uint8_t* GetPayload() const;
+  size_t GetPayloadLength() const;
+
+  // Read the payload as a value of integral type |T|.
+  // Returns false if the payload size doesn't match |T|.
+  template <typename T>
+  bool GetValue(T* value) const {
+    static_assert(
+        std::is_integral<T>::value,
+        "Failed to get NL80211AttrView value of non-integral type");
+    if (!IsValid() ||
+        NLA_ALIGN(sizeof(T)) + NLA_HDRLEN != len_ ||
+        sizeof(T) + NLA_HDRLEN != GetHeader()->nla_len) {
+      return false;
+    }
+    memcpy(value, data_ + NLA_HDRLEN, sizeof(T));
+    return true;
+  }
+  bool GetValue(std::vector<uint8_t>* value) const;
+  // All trailing zeros are trimmed, in the same way as NL80211Attr<string>.
+  bool GetValue(std::string* value) const;
+
+  // Access an attribute nested within |this|.
+  // See NL80211NestedAttr::GetAttribute() for the semantics.
+  bool HasAttribute(int id) const;
+  bool GetAttribute(int id, NL80211AttrView* attribute) const;
+
+  template <typename T>
+  bool GetAttributeValue(int id, T* value) const {
+    NL80211AttrView attribute;
+    if (!GetAttribute(id, &attribute)) {
+      return false;
+    }
+    return attribute.GetValue(value);
+  }
+
+  // Get views of all the attributes nested within |this|, in one pass.
+  bool GetListOfAttributes(std::vector<NL80211AttrView>* value) const;
+
+  // Get values of all the attributes nested within |this|, in one pass.
+  template <typename T>
+  bool GetListOfAttributeValues(std::vector<T>* value) const {
+    std::vector<NL80211AttrView> attributes;
+    if (!GetListOfAttributes(&attributes)) {
+      return false;
+    }
+    std::vector<T> attr_list;
+    for (const auto& attribute : attributes) {
+      T attr_value;
+      if (!attribute.GetValue(&attr_value)) {
+        return false;
+      }
+      attr_list.push_back(std::move(attr_value));
+    }
+    *value = std::move(attr_list);
+    return true;
+  }
+
+  // Index the attributes nested within |this| in one pass.
+  // See NL80211AttrIndex.
+  template <int kMaxAttributeId>
+  bool IndexAttributes(NL80211AttrIndex<kMaxAttributeId>* index) const {
+    if (!IsValid()) {
+      return false;
+    }
+    return index->Build(data_ + NLA_HDRLEN, len_ - NLA_HDRLEN);
+  }
+
+  // Copy the viewed attribute into a NL80211NestedAttr which owns its data.
+  NL80211NestedAttr ToNestedAttr() const;
+
+ private:
+  const nlattr* GetHeader() const {
+    return reinterpret_cast<const nlattr*>(data_);
+  }
+
+  const uint8_t* data_;
+  size_t len_;
+};
+
+// An index of the attributes stored in a nl80211 packet or a nested attribute.
+// It is built with one walk over the attributes, after which looking up an
+// attribute whose id is not greater than |kMaxAttributeId| takes O(1) time
+// instead of another walk. This is useful for messages we get many attributes
+// from, e.g. scan results and wiphy info.
+// |kMaxAttributeId| is supposed to be the maximum id of the attribute set,
+// for example NL80211_BSS_MAX. Attributes with a larger id are still found
+// by a linear search.
+// Like NL80211AttrView, the index refers to the buffer without owning it.
+template <int kMaxAttributeId>
+class NL80211AttrIndex {
+ public:
+  NL80211AttrIndex()
+      : buffer_(nullptr),
+        buffer_len_(0),
+        attributes_(),
+        indexed_ids_(),
+        num_indexed_ids_(0) {}
+
+  // Index the attributes in |buffer|, which holds |len| bytes of attributes.
+  // If an id appears more than once, the first attribute is indexed, in the
+  // same way as BaseNL80211Attr::GetAttributeImpl() finds it.
+  // Returns false if a broken attribute is found. In this case attributes
+  // up until the broken one are still indexed.
+  bool Build(const uint8_t* buffer, size_t len) {
+    attributes_.fill(nullptr);
+    num_indexed_ids_ = 0;
+    const uint8_t* ptr = buffer;
+    const uint8_t* end_ptr = buffer + len;
+    while (ptr + NLA_HDRLEN <= end_ptr) {
+      const nlattr* header = reinterpret_cast<const nlattr*>(ptr);
+      if (ptr + NLA_ALIGN(header->nla_len) > end_ptr ||
+          header->nla_len < NLA_HDRLEN) {
+        LOG(ERROR) << "Failed to index attributes: broken nl80211 atrribute.";
+        // Only search the part of buffer that is indexed.
+        buffer_ = buffer;
+        buffer_len_ = ptr - buffer;
+        return false;
+      }
+      if (header->nla_type <= kMaxAttributeId &&
+          attributes_[header->nla_type] == nullptr) {
+        attributes_[header->nla_type] = ptr;
+        indexed_ids_[num_indexed_ids_++] = header->nla_type;
+      }
+      ptr += NLA_ALIGN(header->nla_len);
+    }
+    buffer_ = buffer;
+    buffer_len_ = len;
+    return true;
+  }
+
+  bool HasAttribute(int id) const {
+    NL80211AttrView attribute;
+    return GetAttribute(id, &attribute);
+  }
+
+  // Ids of the indexed attributes, in the order they appear in the buffer.
+  // This only covers ids which are not greater than |kMaxAttributeId|.
+  size_t GetNumIndexedIds() const { return num_indexed_ids_; }
+  int GetIndexedId(size_t i) const { return indexed_ids_[i]; }
+
+  // Drop attribute |id| from the index, so that it is treated as missing.
+  // |id| must not be greater than |kMaxAttributeId|.
+  void RemoveAttribute(int id) {
+    attributes_[id] = nullptr;
+  }
+
+  bool GetAttribute(int id, NL80211AttrView* attribute) const {
+    if (id < 0) {
+      return false;
+    }
+    if (id > kMaxAttributeId) {
+      uint8_t* start = nullptr;
+      uint8_t* end = nullptr;
+      if (buffer_ == nullptr ||
+          !BaseNL80211Attr::GetAttributeImpl(buffer_, buffer_len_,
+                                             id, &start, &end)) {
+        return false;
+      }
+      *attribute = NL80211AttrView(start, end - start);
+      return attribute->IsValid();
+    }
+    const uint8_t* ptr = attributes_[id];
+    if (ptr == nullptr) {
+      return false;
+    }
+    // The bounds of attribute are verified when it is indexed.
+    *attribute = NL80211AttrView(
+        ptr, NLA_ALIGN(reinterpret_cast<const nlattr*>(ptr)->nla_len));
+    return true;
+  }
+
+  template <typename T>
+  bool GetAttributeValue(int id, T* value) const {
+    NL80211AttrView attribute;
+    if (!GetAttribute(id, &attribute)) {
+      return false;
+    }
+    return attribute.GetValue(value);
+  }
+
+ private:
+  const uint8_t* buffer_;
+  size_t buffer_len_;
+  // Start of the attribute for each id, or nullptr if it is missing.
+  std::array<const uint8_t*, kMaxAttributeId + 1> attributes_;
+  // Ids of the non-null entries of |attributes_|, so that they can be
+  // visited without scanning the whole array.
+  std::array<uint16_t, kMaxAttributeId + 1> indexed_ids_;
+  size_t num_indexed_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(NL80211AttrIndex);
+};
+
 }  // namespace wificond
 }  // namespace android
 
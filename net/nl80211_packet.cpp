@@ -16,6 +16,8 @@
 
 #include "wificond/net/nl80211_packet.h"
 
+#include <string.h>
+
 #include <android-base/logging.h>
 
 using std::make_unique;
@@ -27,7 +29,10 @@ namespace wificond {
 
 NL80211Packet::NL80211Packet(const vector<uint8_t>& data)
     : data_(data) {
-  data_ = data;
+}
+
+NL80211Packet::NL80211Packet(vector<uint8_t>&& data)
+    : data_(std::move(data)) {
 }
 
 NL80211Packet::NL80211Packet(const NL80211Packet& packet) {
@@ -255,5 +260,104 @@ void NL80211Packet::DebugLog() const {
   }
 }
 
+// For NL80211PacketView
+NL80211PacketView::NL80211PacketView(const NL80211Packet& packet)
+    : data_(packet.GetConstData().data()),
+      len_(packet.GetConstData().size()) {
+}
+
+bool NL80211PacketView::IsValid() const {
+  // Verify the size of packet.
+  if (data_ == nullptr || len_ < NLMSG_HDRLEN) {
+    LOG(ERROR) << "Cannot retrieve netlink header.";
+    return false;
+  }
+  const nlmsghdr* nl_header = GetHeader();
+  if (GetMessageType() >= NLMSG_MIN_TYPE) {
+    if (len_ < NLMSG_HDRLEN + GENL_HDRLEN ||
+        nl_header->nlmsg_len < NLMSG_HDRLEN + GENL_HDRLEN) {
+      LOG(ERROR) << "Cannot retrieve generic netlink header.";
+      return false;
+    }
+  }
+  if (GetMessageType() == NLMSG_ERROR) {
+    if (len_ < NLMSG_HDRLEN + sizeof(int) ||
+        nl_header->nlmsg_len < NLMSG_HDRLEN + sizeof(int)) {
+     LOG(ERROR) << "Broken error message.";
+     return false;
+    }
+  }
+  if (len_ < nl_header->nlmsg_len ||
+      nl_header->nlmsg_len < sizeof(nlmsghdr)) {
+    LOG(ERROR) << "Discarding incomplete / invalid message.";
+    return false;
+  }
+  return true;
+}
+
+bool NL80211PacketView::IsDump() const {
+  return GetFlags() & NLM_F_DUMP;
+}
+
+bool NL80211PacketView::IsMulti() const {
+  return GetFlags() & NLM_F_MULTI;
+}
+
+uint8_t NL80211PacketView::GetCommand() const {
+  const genlmsghdr* genl_header = reinterpret_cast<const genlmsghdr*>(
+      data_ + NLMSG_HDRLEN);
+  return genl_header->cmd;
+}
+
+uint16_t NL80211PacketView::GetFlags() const {
+  return GetHeader()->nlmsg_flags;
+}
+
+uint16_t NL80211PacketView::GetMessageType() const {
+  return GetHeader()->nlmsg_type;
+}
+
+uint32_t NL80211PacketView::GetMessageSequence() const {
+  return GetHeader()->nlmsg_seq;
+}
+
+uint32_t NL80211PacketView::GetPortId() const {
+  return GetHeader()->nlmsg_pid;
+}
+
+int NL80211PacketView::GetErrorCode() const {
+  int error_code;
+  memcpy(&error_code, data_ + NLMSG_HDRLEN, sizeof(error_code));
+  return -error_code;
+}
+
+bool NL80211PacketView::HasAttribute(int id) const {
+  return BaseNL80211Attr::GetAttributeImpl(
+      data_ + NLMSG_HDRLEN + GENL_HDRLEN,
+      len_ - NLMSG_HDRLEN - GENL_HDRLEN,
+      id, nullptr, nullptr);
+}
+
+bool NL80211PacketView::GetAttribute(int id,
+                                     NL80211AttrView* attribute) const {
+  uint8_t* start = nullptr;
+  uint8_t* end = nullptr;
+  if (!BaseNL80211Attr::GetAttributeImpl(
+          data_ + NLMSG_HDRLEN + GENL_HDRLEN,
+          len_ - NLMSG_HDRLEN - GENL_HDRLEN,
+          id, &start, &end) ||
+      start == nullptr ||
+      end == nullptr) {
+    return false;
+  }
+  *attribute = NL80211AttrView(start, end - start);
+  return attribute->IsValid();
+}
+
+unique_ptr<NL80211Packet> NL80211PacketView::ToPacket() const {
+  return unique_ptr<NL80211Packet>(new NL80211Packet(
+      vector<uint8_t>(data_, data_ + len_)));
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -41,6 +41,7 @@ class NL80211Packet {
  public:
   // This is used for creating a NL80211Packet from buffer.
   explicit NL80211Packet(const std::vector<uint8_t>& data);
+  explicit NL80211Packet(std::vector<uint8_t>&& data);
   // This is used for creating an empty NL80211Packet to be filled later.
   // See comment of SetMessageType() for |type|.
   // See comment of SetCommand() for |command|.
@@ -161,6 +162,66 @@ class NL80211Packet {
   std::vector<uint8_t> data_;
 };
 
+// A non-owning view of a nl80211 packet stored in a buffer owned by someone
+// else, typically the netlink receive buffer.
+// This allows dispatching and parsing received messages without copying them.
+// A view must not be used after the buffer it refers to is released or reused.
+// Use ToPacket() to keep a copy of the packet.
+class NL80211PacketView {
+ public:
+  // |data| points to the netlink header.
+  // |len| is the length of this message, i.e. nlmsg_len bounded by the size
+  // of the buffer holding it.
+  NL80211PacketView(const uint8_t* data, size_t len)
+      : data_(data), len_(len) {}
+  explicit NL80211PacketView(const NL80211Packet& packet);
+
+  // See comments of the same methods in NL80211Packet.
+  bool IsValid() const;
+  bool IsDump() const;
+  bool IsMulti() const;
+  uint8_t GetCommand() const;
+  uint16_t GetFlags() const;
+  uint16_t GetMessageType() const;
+  uint32_t GetMessageSequence() const;
+  uint32_t GetPortId() const;
+  int GetErrorCode() const;
+
+  bool HasAttribute(int id) const;
+  bool GetAttribute(int id, NL80211AttrView* attribute) const;
+
+  template <typename T>
+  bool GetAttributeValue(int id, T* value) const {
+    NL80211AttrView attribute;
+    if (!GetAttribute(id, &attribute)) {
+      return false;
+    }
+    return attribute.GetValue(value);
+  }
+
+  // Index the top level attributes of this packet in one pass.
+  // See NL80211AttrIndex.
+  template <int kMaxAttributeId>
+  bool IndexAttributes(NL80211AttrIndex<kMaxAttributeId>* index) const {
+    if (len_ < NLMSG_HDRLEN + GENL_HDRLEN) {
+      return false;
+    }
+    return index->Build(data_ + NLMSG_HDRLEN + GENL_HDRLEN,
+                        len_ - NLMSG_HDRLEN - GENL_HDRLEN);
+  }
+
+  // Copy the viewed message into a NL80211Packet which owns its data.
+  std::unique_ptr<NL80211Packet> ToPacket() const;
+
+ private:
+  const nlmsghdr* GetHeader() const {
+    return reinterpret_cast<const nlmsghdr*>(data_);
+  }
+
+  const uint8_t* data_;
+  size_t len_;
+};
+
 }  // namespace wificond
 }  // namespace android
 
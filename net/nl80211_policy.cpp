@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/net/nl80211_policy.h"
+
+namespace android {
+namespace wificond {
+
+constexpr NL80211PolicyTable<NL80211BssPolicy::kMaxAttributeId>
+    NL80211BssPolicy::kPolicy;
+constexpr NL80211PolicyTable<NL80211StaInfoPolicy::kMaxAttributeId>
+    NL80211StaInfoPolicy::kPolicy;
+constexpr NL80211PolicyTable<NL80211RateInfoPolicy::kMaxAttributeId>
+    NL80211RateInfoPolicy::kPolicy;
+constexpr NL80211PolicyTable<NL80211WiphyPolicy::kMaxAttributeId>
+    NL80211WiphyPolicy::kPolicy;
+constexpr NL80211PolicyTable<NL80211BandPolicy::kMaxAttributeId>
+    NL80211BandPolicy::kPolicy;
+constexpr NL80211PolicyTable<NL80211FrequencyPolicy::kMaxAttributeId>
+    NL80211FrequencyPolicy::kPolicy;
+
+bool ValidateAttribute(const NL80211AttrView& attribute,
+                       const NL80211AttrPolicy& policy) {
+  size_t payload_length = attribute.GetPayloadLength();
+  switch (policy.type) {
+    case NL80211AttrType::kUnspec:
+    case NL80211AttrType::kNested:
+      // Nested attributes are validated when they are parsed
+      // with their own policy.
+      return true;
+    case NL80211AttrType::kFlag:
+      return payload_length == 0;
+    case NL80211AttrType::kU8:
+    case NL80211AttrType::kS8:
+      return payload_length == sizeof(uint8_t);
+    case NL80211AttrType::kU16:
+      return payload_length == sizeof(uint16_t);
+    case NL80211AttrType::kU32:
+    case NL80211AttrType::kS32:
+      return payload_length == sizeof(uint32_t);
+    case NL80211AttrType::kU64:
+      return payload_length == sizeof(uint64_t);
+    case NL80211AttrType::kString:
+    case NL80211AttrType::kBinary:
+      return policy.len == 0 || payload_length <= policy.len;
+  }
+  return false;
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_NET_NL80211_POLICY_H_
+#define WIFICOND_NET_NL80211_POLICY_H_
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/net/kernel-header-latest/nl80211.h"
+#include "wificond/net/nl80211_attribute.h"
+#include "wificond/net/nl80211_packet.h"
+
+namespace android {
+namespace wificond {
+
+// Types of attribute payloads.
+// This is modelled on the attribute types of nla_policy in kernel.
+enum class NL80211AttrType : uint8_t {
+  // Attributes we don't care about. They are not validated.
+  kUnspec = 0,
+  kFlag,
+  kU8,
+  kU16,
+  kU32,
+  kU64,
+  kS8,
+  kS32,
+  kString,
+  kBinary,
+  kNested,
+};
+
+// Describes the expected payload of an attribute.
+struct NL80211AttrPolicy {
+  int id;
+  NL80211AttrType type;
+  // Maximum payload length of a kString or kBinary attribute.
+  // 0 means there is no limit.
+  uint16_t len;
+};
+
+// Policies of an attribute set indexed by attribute id, like the policy
+// arrays used by kernel.
+template <int kMaxAttributeId>
+struct NL80211PolicyTable {
+  NL80211AttrPolicy policies[kMaxAttributeId + 1];
+};
+
+// Builds a NL80211PolicyTable from a list of policies at compile time.
+// Attributes not in the list are left as kUnspec.
+template <int kMaxAttributeId>
+constexpr NL80211PolicyTable<kMaxAttributeId> MakePolicyTable(
+    std::initializer_list<NL80211AttrPolicy> policies) {
+  NL80211PolicyTable<kMaxAttributeId> table{};
+  for (const NL80211AttrPolicy& policy : policies) {
+    table.policies[policy.id] = policy;
+  }
+  return table;
+}
+
+// Maps the C++ type an attribute value is read as to its NL80211AttrType.
+template <typename T>
+struct NL80211AttrTypeOf;
+template <> struct NL80211AttrTypeOf<uint8_t> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kU8;
+};
+template <> struct NL80211AttrTypeOf<uint16_t> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kU16;
+};
+template <> struct NL80211AttrTypeOf<uint32_t> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kU32;
+};
+template <> struct NL80211AttrTypeOf<uint64_t> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kU64;
+};
+template <> struct NL80211AttrTypeOf<int8_t> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kS8;
+};
+template <> struct NL80211AttrTypeOf<int32_t> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kS32;
+};
+template <> struct NL80211AttrTypeOf<std::string> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kString;
+};
+template <> struct NL80211AttrTypeOf<std::vector<uint8_t>> {
+  static constexpr NL80211AttrType kType = NL80211AttrType::kBinary;
+};
+
+// Policies of the attribute sets wificond parses.
+// Each of them provides the maximum attribute id of the set, and a
+// NL80211PolicyTable |kPolicy| for it.
+
+// Attributes within NL80211_ATTR_BSS.
+struct NL80211BssPolicy {
+  static constexpr int kMaxAttributeId = NL80211_BSS_MAX;
+  static constexpr NL80211PolicyTable<kMaxAttributeId> kPolicy =
+      MakePolicyTable<kMaxAttributeId>({
+          {NL80211_BSS_BSSID, NL80211AttrType::kBinary, 6},
+          {NL80211_BSS_FREQUENCY, NL80211AttrType::kU32, 0},
+          {NL80211_BSS_TSF, NL80211AttrType::kU64, 0},
+          {NL80211_BSS_BEACON_INTERVAL, NL80211AttrType::kU16, 0},
+          {NL80211_BSS_CAPABILITY, NL80211AttrType::kU16, 0},
+          {NL80211_BSS_INFORMATION_ELEMENTS, NL80211AttrType::kBinary, 0},
+          {NL80211_BSS_SIGNAL_MBM, NL80211AttrType::kS32, 0},
+          {NL80211_BSS_SIGNAL_UNSPEC, NL80211AttrType::kU8, 0},
+          {NL80211_BSS_STATUS, NL80211AttrType::kU32, 0},
+          {NL80211_BSS_SEEN_MS_AGO, NL80211AttrType::kU32, 0},
+          {NL80211_BSS_BEACON_IES, NL80211AttrType::kBinary, 0},
+          {NL80211_BSS_CHAN_WIDTH, NL80211AttrType::kU32, 0},
+          {NL80211_BSS_BEACON_TSF, NL80211AttrType::kU64, 0},
+          {NL80211_BSS_PRESP_DATA, NL80211AttrType::kFlag, 0},
+          {NL80211_BSS_LAST_SEEN_BOOTTIME, NL80211AttrType::kU64, 0},
+          {NL80211_BSS_PARENT_TSF, NL80211AttrType::kU64, 0},
+          {NL80211_BSS_PARENT_BSSID, NL80211AttrType::kBinary, 6},
+          {NL80211_BSS_CHAIN_SIGNAL, NL80211AttrType::kNested, 0},
+      });
+};
+
+// Attributes within NL80211_ATTR_STA_INFO.
+struct NL80211StaInfoPolicy {
+  static constexpr int kMaxAttributeId = NL80211_STA_INFO_MAX;
+  static constexpr NL80211PolicyTable<kMaxAttributeId> kPolicy =
+      MakePolicyTable<kMaxAttributeId>({
+          {NL80211_STA_INFO_INACTIVE_TIME, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_RX_BYTES, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_TX_BYTES, NL80211AttrType::kU32, 0},
+          // Signal strength in dBm is reported as a signed byte.
+          {NL80211_STA_INFO_SIGNAL, NL80211AttrType::kS8, 0},
+          {NL80211_STA_INFO_TX_BITRATE, NL80211AttrType::kNested, 0},
+          {NL80211_STA_INFO_RX_PACKETS, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_TX_PACKETS, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_TX_RETRIES, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_TX_FAILED, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_SIGNAL_AVG, NL80211AttrType::kS8, 0},
+          {NL80211_STA_INFO_RX_BITRATE, NL80211AttrType::kNested, 0},
+          {NL80211_STA_INFO_CONNECTED_TIME, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_BEACON_LOSS, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_RX_BYTES64, NL80211AttrType::kU64, 0},
+          {NL80211_STA_INFO_TX_BYTES64, NL80211AttrType::kU64, 0},
+          {NL80211_STA_INFO_CHAIN_SIGNAL, NL80211AttrType::kNested, 0},
+          {NL80211_STA_INFO_CHAIN_SIGNAL_AVG, NL80211AttrType::kNested, 0},
+          {NL80211_STA_INFO_EXPECTED_THROUGHPUT, NL80211AttrType::kU32, 0},
+          {NL80211_STA_INFO_RX_DROP_MISC, NL80211AttrType::kU64, 0},
+          {NL80211_STA_INFO_BEACON_RX, NL80211AttrType::kU64, 0},
+          {NL80211_STA_INFO_BEACON_SIGNAL_AVG, NL80211AttrType::kS8, 0},
+      });
+};
+
+// Attributes within NL80211_STA_INFO_TX_BITRATE and
+// NL80211_STA_INFO_RX_BITRATE.
+struct NL80211RateInfoPolicy {
+  static constexpr int kMaxAttributeId = NL80211_RATE_INFO_MAX;
+  static constexpr NL80211PolicyTable<kMaxAttributeId> kPolicy =
+      MakePolicyTable<kMaxAttributeId>({
+          {NL80211_RATE_INFO_BITRATE, NL80211AttrType::kU16, 0},
+          {NL80211_RATE_INFO_MCS, NL80211AttrType::kU8, 0},
+          {NL80211_RATE_INFO_40_MHZ_WIDTH, NL80211AttrType::kFlag, 0},
+          {NL80211_RATE_INFO_SHORT_GI, NL80211AttrType::kFlag, 0},
+          {NL80211_RATE_INFO_BITRATE32, NL80211AttrType::kU32, 0},
+          {NL80211_RATE_INFO_VHT_MCS, NL80211AttrType::kU8, 0},
+          {NL80211_RATE_INFO_VHT_NSS, NL80211AttrType::kU8, 0},
+          {NL80211_RATE_INFO_80_MHZ_WIDTH, NL80211AttrType::kFlag, 0},
+          {NL80211_RATE_INFO_80P80_MHZ_WIDTH, NL80211AttrType::kFlag, 0},
+          {NL80211_RATE_INFO_160_MHZ_WIDTH, NL80211AttrType::kFlag, 0},
+          {NL80211_RATE_INFO_10_MHZ_WIDTH, NL80211AttrType::kFlag, 0},
+          {NL80211_RATE_INFO_5_MHZ_WIDTH, NL80211AttrType::kFlag, 0},
+      });
+};
+
+// Top level attributes of a NL80211_CMD_NEW_WIPHY message.
+struct NL80211WiphyPolicy {
+  static constexpr int kMaxAttributeId = NL80211_ATTR_MAX;
+  static constexpr NL80211PolicyTable<kMaxAttributeId> kPolicy =
+      MakePolicyTable<kMaxAttributeId>({
+          {NL80211_ATTR_WIPHY, NL80211AttrType::kU32, 0},
+          {NL80211_ATTR_WIPHY_NAME, NL80211AttrType::kString, 0},
+          {NL80211_ATTR_WIPHY_BANDS, NL80211AttrType::kNested, 0},
+          {NL80211_ATTR_MAX_NUM_SCAN_SSIDS, NL80211AttrType::kU8, 0},
+          {NL80211_ATTR_MAX_NUM_SCHED_SCAN_SSIDS, NL80211AttrType::kU8, 0},
+          {NL80211_ATTR_MAX_MATCH_SETS, NL80211AttrType::kU8, 0},
+          {NL80211_ATTR_MAX_NUM_SCHED_SCAN_PLANS, NL80211AttrType::kU32, 0},
+          {NL80211_ATTR_MAX_SCAN_PLAN_INTERVAL, NL80211AttrType::kU32, 0},
+          {NL80211_ATTR_MAX_SCAN_PLAN_ITERATIONS, NL80211AttrType::kU32, 0},
+          {NL80211_ATTR_FEATURE_FLAGS, NL80211AttrType::kU32, 0},
+          {NL80211_ATTR_EXT_FEATURES, NL80211AttrType::kBinary, 0},
+      });
+};
+
+// Attributes of a band within NL80211_ATTR_WIPHY_BANDS.
+struct NL80211BandPolicy {
+  static constexpr int kMaxAttributeId = NL80211_BAND_ATTR_MAX;
+  static constexpr NL80211PolicyTable<kMaxAttributeId> kPolicy =
+      MakePolicyTable<kMaxAttributeId>({
+          {NL80211_BAND_ATTR_FREQS, NL80211AttrType::kNested, 0},
+          {NL80211_BAND_ATTR_RATES, NL80211AttrType::kNested, 0},
+      });
+};
+
+// Attributes of a frequency within NL80211_BAND_ATTR_FREQS.
+struct NL80211FrequencyPolicy {
+  static constexpr int kMaxAttributeId = NL80211_FREQUENCY_ATTR_MAX;
+  static constexpr NL80211PolicyTable<kMaxAttributeId> kPolicy =
+      MakePolicyTable<kMaxAttributeId>({
+          {NL80211_FREQUENCY_ATTR_FREQ, NL80211AttrType::kU32, 0},
+          {NL80211_FREQUENCY_ATTR_DISABLED, NL80211AttrType::kFlag, 0},
+          {NL80211_FREQUENCY_ATTR_NO_IR, NL80211AttrType::kFlag, 0},
+          {NL80211_FREQUENCY_ATTR_RADAR, NL80211AttrType::kFlag, 0},
+          {NL80211_FREQUENCY_ATTR_MAX_TX_POWER, NL80211AttrType::kU32, 0},
+          {NL80211_FREQUENCY_ATTR_DFS_STATE, NL80211AttrType::kU32, 0},
+      });
+};
+
+// Checks that the payload of |attribute| is what |policy| describes.
+bool ValidateAttribute(const NL80211AttrView& attribute,
+                       const NL80211AttrPolicy& policy);
+
+// A set of attributes validated against the policy of |Policy|, which is
+// one of the policy structs above.
+// Parse() walks through the attributes once to index them, and then
+// validates the indexed ones.
+// Afterwards values are extracted by attribute id, and the C++ type used
+// for a value is checked against the policy at compile time:
+//
+//   NL80211AttrSet<NL80211BssPolicy> bss;
+//   uint32_t frequency;
+//   if (bss.Parse(bss_attribute) &&
+//       bss.Get<NL80211_BSS_FREQUENCY>(&frequency)) {...}
+//
+// Like NL80211AttrView, this refers to the parsed buffer without owning it.
+template <typename Policy>
+class NL80211AttrSet {
+ public:
+  NL80211AttrSet() = default;
+
+  // Parse the attributes nested within |attribute|.
+  // An attribute which doesn't match its policy is dropped, as if it were
+  // missing. This way a malformed optional attribute doesn't fail the whole
+  // set, while getting a malformed required attribute still fails.
+  // Returns false if the attributes are broken.
+  bool Parse(const NL80211AttrView& attribute) {
+    if (!attribute.IndexAttributes(&index_)) {
+      return false;
+    }
+    Validate();
+    return true;
+  }
+
+  // Parse the top level attributes of |packet|.
+  // Attributes are validated in the same way as above.
+  bool Parse(const NL80211PacketView& packet) {
+    if (!packet.IndexAttributes(&index_)) {
+      return false;
+    }
+    Validate();
+    return true;
+  }
+
+  template <int kId>
+  bool Has() const {
+    CheckId<kId>();
+    return index_.HasAttribute(kId);
+  }
+
+  template <int kId, typename T>
+  bool Get(T* value) const {
+    CheckId<kId>();
+    static_assert(
+        Policy::kPolicy.policies[kId].type == NL80211AttrTypeOf<T>::kType,
+        "Value type doesn't match the policy of attribute");
+    return index_.GetAttributeValue(kId, value);
+  }
+
+  // Get a view of a kNested attribute, which can be parsed by another
+  // NL80211AttrSet.
+  template <int kId>
+  bool GetNested(NL80211AttrView* attribute) const {
+    CheckId<kId>();
+    static_assert(
+        Policy::kPolicy.policies[kId].type == NL80211AttrType::kNested,
+        "Attribute is not nested according to its policy");
+    return index_.GetAttribute(kId, attribute);
+  }
+
+  // Get a view of a kBinary or kString attribute, so that its payload can be
+  // inspected without copying it out.
+  template <int kId>
+  bool GetView(NL80211AttrView* attribute) const {
+    CheckId<kId>();
+    static_assert(
+        Policy::kPolicy.policies[kId].type == NL80211AttrType::kBinary ||
+            Policy::kPolicy.policies[kId].type == NL80211AttrType::kString,
+        "Attribute is neither binary nor string according to its policy");
+    return index_.GetAttribute(kId, attribute);
+  }
+
+ private:
+  template <int kId>
+  static void CheckId() {
+    static_assert(kId > 0 && kId <= Policy::kMaxAttributeId,
+                  "Attribute id is out of the range of policy");
+  }
+
+  void Validate() {
+    for (size_t i = 0; i < index_.GetNumIndexedIds(); i++) {
+      const int id = index_.GetIndexedId(i);
+      const NL80211AttrPolicy& policy = Policy::kPolicy.policies[id];
+      NL80211AttrView attribute;
+      if (policy.type == NL80211AttrType::kUnspec ||
+          !index_.GetAttribute(id, &attribute)) {
+        continue;
+      }
+      if (!ValidateAttribute(attribute, policy)) {
+        LOG(WARNING) << "Drop attribute " << id
+                     << " which doesn't match its policy";
+        index_.RemoveAttribute(id);
+      }
+    }
+  }
+
+  NL80211AttrIndex<Policy::kMaxAttributeId> index_;
+
+  DISALLOW_COPY_AND_ASSIGN(NL80211AttrSet);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_NET_NL80211_POLICY_H_
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_BOUNDED_LRU_MAP_H_
+#define WIFICOND_SCANNING_BOUNDED_LRU_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace wificond {
+
+// Maximum number of networks the scan heuristics remember anything about.
+constexpr size_t kMaxTrackedSsids = 256;
+
+// A map which holds at most |max_size| entries, forgetting the least
+// recently touched ones beyond that.
+// Lookups don't count as touching an entry, so the heuristics built on top
+// of it decide which events keep an entry around.
+template <typename Key, typename Value>
+class BoundedLruMap {
+ public:
+  explicit BoundedLruMap(size_t max_size) : max_size_(max_size) {}
+  ~BoundedLruMap() = default;
+
+  // Returns the value of |key|, or nullptr if there is none.
+  const Value* Find(const Key& key) const {
+    const auto it = values_.find(key);
+    return it == values_.end() ? nullptr : &it->second;
+  }
+  // Returns the value of |key|, inserting a default constructed one if
+  // there is none, and marks it as the most recently touched entry.
+  // This forgets the least recently touched entry if the map is full.
+  Value& Touch(const Key& key) {
+    Value& value = values_[key];
+    auto touched = touch_times_.find(key);
+    if (touched != touch_times_.end()) {
+      keys_by_touch_time_.erase(touched->second);
+      touched->second = ++touch_time_;
+    } else {
+      touched = touch_times_.emplace(key, ++touch_time_).first;
+    }
+    keys_by_touch_time_.emplace(touched->second, key);
+    while (values_.size() > max_size_ &&
+           keys_by_touch_time_.begin()->second != key) {
+      const auto least_recent = keys_by_touch_time_.begin();
+      values_.erase(least_recent->second);
+      touch_times_.erase(least_recent->second);
+      keys_by_touch_time_.erase(least_recent);
+    }
+    return value;
+  }
+  // Returns every entry, ordered by key.
+  const std::map<Key, Value>& GetValues() const { return values_; }
+  size_t size() const { return values_.size(); }
+
+ private:
+  const size_t max_size_;
+  std::map<Key, Value> values_;
+  // Touch times are a counter which increases with every Touch() call.
+  uint64_t touch_time_{0};
+  std::map<Key, uint64_t> touch_times_;
+  std::map<uint64_t, Key> keys_by_touch_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundedLruMap);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_BOUNDED_LRU_MAP_H_
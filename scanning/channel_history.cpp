@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/channel_history.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+using com::android::server::wifi::wificond::NativeScanResult;
+using std::endl;
+using std::map;
+using std::set;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+constexpr size_t ChannelHistory::kMaxChannelsPerSsid;
+
+void ChannelHistory::Update(const vector<NativeScanResult>& scan_results) {
+  num_updates_++;
+  for (const auto& scan_result : scan_results) {
+    // Hidden networks don't advertise their SSID in beacons.
+    if (scan_result.ssid.empty()) {
+      continue;
+    }
+    const auto* known_channels = ssid_channels_.Find(scan_result.ssid);
+    if (known_channels != nullptr) {
+      const auto known = known_channels->find(scan_result.frequency);
+      if (known != known_channels->end() &&
+          scan_result.tsf <= known->second.last_seen_us) {
+        continue;
+      }
+    }
+    auto& ssid_channels = ssid_channels_.Touch(scan_result.ssid);
+    auto it = ssid_channels.emplace(scan_result.frequency,
+                                    ChannelStats{0, 0, 0}).first;
+    it->second.num_sightings++;
+    it->second.last_seen_us = scan_result.tsf;
+    it->second.last_update = num_updates_;
+    channel_occupancy_[scan_result.frequency]++;
+
+    // Drop the channel the network was not seen on for the longest time,
+    // or the least seen one among those.
+    if (ssid_channels.size() > kMaxChannelsPerSsid) {
+      ssid_channels.erase(std::min_element(
+          ssid_channels.begin(), ssid_channels.end(),
+          [](const map<uint32_t, ChannelStats>::value_type& lhs,
+             const map<uint32_t, ChannelStats>::value_type& rhs) {
+            if (lhs.second.last_update != rhs.second.last_update) {
+              return lhs.second.last_update < rhs.second.last_update;
+            }
+            return lhs.second.num_sightings < rhs.second.num_sightings;
+          }));
+    }
+  }
+}
+
+vector<uint32_t> ChannelHistory::GetFrequencies(
+    const vector<vector<uint8_t>>& ssids) const {
+  set<uint32_t> frequencies;
+  for (const auto& ssid : ssids) {
+    const auto* ssid_channels = ssid_channels_.Find(ssid);
+    if (ssid_channels == nullptr) {
+      continue;
+    }
+    for (const auto& channel : *ssid_channels) {
+      frequencies.insert(channel.first);
+    }
+  }
+  return vector<uint32_t>(frequencies.begin(), frequencies.end());
+}
+
+uint32_t ChannelHistory::GetNumSightings(const vector<uint8_t>& ssid) const {
+  const auto* ssid_channels = ssid_channels_.Find(ssid);
+  if (ssid_channels == nullptr) {
+    return 0;
+  }
+  uint32_t num_sightings = 0;
+  for (const auto& channel : *ssid_channels) {
+    num_sightings += channel.second.num_sightings;
+  }
+  return num_sightings;
+}
+
+void ChannelHistory::Dump(stringstream* ss) const {
+  *ss << "Channel history of " << ssid_channels_.size()
+      << " networks" << endl;
+  *ss << "Sightings per frequency:";
+  for (const auto& channel : channel_occupancy_) {
+    *ss << " " << channel.first << ":" << channel.second;
+  }
+  *ss << endl;
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_CHANNEL_HISTORY_H_
+#define WIFICOND_SCANNING_CHANNEL_HISTORY_H_
+
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/scanning/bounded_lru_map.h"
+#include "wificond/scanning/scan_result.h"
+
+namespace android {
+namespace wificond {
+
+// Keeps track of the channels networks were seen on in past scan results,
+// so that scans can be narrowed down to the channels they are likely on.
+// The channels of at most |kMaxTrackedSsids| networks are remembered, and
+// the networks which were not seen for the longest time are forgotten
+// first.
+class ChannelHistory {
+ public:
+  // Maximum number of channels remembered for each SSID.
+  static constexpr size_t kMaxChannelsPerSsid = 4;
+
+  ChannelHistory() = default;
+  ~ChannelHistory() = default;
+
+  // Records the channels of |scan_results|.
+  // A scan result only counts as a new sighting if it was seen later than
+  // the previous sighting of its SSID on the same channel, so the same scan
+  // results can be recorded more than once.
+  void Update(const std::vector<
+      ::com::android::server::wifi::wificond::NativeScanResult>& scan_results);
+  // Returns the frequencies any of |ssids| were recently seen on, in
+  // ascending order.
+  // Returns an empty vector if none of them was ever seen.
+  std::vector<uint32_t> GetFrequencies(
+      const std::vector<std::vector<uint8_t>>& ssids) const;
+  // Returns the number of times |ssid| was seen on any channel.
+  uint32_t GetNumSightings(const std::vector<uint8_t>& ssid) const;
+  // Returns the number of sightings of any network on each frequency.
+  const std::map<uint32_t, uint32_t>& GetChannelOccupancy() const {
+    return channel_occupancy_;
+  }
+  void Dump(std::stringstream* ss) const;
+
+ private:
+  struct ChannelStats {
+    uint32_t num_sightings;
+    // Time the SSID was last seen on the channel, as reported in
+    // NativeScanResult::tsf.
+    uint64_t last_seen_us;
+    // Value of |num_updates_| when the SSID was last seen on the channel.
+    uint64_t last_update;
+  };
+
+  // Channel statistics keyed by SSID, then by frequency.
+  BoundedLruMap<std::vector<uint8_t>, std::map<uint32_t, ChannelStats>>
+      ssid_channels_{kMaxTrackedSsids};
+  // Number of sightings keyed by frequency.
+  std::map<uint32_t, uint32_t> channel_occupancy_;
+  uint64_t num_updates_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(ChannelHistory);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_CHANNEL_HISTORY_H_
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/hidden_ssid_scheduler.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+using std::endl;
+using std::set;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+vector<vector<uint8_t>> HiddenSsidScheduler::Prioritize(
+    const vector<vector<uint8_t>>& ssids) const {
+  vector<vector<uint8_t>> prioritized_ssids;
+  set<vector<uint8_t>> seen_ssids;
+  for (const auto& ssid : ssids) {
+    if (seen_ssids.insert(ssid).second) {
+      prioritized_ssids.push_back(ssid);
+    }
+  }
+  // SSIDs which were never probed are treated as probed at time 0.
+  auto last_probed_ms = [this](const vector<uint8_t>& ssid) -> uint64_t {
+    const uint64_t* timestamp_ms = last_probed_ms_.Find(ssid);
+    return timestamp_ms == nullptr ? 0 : *timestamp_ms;
+  };
+  std::stable_sort(prioritized_ssids.begin(), prioritized_ssids.end(),
+                   [&last_probed_ms](const vector<uint8_t>& lhs,
+                                     const vector<uint8_t>& rhs) {
+                     return last_probed_ms(lhs) < last_probed_ms(rhs);
+                   });
+  return prioritized_ssids;
+}
+
+void HiddenSsidScheduler::MarkProbed(const vector<vector<uint8_t>>& ssids,
+                                     uint64_t timestamp_ms) {
+  // The networks which have not been probed for the longest time are
+  // forgotten first. They are then probed first again if they are still
+  // configured.
+  for (const auto& ssid : ssids) {
+    if (!ssid.empty()) {
+      last_probed_ms_.Touch(ssid) = timestamp_ms;
+    }
+  }
+}
+
+void HiddenSsidScheduler::Dump(stringstream* ss) const {
+  *ss << "Hidden networks last probed (boottime in ms): "
+      << last_probed_ms_.size() << endl;
+  for (const auto& entry : last_probed_ms_.GetValues()) {
+    *ss << "  " << string(entry.first.begin(), entry.first.end())
+        << ": " << entry.second << endl;
+  }
+}
+
+}  // namespace wificond
+}  // namespace android
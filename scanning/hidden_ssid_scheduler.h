@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_HIDDEN_SSID_SCHEDULER_H_
+#define WIFICOND_SCANNING_HIDDEN_SSID_SCHEDULER_H_
+
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/scanning/bounded_lru_map.h"
+
+namespace android {
+namespace wificond {
+
+// Decides which hidden networks are probed by each scan, when there are
+// more of them than a scan request can carry.
+// Hidden networks are ordered by the time they were last probed, so that the
+// ones which were never probed come first, followed by the least recently
+// probed ones. Every hidden network is eventually probed, whether the
+// networks are split into several rounds of a single scan or rotated across
+// successive scheduled scans.
+// The last probe times of at most |kMaxTrackedSsids| networks are
+// remembered.
+class HiddenSsidScheduler {
+ public:
+  HiddenSsidScheduler() = default;
+  ~HiddenSsidScheduler() = default;
+
+  // Returns |ssids| without duplicates, in the order they should be probed.
+  // SSIDs last probed at the same time keep their relative order.
+  std::vector<std::vector<uint8_t>> Prioritize(
+      const std::vector<std::vector<uint8_t>>& ssids) const;
+  // Records that |ssids| were probed at |timestamp_ms|.
+  // Empty (wildcard) SSIDs are ignored.
+  void MarkProbed(const std::vector<std::vector<uint8_t>>& ssids,
+                  uint64_t timestamp_ms);
+  // Returns the time each hidden network was last probed, keyed by SSID.
+  const std::map<std::vector<uint8_t>, uint64_t>& GetLastProbedTimes() const {
+    return last_probed_ms_.GetValues();
+  }
+  void Dump(std::stringstream* ss) const;
+
+ private:
+  BoundedLruMap<std::vector<uint8_t>, uint64_t> last_probed_ms_{
+      kMaxTrackedSsids};
+
+  DISALLOW_COPY_AND_ASSIGN(HiddenSsidScheduler);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_HIDDEN_SSID_SCHEDULER_H_
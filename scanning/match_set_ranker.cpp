@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/match_set_ranker.h"
+
+#include <algorithm>
+#include <string>
+
+using com::android::server::wifi::wificond::PnoNetwork;
+using std::endl;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+constexpr size_t MatchSetRanker::kRotatingMatchSetDivisor;
+
+MatchSetRanker::MatchSetRanker(const ChannelHistory* channel_history)
+    : channel_history_(channel_history) {
+}
+
+vector<PnoNetwork> MatchSetRanker::Select(const vector<PnoNetwork>& networks,
+                                          size_t max_match_sets) const {
+  if (networks.size() <= max_match_sets) {
+    return networks;
+  }
+  // Indices of |networks|, best ranked first.
+  vector<size_t> ranked(networks.size());
+  for (size_t i = 0; i < ranked.size(); i++) {
+    ranked[i] = i;
+  }
+  std::stable_sort(
+      ranked.begin(), ranked.end(),
+      [this, &networks](size_t lhs, size_t rhs) {
+        const PnoNetwork& lhs_network = networks[lhs];
+        const PnoNetwork& rhs_network = networks[rhs];
+        if (lhs_network.priority_ != rhs_network.priority_) {
+          return lhs_network.priority_ > rhs_network.priority_;
+        }
+        uint64_t lhs_connected_ms =
+            GetTime(last_connected_ms_, lhs_network.ssid_);
+        uint64_t rhs_connected_ms =
+            GetTime(last_connected_ms_, rhs_network.ssid_);
+        if (lhs_connected_ms != rhs_connected_ms) {
+          return lhs_connected_ms > rhs_connected_ms;
+        }
+        return channel_history_->GetNumSightings(lhs_network.ssid_) >
+            channel_history_->GetNumSightings(rhs_network.ssid_);
+      });
+
+  // A single match set always goes to the best ranked network.
+  size_t num_rotating = 0;
+  if (max_match_sets > 1) {
+    num_rotating = std::max<size_t>(
+        1, max_match_sets / kRotatingMatchSetDivisor);
+  }
+  size_t num_fixed = max_match_sets - num_rotating;
+  // Lower ranked networks which were never matched come first, followed by
+  // the least recently matched ones.
+  std::stable_sort(
+      ranked.begin() + num_fixed, ranked.end(),
+      [this, &networks](size_t lhs, size_t rhs) {
+        return GetTime(last_matched_ms_, networks[lhs].ssid_) <
+            GetTime(last_matched_ms_, networks[rhs].ssid_);
+      });
+
+  vector<PnoNetwork> selected;
+  for (size_t i = 0; i < max_match_sets; i++) {
+    selected.push_back(networks[ranked[i]]);
+  }
+  return selected;
+}
+
+void MatchSetRanker::RecordConnected(const vector<uint8_t>& ssid,
+                                     uint64_t timestamp_ms) {
+  if (ssid.empty()) {
+    return;
+  }
+  last_connected_ms_.Touch(ssid) = timestamp_ms;
+}
+
+void MatchSetRanker::MarkMatched(const vector<vector<uint8_t>>& ssids,
+                                 uint64_t timestamp_ms) {
+  for (const auto& ssid : ssids) {
+    last_matched_ms_.Touch(ssid) = timestamp_ms;
+  }
+}
+
+void MatchSetRanker::Dump(stringstream* ss) const {
+  *ss << "Networks last connected (boottime in ms): "
+      << last_connected_ms_.size() << endl;
+  for (const auto& entry : last_connected_ms_.GetValues()) {
+    *ss << "  " << string(entry.first.begin(), entry.first.end())
+        << ": " << entry.second << endl;
+  }
+}
+
+uint64_t MatchSetRanker::GetTime(const SsidTimes& times,
+                                 const vector<uint8_t>& ssid) {
+  const uint64_t* time = times.Find(ssid);
+  return time == nullptr ? 0 : *time;
+}
+
+}  // namespace wificond
+}  // namespace android
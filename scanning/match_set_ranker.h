@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_MATCH_SET_RANKER_H_
+#define WIFICOND_SCANNING_MATCH_SET_RANKER_H_
+
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/scanning/bounded_lru_map.h"
+#include "wificond/scanning/channel_history.h"
+#include "wificond/scanning/pno_network.h"
+
+namespace android {
+namespace wificond {
+
+// Decides which pno networks get a match set, when there are more of them
+// than the device supports.
+// Networks are ranked by their priority, then by how recently the device
+// was connected to them, then by how often they were seen in scan results.
+// Most match sets go to the best ranked networks. The remaining ones are
+// rotated among the other networks across pno scans, least recently matched
+// first, so that every network is eventually matched.
+// The connection and match times of at most |kMaxTrackedSsids| networks are
+// remembered.
+class MatchSetRanker {
+ public:
+  // One in this many match sets is rotated among lower ranked networks.
+  static constexpr size_t kRotatingMatchSetDivisor = 4;
+
+  explicit MatchSetRanker(const ChannelHistory* channel_history);
+  ~MatchSetRanker() = default;
+
+  // Returns the networks of |networks| which get one of |max_match_sets|
+  // match sets, best ranked first.
+  // Returns |networks| unchanged if they all fit.
+  std::vector<::com::android::server::wifi::wificond::PnoNetwork> Select(
+      const std::vector<::com::android::server::wifi::wificond::PnoNetwork>&
+          networks,
+      size_t max_match_sets) const;
+  // Records that the device was connected to |ssid| at |timestamp_ms|.
+  void RecordConnected(const std::vector<uint8_t>& ssid,
+                       uint64_t timestamp_ms);
+  // Records that match sets of |ssids| were set up at |timestamp_ms|.
+  void MarkMatched(const std::vector<std::vector<uint8_t>>& ssids,
+                   uint64_t timestamp_ms);
+  void Dump(std::stringstream* ss) const;
+
+ private:
+  typedef BoundedLruMap<std::vector<uint8_t>, uint64_t> SsidTimes;
+  // Returns the time |ssid| is associated with in |times|, or 0.
+  static uint64_t GetTime(const SsidTimes& times,
+                          const std::vector<uint8_t>& ssid);
+
+  const ChannelHistory* const channel_history_;
+  SsidTimes last_connected_ms_{kMaxTrackedSsids};
+  SsidTimes last_matched_ms_{kMaxTrackedSsids};
+
+  DISALLOW_COPY_AND_ASSIGN(MatchSetRanker);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_MATCH_SET_RANKER_H_
@@ -180,7 +180,7 @@ bool OffloadScanManager::VerifyAndConvertHIDLStatus(
 }
 
 bool OffloadScanManager::startScan(
-    uint32_t interval_ms, int32_t rssi_threshold,
+    uint32_t interval_ms, int32_t rssi_threshold_2g, int32_t rssi_threshold_5g,
     const vector<vector<uint8_t>>& scan_ssids,
     const vector<vector<uint8_t>>& match_ssids,
     const vector<uint8_t>& match_security, const vector<uint32_t>& freqs,
@@ -194,7 +194,7 @@ bool OffloadScanManager::startScan(
   ScanParam param =
       OffloadScanUtils::createScanParam(scan_ssids, freqs, interval_ms);
   ScanFilter filter = OffloadScanUtils::createScanFilter(
-      match_ssids, match_security, rssi_threshold);
+      match_ssids, match_security, rssi_threshold_2g, rssi_threshold_5g);
 
   if (!ConfigureScans(param, filter, reason_code)) {
     return false;
@@ -98,7 +98,8 @@ class OffloadScanManager {
    * and subscribeScanResults() APIs. Reason code indicates failure reason.
    */
   virtual bool startScan(
-      uint32_t /* interval_ms */, int32_t /* rssi_threshold */,
+      uint32_t /* interval_ms */, int32_t /* rssi_threshold_2g */,
+      int32_t /* rssi_threshold_5g */,
       const std::vector<std::vector<uint8_t>>& /* scan_ssids */,
       const std::vector<std::vector<uint8_t>>& /* match_ssids */,
       const std::vector<uint8_t>& /* match_security */,
@@ -15,6 +15,8 @@
  */
 #include "wificond/scanning/offload/offload_scan_utils.h"
 
+#include <algorithm>
+
 #include <android-base/logging.h>
 #include <utils/Timers.h>
 
@@ -71,11 +73,11 @@ ScanParam OffloadScanUtils::createScanParam(
 
 ScanFilter OffloadScanUtils::createScanFilter(
     const vector<vector<uint8_t>>& ssids, const vector<uint8_t>& flags,
-    int8_t rssi_threshold) {
+    int8_t rssi_threshold_2g, int8_t rssi_threshold_5g) {
   ScanFilter scan_filter;
   vector<NetworkInfo> nw_info_list;
   size_t i = 0;
-  scan_filter.rssiThreshold = rssi_threshold;
+  scan_filter.rssiThreshold = std::min(rssi_threshold_2g, rssi_threshold_5g);
   // Note that the number of ssids should match the number of security flags
   for (const auto& ssid : ssids) {
     NetworkInfo nw_info;
@@ -48,15 +48,19 @@ class OffloadScanUtils {
   static android::hardware::wifi::offload::V1_0::ScanParam createScanParam(
       const std::vector<std::vector<uint8_t>>& ssid_list,
       const std::vector<uint32_t>& frequency_list, uint32_t scan_interval_ms);
-  /* Creates ScanFilter using ssids, security flags and rssi_threshold
+  /* Creates ScanFilter using ssids, security flags and rssi thresholds
    * The caller must ensure that the number of ssids match the number of
    * security flags, also there must be ordering maintained among the two lists.
    * For eg: (ssid[0], flags[0]) describe the SSID and security settings of one
    * network
+   * ScanFilter has a single rssi threshold for all bands, so the lower one
+   * of |rssi_threshold_2g| and |rssi_threshold_5g| is used to not filter out
+   * networks which pass the threshold of their band.
    */
   static android::hardware::wifi::offload::V1_0::ScanFilter createScanFilter(
       const std::vector<std::vector<uint8_t>>& ssids,
-      const std::vector<uint8_t>& flags, int8_t rssi_threshold);
+      const std::vector<uint8_t>& flags, int8_t rssi_threshold_2g,
+      int8_t rssi_threshold_5g);
   static ::com::android::server::wifi::wificond::NativeScanStats
       convertToNativeScanStats(
           const android::hardware::wifi::offload::V1_0::ScanStats& /* scanStats */);
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/partial_scan_settings.h"
+
+#include <android-base/logging.h>
+
+#include "wificond/parcelable_utils.h"
+
+using android::status_t;
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+status_t PartialScanSettings::writeToParcel(::android::Parcel* parcel) const {
+  RETURN_IF_FAILED(parcel->writeInt32(ssids_.size()));
+  for (const auto& ssid : ssids_) {
+    RETURN_IF_FAILED(parcel->writeByteVector(ssid));
+  }
+  RETURN_IF_FAILED(parcel->writeInt32(full_scan_interval_));
+  return ::android::OK;
+}
+
+status_t PartialScanSettings::readFromParcel(const ::android::Parcel* parcel) {
+  int32_t num_ssids = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&num_ssids));
+  // -1 means a null list, which is mapped to an empty vector.
+  ssids_.clear();
+  for (int i = 0; i < num_ssids; i++) {
+    std::vector<uint8_t> ssid;
+    RETURN_IF_FAILED(parcel->readByteVector(&ssid));
+    ssids_.push_back(std::move(ssid));
+  }
+  RETURN_IF_FAILED(parcel->readInt32(&full_scan_interval_));
+  if (full_scan_interval_ < 0) {
+    LOG(ERROR) << "Unexpected negative full scan interval: "
+               << full_scan_interval_;
+    return ::android::BAD_VALUE;
+  }
+  return ::android::OK;
+}
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_PARTIAL_SCAN_SETTINGS_H_
+#define WIFICOND_SCANNING_PARTIAL_SCAN_SETTINGS_H_
+
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// Settings of partial scans, which only cover the channels saved networks
+// were recently seen on.
+// They are used for single scans requested without any channel.
+class PartialScanSettings : public ::android::Parcelable {
+ public:
+  PartialScanSettings() = default;
+  bool operator==(const PartialScanSettings& rhs) const {
+    return (ssids_ == rhs.ssids_ &&
+            full_scan_interval_ == rhs.full_scan_interval_);
+  }
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // SSIDs of the saved networks.
+  // An empty vector disables partial scans.
+  std::vector<std::vector<uint8_t>> ssids_;
+  // Every |full_scan_interval_|-th scan covers all channels, so that
+  // networks which moved to another channel are found again.
+  // Values below 2 disable partial scans.
+  int32_t full_scan_interval_{0};
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_SCANNING_PARTIAL_SCAN_SETTINGS_H_
@@ -33,13 +33,19 @@ class PnoNetwork : public ::android::Parcelable {
   PnoNetwork() = default;
   bool operator==(const PnoNetwork& rhs) const {
     return is_hidden_ == rhs.is_hidden_ &&
-           ssid_ == rhs.ssid_;
+           ssid_ == rhs.ssid_ &&
+           priority_ == rhs.priority_;
   }
   ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
   ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
 
   bool is_hidden_;
   std::vector<uint8_t> ssid_;
+  // Networks with a higher priority are preferred when there are more
+  // networks than match sets.
+  // This is parcelled by PnoSettings, after all the fields which frameworks
+  // that predate it write.
+  int32_t priority_{0};
 };
 
 }  // namespace wificond
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/pno_scan_planner.h"
+
+#include <algorithm>
+
+#include "android/net/wifi/IWifiScannerImpl.h"
+
+using android::net::wifi::IWifiScannerImpl;
+using com::android::server::wifi::wificond::PnoSettings;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr uint32_t kMsecPerSec = 1000;
+// Factors applied to the slow scan interval.
+constexpr uint32_t kScreenOffSlowdown = 2;
+constexpr uint32_t kStationarySlowdown = 4;
+constexpr uint32_t kLowMobilitySlowdown = 2;
+// Factor applied to the number of fast scans when the device moves a lot.
+constexpr uint32_t kHighMobilityFastScanMultiplier = 2;
+
+}  // namespace
+
+constexpr uint64_t PnoScanPlanner::kRecentNetworkFoundWindowMs;
+
+PnoScanPlanner::PnoScanPlanner(const ScanCapabilities& scan_capabilities)
+    : scan_capabilities_(scan_capabilities),
+      has_found_network_(false),
+      last_network_found_ms_(0) {
+}
+
+SchedScanIntervalSetting PnoScanPlanner::GeneratePlans(
+    const PnoSettings& pno_settings,
+    uint64_t now_ms) const {
+  const uint32_t fast_scan_interval =
+      static_cast<uint32_t>(pno_settings.interval_ms_);
+  const bool found_network_recently = has_found_network_ &&
+      now_ms - last_network_found_ms_ < kRecentNetworkFoundWindowMs;
+
+  uint32_t slowdown = 1;
+  uint32_t fast_scan_iterations = PnoSettings::kFastScanIterations;
+  if (!found_network_recently) {
+    if (!pno_settings.is_screen_on_) {
+      slowdown *= kScreenOffSlowdown;
+    }
+    if (pno_settings.mobility_hint_ ==
+        IWifiScannerImpl::MOBILITY_STATIONARY) {
+      slowdown *= kStationarySlowdown;
+    } else if (pno_settings.mobility_hint_ ==
+               IWifiScannerImpl::MOBILITY_LOW) {
+      slowdown *= kLowMobilitySlowdown;
+    }
+  }
+  if (pno_settings.mobility_hint_ == IWifiScannerImpl::MOBILITY_HIGH) {
+    fast_scan_iterations *= kHighMobilityFastScanMultiplier;
+  }
+
+  const uint64_t max_scan_plan_interval_ms =
+      static_cast<uint64_t>(scan_capabilities_.max_scan_plan_interval) *
+          kMsecPerSec;
+  const uint64_t default_slow_scan_interval =
+      static_cast<uint64_t>(fast_scan_interval) *
+          PnoSettings::kSlowScanIntervalMultiplier;
+  if (scan_capabilities_.max_num_scan_plans < 2 ||
+      scan_capabilities_.max_scan_plan_iterations <
+          PnoSettings::kFastScanIterations ||
+      max_scan_plan_interval_ms < default_slow_scan_interval) {
+    // Device doesn't support the provided scan plans.
+    // Specify single interval instead.
+    // In this case, the driver/firmware is expected to implement back off
+    // logic internally using |pno_settings.interval_ms_| as "fast scan"
+    // interval.
+    return SchedScanIntervalSetting{{}, fast_scan_interval * slowdown};
+  }
+
+  const uint64_t slow_scan_interval = std::min<uint64_t>(
+      default_slow_scan_interval * slowdown, max_scan_plan_interval_ms);
+  const uint32_t n_iterations = std::min(
+      fast_scan_iterations, scan_capabilities_.max_scan_plan_iterations);
+  SchedScanIntervalSetting interval_setting;
+  interval_setting.plans.push_back({fast_scan_interval, n_iterations});
+  // When the hints slow scans down, the last scan plan is reached by
+  // doubling the default slow interval in as many finite scan plans as the
+  // device supports. Without hints, this is the default schedule.
+  uint64_t interval = default_slow_scan_interval;
+  while (interval_setting.plans.size() + 1 <
+             scan_capabilities_.max_num_scan_plans &&
+         interval < slow_scan_interval) {
+    interval_setting.plans.push_back(
+        {static_cast<uint32_t>(interval), n_iterations});
+    interval *= 2;
+  }
+  interval_setting.final_interval_ms =
+      static_cast<uint32_t>(slow_scan_interval);
+  return interval_setting;
+}
+
+void PnoScanPlanner::RecordNetworkFound(uint64_t now_ms) {
+  has_found_network_ = true;
+  last_network_found_ms_ = now_ms;
+}
+
+}  // namespace wificond
+}  // namespace android
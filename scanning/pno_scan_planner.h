@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_PNO_SCAN_PLANNER_H_
+#define WIFICOND_SCANNING_PNO_SCAN_PLANNER_H_
+
+#include <android-base/macros.h>
+
+#include "wificond/net/netlink_utils.h"
+#include "wificond/scanning/pno_settings.h"
+#include "wificond/scanning/scan_utils.h"
+
+namespace android {
+namespace wificond {
+
+// Generates the scan plans of pno scans.
+// Scans start at |PnoSettings::interval_ms_| and then settle on a slow
+// interval, as they do without any hints. Hints adjust the schedule by how
+// likely the network environment is to change, with scans backing off
+// exponentially over as many scan plans as the device supports:
+// - Scans slow down further when the device is stationary or the screen
+//   is off.
+// - Scans stay fast for longer when the device moves a lot.
+// - Scans don't slow down further while pno scans keep finding networks.
+class PnoScanPlanner {
+ public:
+  // Networks found by pno scans within this window keep scans from slowing
+  // down because of the hints.
+  static constexpr uint64_t kRecentNetworkFoundWindowMs = 10 * 60 * 1000;
+
+  explicit PnoScanPlanner(const ScanCapabilities& scan_capabilities);
+  ~PnoScanPlanner() = default;
+
+  // |now_ms| is the current CLOCK_BOOTTIME in milliseconds.
+  SchedScanIntervalSetting GeneratePlans(
+      const ::com::android::server::wifi::wificond::PnoSettings& pno_settings,
+      uint64_t now_ms) const;
+  // Records that a pno scan found networks at |now_ms|.
+  void RecordNetworkFound(uint64_t now_ms);
+
+ private:
+  const ScanCapabilities scan_capabilities_;
+  // CLOCK_BOOTTIME in milliseconds when a pno scan last found networks.
+  // It is only valid if |has_found_network_| is true.
+  bool has_found_network_;
+  uint64_t last_network_found_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(PnoScanPlanner);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_PNO_SCAN_PLANNER_H_
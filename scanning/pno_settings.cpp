@@ -16,10 +16,14 @@
 
 #include "wificond/scanning/pno_settings.h"
 
+#include <limits>
+
 #include <android-base/logging.h>
 
+#include "android/net/wifi/IWifiScannerImpl.h"
 #include "wificond/parcelable_utils.h"
 
+using android::net::wifi::IWifiScannerImpl;
 using android::status_t;
 
 namespace com {
@@ -31,6 +35,13 @@ namespace wificond {
 const uint32_t PnoSettings::kFastScanIterations = 3;
 const uint32_t PnoSettings::kSlowScanIntervalMultiplier = 3;
 
+bool PnoSettings::isValidMobilityHint() const {
+  return (mobility_hint_ == IWifiScannerImpl::MOBILITY_UNKNOWN ||
+          mobility_hint_ == IWifiScannerImpl::MOBILITY_STATIONARY ||
+          mobility_hint_ == IWifiScannerImpl::MOBILITY_LOW ||
+          mobility_hint_ == IWifiScannerImpl::MOBILITY_HIGH);
+}
+
 status_t PnoSettings::writeToParcel(::android::Parcel* parcel) const {
   RETURN_IF_FAILED(parcel->writeInt32(interval_ms_));
   RETURN_IF_FAILED(parcel->writeInt32(min_2g_rssi_));
@@ -42,6 +53,14 @@ status_t PnoSettings::writeToParcel(::android::Parcel* parcel) const {
     RETURN_IF_FAILED(parcel->writeInt32(1));
     RETURN_IF_FAILED(network.writeToParcel(parcel));
   }
+  RETURN_IF_FAILED(parcel->writeInt32(mobility_hint_));
+  RETURN_IF_FAILED(parcel->writeBool(is_screen_on_));
+  RETURN_IF_FAILED(parcel->writeBool(relative_rssi_set_));
+  RETURN_IF_FAILED(parcel->writeInt32(relative_rssi_));
+  RETURN_IF_FAILED(parcel->writeInt32(pno_networks_.size()));
+  for (const auto& network : pno_networks_) {
+    RETURN_IF_FAILED(parcel->writeInt32(network.priority_));
+  }
   return ::android::OK;
 }
 
@@ -66,6 +85,45 @@ status_t PnoSettings::readFromParcel(const ::android::Parcel* parcel) {
     RETURN_IF_FAILED(network.readFromParcel(parcel));
     pno_networks_.push_back(network);
   }
+  // Frameworks which predate the hints don't write them, in which case
+  // pno scans are planned as if there were none.
+  mobility_hint_ = IWifiScannerImpl::MOBILITY_UNKNOWN;
+  is_screen_on_ = true;
+  if (parcel->dataAvail() > 0) {
+    RETURN_IF_FAILED(parcel->readInt32(&mobility_hint_));
+    if (!isValidMobilityHint()) {
+      LOG(ERROR) << "Unexpected mobility hint: " << mobility_hint_;
+      return ::android::BAD_VALUE;
+    }
+    RETURN_IF_FAILED(parcel->readBool(&is_screen_on_));
+  }
+  // Frameworks which predate relative rssi don't write it.
+  relative_rssi_set_ = false;
+  relative_rssi_ = 0;
+  if (parcel->dataAvail() > 0) {
+    RETURN_IF_FAILED(parcel->readBool(&relative_rssi_set_));
+    RETURN_IF_FAILED(parcel->readInt32(&relative_rssi_));
+    if (relative_rssi_ < std::numeric_limits<int8_t>::min() ||
+        relative_rssi_ > std::numeric_limits<int8_t>::max()) {
+      LOG(ERROR) << "Unexpected relative rssi: " << relative_rssi_;
+      return ::android::BAD_VALUE;
+    }
+  }
+  // Network priorities follow everything else, because a network which
+  // isn't the last one in the parcel can't tell whether its priority was
+  // written.
+  if (parcel->dataAvail() > 0) {
+    int32_t num_priorities = 0;
+    RETURN_IF_FAILED(parcel->readInt32(&num_priorities));
+    if (num_priorities != static_cast<int32_t>(pno_networks_.size())) {
+      LOG(ERROR) << "Unexpected number of network priorities: "
+                 << num_priorities;
+      return ::android::BAD_VALUE;
+    }
+    for (auto& network : pno_networks_) {
+      RETURN_IF_FAILED(parcel->readInt32(&network.priority_));
+    }
+  }
   return ::android::OK;
 }
 
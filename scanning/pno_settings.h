@@ -38,11 +38,19 @@ class PnoSettings : public ::android::Parcelable {
   PnoSettings()
       : interval_ms_(0),
         min_2g_rssi_(0),
-        min_5g_rssi_(0) {}
+        min_5g_rssi_(0),
+        mobility_hint_(0),
+        is_screen_on_(true),
+        relative_rssi_set_(false),
+        relative_rssi_(0) {}
   bool operator==(const PnoSettings& rhs) const {
     return (pno_networks_ == rhs.pno_networks_ &&
             min_2g_rssi_ == rhs.min_2g_rssi_ &&
-            min_5g_rssi_ == rhs.min_5g_rssi_);
+            min_5g_rssi_ == rhs.min_5g_rssi_ &&
+            mobility_hint_ == rhs.mobility_hint_ &&
+            is_screen_on_ == rhs.is_screen_on_ &&
+            relative_rssi_set_ == rhs.relative_rssi_set_ &&
+            relative_rssi_ == rhs.relative_rssi_);
   }
   ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
   ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
@@ -51,6 +59,17 @@ class PnoSettings : public ::android::Parcelable {
   int32_t min_2g_rssi_;
   int32_t min_5g_rssi_;
   std::vector<PnoNetwork> pno_networks_;
+  // One of IWifiScannerImpl::MOBILITY_*.
+  int32_t mobility_hint_;
+  bool is_screen_on_;
+  // If |relative_rssi_set_| is true, pno scans only report networks with a
+  // signal at most |relative_rssi_| dB worse than the connected network
+  // while associated. A positive |relative_rssi_| asks for better ones.
+  bool relative_rssi_set_;
+  int32_t relative_rssi_;
+
+ private:
+  bool isValidMobilityHint() const;
 };
 
 }  // namespace wificond
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/scan_latency_stats.h"
+
+#include <algorithm>
+
+#include "android/net/wifi/IWifiScannerImpl.h"
+
+using android::net::wifi::IWifiScannerImpl;
+using std::endl;
+using std::stringstream;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr uint64_t kUsecPerMsec = 1000;
+
+const char* GetScanTypeName(int scan_type) {
+  switch (scan_type) {
+    case IWifiScannerImpl::SCAN_TYPE_LOW_SPAN:
+      return "LOW_SPAN";
+    case IWifiScannerImpl::SCAN_TYPE_LOW_POWER:
+      return "LOW_POWER";
+    case IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY:
+      return "HIGH_ACCURACY";
+    default:
+      return "DEFAULT";
+  }
+}
+
+const char* GetPhaseName(int phase) {
+  switch (phase) {
+    case ScanLatencyStats::kPhaseTrigger:
+      return "trigger";
+    case ScanLatencyStats::kPhaseScan:
+      return "scan";
+    case ScanLatencyStats::kPhaseResultsPending:
+      return "results pending";
+    case ScanLatencyStats::kPhaseDump:
+      return "dump";
+    case ScanLatencyStats::kPhaseParse:
+      return "parse";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace
+
+constexpr size_t LatencyHistogram::kNumBuckets;
+
+void LatencyHistogram::Add(uint64_t latency_us) {
+  size_t bucket = 0;
+  for (uint64_t latency_ms = latency_us / kUsecPerMsec;
+       latency_ms > 0 && bucket < kNumBuckets - 1;
+       latency_ms >>= 1) {
+    bucket++;
+  }
+  buckets_[bucket]++;
+  count_++;
+  sum_us_ += latency_us;
+  max_us_ = std::max(max_us_, latency_us);
+}
+
+void LatencyHistogram::Dump(stringstream* ss) const {
+  if (count_ == 0) {
+    *ss << "count: 0" << endl;
+    return;
+  }
+  *ss << "count: " << count_
+      << ", mean: " << sum_us_ / count_ / kUsecPerMsec << "ms"
+      << ", max: " << max_us_ / kUsecPerMsec << "ms,";
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    if (buckets_[i] == 0) {
+      continue;
+    }
+    if (i == 0) {
+      *ss << " <1ms:";
+    } else if (i == kNumBuckets - 1) {
+      *ss << " >=" << (1 << (i - 1)) << "ms:";
+    } else {
+      *ss << " " << (1 << (i - 1)) << "-" << (1 << i) << "ms:";
+    }
+    *ss << buckets_[i];
+  }
+  *ss << endl;
+}
+
+void ScanLatencyStats::Add(int scan_type, Phase phase, uint64_t latency_us) {
+  histograms_[scan_type][phase].Add(latency_us);
+}
+
+const LatencyHistogram* ScanLatencyStats::GetHistogram(int scan_type,
+                                                       Phase phase) const {
+  const auto it = histograms_.find(scan_type);
+  if (it == histograms_.end()) {
+    return nullptr;
+  }
+  return &it->second[phase];
+}
+
+void ScanLatencyStats::Dump(stringstream* ss) const {
+  *ss << "Single scan latencies:" << endl;
+  for (const auto& histograms : histograms_) {
+    *ss << "  Scan type " << GetScanTypeName(histograms.first) << ":" << endl;
+    for (int phase = 0; phase < kNumPhases; phase++) {
+      *ss << "    " << GetPhaseName(phase) << ": ";
+      histograms.second[phase].Dump(ss);
+    }
+  }
+}
+
+}  // namespace wificond
+}  // namespace android
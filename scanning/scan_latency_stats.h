@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_LATENCY_STATS_H_
+#define WIFICOND_SCANNING_SCAN_LATENCY_STATS_H_
+
+#include <array>
+#include <map>
+#include <sstream>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace wificond {
+
+// Histogram of latencies with power of two millisecond buckets.
+class LatencyHistogram {
+ public:
+  // Bucket 0 holds latencies below 1ms, bucket i holds latencies in
+  // [2^(i-1), 2^i) ms, and the last bucket holds everything above.
+  static constexpr size_t kNumBuckets = 16;
+
+  LatencyHistogram() = default;
+
+  void Add(uint64_t latency_us);
+  uint32_t GetCount() const { return count_; }
+  const std::array<uint32_t, kNumBuckets>& GetBuckets() const {
+    return buckets_;
+  }
+  // Writes the count, mean, max and the non-empty buckets on one line.
+  void Dump(std::stringstream* ss) const;
+
+ private:
+  std::array<uint32_t, kNumBuckets> buckets_{};
+  uint32_t count_{0};
+  uint64_t sum_us_{0};
+  uint64_t max_us_{0};
+};
+
+// Latencies of each phase of single scans, kept per scan type.
+class ScanLatencyStats {
+ public:
+  enum Phase {
+    // From the scan() call to the ACK of NL80211_CMD_TRIGGER_SCAN.
+    kPhaseTrigger = 0,
+    // From the ACK of NL80211_CMD_TRIGGER_SCAN to the
+    // NL80211_CMD_NEW_SCAN_RESULTS notification.
+    kPhaseScan,
+    // From the NL80211_CMD_NEW_SCAN_RESULTS notification to the first read
+    // of the scan results.
+    kPhaseResultsPending,
+    // Duration of the NL80211_CMD_GET_SCAN dump.
+    kPhaseDump,
+    // Duration of parsing the dumped scan results.
+    kPhaseParse,
+    kNumPhases
+  };
+
+  ScanLatencyStats() = default;
+
+  // |scan_type| is one of IWifiScannerImpl::SCAN_TYPE_*.
+  void Add(int scan_type, Phase phase, uint64_t latency_us);
+  // Returns nullptr if no latency was recorded for |scan_type|.
+  const LatencyHistogram* GetHistogram(int scan_type, Phase phase) const;
+  void Dump(std::stringstream* ss) const;
+
+ private:
+  std::map<int, std::array<LatencyHistogram, kNumPhases>> histograms_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanLatencyStats);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_SCANNING_SCAN_LATENCY_STATS_H_
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/scan_result_buffer.h"
+
+#include <fcntl.h>
+#include <linux/if_ether.h>
+#include <linux/memfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <limits>
+
+#include <android-base/logging.h>
+
+#include "wificond/parcelable_utils.h"
+
+using android::base::unique_fd;
+using android::status_t;
+using std::vector;
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+namespace {
+
+struct FlatHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_scan_results;
+  uint32_t reserved;
+};
+static_assert(sizeof(FlatHeader) == 16, "Unexpected padding in FlatHeader");
+
+struct FlatScanResult {
+  uint64_t tsf;
+  uint32_t frequency;
+  int32_t signal_mbm;
+  uint16_t capability;
+  uint8_t associated;
+  uint8_t ssid_length;
+  uint8_t bssid[ETH_ALEN];
+  uint16_t num_radio_chains;
+  uint32_t ie_length;
+};
+static_assert(sizeof(FlatScanResult) == 32,
+              "Unexpected padding in FlatScanResult");
+
+struct FlatRadioChain {
+  int32_t chain_id;
+  int32_t level;
+};
+
+constexpr size_t kFlatScanResultAlignment = 8;
+constexpr char kMemfdName[] = "wificond_scan_results";
+
+size_t AlignScanResultSize(size_t size) {
+  return (size + kFlatScanResultAlignment - 1) &
+      ~(kFlatScanResultAlignment - 1);
+}
+
+size_t GetFlatScanResultSize(const NativeScanResult& scan_result) {
+  return AlignScanResultSize(
+      sizeof(FlatScanResult) +
+      scan_result.radio_chain_infos.size() * sizeof(FlatRadioChain) +
+      scan_result.ssid.size() +
+      scan_result.info_element.size());
+}
+
+void WriteFlatScanResult(const NativeScanResult& scan_result, uint8_t* out) {
+  FlatScanResult flat;
+  flat.tsf = scan_result.tsf;
+  flat.frequency = scan_result.frequency;
+  flat.signal_mbm = scan_result.signal_mbm;
+  flat.capability = scan_result.capability;
+  flat.associated = scan_result.associated ? 1 : 0;
+  flat.ssid_length = scan_result.ssid.size();
+  memcpy(flat.bssid, scan_result.bssid.data(), ETH_ALEN);
+  flat.num_radio_chains = scan_result.radio_chain_infos.size();
+  flat.ie_length = scan_result.info_element.size();
+  memcpy(out, &flat, sizeof(flat));
+  out += sizeof(flat);
+  for (const auto& radio_chain_info : scan_result.radio_chain_infos) {
+    FlatRadioChain radio_chain{radio_chain_info.chain_id,
+                               radio_chain_info.level};
+    memcpy(out, &radio_chain, sizeof(radio_chain));
+    out += sizeof(radio_chain);
+  }
+  memcpy(out, scan_result.ssid.data(), scan_result.ssid.size());
+  out += scan_result.ssid.size();
+  memcpy(out, scan_result.info_element.data(),
+         scan_result.info_element.size());
+}
+
+bool ReadFlatScanResult(const uint8_t* region, size_t region_size,
+                        size_t offset, NativeScanResult* scan_result) {
+  if (offset % kFlatScanResultAlignment != 0 ||
+      offset > region_size ||
+      region_size - offset < sizeof(FlatScanResult)) {
+    LOG(ERROR) << "Invalid scan result offset: " << offset;
+    return false;
+  }
+  FlatScanResult flat;
+  memcpy(&flat, region + offset, sizeof(flat));
+  const size_t variable_size =
+      flat.num_radio_chains * sizeof(FlatRadioChain) +
+      flat.ssid_length + flat.ie_length;
+  if (region_size - offset - sizeof(flat) < variable_size) {
+    LOG(ERROR) << "Scan result at offset " << offset
+               << " exceeds the shared memory region";
+    return false;
+  }
+  const uint8_t* data = region + offset + sizeof(flat);
+  scan_result->tsf = flat.tsf;
+  scan_result->frequency = flat.frequency;
+  scan_result->signal_mbm = flat.signal_mbm;
+  scan_result->capability = flat.capability;
+  scan_result->associated = (flat.associated != 0);
+  scan_result->bssid.assign(flat.bssid, flat.bssid + ETH_ALEN);
+  scan_result->radio_chain_infos.clear();
+  for (uint16_t i = 0; i < flat.num_radio_chains; i++) {
+    FlatRadioChain radio_chain;
+    memcpy(&radio_chain, data, sizeof(radio_chain));
+    data += sizeof(radio_chain);
+    scan_result->radio_chain_infos.emplace_back(radio_chain.chain_id,
+                                                radio_chain.level);
+  }
+  scan_result->ssid.assign(data, data + flat.ssid_length);
+  data += flat.ssid_length;
+  scan_result->info_element.assign(data, data + flat.ie_length);
+  return true;
+}
+
+}  // namespace
+
+status_t NativeScanResultBuffer::writeToParcel(
+    ::android::Parcel* parcel) const {
+  // A leading number 0 means there is no shared memory region.
+  if (fd.get() < 0) {
+    RETURN_IF_FAILED(parcel->writeInt32(0));
+    return ::android::OK;
+  }
+  RETURN_IF_FAILED(parcel->writeInt32(1));
+  RETURN_IF_FAILED(parcel->writeUniqueFileDescriptor(fd));
+  RETURN_IF_FAILED(parcel->writeUint32(size));
+  RETURN_IF_FAILED(parcel->writeInt32(offsets.size()));
+  for (uint32_t offset : offsets) {
+    RETURN_IF_FAILED(parcel->writeUint32(offset));
+  }
+  return ::android::OK;
+}
+
+status_t NativeScanResultBuffer::readFromParcel(
+    const ::android::Parcel* parcel) {
+  fd.reset();
+  size = 0;
+  offsets.clear();
+  int32_t has_region = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&has_region));
+  if (has_region == 0) {
+    return ::android::OK;
+  }
+  RETURN_IF_FAILED(parcel->readUniqueFileDescriptor(&fd));
+  RETURN_IF_FAILED(parcel->readUint32(&size));
+  int32_t num_offsets = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&num_offsets));
+  for (int i = 0; i < num_offsets; i++) {
+    uint32_t offset = 0;
+    RETURN_IF_FAILED(parcel->readUint32(&offset));
+    offsets.push_back(offset);
+  }
+  return ::android::OK;
+}
+
+bool NativeScanResultBuffer::Write(
+    const vector<NativeScanResult>& scan_results) {
+  vector<uint32_t> new_offsets;
+  new_offsets.reserve(scan_results.size());
+  size_t region_size = sizeof(FlatHeader);
+  for (const auto& scan_result : scan_results) {
+    if (scan_result.bssid.size() != ETH_ALEN ||
+        scan_result.ssid.size() > std::numeric_limits<uint8_t>::max() ||
+        scan_result.radio_chain_infos.size() >
+            std::numeric_limits<uint16_t>::max()) {
+      LOG(ERROR) << "Scan result can't be stored in the flat layout";
+      return false;
+    }
+    new_offsets.push_back(region_size);
+    region_size += GetFlatScanResultSize(scan_result);
+    if (region_size > std::numeric_limits<uint32_t>::max()) {
+      LOG(ERROR) << "Scan results are too large for shared memory";
+      return false;
+    }
+  }
+
+  unique_fd new_fd(syscall(__NR_memfd_create, kMemfdName,
+                           MFD_CLOEXEC | MFD_ALLOW_SEALING));
+  if (new_fd.get() < 0) {
+    PLOG(ERROR) << "Failed to create memfd for scan results";
+    return false;
+  }
+  if (ftruncate(new_fd.get(), region_size) != 0) {
+    PLOG(ERROR) << "Failed to resize memfd for scan results";
+    return false;
+  }
+  void* region = mmap(nullptr, region_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, new_fd.get(), 0);
+  if (region == MAP_FAILED) {
+    PLOG(ERROR) << "Failed to map memfd for scan results";
+    return false;
+  }
+  uint8_t* data = static_cast<uint8_t*>(region);
+  FlatHeader header{kMagic, kVersion,
+                    static_cast<uint32_t>(scan_results.size()), 0};
+  memcpy(data, &header, sizeof(header));
+  for (size_t i = 0; i < scan_results.size(); i++) {
+    WriteFlatScanResult(scan_results[i], data + new_offsets[i]);
+  }
+  munmap(region, region_size);
+
+  // Clients map the region read-only, and sealing it guarantees that the
+  // content doesn't change underneath them.
+  if (fcntl(new_fd.get(), F_ADD_SEALS,
+            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+    PLOG(ERROR) << "Failed to seal memfd for scan results";
+    return false;
+  }
+  fd = std::move(new_fd);
+  size = region_size;
+  offsets = std::move(new_offsets);
+  return true;
+}
+
+bool NativeScanResultBuffer::Read(vector<NativeScanResult>* scan_results) const {
+  scan_results->clear();
+  if (fd.get() < 0) {
+    return true;
+  }
+  if (size < sizeof(FlatHeader)) {
+    LOG(ERROR) << "Shared memory region is too small: " << size;
+    return false;
+  }
+  // Touching a mapped page beyond the end of the file raises SIGBUS, so
+  // |size| from the parcel must not exceed the file. The shrink seal keeps
+  // it that way while the region is mapped.
+  const int seals = fcntl(fd.get(), F_GET_SEALS);
+  if (seals < 0 || (seals & F_SEAL_SHRINK) == 0) {
+    LOG(ERROR) << "Shared memory region is not sealed against shrinking";
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd.get(), &file_stat) != 0) {
+    PLOG(ERROR) << "Failed to get size of shared scan results";
+    return false;
+  }
+  if (static_cast<uint64_t>(file_stat.st_size) < size) {
+    LOG(ERROR) << "Shared memory region of " << file_stat.st_size
+               << " bytes is smaller than " << size << " bytes";
+    return false;
+  }
+  void* region = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+  if (region == MAP_FAILED) {
+    PLOG(ERROR) << "Failed to map shared scan results";
+    return false;
+  }
+  const uint8_t* data = static_cast<const uint8_t*>(region);
+  FlatHeader header;
+  memcpy(&header, data, sizeof(header));
+  bool success = true;
+  if (header.magic != kMagic || header.version != kVersion ||
+      header.num_scan_results != offsets.size()) {
+    LOG(ERROR) << "Unexpected shared scan results header";
+    success = false;
+  }
+  for (size_t i = 0; success && i < offsets.size(); i++) {
+    NativeScanResult scan_result;
+    success = ReadFlatScanResult(data, size, offsets[i], &scan_result);
+    scan_results->push_back(std::move(scan_result));
+  }
+  munmap(region, size);
+  if (!success) {
+    scan_results->clear();
+  }
+  return success;
+}
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_BUFFER_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_BUFFER_H_
+
+#include <vector>
+
+#include <android-base/macros.h>
+#include <android-base/unique_fd.h>
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+#include "wificond/scanning/scan_result.h"
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// This is the class to represent scan results stored in a sealed shared
+// memory region, so that they are not marshalled field by field into the
+// binder buffer and are not bound by the binder transaction size limit.
+//
+// The region starts with a header of four little-endian uint32s:
+//   magic (kMagic), version (kVersion), number of scan results, reserved.
+// Each scan result is stored at the 8-byte aligned offset given in
+// |offsets| as a 32-byte fixed part:
+//   uint64 tsf, uint32 frequency, int32 signal_mbm, uint16 capability,
+//   uint8 associated, uint8 ssid length, uint8[6] bssid,
+//   uint16 number of radio chains, uint32 information element length,
+// followed by the radio chains as pairs of int32 chain id and level,
+// the ssid and the information elements.
+class NativeScanResultBuffer : public ::android::Parcelable {
+ public:
+  static constexpr uint32_t kMagic = 0x42525357;  // "WSRB"
+  static constexpr uint32_t kVersion = 1;
+
+  NativeScanResultBuffer() = default;
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // Writes |scan_results| into a new sealed memfd, which replaces the
+  // current one.
+  // Returns true on success.
+  bool Write(const std::vector<NativeScanResult>& scan_results);
+  // Maps the shared memory region and reads scan results out of it.
+  // The region must be sealed against shrinking and hold at least |size|
+  // bytes.
+  // Returns true on success.
+  bool Read(std::vector<NativeScanResult>* scan_results) const;
+
+  // File descriptor of the shared memory region.
+  // It is not valid if no scan results were written.
+  ::android::base::unique_fd fd;
+  // Size of the shared memory region in bytes.
+  uint32_t size{0};
+  // Offset of each scan result in the shared memory region.
+  std::vector<uint32_t> offsets;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NativeScanResultBuffer);
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_BUFFER_H_
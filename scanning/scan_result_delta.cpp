@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/scanning/scan_result_delta.h"
+
+#include <android-base/logging.h>
+
+#include "wificond/parcelable_utils.h"
+
+using android::status_t;
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+status_t NativeScanResultDelta::writeToParcel(::android::Parcel* parcel) const {
+  RETURN_IF_FAILED(parcel->writeInt64(cursor));
+  RETURN_IF_FAILED(parcel->writeInt32(is_full_update ? 1 : 0));
+  RETURN_IF_FAILED(parcel->writeInt32(changed_scan_results.size()));
+  for (const auto& scan_result : changed_scan_results) {
+    // For Java readTypedList():
+    // A leading number 1 means this object is not null.
+    RETURN_IF_FAILED(parcel->writeInt32(1));
+    RETURN_IF_FAILED(scan_result.writeToParcel(parcel));
+  }
+  RETURN_IF_FAILED(parcel->writeInt32(expired_bssids.size()));
+  for (const auto& bssid : expired_bssids) {
+    RETURN_IF_FAILED(parcel->writeByteVector(bssid));
+  }
+  return ::android::OK;
+}
+
+status_t NativeScanResultDelta::readFromParcel(const ::android::Parcel* parcel) {
+  RETURN_IF_FAILED(parcel->readInt64(&cursor));
+  is_full_update = (parcel->readInt32() != 0);
+  int32_t num_scan_results = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&num_scan_results));
+  changed_scan_results.clear();
+  for (int i = 0; i < num_scan_results; i++) {
+    // From Java writeTypedList():
+    // A leading number 1 means this object is not null.
+    // We never expect a 0 or other values here.
+    int32_t leading_number = 0;
+    RETURN_IF_FAILED(parcel->readInt32(&leading_number));
+    if (leading_number != 1) {
+      LOG(ERROR) << "Unexpected leading number before an object: "
+                 << leading_number;
+      return ::android::BAD_VALUE;
+    }
+    NativeScanResult scan_result;
+    RETURN_IF_FAILED(scan_result.readFromParcel(parcel));
+    changed_scan_results.push_back(std::move(scan_result));
+  }
+  int32_t num_bssids = 0;
+  RETURN_IF_FAILED(parcel->readInt32(&num_bssids));
+  expired_bssids.clear();
+  for (int i = 0; i < num_bssids; i++) {
+    std::vector<uint8_t> bssid;
+    RETURN_IF_FAILED(parcel->readByteVector(&bssid));
+    expired_bssids.push_back(std::move(bssid));
+  }
+  return ::android::OK;
+}
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
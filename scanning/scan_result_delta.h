@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_DELTA_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_DELTA_H_
+
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+#include "wificond/scanning/scan_result.h"
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// This is the class to represent the changes to the scan results since a
+// cursor returned by an earlier delta.
+class NativeScanResultDelta : public ::android::Parcelable {
+ public:
+  NativeScanResultDelta() = default;
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // Cursor describing the scan results as of this delta.
+  // It is to be passed in the next request for a delta.
+  int64_t cursor{0};
+  // True if the requested cursor was unknown, in which case
+  // |changed_scan_results| contains all the current scan results and
+  // |expired_bssids| is empty.
+  bool is_full_update{false};
+  // Scan results which were added or changed since the requested cursor.
+  std::vector<NativeScanResult> changed_scan_results;
+  // BSSIDs of the scan results which expired since the requested cursor.
+  std::vector<std::vector<uint8_t>> expired_bssids;
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_DELTA_H_
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_SCANNING_SCAN_RESULT_FILTER_H_
+#define WIFICOND_SCANNING_SCAN_RESULT_FILTER_H_
+
+#include <limits>
+#include <vector>
+
+#include <binder/Parcel.h>
+#include <binder/Parcelable.h>
+
+namespace com {
+namespace android {
+namespace server {
+namespace wifi {
+namespace wificond {
+
+// Criteria a scan result must meet to be returned by
+// IWifiScannerImpl.getFilteredScanResults().
+class ScanResultFilter : public ::android::Parcelable {
+ public:
+  ScanResultFilter() = default;
+  bool operator==(const ScanResultFilter& rhs) const {
+    return (band_mask_ == rhs.band_mask_ &&
+            min_signal_mbm_ == rhs.min_signal_mbm_ &&
+            ssids_ == rhs.ssids_ &&
+            max_age_ms_ == rhs.max_age_ms_ &&
+            max_num_results_ == rhs.max_num_results_);
+  }
+  ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
+  ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
+
+  // Bitmask of IWifiScannerImpl::BAND_* the scan result must be on.
+  // 0 means any band.
+  int32_t band_mask_{0};
+  // Minimum signal strength in mBm.
+  int32_t min_signal_mbm_{std::numeric_limits<int32_t>::min()};
+  // SSIDs the scan result must have one of.
+  // An empty vector means any SSID.
+  std::vector<std::vector<uint8_t>> ssids_;
+  // Maximum time since the BSS was last seen, in milliseconds.
+  // 0 means no limit.
+  int64_t max_age_ms_{0};
+  // Maximum number of scan results to return. Only the ones with the
+  // strongest signal are returned, in descending order of signal strength.
+  // 0 means no limit.
+  int32_t max_num_results_{0};
+};
+
+}  // namespace wificond
+}  // namespace wifi
+}  // namespace server
+}  // namespace android
+}  // namespace com
+
+#endif  // WIFICOND_SCANNING_SCAN_RESULT_FILTER_H_
@@ -17,20 +17,33 @@
 #include "android/net/wifi/IWifiScannerImpl.h"
 #include "wificond/scanning/scan_utils.h"
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 #include <linux/netlink.h>
+#include <string.h>
 
 #include <android-base/logging.h>
 
 #include "wificond/net/kernel-header-latest/nl80211.h"
 #include "wificond/net/netlink_manager.h"
+#include "wificond/net/netlink_utils.h"
 #include "wificond/net/nl80211_packet.h"
+#include "wificond/net/nl80211_policy.h"
 #include "wificond/scanning/scan_result.h"
+#include "wificond/time_utils.h"
 
 using android::net::wifi::IWifiScannerImpl;
 using com::android::server::wifi::wificond::NativeScanResult;
 using com::android::server::wifi::wificond::RadioChainInfo;
+using com::android::server::wifi::wificond::ScanResultFilter;
+using std::make_shared;
+using std::map;
+using std::min;
+using std::pop_heap;
+using std::push_heap;
+using std::sort_heap;
 using std::unique_ptr;
 using std::vector;
 
@@ -40,6 +53,135 @@ namespace {
 
 constexpr uint8_t kElemIdSsid = 0;
 constexpr unsigned int kMsecPerSec = 1000;
+constexpr uint64_t kUsecPerMsec = 1000;
+// The kernel drops a BSS that hasn't been seen for this long, unless we are
+// associated with it (IEEE80211_SCAN_RESULT_EXPIRE).
+constexpr uint64_t kBssExpirationMicroseconds = 30 * 1000 * 1000;
+
+// Finds the SSID element in information elements |ie| of |ie_length| bytes.
+// Returns false if there is no SSID element or the elements are malformed.
+bool FindSsidElement(const uint8_t* ie, size_t ie_length,
+                     const uint8_t** ssid, size_t* ssid_length) {
+  // Information elements are stored in 'TLV' format.
+  // Field:  |   Type     |          Length           |      Value      |
+  // Length: |     1      |             1             |     variable    |
+  // Content:| Element ID | Length of the Value field | Element payload |
+  const uint8_t* end = ie + ie_length;
+  const uint8_t* ptr = ie;
+  // +1 means we must have space for the length field.
+  while (ptr + 1  < end) {
+    uint8_t type = *ptr;
+    uint8_t length = *(ptr + 1);
+    // Length field is invalid.
+    if (ptr + 1 + length >= end) {
+      return false;
+    }
+    // SSID element is found.
+    if (type == kElemIdSsid) {
+      *ssid = ptr + 2;
+      *ssid_length = length;
+      return true;
+    }
+    ptr += 2 + length;
+  }
+  return false;
+}
+
+// Selects the scan results matching a ScanResultFilter as they are parsed,
+// keeping only the ones with the strongest signal if the number of results
+// is limited.
+class ScanResultSelector {
+ public:
+  ScanResultSelector(const ScanResultFilter& filter,
+                     uint64_t now_microseconds)
+      : filter_(filter),
+        now_microseconds_(now_microseconds) {}
+
+  // Returns true if a BSS with these properties can be selected.
+  // This is meant to be checked before the BSS is fully parsed.
+  bool Accepts(uint32_t frequency,
+               int32_t signal_mbm,
+               uint64_t last_seen_since_boot_microseconds) const {
+    if (filter_.band_mask_ != 0 && !IsOnBand(frequency)) {
+      return false;
+    }
+    if (signal_mbm < filter_.min_signal_mbm_) {
+      return false;
+    }
+    if (filter_.max_age_ms_ > 0 &&
+        now_microseconds_ > last_seen_since_boot_microseconds &&
+        now_microseconds_ - last_seen_since_boot_microseconds >
+            static_cast<uint64_t>(filter_.max_age_ms_) * kUsecPerMsec) {
+      return false;
+    }
+    // Don't bother with a BSS that would be dropped right away.
+    if (filter_.max_num_results_ > 0 &&
+        selected_.size() >= static_cast<size_t>(filter_.max_num_results_) &&
+        signal_mbm <= selected_.front().signal_mbm) {
+      return false;
+    }
+    return true;
+  }
+
+  bool AcceptsSsid(const uint8_t* ssid, size_t ssid_length) const {
+    if (filter_.ssids_.empty()) {
+      return true;
+    }
+    for (const auto& allowed_ssid : filter_.ssids_) {
+      if (allowed_ssid.size() == ssid_length &&
+          std::equal(allowed_ssid.begin(), allowed_ssid.end(), ssid)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // |scan_result| must have been accepted.
+  void Add(NativeScanResult scan_result) {
+    selected_.push_back(std::move(scan_result));
+    if (filter_.max_num_results_ == 0) {
+      return;
+    }
+    // |selected_| is a heap with the weakest scan result at the front.
+    push_heap(selected_.begin(), selected_.end(), HasStrongerSignal);
+    if (selected_.size() > static_cast<size_t>(filter_.max_num_results_)) {
+      pop_heap(selected_.begin(), selected_.end(), HasStrongerSignal);
+      selected_.pop_back();
+    }
+  }
+
+  void GetSelected(vector<NativeScanResult>* out_scan_results) {
+    if (filter_.max_num_results_ > 0) {
+      sort_heap(selected_.begin(), selected_.end(), HasStrongerSignal);
+    }
+    for (auto& scan_result : selected_) {
+      out_scan_results->push_back(std::move(scan_result));
+    }
+    selected_.clear();
+  }
+
+ private:
+  static bool HasStrongerSignal(const NativeScanResult& lhs,
+                                const NativeScanResult& rhs) {
+    return lhs.signal_mbm > rhs.signal_mbm;
+  }
+
+  bool IsOnBand(uint32_t frequency) const {
+    if ((filter_.band_mask_ & IWifiScannerImpl::BAND_2_4_GHZ) &&
+        Is2GHzFrequency(frequency)) {
+      return true;
+    }
+    if ((filter_.band_mask_ & IWifiScannerImpl::BAND_5_GHZ) &&
+        Is5GHzFrequency(frequency)) {
+      return true;
+    }
+    return false;
+  }
+
+  const ScanResultFilter& filter_;
+  const uint64_t now_microseconds_;
+  vector<NativeScanResult> selected_;
+};
 
 }  // namespace
 
@@ -55,18 +197,34 @@ ScanUtils::~ScanUtils() {}
 void ScanUtils::SubscribeScanResultNotification(
     uint32_t interface_index,
     OnScanResultsReadyHandler handler) {
-  netlink_manager_->SubscribeScanResultNotification(interface_index, handler);
+  // Scan results are cached only while we are notified of new ones.
+  bss_caches_[interface_index] = BssCache();
+  netlink_manager_->SubscribeScanResultNotification(
+      interface_index,
+      [this, handler](uint32_t interface_index,
+                      bool aborted,
+                      vector<vector<uint8_t>>& ssids,
+                      vector<uint32_t>& frequencies) {
+        // Even an aborted scan may have updated the BSS table.
+        InvalidateScanResultCache(interface_index);
+        handler(interface_index, aborted, ssids, frequencies);
+      });
 }
 
 void ScanUtils::UnsubscribeScanResultNotification(uint32_t interface_index) {
+  bss_caches_.erase(interface_index);
   netlink_manager_->UnsubscribeScanResultNotification(interface_index);
 }
 
 void ScanUtils::SubscribeSchedScanResultNotification(
     uint32_t interface_index,
     OnSchedScanResultsReadyHandler handler) {
-  netlink_manager_->SubscribeSchedScanResultNotification(interface_index,
-                                                         handler);
+  netlink_manager_->SubscribeSchedScanResultNotification(
+      interface_index,
+      [this, handler](uint32_t interface_index, bool scan_stopped) {
+        InvalidateScanResultCache(interface_index);
+        handler(interface_index, scan_stopped);
+      });
 }
 
 void ScanUtils::UnsubscribeSchedScanResultNotification(
@@ -74,8 +232,160 @@ void ScanUtils::UnsubscribeSchedScanResultNotification(
   netlink_manager_->UnsubscribeSchedScanResultNotification(interface_index);
 }
 
+void ScanUtils::InvalidateScanResultCache(uint32_t interface_index) {
+  const auto cache = bss_caches_.find(interface_index);
+  if (cache != bss_caches_.end()) {
+    cache->second.valid = false;
+  }
+}
+
 bool ScanUtils::GetScanResult(uint32_t interface_index,
                               vector<NativeScanResult>* out_scan_results) {
+  return GetFilteredScanResult(interface_index,
+                               ScanResultFilter(),
+                               out_scan_results);
+}
+
+bool ScanUtils::GetFilteredScanResult(
+    uint32_t interface_index,
+    const ScanResultFilter& filter,
+    vector<NativeScanResult>* out_scan_results) {
+  const uint64_t now_microseconds = TimeUtils::GetBoottimeUs();
+  ScanResultSelector selector(filter, now_microseconds);
+  last_dump_timings_.erase(interface_index);
+  const auto cache = bss_caches_.find(interface_index);
+  if (cache == bss_caches_.end() || !cache->second.valid ||
+      now_microseconds >= cache->second.expiry_microseconds) {
+    NL80211Packet get_scan(
+        netlink_manager_->GetFamilyId(),
+        NL80211_CMD_GET_SCAN,
+        netlink_manager_->GetSequenceNumber(),
+        getpid());
+    get_scan.AddFlag(NLM_F_DUMP);
+    NL80211Attr<uint32_t> ifindex(NL80211_ATTR_IFINDEX, interface_index);
+    get_scan.AddAttribute(ifindex);
+
+    // Each BSS is parsed into |selector| or the cache as soon as its message
+    // is received, so the raw packets of the dump are never held at once.
+    BssCache updated_cache;
+    updated_cache.expiry_microseconds =
+        now_microseconds + kBssExpirationMicroseconds;
+    auto select_bss = [&](const NL80211PacketView& packet) {
+      NL80211AttrSet<NL80211BssPolicy> bss;
+      if (!ParseDumpedBss(interface_index, packet, &bss)) {
+        return;
+      }
+      // Check the filter against the attributes in place, so that a BSS
+      // which doesn't match is never copied out of the dump.
+      // A BSS missing any of them is rejected by ParseBss() below.
+      uint32_t frequency;
+      int32_t signal_mbm;
+      uint64_t last_seen_since_boot_microseconds;
+      if (bss.Get<NL80211_BSS_FREQUENCY>(&frequency) &&
+          bss.Get<NL80211_BSS_SIGNAL_MBM>(&signal_mbm) &&
+          GetBssTimestamp(bss, &last_seen_since_boot_microseconds) &&
+          !selector.Accepts(frequency, signal_mbm,
+                            last_seen_since_boot_microseconds)) {
+        return;
+      }
+      NL80211AttrView ie;
+      const uint8_t* ssid;
+      size_t ssid_length;
+      if (!filter.ssids_.empty() &&
+          bss.GetView<NL80211_BSS_INFORMATION_ELEMENTS>(&ie) &&
+          FindSsidElement(ie.GetPayload(), ie.GetPayloadLength(),
+                          &ssid, &ssid_length) &&
+          !selector.AcceptsSsid(ssid, ssid_length)) {
+        return;
+      }
+      NativeScanResult scan_result;
+      if (!ParseBss(bss, &scan_result)) {
+        LOG(DEBUG) << "Ignore invalid scan result";
+        return;
+      }
+      selector.Add(std::move(scan_result));
+    };
+    size_t num_messages = 0;
+    uint64_t parse_microseconds = 0;
+    // An error or an interrupted dump leaves an incomplete BSS table, which
+    // must not be cached.
+    bool dump_failed = false;
+    auto handler = [&](const NL80211PacketView& packet) {
+      const uint64_t parse_start_microseconds = TimeUtils::GetBoottimeUs();
+      num_messages++;
+      if (packet.GetMessageType() == NLMSG_ERROR) {
+        LOG(ERROR) << "Receive ERROR message: "
+                   << strerror(packet.GetErrorCode());
+        dump_failed = true;
+        return;
+      }
+      if (packet.GetFlags() & NLM_F_DUMP_INTR) {
+        LOG(ERROR) << "NL80211_CMD_GET_SCAN dump was interrupted";
+        dump_failed = true;
+      }
+      if (dump_failed) {
+        return;
+      }
+      if (cache == bss_caches_.end()) {
+        select_bss(packet);
+      } else {
+        AddDumpedBssToCache(interface_index, packet, &cache->second,
+                            &updated_cache);
+      }
+      parse_microseconds +=
+          TimeUtils::GetBoottimeUs() - parse_start_microseconds;
+    };
+    if (!netlink_manager_->SendMessageAndHandleResponses(get_scan, handler) ||
+        dump_failed) {
+      LOG(ERROR) << "NL80211_CMD_GET_SCAN dump failed";
+      if (cache != bss_caches_.end()) {
+        // Some cached results may have been moved out already.
+        cache->second = BssCache();
+      }
+      return false;
+    }
+    if (num_messages == 0) {
+      LOG(INFO) << "Unexpected empty scan result!";
+    }
+    ScanResultDumpTiming& timing = last_dump_timings_[interface_index];
+    timing.dump_us =
+        TimeUtils::GetBoottimeUs() - now_microseconds - parse_microseconds;
+    timing.parse_us = parse_microseconds;
+
+    if (cache == bss_caches_.end()) {
+      selector.GetSelected(out_scan_results);
+      return true;
+    }
+    updated_cache.valid = true;
+    cache->second = std::move(updated_cache);
+  }
+
+  for (const auto& bss : cache->second.bss) {
+    const NativeScanResult& scan_result = bss.second;
+    if (selector.Accepts(scan_result.frequency,
+                         scan_result.signal_mbm,
+                         scan_result.tsf) &&
+        selector.AcceptsSsid(scan_result.ssid.data(),
+                             scan_result.ssid.size())) {
+      selector.Add(scan_result);
+    }
+  }
+  selector.GetSelected(out_scan_results);
+  return true;
+}
+
+bool ScanUtils::GetLastDumpTiming(uint32_t interface_index,
+                                  ScanResultDumpTiming* timing) const {
+  const auto it = last_dump_timings_.find(interface_index);
+  if (it == last_dump_timings_.end()) {
+    return false;
+  }
+  *timing = it->second;
+  return true;
+}
+
+bool ScanUtils::GetScanResultAsync(uint32_t interface_index,
+                                   OnScanResultsDumpedHandler handler) {
   NL80211Packet get_scan(
       netlink_manager_->GetFamilyId(),
       NL80211_CMD_GET_SCAN,
@@ -85,130 +395,237 @@ bool ScanUtils::GetScanResult(uint32_t interface_index,
   NL80211Attr<uint32_t> ifindex(NL80211_ATTR_IFINDEX, interface_index);
   get_scan.AddAttribute(ifindex);
 
-  vector<unique_ptr<const NL80211Packet>> response;
-  if (!netlink_manager_->SendMessageAndGetResponses(get_scan, &response))  {
-    LOG(ERROR) << "NL80211_CMD_GET_SCAN dump failed";
+  auto scan_results = make_shared<vector<NativeScanResult>>();
+  auto message_handler =
+      [this, interface_index, scan_results](
+          const NL80211PacketView& packet) {
+    NativeScanResult scan_result;
+    if (ParseDumpedScanResult(interface_index, packet, &scan_result)) {
+      scan_results->push_back(std::move(scan_result));
+    }
+  };
+  auto complete_handler =
+      [scan_results, handler](DumpResult result, int error_code) {
+    if (result == DUMP_ERROR) {
+      LOG(ERROR) << "NL80211_CMD_GET_SCAN dump failed: "
+                 << strerror(error_code);
+    }
+    handler(result == DUMP_DONE, *scan_results);
+  };
+  if (!netlink_manager_->RegisterHandlerAndSendDumpMessage(
+          get_scan, message_handler, complete_handler)) {
+    LOG(ERROR) << "Failed to send NL80211_CMD_GET_SCAN dump request";
     return false;
   }
-  if (response.empty()) {
-    LOG(INFO) << "Unexpected empty scan result!";
-    return true;
-  }
+  return true;
+}
 
-  for (auto& packet : response) {
-    if (packet->GetMessageType() == NLMSG_ERROR) {
-      LOG(ERROR) << "Receive ERROR message: "
-                 << strerror(packet->GetErrorCode());
-      continue;
-    }
-    if (packet->GetMessageType() != netlink_manager_->GetFamilyId()) {
-      LOG(ERROR) << "Wrong message type: "
-                 << packet->GetMessageType();
-      continue;
-    }
-    uint32_t if_index;
-    if (!packet->GetAttributeValue(NL80211_ATTR_IFINDEX, &if_index)) {
-      LOG(ERROR) << "No interface index in scan result.";
-      continue;
-    }
-    if (if_index != interface_index) {
-      LOG(WARNING) << "Uninteresting scan result for interface: " << if_index;
-      continue;
+void ScanUtils::AddDumpedBssToCache(uint32_t interface_index,
+                                    const NL80211PacketView& packet,
+                                    BssCache* cache,
+                                    BssCache* updated_cache) {
+  NL80211AttrSet<NL80211BssPolicy> bss;
+  if (!ParseDumpedBss(interface_index, packet, &bss)) {
+    return;
+  }
+  // If the generation is unchanged, so are the cached BSSs, except for
+  // their status.
+  updated_cache->has_generation = packet.GetAttributeValue(
+      NL80211_ATTR_GENERATION, &updated_cache->generation);
+  bool same_generation = updated_cache->has_generation &&
+      cache->has_generation &&
+      updated_cache->generation == cache->generation;
+  vector<uint8_t> bssid;
+  if (!bss.Get<NL80211_BSS_BSSID>(&bssid)) {
+    LOG(ERROR) << "Failed to get BSSID from scan result packet";
+    return;
+  }
+  NativeScanResult scan_result;
+  const auto cached = cache->bss.find(bssid);
+  if (cached != cache->bss.end() &&
+      IsCachedBssUpToDate(bss, same_generation, cached->second)) {
+    scan_result = std::move(cached->second);
+  } else if (!ParseBss(bss, &scan_result)) {
+    LOG(DEBUG) << "Ignore invalid scan result";
+    return;
+  }
+  if (!scan_result.associated) {
+    uint64_t last_seen_since_boot_nanoseconds;
+    if (bss.Get<NL80211_BSS_LAST_SEEN_BOOTTIME>(
+            &last_seen_since_boot_nanoseconds)) {
+      updated_cache->expiry_microseconds = min(
+          updated_cache->expiry_microseconds,
+          last_seen_since_boot_nanoseconds / 1000 +
+              kBssExpirationMicroseconds);
     }
+  }
+  updated_cache->bss[bssid] = std::move(scan_result);
+}
 
-    NativeScanResult scan_result;
-    if (!ParseScanResult(std::move(packet), &scan_result)) {
-      LOG(DEBUG) << "Ignore invalid scan result";
-      continue;
-    }
-    out_scan_results->push_back(std::move(scan_result));
+bool ScanUtils::IsCachedBssUpToDate(const NL80211AttrSet<NL80211BssPolicy>& bss,
+                                    bool same_generation,
+                                    const NativeScanResult& scan_result) {
+  // The status of a BSS isn't covered by the generation number.
+  uint32_t bss_status;
+  bool associated =
+      bss.Get<NL80211_BSS_STATUS>(&bss_status) &&
+      (bss_status == NL80211_BSS_STATUS_AUTHENTICATED ||
+          bss_status == NL80211_BSS_STATUS_ASSOCIATED);
+  if (associated != scan_result.associated) {
+    return false;
+  }
+  if (same_generation) {
+    return true;
+  }
+  uint64_t last_seen_since_boot_microseconds;
+  if (!GetBssTimestamp(bss, &last_seen_since_boot_microseconds) ||
+      last_seen_since_boot_microseconds != scan_result.tsf) {
+    return false;
+  }
+  // Compare the IEs in place to avoid copying them out of the packet.
+  NL80211AttrView ie;
+  return bss.GetView<NL80211_BSS_INFORMATION_ELEMENTS>(&ie) &&
+      ie.GetPayloadLength() == scan_result.info_element.size() &&
+      memcmp(ie.GetPayload(), scan_result.info_element.data(),
+             ie.GetPayloadLength()) == 0;
+}
+
+bool ScanUtils::ParseDumpedScanResult(uint32_t interface_index,
+                                      const NL80211PacketView& packet,
+                                      NativeScanResult* scan_result) {
+  NL80211AttrSet<NL80211BssPolicy> bss;
+  if (!ParseDumpedBss(interface_index, packet, &bss)) {
+    return false;
+  }
+  if (!ParseBss(bss, scan_result)) {
+    LOG(DEBUG) << "Ignore invalid scan result";
+    return false;
   }
   return true;
 }
 
-bool ScanUtils::ParseScanResult(unique_ptr<const NL80211Packet> packet,
-                                NativeScanResult* scan_result) {
-  if (packet->GetCommand() != NL80211_CMD_NEW_SCAN_RESULTS) {
+bool ScanUtils::ParseDumpedBss(uint32_t interface_index,
+                               const NL80211PacketView& packet,
+                               NL80211AttrSet<NL80211BssPolicy>* bss) {
+  if (packet.GetMessageType() == NLMSG_ERROR) {
+    LOG(ERROR) << "Receive ERROR message: "
+               << strerror(packet.GetErrorCode());
+    return false;
+  }
+  if (packet.GetMessageType() != netlink_manager_->GetFamilyId()) {
+    LOG(ERROR) << "Wrong message type: "
+               << packet.GetMessageType();
+    return false;
+  }
+  uint32_t if_index;
+  if (!packet.GetAttributeValue(NL80211_ATTR_IFINDEX, &if_index)) {
+    LOG(ERROR) << "No interface index in scan result.";
+    return false;
+  }
+  if (if_index != interface_index) {
+    LOG(WARNING) << "Uninteresting scan result for interface: " << if_index;
+    return false;
+  }
+  if (packet.GetCommand() != NL80211_CMD_NEW_SCAN_RESULTS) {
     LOG(ERROR) << "Wrong command command for new scan result message";
     return false;
   }
-  NL80211NestedAttr bss(0);
-  if (packet->GetAttribute(NL80211_ATTR_BSS, &bss)) {
-    vector<uint8_t> bssid;
-    if (!bss.GetAttributeValue(NL80211_BSS_BSSID, &bssid)) {
-      LOG(ERROR) << "Failed to get BSSID from scan result packet";
-      return false;
-    }
-    uint32_t freq;
-    if (!bss.GetAttributeValue(NL80211_BSS_FREQUENCY, &freq)) {
-      LOG(ERROR) << "Failed to get Frequency from scan result packet";
-      return false;
-    }
-    vector<uint8_t> ie;
-    if (!bss.GetAttributeValue(NL80211_BSS_INFORMATION_ELEMENTS, &ie)) {
-      LOG(ERROR) << "Failed to get Information Element from scan result packet";
-      return false;
-    }
-    vector<uint8_t> ssid;
-    if (!GetSSIDFromInfoElement(ie, &ssid)) {
-      // Skip BSS without SSID IE.
-      // These scan results are considered as malformed.
-      return false;
-    }
-    uint64_t last_seen_since_boot_microseconds;
-    if (!GetBssTimestamp(bss, &last_seen_since_boot_microseconds)) {
-      // Logging is done inside |GetBssTimestamp|.
-      return false;
-    }
-    int32_t signal;
-    if (!bss.GetAttributeValue(NL80211_BSS_SIGNAL_MBM, &signal)) {
-      LOG(ERROR) << "Failed to get Signal Strength from scan result packet";
-      return false;
-    }
-    uint16_t capability;
-    if (!bss.GetAttributeValue(NL80211_BSS_CAPABILITY, &capability)) {
-      LOG(ERROR) << "Failed to get capability field from scan result packet";
-      return false;
-    }
-    bool associated = false;
-    uint32_t bss_status;
-    if (bss.GetAttributeValue(NL80211_BSS_STATUS, &bss_status) &&
-            (bss_status == NL80211_BSS_STATUS_AUTHENTICATED ||
-                bss_status == NL80211_BSS_STATUS_ASSOCIATED)) {
-      associated = true;
-    }
-    std::vector<RadioChainInfo> radio_chain_infos;
-    ParseRadioChainInfos(bss, &radio_chain_infos);
+  // The BSS attribute is parsed in place, without copying it out of |packet|.
+  NL80211AttrView bss_attr;
+  if (!packet.GetAttribute(NL80211_ATTR_BSS, &bss_attr)) {
+    LOG(ERROR) << "No BSS attribute in scan result";
+    return false;
+  }
+  // Index and validate the BSS attributes once, rather than walking
+  // through them for every field.
+  if (!bss->Parse(bss_attr)) {
+    LOG(ERROR) << "Failed to parse BSS attributes from scan result packet";
+    return false;
+  }
+  return true;
+}
 
-    *scan_result =
-        NativeScanResult(ssid, bssid, ie, freq, signal,
-                         last_seen_since_boot_microseconds,
-                         capability, associated, radio_chain_infos);
+bool ScanUtils::ParseBss(const NL80211AttrSet<NL80211BssPolicy>& bss,
+                         NativeScanResult* scan_result) {
+  vector<uint8_t> bssid;
+  if (!bss.Get<NL80211_BSS_BSSID>(&bssid)) {
+    LOG(ERROR) << "Failed to get BSSID from scan result packet";
+    return false;
+  }
+  uint32_t freq;
+  if (!bss.Get<NL80211_BSS_FREQUENCY>(&freq)) {
+    LOG(ERROR) << "Failed to get Frequency from scan result packet";
+    return false;
+  }
+  vector<uint8_t> ie;
+  if (!bss.Get<NL80211_BSS_INFORMATION_ELEMENTS>(&ie)) {
+    LOG(ERROR) << "Failed to get Information Element from scan result packet";
+    return false;
+  }
+  vector<uint8_t> ssid;
+  if (!GetSSIDFromInfoElement(ie, &ssid)) {
+    // Skip BSS without SSID IE.
+    // These scan results are considered as malformed.
+    return false;
+  }
+  uint64_t last_seen_since_boot_microseconds;
+  if (!GetBssTimestamp(bss, &last_seen_since_boot_microseconds)) {
+    // Logging is done inside |GetBssTimestamp|.
+    return false;
+  }
+  int32_t signal;
+  if (!bss.Get<NL80211_BSS_SIGNAL_MBM>(&signal)) {
+    LOG(ERROR) << "Failed to get Signal Strength from scan result packet";
+    return false;
+  }
+  uint16_t capability;
+  if (!bss.Get<NL80211_BSS_CAPABILITY>(&capability)) {
+    LOG(ERROR) << "Failed to get capability field from scan result packet";
+    return false;
   }
+  bool associated = false;
+  uint32_t bss_status;
+  if (bss.Get<NL80211_BSS_STATUS>(&bss_status) &&
+          (bss_status == NL80211_BSS_STATUS_AUTHENTICATED ||
+              bss_status == NL80211_BSS_STATUS_ASSOCIATED)) {
+    associated = true;
+  }
+  std::vector<RadioChainInfo> radio_chain_infos;
+  ParseRadioChainInfos(bss, &radio_chain_infos);
+
+  *scan_result =
+      NativeScanResult(ssid, bssid, ie, freq, signal,
+                       last_seen_since_boot_microseconds,
+                       capability, associated, radio_chain_infos);
   return true;
 }
 
 bool ScanUtils::GetBssTimestampForTesting(
     const NL80211NestedAttr& bss,
     uint64_t* last_seen_since_boot_microseconds){
-  return GetBssTimestamp(bss, last_seen_since_boot_microseconds);
+  NL80211AttrSet<NL80211BssPolicy> bss_attributes;
+  if (!bss_attributes.Parse(NL80211AttrView(bss))) {
+    return false;
+  }
+  return GetBssTimestamp(bss_attributes, last_seen_since_boot_microseconds);
 }
 
-bool ScanUtils::GetBssTimestamp(const NL80211NestedAttr& bss,
-                                uint64_t* last_seen_since_boot_microseconds){
+bool ScanUtils::GetBssTimestamp(
+    const NL80211AttrSet<NL80211BssPolicy>& bss,
+    uint64_t* last_seen_since_boot_microseconds){
   uint64_t last_seen_since_boot_nanoseconds;
-  if (bss.GetAttributeValue(NL80211_BSS_LAST_SEEN_BOOTTIME,
-                            &last_seen_since_boot_nanoseconds)) {
+  if (bss.Get<NL80211_BSS_LAST_SEEN_BOOTTIME>(
+          &last_seen_since_boot_nanoseconds)) {
     *last_seen_since_boot_microseconds = last_seen_since_boot_nanoseconds / 1000;
   } else {
     // Fall back to use TSF if we can't find NL80211_BSS_LAST_SEEN_BOOTTIME
     // attribute.
-    if (!bss.GetAttributeValue(NL80211_BSS_TSF, last_seen_since_boot_microseconds)) {
+    if (!bss.Get<NL80211_BSS_TSF>(last_seen_since_boot_microseconds)) {
       LOG(ERROR) << "Failed to get TSF from scan result packet";
       return false;
     }
     uint64_t beacon_tsf_microseconds;
-    if (bss.GetAttributeValue(NL80211_BSS_BEACON_TSF, &beacon_tsf_microseconds)) {
+    if (bss.Get<NL80211_BSS_BEACON_TSF>(&beacon_tsf_microseconds)) {
       *last_seen_since_boot_microseconds = std::max(*last_seen_since_boot_microseconds,
                                                     beacon_tsf_microseconds);
     }
@@ -217,15 +634,15 @@ bool ScanUtils::GetBssTimestamp(const NL80211NestedAttr& bss,
 }
 
 bool ScanUtils::ParseRadioChainInfos(
-    const NL80211NestedAttr& bss,
+    const NL80211AttrSet<NL80211BssPolicy>& bss,
     std::vector<RadioChainInfo> *radio_chain_infos) {
   *radio_chain_infos = {};
   // Contains a nested array of signal strength attributes: (ChainId, Rssi in dBm)
-  NL80211NestedAttr radio_chain_infos_attr(0);
-  if (!bss.GetAttribute(NL80211_BSS_CHAIN_SIGNAL, &radio_chain_infos_attr)) {
+  NL80211AttrView radio_chain_infos_attr;
+  if (!bss.GetNested<NL80211_BSS_CHAIN_SIGNAL>(&radio_chain_infos_attr)) {
     return false;
   }
-  std::vector<NL80211Attr<int8_t>> radio_chain_infos_attrs;
+  std::vector<NL80211AttrView> radio_chain_infos_attrs;
   if (!radio_chain_infos_attr.GetListOfAttributes(
         &radio_chain_infos_attrs)) {
     LOG(ERROR) << "Failed to get radio chain info attrs within "
@@ -234,8 +651,13 @@ bool ScanUtils::ParseRadioChainInfos(
   }
   for (const auto& attr : radio_chain_infos_attrs) {
     RadioChainInfo radio_chain_info;
+    int8_t level;
+    if (!attr.GetValue(&level)) {
+      LOG(ERROR) << "Invalid signal strength within NL80211_BSS_CHAIN_SIGNAL";
+      return false;
+    }
     radio_chain_info.chain_id = attr.GetAttributeId();
-    radio_chain_info.level = attr.GetValue();
+    radio_chain_info.level = level;
     radio_chain_infos->push_back(radio_chain_info);
   }
   return true;
@@ -243,33 +665,13 @@ bool ScanUtils::ParseRadioChainInfos(
 
 bool ScanUtils::GetSSIDFromInfoElement(const vector<uint8_t>& ie,
                                        vector<uint8_t>* ssid) {
-  // Information elements are stored in 'TLV' format.
-  // Field:  |   Type     |          Length           |      Value      |
-  // Length: |     1      |             1             |     variable    |
-  // Content:| Element ID | Length of the Value field | Element payload |
-  const uint8_t* end = ie.data() + ie.size();
-  const uint8_t* ptr = ie.data();
-  // +1 means we must have space for the length field.
-  while (ptr + 1  < end) {
-    uint8_t type = *ptr;
-    uint8_t length = *(ptr + 1);
-    // Length field is invalid.
-    if (ptr + 1 + length >= end) {
-      return false;
-    }
-    // SSID element is found.
-    if (type == kElemIdSsid) {
-      // SSID is an empty string.
-      if (length == 0) {
-        *ssid = vector<uint8_t>();
-      } else {
-        *ssid = vector<uint8_t>(ptr + 2, ptr + length + 2);
-      }
-      return true;
-    }
-    ptr += 2 + length;
+  const uint8_t* ssid_element;
+  size_t ssid_length;
+  if (!FindSsidElement(ie.data(), ie.size(), &ssid_element, &ssid_length)) {
+    return false;
   }
-  return false;
+  ssid->assign(ssid_element, ssid_element + ssid_length);
+  return true;
 }
 
 bool ScanUtils::Scan(uint32_t interface_index,
@@ -400,12 +802,11 @@ bool ScanUtils::AbortScan(uint32_t interface_index) {
 bool ScanUtils::StartScheduledScan(
     uint32_t interface_index,
     const SchedScanIntervalSetting& interval_setting,
-    int32_t rssi_threshold_2g,
-    int32_t rssi_threshold_5g,
+    const SchedScanRssiSetting& rssi_setting,
     bool request_random_mac,
     bool request_low_power,
     const std::vector<std::vector<uint8_t>>& scan_ssids,
-    const std::vector<std::vector<uint8_t>>& match_ssids,
+    const std::vector<SchedScanMatchSet>& match_sets,
     const std::vector<uint32_t>& freqs,
     int* error_code) {
   NL80211Packet start_sched_scan(
@@ -430,20 +831,29 @@ bool ScanUtils::StartScheduledScan(
   // |     Nested Attributed: id: 0       |    Nested Attributed: id: 1         |      Nested Attr: id: 2     | ... |
   // | MATCH_SSID  | MATCH_RSSI(optional) | MATCH_SSID  | MACTCH_RSSI(optional) | MATCH_RSSI(optinal, global) | ... |
   NL80211NestedAttr scan_match_attr(NL80211_ATTR_SCHED_SCAN_MATCH);
-  for (size_t i = 0; i < match_ssids.size(); i++) {
+  for (size_t i = 0; i < match_sets.size(); i++) {
     NL80211NestedAttr match_group(i);
     match_group.AddAttribute(
-        NL80211Attr<vector<uint8_t>>(NL80211_SCHED_SCAN_MATCH_ATTR_SSID, match_ssids[i]));
+        NL80211Attr<vector<uint8_t>>(NL80211_SCHED_SCAN_MATCH_ATTR_SSID,
+                                     match_sets[i].ssid));
     match_group.AddAttribute(
-        NL80211Attr<int32_t>(NL80211_SCHED_SCAN_MATCH_ATTR_RSSI, rssi_threshold_5g));
+        NL80211Attr<int32_t>(NL80211_SCHED_SCAN_MATCH_ATTR_RSSI,
+                             match_sets[i].rssi_threshold));
     scan_match_attr.AddAttribute(match_group);
   }
   start_sched_scan.AddAttribute(scan_match_attr);
 
-  // We set 5g threshold for default and ajust threshold for 2g band.
+  if (rssi_setting.relative_rssi_set) {
+    start_sched_scan.AddAttribute(
+        NL80211Attr<uint8_t>(NL80211_ATTR_SCHED_SCAN_RELATIVE_RSSI,
+                             static_cast<uint8_t>(rssi_setting.relative_rssi)));
+  }
+  // Adjust 2g band BSSs by the difference of the thresholds, so that they
+  // are compared on equal terms with 5g band BSSs.
   struct nl80211_bss_select_rssi_adjust rssi_adjust;
   rssi_adjust.band = NL80211_BAND_2GHZ;
-  rssi_adjust.delta = static_cast<int8_t>(rssi_threshold_2g - rssi_threshold_5g);
+  rssi_adjust.delta = static_cast<int8_t>(
+      rssi_setting.rssi_threshold_2g - rssi_setting.rssi_threshold_5g);
   NL80211Attr<vector<uint8_t>> rssi_adjust_attr(
       NL80211_ATTR_SCHED_SCAN_RSSI_ADJUST,
       vector<uint8_t>(
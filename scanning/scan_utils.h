@@ -17,12 +17,16 @@
 #ifndef WIFICOND_SCANNING_SCAN_UTILS_H_
 #define WIFICOND_SCANNING_SCAN_UTILS_H_
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <vector>
 
 #include <android-base/macros.h>
 
 #include "wificond/net/netlink_manager.h"
+#include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_filter.h"
 
 namespace com {
 namespace android {
@@ -42,8 +46,32 @@ class RadioChainInfo;
 namespace android {
 namespace wificond {
 
+template <typename Policy>
+class NL80211AttrSet;
+class NL80211AttrView;
+struct NL80211BssPolicy;
 class NL80211NestedAttr;
 class NL80211Packet;
+class NL80211PacketView;
+
+// This describes a type of function handling the end of an asynchronous
+// scan result dump.
+// |success| is false if the dump failed or timed out. Scan results received
+// before that are still included in |scan_results|.
+typedef std::function<void(
+    bool success,
+    std::vector<::com::android::server::wifi::wificond::NativeScanResult>&
+        scan_results)> OnScanResultsDumpedHandler;
+
+// Time spent getting scan results from kernel.
+struct ScanResultDumpTiming {
+  // Time spent waiting for the NL80211_CMD_GET_SCAN dump in microseconds.
+  uint64_t dump_us{0};
+  // Time spent parsing the dumped scan results in microseconds.
+  // Scan results are parsed while the dump is still arriving, so the dump
+  // takes |dump_us| + |parse_us| in total.
+  uint64_t parse_us{0};
+};
 
 struct SchedScanIntervalSetting {
   struct ScanPlan {
@@ -56,6 +84,26 @@ struct SchedScanIntervalSetting {
   uint32_t final_interval_ms{0};
 };
 
+struct SchedScanMatchSet {
+  std::vector<uint8_t> ssid;
+  // Only BSSs of |ssid| with a signal of at least |rssi_threshold| dBm are
+  // reported.
+  int32_t rssi_threshold;
+};
+
+struct SchedScanRssiSetting {
+  // Minimum RSSI thresholds of each band. These are used to prefer 5GHz
+  // BSSs over 2.4GHz ones when comparing them with the connected BSS.
+  int32_t rssi_threshold_2g{0};
+  int32_t rssi_threshold_5g{0};
+  // If |relative_rssi_set| is true, only BSSs with a signal at most
+  // |relative_rssi| dB worse than the connected BSS are reported while
+  // associated.
+  // Requires |supports_relative_rssi_sched_scan|.
+  bool relative_rssi_set{false};
+  int8_t relative_rssi{0};
+};
+
 // Provides scanning helper functions.
 class ScanUtils {
  public:
@@ -65,12 +113,42 @@ class ScanUtils {
   // Send 'get scan results' request to kernel and get the latest scan results.
   // |interface_index| is the index of interface we want to get scan results
   // from.
+  // While there is a scan result notification subscription for the interface,
+  // its results are cached: they are served without a kernel dump until new
+  // scan results are available, or until the kernel would have expired a
+  // cached BSS. When the cache is refreshed, only BSSs whose timestamp, IEs
+  // or status changed are parsed again.
   // A vector of ScanResult object will be returned by |*out_scan_results|.
   // Returns true on success.
   virtual bool GetScanResult(
       uint32_t interface_index,
       std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results);
 
+  // Same as |GetScanResult|, but only returns the scan results matching
+  // |filter|.
+  // Uncached BSSs are checked against |filter| before they are fully parsed,
+  // and the ones that don't match are never copied out of the dump.
+  // Returns true on success.
+  virtual bool GetFilteredScanResult(
+      uint32_t interface_index,
+      const ::com::android::server::wifi::wificond::ScanResultFilter& filter,
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results);
+
+  // Get the time spent by the last GetScanResult() or GetFilteredScanResult()
+  // call of interface |interface_index| dumping and parsing scan results.
+  // Returns false if that call didn't dump scan results from kernel, i.e.
+  // it was served from the cache or it failed.
+  virtual bool GetLastDumpTiming(uint32_t interface_index,
+                                 ScanResultDumpTiming* timing) const;
+
+  // Asynchronous version of |GetScanResult|.
+  // This doesn't block the event loop while kernel is dumping scan results.
+  // Each scan result is parsed as soon as it arrives, and |handler| is run
+  // once the dump ends.
+  // Returns true if the request is successfully sent.
+  virtual bool GetScanResultAsync(uint32_t interface_index,
+                                  OnScanResultsDumpedHandler handler);
+
   // Send scan request to kernel for interface with index |interface_index|.
   // - |request_random_mac| If true, request device/driver to use a random MAC
   // address during scan. Requires |supports_random_mac_sched_scan|
@@ -100,10 +178,7 @@ class ScanUtils {
 
   // Send scan request to kernel for interface with index |interface_index|.
   // - |inteval_ms| is the expected scan interval in milliseconds.
-  // - |rssi_threshold_2g| is the minimum RSSI threshold value as a filter for
-  // 2GHz band.
-  // - |rssi_threshold_5g| is the minimum RSSI threshold value as a filter for
-  // 5GHz band.
+  // - |rssi_setting| describes how BSSs are compared with the connected BSS.
   // - |scan_ssids| is a vector of ssids we request to scan, which is mostly
   // used for hidden networks.
   // - |request_random_mac| If true, request device/driver to use a random MAC
@@ -114,22 +189,21 @@ class ScanUtils {
   // - |scan_ssids| is the list of ssids to actively scan for.
   // If |scan_ssids| is an empty vector, it will do a passive scan.
   // If |scan_ssids| contains an empty string, it will a scan for all ssids.
-  // - |match_ssids| is the list of ssids that we want to add as filters.
+  // - |match_sets| is the list of ssids that we want to add as filters,
+  // along with the minimum RSSI of each of them.
   // - |freqs| is a vector of frequencies we request to scan.
   // If |freqs| is an empty vector, it will scan all supported frequencies.
   // - |error_code| contains the errno kernel replied when this returns false.
-  // Only BSSs match the |match_ssids| and |rssi_threshold| will be returned as
-  // scan results.
+  // Only BSSs match the |match_sets| will be returned as scan results.
   // Returns true on success.
   virtual bool StartScheduledScan(
       uint32_t interface_index,
       const SchedScanIntervalSetting& interval_setting,
-      int32_t rssi_threshold_2g,
-      int32_t rssi_threshold_5g,
+      const SchedScanRssiSetting& rssi_setting,
       bool request_random_mac,
       bool request_low_power,
       const std::vector<std::vector<uint8_t>>& scan_ssids,
-      const std::vector<std::vector<uint8_t>>& match_ssids,
+      const std::vector<SchedScanMatchSet>& match_sets,
       const std::vector<uint32_t>& freqs,
       int* error_code);
 
@@ -176,21 +250,75 @@ class ScanUtils {
   // interface with index |interface_index|.
   virtual void UnsubscribeSchedScanResultNotification(uint32_t interface_index);
 
+  // Mark the cached scan results of interface |interface_index| as stale, so
+  // that the next GetScanResult() call dumps them from kernel.
+  // This is needed when the kernel changes its BSS table without sending a
+  // scan result notification, e.g. the status of a BSS on association.
+  virtual void InvalidateScanResultCache(uint32_t interface_index);
+
  private:
-  bool GetBssTimestamp(const NL80211NestedAttr& bss,
+  // Scan results of an interface as of the last NL80211_CMD_GET_SCAN dump.
+  struct BssCache {
+    // False if the kernel may have changed its BSS table since the last dump.
+    bool valid{false};
+    // NL80211_ATTR_GENERATION of the last dump, if the kernel reported it.
+    // The kernel bumps it whenever a BSS is added, updated or expired.
+    bool has_generation{false};
+    uint32_t generation{0};
+    // CLOCK_BOOTTIME in microseconds at which the kernel expires the oldest
+    // cached BSS.
+    uint64_t expiry_microseconds{0};
+    // Scan results keyed by BSSID.
+    std::map<std::vector<uint8_t>,
+             ::com::android::server::wifi::wificond::NativeScanResult> bss;
+  };
+
+  // Adds the BSS of |packet|, a message of the scan dump of interface
+  // |interface_index|, to |updated_cache|. The result cached in |cache| is
+  // moved over if the BSS is unchanged, and the BSS is parsed otherwise.
+  void AddDumpedBssToCache(uint32_t interface_index,
+                           const NL80211PacketView& packet,
+                           BssCache* cache,
+                           BssCache* updated_cache);
+  // Returns true if |scan_result| still describes |bss|, which is from a dump
+  // of the same generation as |scan_result| if |same_generation| is true.
+  bool IsCachedBssUpToDate(
+      const NL80211AttrSet<NL80211BssPolicy>& bss,
+      bool same_generation,
+      const ::com::android::server::wifi::wificond::NativeScanResult&
+          scan_result);
+  bool GetBssTimestamp(const NL80211AttrSet<NL80211BssPolicy>& bss,
                        uint64_t* last_seen_since_boot_microseconds);
   bool ParseRadioChainInfos(
-      const NL80211NestedAttr& bss,
+      const NL80211AttrSet<NL80211BssPolicy>& bss,
       std::vector<::com::android::server::wifi::wificond::RadioChainInfo>
         *radio_chain_infos);
   bool GetSSIDFromInfoElement(const std::vector<uint8_t>& ie,
                               std::vector<uint8_t>* ssid);
-  // Converts a NL80211_CMD_NEW_SCAN_RESULTS packet to a ScanResult object.
-  bool ParseScanResult(
-      std::unique_ptr<const NL80211Packet> packet,
+  // Checks that |packet| is a scan result of interface |interface_index| in
+  // a scan dump reply, and converts it to a ScanResult object.
+  bool ParseDumpedScanResult(
+      uint32_t interface_index,
+      const NL80211PacketView& packet,
+      ::com::android::server::wifi::wificond::NativeScanResult* scan_result);
+  // Checks that |packet| is a scan result of interface |interface_index| in
+  // a scan dump reply, and parses its BSS attributes into |bss|.
+  bool ParseDumpedBss(uint32_t interface_index,
+                      const NL80211PacketView& packet,
+                      NL80211AttrSet<NL80211BssPolicy>* bss);
+  // Converts the attributes of a BSS to a ScanResult object.
+  bool ParseBss(
+      const NL80211AttrSet<NL80211BssPolicy>& bss,
       ::com::android::server::wifi::wificond::NativeScanResult* scan_result);
 
   NetlinkManager* netlink_manager_;
+  // Scan result caches keyed by interface index. A cache only exists while
+  // the interface has a scan result notification subscription, which is what
+  // keeps it from going stale.
+  std::map<uint32_t, BssCache> bss_caches_;
+  // Timing of the last successful scan result dump keyed by interface index.
+  // An interface is absent if its last scan results were not dumped.
+  std::map<uint32_t, ScanResultDumpTiming> last_dump_timings_;
 
   DISALLOW_COPY_AND_ASSIGN(ScanUtils);
 };
@@ -16,15 +16,18 @@
 
 #include "wificond/scanning/scanner_impl.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include <android-base/logging.h>
 
 #include "wificond/client_interface_impl.h"
+#include "wificond/event_loop.h"
 #include "wificond/scanning/offload/offload_scan_manager.h"
 #include "wificond/scanning/offload/offload_service_utils.h"
 #include "wificond/scanning/scan_utils.h"
+#include "wificond/time_utils.h"
 
 using android::binder::Status;
 using android::net::wifi::IPnoScanEvent;
@@ -33,11 +36,20 @@ using android::net::wifi::IWifiScannerImpl;
 using android::hardware::wifi::offload::V1_0::IOffload;
 using android::sp;
 using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::NativeScanResultBuffer;
+using com::android::server::wifi::wificond::NativeScanResultDelta;
+using com::android::server::wifi::wificond::PartialScanSettings;
 using com::android::server::wifi::wificond::PnoSettings;
+using com::android::server::wifi::wificond::ScanResultFilter;
 using com::android::server::wifi::wificond::SingleScanSettings;
 
+using std::endl;
+using std::map;
 using std::pair;
+using std::set;
 using std::string;
+using std::stringstream;
+using std::unique_ptr;
 using std::vector;
 using std::weak_ptr;
 using std::shared_ptr;
@@ -45,6 +57,8 @@ using std::shared_ptr;
 using namespace std::placeholders;
 
 namespace {
+using android::wificond::Is2GHzFrequency;
+using android::wificond::Is5GHzFrequency;
 using android::wificond::WiphyFeatures;
 bool IsScanTypeSupported(int scan_type, const WiphyFeatures& wiphy_features) {
   switch(scan_type) {
@@ -59,6 +73,51 @@ bool IsScanTypeSupported(int scan_type, const WiphyFeatures& wiphy_features) {
   }
   return {};
 }
+
+// Returns the RSSI threshold of the match set of a network which was
+// recently seen on |frequencies|.
+int32_t GetMatchRssiThreshold(const PnoSettings& pno_settings,
+                              const vector<uint32_t>& frequencies) {
+  bool seen_on_2g = false;
+  bool seen_on_5g = false;
+  for (uint32_t frequency : frequencies) {
+    if (Is2GHzFrequency(frequency)) {
+      seen_on_2g = true;
+    } else if (Is5GHzFrequency(frequency)) {
+      seen_on_5g = true;
+    }
+  }
+  if (seen_on_2g && !seen_on_5g) {
+    return pno_settings.min_2g_rssi_;
+  }
+  if (seen_on_5g && !seen_on_2g) {
+    return pno_settings.min_5g_rssi_;
+  }
+  // A match set applies to every band. Use the lower threshold so that no
+  // BSS passing the threshold of its band is filtered out.
+  return std::min(pno_settings.min_2g_rssi_, pno_settings.min_5g_rssi_);
+}
+
+// Maximum number of expired scan results remembered for computing deltas.
+constexpr size_t kMaxExpiredBssids = 512;
+
+// Scan result generations start from the time since boot in microseconds,
+// so that a cursor from an earlier ScannerImpl instance or wificond process
+// is never mistaken for a cursor of the current one.
+uint64_t GetInitialScanResultsGeneration() {
+  return TimeUtils::GetBoottimeUs();
+}
+
+bool IsSameScanResult(const NativeScanResult& lhs,
+                      const NativeScanResult& rhs) {
+  return lhs.tsf == rhs.tsf &&
+      lhs.signal_mbm == rhs.signal_mbm &&
+      lhs.frequency == rhs.frequency &&
+      lhs.capability == rhs.capability &&
+      lhs.associated == rhs.associated &&
+      lhs.ssid == rhs.ssid &&
+      lhs.info_element == rhs.info_element;
+}
 } // namespace
 
 namespace android {
@@ -69,7 +128,8 @@ ScannerImpl::ScannerImpl(uint32_t interface_index,
                          const WiphyFeatures& wiphy_features,
                          ClientInterfaceImpl* client_interface,
                          ScanUtils* scan_utils,
-                         weak_ptr<OffloadServiceUtils> offload_service_utils)
+                         weak_ptr<OffloadServiceUtils> offload_service_utils,
+                         EventLoop* event_loop)
     : valid_(true),
       scan_started_(false),
       pno_scan_started_(false),
@@ -78,10 +138,24 @@ ScannerImpl::ScannerImpl(uint32_t interface_index,
       pno_scan_results_from_offload_(false),
       interface_index_(interface_index),
       scan_capabilities_(scan_capabilities),
+      pno_scan_planner_(scan_capabilities),
       wiphy_features_(wiphy_features),
       client_interface_(client_interface),
       scan_utils_(scan_utils),
-      scan_event_handler_(nullptr) {
+      event_loop_(event_loop),
+      generation_(new uint64_t(0)),
+      scan_event_handler_(nullptr),
+      num_scan_waiters_(0),
+      scanning_all_channels_(false),
+      ongoing_scan_type_(SCAN_TYPE_DEFAULT),
+      scan_triggered_us_(0),
+      scan_results_pending_read_(false),
+      last_scan_type_(SCAN_TYPE_DEFAULT),
+      scan_results_ready_us_(0),
+      num_scans_since_full_scan_(0),
+      match_set_ranker_(&channel_history_),
+      scan_results_generation_(GetInitialScanResultsGeneration()),
+      min_delta_cursor_(scan_results_generation_) {
   // Subscribe one-shot scan result notification from kernel.
   LOG(INFO) << "subscribe scan result for interface with index: "
             << (int)interface_index_;
@@ -109,6 +183,9 @@ void ScannerImpl::Invalidate() {
             << (int)interface_index_;
   scan_utils_->UnsubscribeScanResultNotification(interface_index_);
   scan_utils_->UnsubscribeSchedScanResultNotification(interface_index_);
+  pending_scan_request_.reset();
+  next_scan_round_.reset();
+  (*generation_)++;
 }
 
 bool ScannerImpl::CheckIsValid() {
@@ -123,12 +200,158 @@ Status ScannerImpl::getScanResults(vector<NativeScanResult>* out_scan_results) {
   if (!CheckIsValid()) {
     return Status::ok();
   }
+  const uint64_t read_start_us = TimeUtils::GetBoottimeUs();
   if (!scan_utils_->GetScanResult(interface_index_, out_scan_results)) {
     LOG(ERROR) << "Failed to get scan results via NL80211";
+    return Status::ok();
   }
+  RecordScanResultsRead(read_start_us);
+  UpdateNetworkHistory(*out_scan_results);
   return Status::ok();
 }
 
+Status ScannerImpl::getFilteredScanResults(
+    const ScanResultFilter& filter,
+    vector<NativeScanResult>* out_scan_results) {
+  if (!CheckIsValid()) {
+    return Status::ok();
+  }
+  const uint64_t read_start_us = TimeUtils::GetBoottimeUs();
+  if (!scan_utils_->GetFilteredScanResult(interface_index_, filter,
+                                          out_scan_results)) {
+    LOG(ERROR) << "Failed to get scan results via NL80211";
+    return Status::ok();
+  }
+  RecordScanResultsRead(read_start_us);
+  UpdateNetworkHistory(*out_scan_results);
+  return Status::ok();
+}
+
+Status ScannerImpl::getScanResultsDelta(
+    int64_t cursor,
+    NativeScanResultDelta* out_scan_result_delta) {
+  // Unless the delta can be computed, clients keep what they have.
+  out_scan_result_delta->cursor = cursor;
+  if (!CheckIsValid()) {
+    return Status::ok();
+  }
+  vector<NativeScanResult> scan_results;
+  const uint64_t read_start_us = TimeUtils::GetBoottimeUs();
+  if (!scan_utils_->GetScanResult(interface_index_, &scan_results)) {
+    LOG(ERROR) << "Failed to get scan results via NL80211";
+    return Status::ok();
+  }
+  RecordScanResultsRead(read_start_us);
+  UpdateNetworkHistory(scan_results);
+  UpdateTrackedScanResults(scan_results);
+
+  const uint64_t requested_cursor = static_cast<uint64_t>(cursor);
+  const bool is_full_update = cursor <= 0 ||
+      requested_cursor < min_delta_cursor_ ||
+      requested_cursor > scan_results_generation_;
+  out_scan_result_delta->cursor = scan_results_generation_;
+  out_scan_result_delta->is_full_update = is_full_update;
+  for (const auto& tracked : tracked_scan_results_) {
+    if (is_full_update || tracked.second.generation > requested_cursor) {
+      out_scan_result_delta->changed_scan_results.push_back(
+          tracked.second.scan_result);
+    }
+  }
+  if (!is_full_update) {
+    for (const auto& expired : expired_bssids_) {
+      if (expired.second > requested_cursor) {
+        out_scan_result_delta->expired_bssids.push_back(expired.first);
+      }
+    }
+  }
+  return Status::ok();
+}
+
+Status ScannerImpl::getScanResultsBuffer(
+    NativeScanResultBuffer* out_scan_result_buffer) {
+  if (!CheckIsValid()) {
+    return Status::ok();
+  }
+  vector<NativeScanResult> scan_results;
+  const uint64_t read_start_us = TimeUtils::GetBoottimeUs();
+  if (!scan_utils_->GetScanResult(interface_index_, &scan_results)) {
+    LOG(ERROR) << "Failed to get scan results via NL80211";
+    return Status::ok();
+  }
+  RecordScanResultsRead(read_start_us);
+  UpdateNetworkHistory(scan_results);
+  if (!out_scan_result_buffer->Write(scan_results)) {
+    LOG(ERROR) << "Failed to write scan results to shared memory";
+    // An empty buffer would read as no scan results at all.
+    return Status::fromServiceSpecificError(
+        IWifiScannerImpl::ERROR_SCAN_RESULTS_BUFFER_UNAVAILABLE);
+  }
+  return Status::ok();
+}
+
+void ScannerImpl::RecordScanResultsRead(uint64_t read_start_us) {
+  if (scan_results_pending_read_) {
+    scan_latency_stats_.Add(last_scan_type_,
+                            ScanLatencyStats::kPhaseResultsPending,
+                            read_start_us - scan_results_ready_us_);
+    scan_results_pending_read_ = false;
+  }
+  ScanResultDumpTiming timing;
+  if (scan_utils_->GetLastDumpTiming(interface_index_, &timing)) {
+    scan_latency_stats_.Add(last_scan_type_, ScanLatencyStats::kPhaseDump,
+                            timing.dump_us);
+    scan_latency_stats_.Add(last_scan_type_, ScanLatencyStats::kPhaseParse,
+                            timing.parse_us);
+  }
+}
+
+void ScannerImpl::UpdateNetworkHistory(
+    const vector<NativeScanResult>& scan_results) {
+  channel_history_.Update(scan_results);
+  for (const auto& scan_result : scan_results) {
+    if (scan_result.associated) {
+      match_set_ranker_.RecordConnected(scan_result.ssid,
+                                        TimeUtils::GetBoottimeMs());
+    }
+  }
+}
+
+void ScannerImpl::UpdateTrackedScanResults(
+    vector<NativeScanResult>& scan_results) {
+  const uint64_t generation = scan_results_generation_ + 1;
+  bool changed = false;
+  map<vector<uint8_t>, TrackedScanResult> updated_scan_results;
+  for (auto& scan_result : scan_results) {
+    vector<uint8_t> bssid = scan_result.bssid;
+    const auto tracked = tracked_scan_results_.find(bssid);
+    if (tracked != tracked_scan_results_.end() &&
+        IsSameScanResult(tracked->second.scan_result, scan_result)) {
+      updated_scan_results[bssid] = std::move(tracked->second);
+      tracked_scan_results_.erase(tracked);
+      continue;
+    }
+    if (tracked != tracked_scan_results_.end()) {
+      tracked_scan_results_.erase(tracked);
+    }
+    expired_bssids_.erase(bssid);
+    updated_scan_results[bssid] = {std::move(scan_result), generation};
+    changed = true;
+  }
+  // Whatever is left was not in |scan_results| any more.
+  for (const auto& tracked : tracked_scan_results_) {
+    expired_bssids_[tracked.first] = generation;
+    changed = true;
+  }
+  tracked_scan_results_.swap(updated_scan_results);
+  if (expired_bssids_.size() > kMaxExpiredBssids) {
+    expired_bssids_.clear();
+    min_delta_cursor_ = generation;
+  }
+  if (changed) {
+    scan_results_generation_ = generation;
+  }
+}
+
 Status ScannerImpl::getPnoScanResults(
     vector<NativeScanResult>* out_scan_results) {
   if (!CheckIsValid()) {
@@ -141,6 +364,8 @@ Status ScannerImpl::getPnoScanResults(
   } else {
     if (!scan_utils_->GetScanResult(interface_index_, out_scan_results)) {
       LOG(ERROR) << "Failed to get scan results via NL80211";
+    } else {
+      UpdateNetworkHistory(*out_scan_results);
     }
   }
   return Status::ok();
@@ -153,48 +378,215 @@ Status ScannerImpl::scan(const SingleScanSettings& scan_settings,
     return Status::ok();
   }
 
+  ScanRequest request = CreateScanRequest(scan_settings);
+  request.request_time_us = TimeUtils::GetBoottimeUs();
+  ApplyPartialScan(&request);
+  if (!DropFreshChannels(scan_settings.max_channel_age_ms_, &request)) {
+    LOG(INFO) << "All channels were scanned recently, "
+              << "skipping scan in favor of cached scan results";
+    // The caller expects the outcome after scan() returns, as with a scan
+    // sent to kernel.
+    weak_ptr<uint64_t> weak_generation = generation_;
+    const uint64_t generation = *generation_;
+    const int num_waiters = request.num_waiters;
+    event_loop_->PostTask(
+        [this, weak_generation, generation, num_waiters]() {
+          shared_ptr<uint64_t> current_generation = weak_generation.lock();
+          if (current_generation == nullptr ||
+              *current_generation != generation) {
+            return;
+          }
+          NotifyScanEvent(false, num_waiters);
+        });
+    *out_success = true;
+    return Status::ok();
+  }
   if (scan_started_) {
-    LOG(WARNING) << "Scan already started";
+    // Kernel would reject another scan with EBUSY. Queue the request and
+    // send it along with any other queued ones once the ongoing scan is done.
+    LOG(INFO) << "Scan already started, queueing the scan request";
+    if (pending_scan_request_ == nullptr) {
+      pending_scan_request_.reset(new ScanRequest(std::move(request)));
+    } else {
+      MergeScanRequest(request, pending_scan_request_.get());
+    }
+    *out_success = true;
+    return Status::ok();
+  }
+  *out_success = StartScan(request);
+  return Status::ok();
+}
+
+Status ScannerImpl::setPartialScanSettings(
+    const PartialScanSettings& settings) {
+  partial_scan_settings_ = settings;
+  num_scans_since_full_scan_ = 0;
+  return Status::ok();
+}
+
+void ScannerImpl::ApplyPartialScan(ScanRequest* request) {
+  if (!request->freqs.empty() ||
+      partial_scan_settings_.ssids_.empty() ||
+      partial_scan_settings_.full_scan_interval_ < 2) {
+    return;
+  }
+  if (++num_scans_since_full_scan_ >=
+      partial_scan_settings_.full_scan_interval_) {
+    LOG(DEBUG) << "Full scan is due";
+    num_scans_since_full_scan_ = 0;
+    return;
+  }
+  vector<vector<uint8_t>> ssids = partial_scan_settings_.ssids_;
+  ssids.insert(ssids.end(),
+               request->hidden_ssids.begin(), request->hidden_ssids.end());
+  vector<uint32_t> freqs = channel_history_.GetFrequencies(ssids);
+  if (freqs.empty()) {
+    LOG(DEBUG) << "No channel history of saved networks, scan all channels";
+    num_scans_since_full_scan_ = 0;
+    return;
+  }
+  LOG(DEBUG) << "Partial scan on " << freqs.size() << " channels";
+  request->freqs.insert(freqs.begin(), freqs.end());
+}
+
+bool ScannerImpl::DropFreshChannels(int32_t max_channel_age_ms,
+                                    ScanRequest* request) {
+  if (max_channel_age_ms <= 0 || !request->hidden_ssids.empty()) {
+    return true;
+  }
+  const set<uint32_t>& freqs =
+      request->freqs.empty() ? all_frequencies_ : request->freqs;
+  if (freqs.empty()) {
+    // Supported channels are not known until all of them are scanned once.
+    return true;
+  }
+  const uint64_t now_ms = TimeUtils::GetBoottimeMs();
+  set<uint32_t> stale_freqs;
+  for (uint32_t freq : freqs) {
+    const auto it = channel_last_scanned_ms_.find(freq);
+    if (it == channel_last_scanned_ms_.end() ||
+        now_ms - it->second > static_cast<uint64_t>(max_channel_age_ms)) {
+      stale_freqs.insert(freq);
+    }
+  }
+  if (stale_freqs.empty()) {
+    return false;
+  }
+  if (stale_freqs.size() < freqs.size()) {
+    LOG(DEBUG) << "Skip " << freqs.size() - stale_freqs.size()
+               << " recently scanned channels";
+    request->freqs = std::move(stale_freqs);
+  }
+  return true;
+}
+
+ScannerImpl::ScanRequest ScannerImpl::CreateScanRequest(
+    const SingleScanSettings& scan_settings) const {
+  ScanRequest request;
+  request.scan_type = scan_settings.scan_type_;
+  for (auto& channel : scan_settings.channel_settings_) {
+    request.freqs.insert(channel.frequency_);
+  }
+  for (auto& network : scan_settings.hidden_networks_) {
+    request.hidden_ssids.push_back(network.ssid_);
   }
+  request.include_wildcard_ssid = true;
+  request.num_waiters = 1;
+  request.request_time_us = 0;
+  return request;
+}
+
+void ScannerImpl::MergeScanRequest(const ScanRequest& request,
+                                   ScanRequest* merged_request) const {
+  // Prefer the scan type whose guarantees are the hardest to give up:
+  // accuracy, then latency, then power.
+  if (request.scan_type != merged_request->scan_type) {
+    if (request.scan_type == SCAN_TYPE_HIGH_ACCURACY ||
+        merged_request->scan_type == SCAN_TYPE_HIGH_ACCURACY) {
+      merged_request->scan_type = SCAN_TYPE_HIGH_ACCURACY;
+    } else if (request.scan_type == SCAN_TYPE_LOW_SPAN ||
+               merged_request->scan_type == SCAN_TYPE_LOW_SPAN) {
+      merged_request->scan_type = SCAN_TYPE_LOW_SPAN;
+    } else {
+      merged_request->scan_type = SCAN_TYPE_LOW_POWER;
+    }
+  }
+  // Scanning all frequencies covers any set of them.
+  if (request.freqs.empty() || merged_request->freqs.empty()) {
+    merged_request->freqs.clear();
+  } else {
+    merged_request->freqs.insert(request.freqs.begin(), request.freqs.end());
+  }
+  for (const auto& ssid : request.hidden_ssids) {
+    if (std::find(merged_request->hidden_ssids.begin(),
+                  merged_request->hidden_ssids.end(),
+                  ssid) == merged_request->hidden_ssids.end()) {
+      merged_request->hidden_ssids.push_back(ssid);
+    }
+  }
+  merged_request->num_waiters += request.num_waiters;
+  merged_request->request_time_us = std::min(merged_request->request_time_us,
+                                             request.request_time_us);
+}
+
+bool ScannerImpl::StartScan(const ScanRequest& request) {
   // Only request MAC address randomization when station is not associated.
   bool request_random_mac =
       wiphy_features_.supports_random_mac_oneshot_scan &&
       !client_interface_->IsAssociated();
-  int scan_type = scan_settings.scan_type_;
-  if (!IsScanTypeSupported(scan_settings.scan_type_, wiphy_features_)) {
+  int scan_type = request.scan_type;
+  if (!IsScanTypeSupported(request.scan_type, wiphy_features_)) {
     LOG(DEBUG) << "Ignoring scan type because device does not support it";
     scan_type = SCAN_TYPE_DEFAULT;
   }
 
-  // Initialize it with an empty ssid for a wild card scan.
-  vector<vector<uint8_t>> ssids = {{}};
+  vector<vector<uint8_t>> ssids;
+  if (request.include_wildcard_ssid) {
+    // An empty ssid for a wild card scan.
+    ssids.push_back({});
+  }
 
-  vector<vector<uint8_t>> skipped_scan_ssids;
-  for (auto& network : scan_settings.hidden_networks_) {
+  // Hidden networks which don't fit in this scan are probed in the next
+  // round, least recently probed ones first.
+  vector<vector<uint8_t>> remaining_ssids;
+  for (auto& ssid : hidden_ssid_scheduler_.Prioritize(request.hidden_ssids)) {
     if (ssids.size() + 1 > scan_capabilities_.max_num_scan_ssids) {
-      skipped_scan_ssids.emplace_back(network.ssid_);
+      remaining_ssids.push_back(std::move(ssid));
       continue;
     }
-    ssids.push_back(network.ssid_);
+    ssids.push_back(std::move(ssid));
   }
-
-  LogSsidList(skipped_scan_ssids, "Skip scan ssid for single scan");
-
-  vector<uint32_t> freqs;
-  for (auto& channel : scan_settings.channel_settings_) {
-    freqs.push_back(channel.frequency_);
+  if (scan_capabilities_.max_num_scan_ssids == 0) {
+    LogSsidList(remaining_ssids, "Skip scan ssid for single scan");
+    remaining_ssids.clear();
+  } else {
+    LogSsidList(remaining_ssids, "Defer scan ssid to next scan round");
   }
 
+  vector<uint32_t> freqs(request.freqs.begin(), request.freqs.end());
+
   int error_code = 0;
   if (!scan_utils_->Scan(interface_index_, request_random_mac, scan_type,
                          ssids, freqs, &error_code)) {
     CHECK(error_code != ENODEV) << "Driver is in a bad state, restarting wificond";
-    *out_success = false;
-    return Status::ok();
+    return false;
   }
   scan_started_ = true;
-  *out_success = true;
-  return Status::ok();
+  num_scan_waiters_ = request.num_waiters;
+  scanning_all_channels_ = request.freqs.empty();
+  ongoing_scan_type_ = request.scan_type;
+  scan_triggered_us_ = TimeUtils::GetBoottimeUs();
+  scan_latency_stats_.Add(request.scan_type, ScanLatencyStats::kPhaseTrigger,
+                          scan_triggered_us_ - request.request_time_us);
+  hidden_ssid_scheduler_.MarkProbed(ssids, TimeUtils::GetBoottimeMs());
+  if (remaining_ssids.empty()) {
+    next_scan_round_.reset();
+  } else {
+    next_scan_round_.reset(new ScanRequest(request));
+    next_scan_round_->hidden_ssids = std::move(remaining_ssids);
+    next_scan_round_->include_wildcard_ssid = false;
+  }
+  return true;
 }
 
 Status ScannerImpl::startPnoScan(const PnoSettings& pno_settings,
@@ -222,12 +614,13 @@ bool ScannerImpl::StartPnoScanOffload(const PnoSettings& pno_settings) {
   ParsePnoSettings(pno_settings, &scan_ssids, &match_ssids, &freqs,
                    &match_security);
   pno_scan_running_over_offload_ = offload_scan_manager_->startScan(
-      pno_settings.interval_ms_,
-      // TODO: honor both rssi thresholds.
+      pno_settings.interval_ms_, pno_settings.min_2g_rssi_,
       pno_settings.min_5g_rssi_, scan_ssids, match_ssids, match_security, freqs,
       &reason_code);
   if (pno_scan_running_over_offload_) {
     LOG(VERBOSE) << "Pno scans requested over Offload HAL";
+    hidden_ssid_scheduler_.MarkProbed(scan_ssids, TimeUtils::GetBoottimeMs());
+    match_set_ranker_.MarkMatched(match_ssids, TimeUtils::GetBoottimeMs());
     if (pno_scan_event_handler_ != nullptr) {
       pno_scan_event_handler_->OnPnoScanOverOffloadStarted();
     }
@@ -242,29 +635,41 @@ void ScannerImpl::ParsePnoSettings(const PnoSettings& pno_settings,
                                    vector<uint8_t>* match_security) {
   // TODO provide actionable security match parameters
   const uint8_t kNetworkFlagsDefault = 0;
+  vector<vector<uint8_t>> hidden_ssids;
   vector<vector<uint8_t>> skipped_scan_ssids;
   vector<vector<uint8_t>> skipped_match_ssids;
   for (auto& network : pno_settings.pno_networks_) {
-    // Add hidden network ssid.
     if (network.is_hidden_) {
-      // TODO remove pruning for Offload Scans
-      if (scan_ssids->size() + 1 >
-          scan_capabilities_.max_num_sched_scan_ssids) {
-        skipped_scan_ssids.emplace_back(network.ssid_);
-        continue;
-      }
-      scan_ssids->push_back(network.ssid_);
+      hidden_ssids.push_back(network.ssid_);
     }
-
-    if (match_ssids->size() + 1 > scan_capabilities_.max_match_sets) {
-      skipped_match_ssids.emplace_back(network.ssid_);
+  }
+  // Add hidden network ssids. The ones that don't fit are rotated in when
+  // pno scan is started again, least recently probed ones first.
+  // TODO remove pruning for Offload Scans
+  for (auto& ssid : hidden_ssid_scheduler_.Prioritize(hidden_ssids)) {
+    if (scan_ssids->size() + 1 >
+        scan_capabilities_.max_num_sched_scan_ssids) {
+      skipped_scan_ssids.push_back(std::move(ssid));
       continue;
     }
-    match_ssids->push_back(network.ssid_);
+    scan_ssids->push_back(std::move(ssid));
+  }
+
+  // The networks which don't fit are ranked, and the lower ranked ones are
+  // rotated in when pno scan is started again.
+  for (auto& network : match_set_ranker_.Select(
+           pno_settings.pno_networks_, scan_capabilities_.max_match_sets)) {
+    match_ssids->push_back(std::move(network.ssid_));
     match_security->push_back(kNetworkFlagsDefault);
   }
+  for (const auto& network : pno_settings.pno_networks_) {
+    if (std::find(match_ssids->begin(), match_ssids->end(), network.ssid_) ==
+        match_ssids->end()) {
+      skipped_match_ssids.emplace_back(network.ssid_);
+    }
+  }
 
-  LogSsidList(skipped_scan_ssids, "Skip scan ssid for pno scan");
+  LogSsidList(skipped_scan_ssids, "Defer scan ssid to next pno scan");
   LogSsidList(skipped_match_ssids, "Skip match ssid for pno scan");
 }
 
@@ -289,15 +694,35 @@ bool ScannerImpl::StartPnoScanDefault(const PnoSettings& pno_settings) {
   // Always request a low power scan for PNO, if device supports it.
   bool request_low_power = wiphy_features_.supports_low_power_oneshot_scan;
 
+  // Networks only seen on one band are matched against the threshold of
+  // that band.
+  vector<SchedScanMatchSet> match_sets;
+  for (const auto& ssid : match_ssids) {
+    int32_t rssi_threshold = GetMatchRssiThreshold(
+        pno_settings, channel_history_.GetFrequencies({ssid}));
+    match_sets.push_back({ssid, rssi_threshold});
+  }
+  SchedScanRssiSetting rssi_setting;
+  rssi_setting.rssi_threshold_2g = pno_settings.min_2g_rssi_;
+  rssi_setting.rssi_threshold_5g = pno_settings.min_5g_rssi_;
+  // Relative rssi is compared with the connected network, so it only
+  // applies while associated.
+  if (pno_settings.relative_rssi_set_ &&
+      wiphy_features_.supports_relative_rssi_sched_scan &&
+      client_interface_->IsAssociated()) {
+    rssi_setting.relative_rssi_set = true;
+    rssi_setting.relative_rssi =
+        static_cast<int8_t>(pno_settings.relative_rssi_);
+  }
+
   int error_code = 0;
   if (!scan_utils_->StartScheduledScan(interface_index_,
                                        GenerateIntervalSetting(pno_settings),
-                                       pno_settings.min_2g_rssi_,
-                                       pno_settings.min_5g_rssi_,
+                                       rssi_setting,
                                        request_random_mac,
                                        request_low_power,
                                        scan_ssids,
-                                       match_ssids,
+                                       match_sets,
                                        freqs,
                                        &error_code)) {
     LOG(ERROR) << "Failed to start pno scan";
@@ -306,6 +731,8 @@ bool ScannerImpl::StartPnoScanDefault(const PnoSettings& pno_settings) {
   }
   LOG(INFO) << "Pno scan started";
   pno_scan_started_ = true;
+  hidden_ssid_scheduler_.MarkProbed(scan_ssids, TimeUtils::GetBoottimeMs());
+  match_set_ranker_.MarkMatched(match_ssids, TimeUtils::GetBoottimeMs());
   return true;
 }
 
@@ -361,6 +788,12 @@ Status ScannerImpl::abortScan() {
   if (!scan_utils_->AbortScan(interface_index_)) {
     LOG(WARNING) << "Abort scan failed";
   }
+  // Queued scan requests are aborted along with the ongoing scan.
+  if (pending_scan_request_ != nullptr) {
+    int num_waiters = pending_scan_request_->num_waiters;
+    pending_scan_request_.reset();
+    NotifyScanEvent(true, num_waiters);
+  }
   return Status::ok();
 }
 
@@ -407,17 +840,68 @@ void ScannerImpl::OnScanResultsReady(uint32_t interface_index, bool aborted,
   if (!scan_started_) {
     LOG(INFO) << "Received external scan result notification from kernel.";
   }
+  const bool was_started = scan_started_;
   scan_started_ = false;
-  if (scan_event_handler_ != nullptr) {
+  if (!aborted) {
+    const uint64_t now_ms = TimeUtils::GetBoottimeMs();
+    for (uint32_t freq : frequencies) {
+      channel_last_scanned_ms_[freq] = now_ms;
+    }
+    if (scanning_all_channels_) {
+      all_frequencies_ = set<uint32_t>(frequencies.begin(),
+                                       frequencies.end());
+    }
+  }
+  scanning_all_channels_ = false;
+  if (was_started && !aborted) {
+    scan_results_ready_us_ = TimeUtils::GetBoottimeUs();
+    scan_latency_stats_.Add(ongoing_scan_type_, ScanLatencyStats::kPhaseScan,
+                            scan_results_ready_us_ - scan_triggered_us_);
+    last_scan_type_ = ongoing_scan_type_;
+    scan_results_pending_read_ = true;
+  }
+  if (aborted) {
+    next_scan_round_.reset();
+  } else if (next_scan_round_ != nullptr) {
+    // The scan is reported as done once every round of it is done.
+    unique_ptr<ScanRequest> round = std::move(next_scan_round_);
+    round->request_time_us = TimeUtils::GetBoottimeUs();
+    if (StartScan(*round)) {
+      return;
+    }
+    LOG(ERROR) << "Failed to start next scan round";
+  }
+  // The handler is still notified once of external scans.
+  int num_waiters = std::max(num_scan_waiters_, 1);
+  num_scan_waiters_ = 0;
+  if (aborted) {
+    LOG(WARNING) << "Scan aborted";
+  }
+  NotifyScanEvent(aborted, num_waiters);
+
+  // The handler may have started another scan in the meantime, in which case
+  // the queued requests keep waiting for that one to finish.
+  if (pending_scan_request_ != nullptr && !scan_started_) {
+    unique_ptr<ScanRequest> request = std::move(pending_scan_request_);
+    if (!StartScan(*request)) {
+      LOG(ERROR) << "Failed to start queued scan";
+      NotifyScanEvent(true, request->num_waiters);
+    }
+  }
+}
+
+void ScannerImpl::NotifyScanEvent(bool aborted, int num_waiters) {
+  if (scan_event_handler_ == nullptr) {
+    LOG(WARNING) << "No scan event handler found.";
+    return;
+  }
+  for (int i = 0; i < num_waiters; i++) {
     // TODO: Pass other parameters back once we find framework needs them.
     if (aborted) {
-      LOG(WARNING) << "Scan aborted";
       scan_event_handler_->OnScanFailed();
     } else {
       scan_event_handler_->OnScanResultReady();
     }
-  } else {
-    LOG(WARNING) << "No scan event handler found.";
   }
 }
 
@@ -436,6 +920,7 @@ void ScannerImpl::OnSchedScanResultsReady(uint32_t interface_index,
     } else {
       LOG(INFO) << "Pno scan result ready event";
       pno_scan_results_from_offload_ = false;
+      pno_scan_planner_.RecordNetworkFound(TimeUtils::GetBoottimeMs());
       pno_scan_event_handler_->OnPnoNetworkFound();
     }
   }
@@ -444,29 +929,8 @@ void ScannerImpl::OnSchedScanResultsReady(uint32_t interface_index,
 SchedScanIntervalSetting ScannerImpl::GenerateIntervalSetting(
     const ::com::android::server::wifi::wificond::PnoSettings&
         pno_settings) const {
-  bool support_num_scan_plans = scan_capabilities_.max_num_scan_plans >= 2;
-  bool support_scan_plan_interval =
-      scan_capabilities_.max_scan_plan_interval * 1000 >=
-          pno_settings.interval_ms_ * PnoSettings::kSlowScanIntervalMultiplier;
-  bool support_scan_plan_iterations =
-      scan_capabilities_.max_scan_plan_iterations >=
-                  PnoSettings::kFastScanIterations;
-
-  uint32_t fast_scan_interval =
-      static_cast<uint32_t>(pno_settings.interval_ms_);
-  if (support_num_scan_plans && support_scan_plan_interval &&
-      support_scan_plan_iterations) {
-    return SchedScanIntervalSetting{
-        {{fast_scan_interval, PnoSettings::kFastScanIterations}},
-        fast_scan_interval * PnoSettings::kSlowScanIntervalMultiplier};
-  } else {
-    // Device doesn't support the provided scan plans.
-    // Specify single interval instead.
-    // In this case, the driver/firmware is expected to implement back off
-    // logic internally using |pno_settings.interval_ms_| as "fast scan"
-    // interval.
-    return SchedScanIntervalSetting{{}, fast_scan_interval};
-  }
+  return pno_scan_planner_.GeneratePlans(pno_settings,
+                                         TimeUtils::GetBoottimeMs());
 }
 
 void ScannerImpl::OnOffloadScanResult() {
@@ -477,6 +941,7 @@ void ScannerImpl::OnOffloadScanResult() {
   }
   LOG(INFO) << "Offload Scan results received";
   pno_scan_results_from_offload_ = true;
+  pno_scan_planner_.RecordNetworkFound(TimeUtils::GetBoottimeMs());
   if (pno_scan_event_handler_ != nullptr) {
     pno_scan_event_handler_->OnPnoNetworkFound();
   } else {
@@ -528,6 +993,13 @@ void ScannerImpl::OnOffloadError(
   }
 }
 
+void ScannerImpl::Dump(stringstream* ss) const {
+  hidden_ssid_scheduler_.Dump(ss);
+  channel_history_.Dump(ss);
+  match_set_ranker_.Dump(ss);
+  scan_latency_stats_.Dump(ss);
+}
+
 void ScannerImpl::LogSsidList(vector<vector<uint8_t>>& ssid_list,
                               string prefix) {
   if (ssid_list.empty()) {
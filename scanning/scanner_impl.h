@@ -17,6 +17,10 @@
 #ifndef WIFICOND_SCANNER_IMPL_H_
 #define WIFICOND_SCANNER_IMPL_H_
 
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
 #include <vector>
 
 #include <android-base/macros.h>
@@ -25,12 +29,19 @@
 #include "android/net/wifi/BnWifiScannerImpl.h"
 #include "wificond/net/netlink_utils.h"
 #include "wificond/scanning/offload_scan_callback_interface.h"
+#include "wificond/scanning/channel_history.h"
+#include "wificond/scanning/hidden_ssid_scheduler.h"
+#include "wificond/scanning/match_set_ranker.h"
+#include "wificond/scanning/partial_scan_settings.h"
+#include "wificond/scanning/pno_scan_planner.h"
+#include "wificond/scanning/scan_latency_stats.h"
 #include "wificond/scanning/scan_utils.h"
 
 namespace android {
 namespace wificond {
 
 class ClientInterfaceImpl;
+class EventLoop;
 class OffloadServiceUtils;
 class ScanUtils;
 class OffloadScanCallbackInterfaceImpl;
@@ -43,12 +54,27 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
               const WiphyFeatures& wiphy_features,
               ClientInterfaceImpl* client_interface,
               ScanUtils* scan_utils,
-              std::weak_ptr<OffloadServiceUtils> offload_service_utils);
+              std::weak_ptr<OffloadServiceUtils> offload_service_utils,
+              EventLoop* event_loop);
   ~ScannerImpl();
   // Get the latest single scan results from kernel.
   ::android::binder::Status getScanResults(
       std::vector<com::android::server::wifi::wificond::NativeScanResult>*
           out_scan_results) override;
+  // Get the latest single scan results matching |filter|.
+  ::android::binder::Status getFilteredScanResults(
+      const ::com::android::server::wifi::wificond::ScanResultFilter& filter,
+      std::vector<com::android::server::wifi::wificond::NativeScanResult>*
+          out_scan_results) override;
+  // Get the changes to the latest single scan results since |cursor|.
+  ::android::binder::Status getScanResultsDelta(
+      int64_t cursor,
+      ::com::android::server::wifi::wificond::NativeScanResultDelta*
+          out_scan_result_delta) override;
+  // Get the latest single scan results in a shared memory region.
+  ::android::binder::Status getScanResultsBuffer(
+      ::com::android::server::wifi::wificond::NativeScanResultBuffer*
+          out_scan_result_buffer) override;
   // Get the latest pno scan results from the interface that most recently
   // completed PNO scans
   ::android::binder::Status getPnoScanResults(
@@ -58,6 +84,9 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
       const ::com::android::server::wifi::wificond::SingleScanSettings&
           scan_settings,
       bool* out_success) override;
+  ::android::binder::Status setPartialScanSettings(
+      const ::com::android::server::wifi::wificond::PartialScanSettings&
+          settings) override;
   ::android::binder::Status startPnoScan(
       const ::com::android::server::wifi::wificond::PnoSettings& pno_settings,
       bool* out_success) override;
@@ -75,6 +104,13 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   void OnOffloadError(
       OffloadScanCallbackInterface::AsyncErrorReason error_code);
   void Invalidate();
+  void Dump(std::stringstream* ss) const;
+  const HiddenSsidScheduler& GetHiddenSsidScheduler() const {
+    return hidden_ssid_scheduler_;
+  }
+  const ScanLatencyStats& GetScanLatencyStats() const {
+    return scan_latency_stats_;
+  }
 
  private:
   bool CheckIsValid();
@@ -84,6 +120,40 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
   void OnSchedScanResultsReady(uint32_t interface_index, bool scan_stopped);
   void LogSsidList(std::vector<std::vector<uint8_t>>& ssid_list,
                    std::string prefix);
+  // A single scan request, or several overlapping ones merged together.
+  struct ScanRequest {
+    int scan_type;
+    // Frequencies to scan. An empty set means all supported frequencies.
+    std::set<uint32_t> freqs;
+    std::vector<std::vector<uint8_t>> hidden_ssids;
+    // Only the first round of a scan also probes the wildcard SSID.
+    bool include_wildcard_ssid;
+    // Number of scan() calls waiting for the outcome of this request.
+    int num_waiters;
+    // CLOCK_BOOTTIME in microseconds of the earliest scan() call.
+    uint64_t request_time_us;
+  };
+  ScanRequest CreateScanRequest(
+      const ::com::android::server::wifi::wificond::SingleScanSettings&
+          scan_settings) const;
+  // Merges |request| into |merged_request|, so that the merged request
+  // scans everything either of them would.
+  void MergeScanRequest(const ScanRequest& request,
+                        ScanRequest* merged_request) const;
+  // Hidden networks that don't fit in one scan request are left to
+  // |next_scan_round_|.
+  bool StartScan(const ScanRequest& request);
+  // Narrows |request| down to the channels saved networks were recently
+  // seen on, if partial scans are enabled and no full scan is due.
+  void ApplyPartialScan(ScanRequest* request);
+  // Drops the channels of |request| which were scanned within the last
+  // |max_channel_age_ms| milliseconds. Requests probing hidden networks are
+  // left alone, since a broadcast scan can't find those.
+  // Returns false if every channel was, in which case no scan is needed.
+  bool DropFreshChannels(int32_t max_channel_age_ms, ScanRequest* request);
+  // Notifies the scan event handler of the outcome of a scan, once per
+  // scan() call waiting for it.
+  void NotifyScanEvent(bool aborted, int num_waiters);
   bool StartPnoScanDefault(
       const ::com::android::server::wifi::wificond::PnoSettings& pno_settings);
   bool StartPnoScanOffload(
@@ -97,6 +167,20 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
       std::vector<uint32_t>* freqs, std::vector<uint8_t>* match_security);
   SchedScanIntervalSetting GenerateIntervalSetting(
     const ::com::android::server::wifi::wificond::PnoSettings& pno_settings) const;
+  // Records the latencies of reading scan results, which started at
+  // |read_start_us|.
+  void RecordScanResultsRead(uint64_t read_start_us);
+  // Learns the channels of networks and the network the device is
+  // connected to from |scan_results|.
+  void UpdateNetworkHistory(
+      const std::vector<
+          ::com::android::server::wifi::wificond::NativeScanResult>&
+          scan_results);
+  // Compares |scan_results| with the tracked scan results, and stamps the
+  // ones which were added, changed or expired with a new generation.
+  void UpdateTrackedScanResults(
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>&
+          scan_results);
 
   // Boolean variables describing current scanner status.
   bool valid_;
@@ -111,14 +195,70 @@ class ScannerImpl : public android::net::wifi::BnWifiScannerImpl {
 
   // Scanning relevant capability information for this wiphy/interface.
   ScanCapabilities scan_capabilities_;
+  PnoScanPlanner pno_scan_planner_;
   WiphyFeatures wiphy_features_;
 
   ClientInterfaceImpl* client_interface_;
   ScanUtils* const scan_utils_;
+  EventLoop* const event_loop_;
+  // Pending tasks can't be removed from |event_loop_|. Instead they hold a
+  // weak reference to this generation and only run if it still exists and
+  // hasn't changed since they were posted. It changes on Invalidate().
+  std::shared_ptr<uint64_t> generation_;
   ::android::sp<::android::net::wifi::IPnoScanEvent> pno_scan_event_handler_;
   ::android::sp<::android::net::wifi::IScanEvent> scan_event_handler_;
+  // Number of scan() calls waiting for the ongoing scan.
+  int num_scan_waiters_;
+  // Whether the ongoing scan covers all supported channels.
+  bool scanning_all_channels_;
+  // Frequencies covered by the last completed scan of all channels.
+  std::set<uint32_t> all_frequencies_;
+  // Time each frequency was last covered by a completed scan, in
+  // milliseconds since boot.
+  std::map<uint32_t, uint64_t> channel_last_scanned_ms_;
+
+  ScanLatencyStats scan_latency_stats_;
+  // Scan type of the ongoing scan, and the time it was triggered.
+  int ongoing_scan_type_;
+  uint64_t scan_triggered_us_;
+  // Whether the results of the last completed scan were not read yet.
+  bool scan_results_pending_read_;
+  // Scan type of the last completed scan, and the time its results were
+  // ready.
+  int last_scan_type_;
+  uint64_t scan_results_ready_us_;
+  // Scan requests received while a scan is ongoing, merged together.
+  // They are sent to kernel once the ongoing scan finishes.
+  std::unique_ptr<ScanRequest> pending_scan_request_;
+  // Hidden networks left to probe by the ongoing scan, which are scanned for
+  // in another round before the scan is reported as done.
+  std::unique_ptr<ScanRequest> next_scan_round_;
+  HiddenSsidScheduler hidden_ssid_scheduler_;
+  ::com::android::server::wifi::wificond::PartialScanSettings
+      partial_scan_settings_;
+  // Number of scans requested for all channels since the last full scan.
+  int num_scans_since_full_scan_;
+  ChannelHistory channel_history_;
+  MatchSetRanker match_set_ranker_;
   std::shared_ptr<OffloadScanManager> offload_scan_manager_;
 
+  // A scan result as of the last getScanResultsDelta() call, along with the
+  // generation at which it was added or last changed.
+  struct TrackedScanResult {
+    ::com::android::server::wifi::wificond::NativeScanResult scan_result;
+    uint64_t generation;
+  };
+  // Generation of the tracked scan results, used as the cursor of deltas.
+  // It only ever increases, including across ScannerImpl instances.
+  uint64_t scan_results_generation_;
+  // Cursors older than this can't be served a delta, because the expired
+  // scan results they need have been forgotten.
+  uint64_t min_delta_cursor_;
+  // Tracked scan results keyed by BSSID.
+  std::map<std::vector<uint8_t>, TrackedScanResult> tracked_scan_results_;
+  // Generations at which scan results expired, keyed by BSSID.
+  std::map<std::vector<uint8_t>, uint64_t> expired_bssids_;
+
   DISALLOW_COPY_AND_ASSIGN(ScannerImpl);
 };
 
@@ -55,6 +55,7 @@ status_t SingleScanSettings::writeToParcel(::android::Parcel* parcel) const {
     RETURN_IF_FAILED(parcel->writeInt32(1));
     RETURN_IF_FAILED(network.writeToParcel(parcel));
   }
+  RETURN_IF_FAILED(parcel->writeInt32(max_channel_age_ms_));
   return ::android::OK;
 }
 
@@ -106,6 +107,16 @@ status_t SingleScanSettings::readFromParcel(const ::android::Parcel* parcel) {
     RETURN_IF_FAILED(network.readFromParcel(parcel));
     hidden_networks_.push_back(network);
   }
+  // Frameworks which predate the max channel age don't write it.
+  max_channel_age_ms_ = 0;
+  if (parcel->dataAvail() > 0) {
+    RETURN_IF_FAILED(parcel->readInt32(&max_channel_age_ms_));
+    if (max_channel_age_ms_ < 0) {
+      LOG(ERROR) << "Unexpected negative max channel age: "
+                 << max_channel_age_ms_;
+      return ::android::BAD_VALUE;
+    }
+  }
   return ::android::OK;
 }
 
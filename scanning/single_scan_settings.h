@@ -37,7 +37,8 @@ class SingleScanSettings : public ::android::Parcelable {
   bool operator==(const SingleScanSettings& rhs) const {
     return (scan_type_ == rhs.scan_type_ &&
             channel_settings_ == rhs.channel_settings_ &&
-            hidden_networks_ == rhs.hidden_networks_);
+            hidden_networks_ == rhs.hidden_networks_ &&
+            max_channel_age_ms_ == rhs.max_channel_age_ms_);
   }
   ::android::status_t writeToParcel(::android::Parcel* parcel) const override;
   ::android::status_t readFromParcel(const ::android::Parcel* parcel) override;
@@ -45,6 +46,11 @@ class SingleScanSettings : public ::android::Parcelable {
   int32_t scan_type_;
   std::vector<ChannelSettings> channel_settings_;
   std::vector<HiddenNetwork> hidden_networks_;
+  // Channels covered by a completed scan within the last
+  // |max_channel_age_ms_| milliseconds are not scanned again, and scan
+  // results cached from that scan are used for them instead.
+  // 0 means every channel is scanned.
+  int32_t max_channel_age_ms_{0};
 
  private:
   bool isValidScanType() const;
@@ -59,12 +59,15 @@ Server::Server(unique_ptr<InterfaceTool> if_tool,
                unique_ptr<SupplicantManager> supplicant_manager,
                unique_ptr<HostapdManager> hostapd_manager,
                NetlinkUtils* netlink_utils,
-               ScanUtils* scan_utils)
+               ScanUtils* scan_utils,
+               EventLoop* event_loop)
     : if_tool_(std::move(if_tool)),
       supplicant_manager_(std::move(supplicant_manager)),
       hostapd_manager_(std::move(hostapd_manager)),
       netlink_utils_(netlink_utils),
-      scan_utils_(scan_utils) {
+      scan_utils_(scan_utils),
+      event_loop_(event_loop),
+      wiphy_info_cache_(netlink_utils) {
 }
 
 Status Server::RegisterCallback(const sp<IInterfaceEventCallback>& callback) {
@@ -140,7 +143,9 @@ Status Server::createClientInterface(const std::string& iface_name,
       interface.mac_address,
       if_tool_.get(),
       netlink_utils_,
-      scan_utils_));
+      scan_utils_,
+      &wiphy_info_cache_,
+      event_loop_));
   *created_interface = client_interface->GetBinder();
   BroadcastClientInterfaceReady(client_interface->GetBinder());
   client_interfaces_[iface_name] = std::move(client_interface);
@@ -174,6 +179,7 @@ Status Server::tearDownInterfaces() {
   MarkDownAllInterfaces();
 
   netlink_utils_->UnsubscribeRegDomainChange(wiphy_index_);
+  wiphy_info_cache_.SetEnabled(false);
 
   return Status::ok();
 }
@@ -229,11 +235,25 @@ status_t Server::dump(int fd, const Vector<String16>& /*args*/) {
     ss << "Failed to get country code from kernel." << endl;
   }
 
+  NetlinkReceiveStats netlink_stats;
+  netlink_utils_->GetNetlinkReceiveStats(&netlink_stats);
+  ss << "Netlink datagrams received: " << netlink_stats.num_datagrams
+     << " in " << netlink_stats.num_wakeups << " wakeups"
+     << ", max per wakeup: " << netlink_stats.max_datagrams_per_wakeup << endl;
+  ss << "Netlink datagram buffer size: "
+     << netlink_stats.datagram_buffer_size << " bytes" << endl;
+  ss << "Netlink truncated datagrams: "
+     << netlink_stats.num_truncated_datagrams << endl;
+  ss << "Netlink receive queue overruns: "
+     << netlink_stats.num_overruns << endl;
+
   for (const auto& iface : client_interfaces_) {
     iface.second->Dump(&ss);
   }
 
   for (const auto& iface : ap_interfaces_) {
+    // Stations only get their info here, the station events carry none.
+    iface.second->RefreshStationTable();
     iface.second->Dump(&ss);
   }
 
@@ -258,58 +278,29 @@ void Server::MarkDownAllInterfaces() {
 
 Status Server::getAvailable2gChannels(
     std::unique_ptr<vector<int32_t>>* out_frequencies) {
-  BandInfo band_info;
-  ScanCapabilities scan_capabilities_ignored;
-  WiphyFeatures wiphy_features_ignored;
-
-  if (!netlink_utils_->GetWiphyInfo(wiphy_index_, &band_info,
-                                    &scan_capabilities_ignored,
-                                    &wiphy_features_ignored)) {
-    LOG(ERROR) << "Failed to get wiphy info from kernel";
-    out_frequencies->reset(nullptr);
-    return Status::ok();
-  }
-
+  // Logging is done by the cache.
+  const vector<int32_t>* frequencies =
+      wiphy_info_cache_.Get2gFrequencies(wiphy_index_);
   out_frequencies->reset(
-      new vector<int32_t>(band_info.band_2g.begin(), band_info.band_2g.end()));
+      frequencies == nullptr ? nullptr : new vector<int32_t>(*frequencies));
   return Status::ok();
 }
 
 Status Server::getAvailable5gNonDFSChannels(
     std::unique_ptr<vector<int32_t>>* out_frequencies) {
-  BandInfo band_info;
-  ScanCapabilities scan_capabilities_ignored;
-  WiphyFeatures wiphy_features_ignored;
-
-  if (!netlink_utils_->GetWiphyInfo(wiphy_index_, &band_info,
-                                    &scan_capabilities_ignored,
-                                    &wiphy_features_ignored)) {
-    LOG(ERROR) << "Failed to get wiphy info from kernel";
-    out_frequencies->reset(nullptr);
-    return Status::ok();
-  }
-
+  const vector<int32_t>* frequencies =
+      wiphy_info_cache_.Get5gNonDfsFrequencies(wiphy_index_);
   out_frequencies->reset(
-      new vector<int32_t>(band_info.band_5g.begin(), band_info.band_5g.end()));
+      frequencies == nullptr ? nullptr : new vector<int32_t>(*frequencies));
   return Status::ok();
 }
 
 Status Server::getAvailableDFSChannels(
     std::unique_ptr<vector<int32_t>>* out_frequencies) {
-  BandInfo band_info;
-  ScanCapabilities scan_capabilities_ignored;
-  WiphyFeatures wiphy_features_ignored;
-
-  if (!netlink_utils_->GetWiphyInfo(wiphy_index_, &band_info,
-                                    &scan_capabilities_ignored,
-                                    &wiphy_features_ignored)) {
-    LOG(ERROR) << "Failed to get wiphy info from kernel";
-    out_frequencies->reset(nullptr);
-    return Status::ok();
-  }
-
-  out_frequencies->reset(new vector<int32_t>(band_info.band_dfs.begin(),
-                                             band_info.band_dfs.end()));
+  const vector<int32_t>* frequencies =
+      wiphy_info_cache_.GetDfsFrequencies(wiphy_index_);
+  out_frequencies->reset(
+      frequencies == nullptr ? nullptr : new vector<int32_t>(*frequencies));
   return Status::ok();
 }
 
@@ -324,6 +315,7 @@ bool Server::SetupInterface(const std::string& iface_name,
           std::bind(&Server::OnRegDomainChanged,
           this,
           _1));
+  wiphy_info_cache_.SetEnabled(true);
 
   interfaces_.clear();
   if (!netlink_utils_->GetInterfaces(wiphy_index_, &interfaces_)) {
@@ -366,6 +358,7 @@ void Server::OnRegDomainChanged(std::string& country_code) {
   } else {
     LOG(INFO) << "Regulatory domain changed to country: " << country_code;
   }
+  wiphy_info_cache_.Invalidate();
   LogSupportedBands();
 }
 
@@ -373,10 +366,10 @@ void Server::LogSupportedBands() {
   BandInfo band_info;
   ScanCapabilities scan_capabilities;
   WiphyFeatures wiphy_features;
-  netlink_utils_->GetWiphyInfo(wiphy_index_,
-                               &band_info,
-                               &scan_capabilities,
-                               &wiphy_features);
+  wiphy_info_cache_.GetWiphyInfo(wiphy_index_,
+                                 &band_info,
+                                 &scan_capabilities,
+                                 &wiphy_features);
 
   stringstream ss;
   for (unsigned int i = 0; i < band_info.band_2g.size(); i++) {
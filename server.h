@@ -32,10 +32,12 @@
 
 #include "wificond/ap_interface_impl.h"
 #include "wificond/client_interface_impl.h"
+#include "wificond/wiphy_info_cache.h"
 
 namespace android {
 namespace wificond {
 
+class EventLoop;
 class NL80211Packet;
 class NetlinkUtils;
 class ScanUtils;
@@ -48,7 +50,8 @@ class Server : public android::net::wifi::BnWificond {
          std::unique_ptr<wifi_system::SupplicantManager> supplicant_man,
          std::unique_ptr<wifi_system::HostapdManager> hostapd_man,
          NetlinkUtils* netlink_utils,
-         ScanUtils* scan_utils);
+         ScanUtils* scan_utils,
+         EventLoop* event_loop);
   ~Server() override = default;
 
   android::binder::Status RegisterCallback(
@@ -120,6 +123,10 @@ class Server : public android::net::wifi::BnWificond {
   const std::unique_ptr<wifi_system::HostapdManager> hostapd_manager_;
   NetlinkUtils* const netlink_utils_;
   ScanUtils* const scan_utils_;
+  EventLoop* const event_loop_;
+  // Capabilities of the wiphy shared by all interfaces. It is invalidated on
+  // regulatory domain change and interface teardown.
+  WiphyInfoCache wiphy_info_cache_;
 
   uint32_t wiphy_index_;
   std::map<std::string, std::unique_ptr<ApInterfaceImpl>> ap_interfaces_;
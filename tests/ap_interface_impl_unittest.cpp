@@ -35,9 +35,11 @@ using std::placeholders::_1;
 using std::placeholders::_2;
 using std::unique_ptr;
 using std::vector;
+using testing::DoAll;
 using testing::NiceMock;
 using testing::Invoke;
 using testing::Return;
+using testing::SetArgPointee;
 using testing::Sequence;
 using testing::StrEq;
 using testing::_;
@@ -49,6 +51,7 @@ namespace {
 const char kTestInterfaceName[] = "testwifi0";
 const uint32_t kTestInterfaceIndex = 42;
 const uint8_t kFakeMacAddress[] = {0x45, 0x54, 0xad, 0x67, 0x98, 0xf6};
+const uint8_t kFakeMacAddress2[] = {0x45, 0x54, 0xad, 0x67, 0x98, 0xf7};
 
 void CaptureStationEventHandler(
     OnStationEventHandler* out_handler,
@@ -134,13 +137,103 @@ TEST_F(ApInterfaceImplTest, CanGetNumberOfAssociatedStations) {
 
   vector<uint8_t> fake_mac_address(kFakeMacAddress,
                                    kFakeMacAddress + sizeof(kFakeMacAddress));
+  vector<uint8_t> fake_mac_address2(
+      kFakeMacAddress2, kFakeMacAddress2 + sizeof(kFakeMacAddress2));
   EXPECT_EQ(0, ap_interface_->GetNumberOfAssociatedStations());
   handler(NEW_STATION, fake_mac_address);
   EXPECT_EQ(1, ap_interface_->GetNumberOfAssociatedStations());
-  handler(NEW_STATION, fake_mac_address);
+  handler(NEW_STATION, fake_mac_address2);
   EXPECT_EQ(2, ap_interface_->GetNumberOfAssociatedStations());
   handler(DEL_STATION, fake_mac_address);
   EXPECT_EQ(1, ap_interface_->GetNumberOfAssociatedStations());
+  EXPECT_EQ(1u, ap_interface_->GetStationTable().count(fake_mac_address2));
+}
+
+TEST_F(ApInterfaceImplTest, IgnoresStationEventsThatDoNotChangeStationTable) {
+  OnStationEventHandler handler;
+  EXPECT_CALL(*netlink_utils_, SubscribeStationEvent(kTestInterfaceIndex, _))
+      .WillOnce(Invoke(bind(CaptureStationEventHandler, &handler, _1, _2)));
+  ap_interface_.reset(new ApInterfaceImpl(
+      kTestInterfaceName, kTestInterfaceIndex, netlink_utils_.get(),
+      if_tool_.get(), hostapd_manager_.get()));
+
+  vector<uint8_t> fake_mac_address(kFakeMacAddress,
+                                   kFakeMacAddress + sizeof(kFakeMacAddress));
+  vector<uint8_t> fake_mac_address2(
+      kFakeMacAddress2, kFakeMacAddress2 + sizeof(kFakeMacAddress2));
+  handler(NEW_STATION, fake_mac_address);
+  handler(NEW_STATION, fake_mac_address);
+  EXPECT_EQ(1, ap_interface_->GetNumberOfAssociatedStations());
+  handler(DEL_STATION, fake_mac_address2);
+  EXPECT_EQ(1, ap_interface_->GetNumberOfAssociatedStations());
+  handler(DEL_STATION, fake_mac_address);
+  EXPECT_EQ(0, ap_interface_->GetNumberOfAssociatedStations());
+}
+
+TEST_F(ApInterfaceImplTest, CanRefreshStationTable) {
+  OnStationEventHandler handler;
+  EXPECT_CALL(*netlink_utils_, SubscribeStationEvent(kTestInterfaceIndex, _))
+      .WillOnce(Invoke(bind(CaptureStationEventHandler, &handler, _1, _2)));
+  ap_interface_.reset(new ApInterfaceImpl(
+      kTestInterfaceName, kTestInterfaceIndex, netlink_utils_.get(),
+      if_tool_.get(), hostapd_manager_.get()));
+  EXPECT_CALL(*hostapd_manager_, StartHostapd()).WillOnce(Return(true));
+  auto binder = ap_interface_->GetBinder();
+  sp<MockApInterfaceEventCallback> callback(new MockApInterfaceEventCallback());
+  bool out_success = false;
+  EXPECT_TRUE(binder->startHostapd(callback, &out_success).isOk());
+  EXPECT_TRUE(out_success);
+
+  vector<uint8_t> fake_mac_address(kFakeMacAddress,
+                                   kFakeMacAddress + sizeof(kFakeMacAddress));
+  vector<uint8_t> fake_mac_address2(
+      kFakeMacAddress2, kFakeMacAddress2 + sizeof(kFakeMacAddress2));
+  EXPECT_CALL(*callback, onNumAssociatedStationsChanged(_)).Times(2);
+  handler(NEW_STATION, fake_mac_address);
+  handler(NEW_STATION, fake_mac_address2);
+
+  // The second station is left out of the dump, e.g. because it has no tx
+  // bitrate yet. A station without NEW_STATION event is in the dump.
+  vector<uint8_t> unknown_mac_address(fake_mac_address);
+  unknown_mac_address[0] ^= 0xff;
+  StationTable stations;
+  stations[fake_mac_address] = StationInfo(10, 1, 540, -50);
+  stations[fake_mac_address].station_rx_bytes = 123456;
+  stations[unknown_mac_address] = StationInfo(20, 2, 720, -60);
+  EXPECT_CALL(*netlink_utils_, GetStationTable(kTestInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(stations), Return(true)));
+
+  // Refreshing info doesn't change the set of associated stations.
+  EXPECT_CALL(*callback, onNumAssociatedStationsChanged(_)).Times(0);
+  EXPECT_TRUE(ap_interface_->RefreshStationTable());
+  EXPECT_EQ(2, ap_interface_->GetNumberOfAssociatedStations());
+  const StationTable& station_table = ap_interface_->GetStationTable();
+  EXPECT_EQ(0u, station_table.count(unknown_mac_address));
+  ASSERT_EQ(1u, station_table.count(fake_mac_address));
+  EXPECT_EQ(123456u, station_table.at(fake_mac_address).station_rx_bytes);
+  ASSERT_EQ(1u, station_table.count(fake_mac_address2));
+  EXPECT_EQ(0u, station_table.at(fake_mac_address2).station_tx_bitrate);
+
+  // A station that disassociates afterwards is still known.
+  EXPECT_CALL(*callback, onNumAssociatedStationsChanged(1));
+  handler(DEL_STATION, fake_mac_address2);
+}
+
+TEST_F(ApInterfaceImplTest, KeepsStationTableOnRefreshFailure) {
+  OnStationEventHandler handler;
+  EXPECT_CALL(*netlink_utils_, SubscribeStationEvent(kTestInterfaceIndex, _))
+      .WillOnce(Invoke(bind(CaptureStationEventHandler, &handler, _1, _2)));
+  ap_interface_.reset(new ApInterfaceImpl(
+      kTestInterfaceName, kTestInterfaceIndex, netlink_utils_.get(),
+      if_tool_.get(), hostapd_manager_.get()));
+  vector<uint8_t> fake_mac_address(kFakeMacAddress,
+                                   kFakeMacAddress + sizeof(kFakeMacAddress));
+  handler(NEW_STATION, fake_mac_address);
+
+  EXPECT_CALL(*netlink_utils_, GetStationTable(kTestInterfaceIndex, _))
+      .WillOnce(Return(false));
+  EXPECT_FALSE(ap_interface_->RefreshStationTable());
+  EXPECT_EQ(1, ap_interface_->GetNumberOfAssociatedStations());
 }
 
 TEST_F(ApInterfaceImplTest, CallbackIsCalledOnNumAssociatedStationsChanged) {
@@ -160,10 +253,12 @@ TEST_F(ApInterfaceImplTest, CallbackIsCalledOnNumAssociatedStationsChanged) {
 
   vector<uint8_t> fake_mac_address(kFakeMacAddress,
                                    kFakeMacAddress + sizeof(kFakeMacAddress));
+  vector<uint8_t> fake_mac_address2(
+      kFakeMacAddress2, kFakeMacAddress2 + sizeof(kFakeMacAddress2));
   EXPECT_CALL(*callback, onNumAssociatedStationsChanged(1));
   handler(NEW_STATION, fake_mac_address);
   EXPECT_CALL(*callback, onNumAssociatedStationsChanged(2));
-  handler(NEW_STATION, fake_mac_address);
+  handler(NEW_STATION, fake_mac_address2);
   EXPECT_CALL(*callback, onNumAssociatedStationsChanged(1));
   handler(DEL_STATION, fake_mac_address);
 }
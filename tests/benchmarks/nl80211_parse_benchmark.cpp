@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2017, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "wificond/net/kernel-header-latest/nl80211.h"
+#include "wificond/net/nl80211_attribute.h"
+
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const uint8_t kFakeBssid[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+const uint32_t kFakeFrequency = 5180;
+const uint64_t kFakeTsf = 123456789;
+const uint16_t kFakeBeaconInterval = 100;
+const uint16_t kFakeCapability = 0x1431;
+const int32_t kFakeSignalMbm = -5000;
+const uint32_t kFakeSeenMsAgo = 20;
+const uint64_t kFakeBootTimeNs = 987654321000;
+// Typical size of the information elements of an access point.
+const size_t kFakeIeSize = 300;
+
+// Builds a NL80211_ATTR_BSS attribute of a scan result, with attributes
+// in the same order as kernel reports them.
+NL80211NestedAttr CreateBssAttribute() {
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_BSSID,
+      vector<uint8_t>(kFakeBssid, kFakeBssid + sizeof(kFakeBssid))));
+  bss.AddAttribute(NL80211Attr<uint64_t>(NL80211_BSS_TSF, kFakeTsf));
+  vector<uint8_t> ie(kFakeIeSize, 0x2a);
+  // SSID element.
+  ie[0] = 0;
+  ie[1] = 8;
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_INFORMATION_ELEMENTS, ie));
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(NL80211_BSS_BEACON_IES, ie));
+  bss.AddAttribute(NL80211Attr<uint16_t>(NL80211_BSS_BEACON_INTERVAL,
+                                         kFakeBeaconInterval));
+  bss.AddAttribute(NL80211Attr<uint16_t>(NL80211_BSS_CAPABILITY,
+                                         kFakeCapability));
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_FREQUENCY,
+                                         kFakeFrequency));
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_SEEN_MS_AGO,
+                                         kFakeSeenMsAgo));
+  bss.AddAttribute(NL80211Attr<uint64_t>(NL80211_BSS_LAST_SEEN_BOOTTIME,
+                                         kFakeBootTimeNs));
+  bss.AddAttribute(NL80211Attr<int32_t>(NL80211_BSS_SIGNAL_MBM,
+                                        kFakeSignalMbm));
+  NL80211NestedAttr chain_signal(NL80211_BSS_CHAIN_SIGNAL);
+  chain_signal.AddAttribute(NL80211Attr<int8_t>(0, -50));
+  chain_signal.AddAttribute(NL80211Attr<int8_t>(1, -52));
+  bss.AddAttribute(chain_signal);
+  return bss;
+}
+
+// Looks up the BSS fields used by ScanUtils::ParseBss().
+template <typename Attributes>
+void LookUpBssFields(const Attributes& bss) {
+  vector<uint8_t> bssid;
+  uint32_t frequency;
+  vector<uint8_t> ie;
+  uint64_t last_seen;
+  int32_t signal;
+  uint16_t capability;
+  uint32_t status;
+  benchmark::DoNotOptimize(
+      bss.GetAttributeValue(NL80211_BSS_BSSID, &bssid));
+  benchmark::DoNotOptimize(
+      bss.GetAttributeValue(NL80211_BSS_FREQUENCY, &frequency));
+  benchmark::DoNotOptimize(
+      bss.GetAttributeValue(NL80211_BSS_INFORMATION_ELEMENTS, &ie));
+  benchmark::DoNotOptimize(
+      bss.GetAttributeValue(NL80211_BSS_LAST_SEEN_BOOTTIME, &last_seen));
+  benchmark::DoNotOptimize(
+      bss.GetAttributeValue(NL80211_BSS_SIGNAL_MBM, &signal));
+  benchmark::DoNotOptimize(
+      bss.GetAttributeValue(NL80211_BSS_CAPABILITY, &capability));
+  // A missing attribute is the worst case for a linear search.
+  benchmark::DoNotOptimize(
+      bss.GetAttributeValue(NL80211_BSS_STATUS, &status));
+  benchmark::DoNotOptimize(bss.HasAttribute(NL80211_BSS_CHAIN_SIGNAL));
+}
+
+}  // namespace
+
+// Each lookup walks the attributes and copies the one found.
+static void BM_ParseBssWithNestedAttr(benchmark::State& state) {
+  const NL80211NestedAttr bss = CreateBssAttribute();
+  for (auto _ : state) {
+    LookUpBssFields(bss);
+  }
+}
+BENCHMARK(BM_ParseBssWithNestedAttr);
+
+// Each lookup walks the attributes in place.
+static void BM_ParseBssWithAttrView(benchmark::State& state) {
+  const NL80211NestedAttr bss = CreateBssAttribute();
+  for (auto _ : state) {
+    LookUpBssFields(NL80211AttrView(bss));
+  }
+}
+BENCHMARK(BM_ParseBssWithAttrView);
+
+// Attributes are walked once to build the index.
+static void BM_ParseBssWithAttrIndex(benchmark::State& state) {
+  const NL80211NestedAttr bss = CreateBssAttribute();
+  for (auto _ : state) {
+    NL80211AttrIndex<NL80211_BSS_MAX> index;
+    NL80211AttrView(bss).IndexAttributes(&index);
+    LookUpBssFields(index);
+  }
+}
+BENCHMARK(BM_ParseBssWithAttrIndex);
+
+}  // namespace wificond
+}  // namespace android
+
+BENCHMARK_MAIN();
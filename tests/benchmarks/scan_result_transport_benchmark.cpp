@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <binder/Parcel.h>
+
+#include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_buffer.h"
+
+using ::android::Parcel;
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using ::com::android::server::wifi::wificond::NativeScanResultBuffer;
+using ::com::android::server::wifi::wificond::RadioChainInfo;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const uint8_t kFakeSsid[] = {'G', 'o', 'o', 'g', 'l', 'e', 'G', 'u', 'e', 's', 't'};
+const uint32_t kFakeFrequency = 5180;
+const int32_t kFakeSignalMbm = -5000;
+const uint64_t kFakeTsf = 123456789;
+const uint16_t kFakeCapability = 0x1431;
+// Typical size of the information elements of an access point.
+const size_t kFakeIeSize = 300;
+
+vector<NativeScanResult> CreateScanResults(size_t num_scan_results) {
+  vector<NativeScanResult> scan_results;
+  vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  vector<uint8_t> ie(kFakeIeSize, 0x2a);
+  vector<RadioChainInfo> radio_chain_infos;
+  radio_chain_infos.emplace_back(0, -50);
+  radio_chain_infos.emplace_back(1, -52);
+  for (size_t i = 0; i < num_scan_results; i++) {
+    vector<uint8_t> bssid = {0x12, 0x34, 0x56, 0x78,
+                             static_cast<uint8_t>(i >> 8),
+                             static_cast<uint8_t>(i)};
+    scan_results.emplace_back(ssid, bssid, ie, kFakeFrequency, kFakeSignalMbm,
+                              kFakeTsf, kFakeCapability, false,
+                              radio_chain_infos);
+  }
+  return scan_results;
+}
+
+}  // namespace
+
+// Scan results are marshalled field by field into the binder buffer,
+// the way a NativeScanResult[] return value is.
+static void BM_TransportScanResultsWithParcel(benchmark::State& state) {
+  const vector<NativeScanResult> scan_results =
+      CreateScanResults(state.range(0));
+  for (auto _ : state) {
+    Parcel parcel;
+    parcel.writeInt32(scan_results.size());
+    for (const auto& scan_result : scan_results) {
+      parcel.writeInt32(1);
+      scan_result.writeToParcel(&parcel);
+    }
+    parcel.setDataPosition(0);
+    vector<NativeScanResult> received(parcel.readInt32());
+    for (auto& scan_result : received) {
+      parcel.readInt32();
+      scan_result.readFromParcel(&parcel);
+    }
+    benchmark::DoNotOptimize(received.data());
+  }
+}
+BENCHMARK(BM_TransportScanResultsWithParcel)->Arg(50)->Arg(300)->Arg(1000);
+
+// Scan results are written into a sealed memfd, and only the file
+// descriptor and offsets go through the binder buffer.
+static void BM_TransportScanResultsWithSharedMemory(benchmark::State& state) {
+  const vector<NativeScanResult> scan_results =
+      CreateScanResults(state.range(0));
+  for (auto _ : state) {
+    NativeScanResultBuffer buffer;
+    buffer.Write(scan_results);
+    Parcel parcel;
+    buffer.writeToParcel(&parcel);
+    parcel.setDataPosition(0);
+    NativeScanResultBuffer received_buffer;
+    received_buffer.readFromParcel(&parcel);
+    vector<NativeScanResult> received;
+    received_buffer.Read(&received);
+    benchmark::DoNotOptimize(received.data());
+  }
+}
+BENCHMARK(BM_TransportScanResultsWithSharedMemory)
+    ->Arg(50)->Arg(300)->Arg(1000);
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/bounded_lru_map.h"
+
+using std::string;
+
+namespace android {
+namespace wificond {
+
+TEST(BoundedLruMapTest, FindsTouchedEntries) {
+  BoundedLruMap<string, int> lru_map(2);
+  EXPECT_EQ(nullptr, lru_map.Find("a"));
+  lru_map.Touch("a") = 1;
+  ASSERT_NE(nullptr, lru_map.Find("a"));
+  EXPECT_EQ(1, *lru_map.Find("a"));
+  EXPECT_EQ(1u, lru_map.size());
+}
+
+TEST(BoundedLruMapTest, ForgetsLeastRecentlyTouchedEntry) {
+  BoundedLruMap<string, int> lru_map(2);
+  lru_map.Touch("a") = 1;
+  lru_map.Touch("b") = 2;
+  // Touching "a" again makes "b" the least recently touched entry.
+  lru_map.Touch("a") = 3;
+  lru_map.Touch("c") = 4;
+  EXPECT_EQ(2u, lru_map.size());
+  EXPECT_EQ(nullptr, lru_map.Find("b"));
+  ASSERT_NE(nullptr, lru_map.Find("a"));
+  EXPECT_EQ(3, *lru_map.Find("a"));
+  ASSERT_NE(nullptr, lru_map.Find("c"));
+  EXPECT_EQ(4, *lru_map.Find("c"));
+}
+
+TEST(BoundedLruMapTest, LookupsDoNotTouchEntries) {
+  BoundedLruMap<string, int> lru_map(2);
+  lru_map.Touch("a") = 1;
+  lru_map.Touch("b") = 2;
+  lru_map.Find("a");
+  lru_map.Touch("c") = 3;
+  EXPECT_EQ(nullptr, lru_map.Find("a"));
+  EXPECT_EQ(2u, lru_map.GetValues().size());
+}
+
+}  // namespace wificond
+}  // namespace android
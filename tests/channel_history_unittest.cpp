@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/channel_history.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const vector<uint8_t> kFakeSsid1 = {'a', 'p', '1'};
+const vector<uint8_t> kFakeSsid2 = {'a', 'p', '2'};
+const vector<uint8_t> kFakeSsid3 = {'a', 'p', '3'};
+constexpr uint32_t kFakeFrequency1 = 2412;
+constexpr uint32_t kFakeFrequency2 = 2437;
+constexpr uint32_t kFakeFrequency3 = 5180;
+constexpr uint64_t kFakeLastSeenUs = 1000;
+
+NativeScanResult CreateScanResult(const vector<uint8_t>& ssid,
+                                  uint32_t frequency,
+                                  uint64_t last_seen_us) {
+  NativeScanResult scan_result;
+  scan_result.ssid = ssid;
+  scan_result.frequency = frequency;
+  scan_result.tsf = last_seen_us;
+  return scan_result;
+}
+
+}  // namespace
+
+TEST(ChannelHistoryTest, ReturnsChannelsOfRequestedNetworks) {
+  ChannelHistory channel_history;
+  channel_history.Update({
+      CreateScanResult(kFakeSsid1, kFakeFrequency3, kFakeLastSeenUs),
+      CreateScanResult(kFakeSsid1, kFakeFrequency1, kFakeLastSeenUs),
+      CreateScanResult(kFakeSsid2, kFakeFrequency2, kFakeLastSeenUs)});
+  const vector<uint32_t> expected = {kFakeFrequency1, kFakeFrequency3};
+  EXPECT_EQ(expected, channel_history.GetFrequencies({kFakeSsid1}));
+  EXPECT_TRUE(channel_history.GetFrequencies({kFakeSsid3}).empty());
+}
+
+TEST(ChannelHistoryTest, CountsEachSightingOnce) {
+  ChannelHistory channel_history;
+  const vector<NativeScanResult> scan_results = {
+      CreateScanResult(kFakeSsid1, kFakeFrequency1, kFakeLastSeenUs)};
+  // The same scan results are fetched twice.
+  channel_history.Update(scan_results);
+  channel_history.Update(scan_results);
+  EXPECT_EQ(1u, channel_history.GetChannelOccupancy().at(kFakeFrequency1));
+
+  channel_history.Update({
+      CreateScanResult(kFakeSsid1, kFakeFrequency1, kFakeLastSeenUs + 1)});
+  EXPECT_EQ(2u, channel_history.GetChannelOccupancy().at(kFakeFrequency1));
+}
+
+TEST(ChannelHistoryTest, CountsSightingsOfEachNetwork) {
+  ChannelHistory channel_history;
+  channel_history.Update({
+      CreateScanResult(kFakeSsid1, kFakeFrequency1, kFakeLastSeenUs),
+      CreateScanResult(kFakeSsid1, kFakeFrequency3, kFakeLastSeenUs),
+      CreateScanResult(kFakeSsid2, kFakeFrequency2, kFakeLastSeenUs)});
+  EXPECT_EQ(2u, channel_history.GetNumSightings(kFakeSsid1));
+  EXPECT_EQ(1u, channel_history.GetNumSightings(kFakeSsid2));
+  EXPECT_EQ(0u, channel_history.GetNumSightings(kFakeSsid3));
+}
+
+TEST(ChannelHistoryTest, ForgetsChannelsNotSeenForLongest) {
+  ChannelHistory channel_history;
+  for (uint32_t i = 0; i <= ChannelHistory::kMaxChannelsPerSsid; i++) {
+    channel_history.Update({
+        CreateScanResult(kFakeSsid1, kFakeFrequency1 + i, kFakeLastSeenUs)});
+  }
+  vector<uint32_t> frequencies = channel_history.GetFrequencies({kFakeSsid1});
+  EXPECT_EQ(ChannelHistory::kMaxChannelsPerSsid, frequencies.size());
+  EXPECT_EQ(kFakeFrequency1 + 1, frequencies.front());
+}
+
+TEST(ChannelHistoryTest, IgnoresHiddenNetworks) {
+  ChannelHistory channel_history;
+  channel_history.Update({
+      CreateScanResult({}, kFakeFrequency1, kFakeLastSeenUs)});
+  EXPECT_TRUE(channel_history.GetFrequencies({{}}).empty());
+}
+
+}  // namespace wificond
+}  // namespace android
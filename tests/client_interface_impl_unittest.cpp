@@ -22,15 +22,23 @@
 #include <wifi_system_test/mock_interface_tool.h>
 
 #include "wificond/client_interface_impl.h"
+#include "wificond/net/mlme_event.h"
+#include "wificond/scanning/scan_result.h"
+#include "wificond/tests/mock_event_loop.h"
 #include "wificond/tests/mock_netlink_manager.h"
 #include "wificond/tests/mock_netlink_utils.h"
 #include "wificond/tests/mock_scan_utils.h"
+#include "wificond/wiphy_info_cache.h"
 
 using android::wifi_system::MockInterfaceTool;
+using com::android::server::wifi::wificond::NativeScanResult;
 using std::unique_ptr;
 using std::vector;
+using testing::DoAll;
 using testing::NiceMock;
 using testing::Return;
+using testing::SaveArg;
+using testing::SetArgPointee;
 using testing::_;
 
 namespace android {
@@ -41,13 +49,28 @@ const uint32_t kTestWiphyIndex = 2;
 const char kTestInterfaceName[] = "testwifi0";
 const uint32_t kTestInterfaceIndex = 42;
 const size_t kMacAddrLenBytes = ETH_ALEN;
+const uint8_t kFakeBssid[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+const uint8_t kFakeBssid1[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbd};
+const uint16_t kFakeFamilyId = 14;
+const uint32_t kFakeSequenceNumber = 162;
+
+// MLME event packets carry the interface index and the bssid.
+NL80211Packet CreateMlmeEventPacket(uint8_t command, const uint8_t* bssid) {
+  NL80211Packet packet(kFakeFamilyId, command, kFakeSequenceNumber, getpid());
+  packet.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX, kTestInterfaceIndex));
+  packet.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_ATTR_MAC, vector<uint8_t>(bssid, bssid + ETH_ALEN)));
+  return packet;
+}
 
 class ClientInterfaceImplTest : public ::testing::Test {
  protected:
 
   void SetUp() override {
     EXPECT_CALL(*netlink_utils_,
-                SubscribeMlmeEvent(kTestInterfaceIndex, _));
+                SubscribeMlmeEvent(kTestInterfaceIndex, _))
+        .WillOnce(SaveArg<1>(&mlme_event_handler_));
     EXPECT_CALL(*netlink_utils_,
                 GetWiphyInfo(kTestWiphyIndex, _, _, _));
     client_interface_.reset(new ClientInterfaceImpl{
@@ -57,7 +80,26 @@ class ClientInterfaceImplTest : public ::testing::Test {
         vector<uint8_t>{0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
         if_tool_.get(),
         netlink_utils_.get(),
-        scan_utils_.get()});
+        scan_utils_.get(),
+        &wiphy_info_cache_,
+        &event_loop_});
+  }
+
+  void Connect(const uint8_t* bssid) {
+    NL80211Packet packet = CreateMlmeEventPacket(NL80211_CMD_CONNECT, bssid);
+    mlme_event_handler_->OnConnect(MlmeConnectEvent::InitFromPacket(&packet));
+  }
+
+  void Roam(const uint8_t* bssid) {
+    NL80211Packet packet = CreateMlmeEventPacket(NL80211_CMD_ROAM, bssid);
+    mlme_event_handler_->OnRoam(MlmeRoamEvent::InitFromPacket(&packet));
+  }
+
+  void Disconnect() {
+    NL80211Packet packet =
+        CreateMlmeEventPacket(NL80211_CMD_DISCONNECT, kFakeBssid);
+    mlme_event_handler_->OnDisconnect(
+        MlmeDisconnectEvent::InitFromPacket(&packet));
   }
 
   void TearDown() override {
@@ -73,7 +115,10 @@ class ClientInterfaceImplTest : public ::testing::Test {
       new NiceMock<MockNetlinkUtils>(netlink_manager_.get())};
   unique_ptr<NiceMock<MockScanUtils>> scan_utils_{
       new NiceMock<MockScanUtils>(netlink_manager_.get())};
+  WiphyInfoCache wiphy_info_cache_{netlink_utils_.get()};
+  NiceMock<MockEventLoop> event_loop_;
   unique_ptr<ClientInterfaceImpl> client_interface_;
+  MlmeEventHandler* mlme_event_handler_ = nullptr;
 };  // class ClientInterfaceImplTest
 
 }  // namespace
@@ -124,5 +169,107 @@ TEST_F(ClientInterfaceImplTest, SetMacAddressPassesCorrectAddressToIfTool) {
       std::vector<uint8_t>{1, 2, 3, 4, 5, 6}));
 }
 
+TEST_F(ClientInterfaceImplTest, SharesStationInfoBetweenLinkQueries) {
+  Connect(kFakeBssid);
+  const vector<uint8_t> bssid(kFakeBssid, kFakeBssid + ETH_ALEN);
+  StationInfo station_info(100, 5, 650, -60);
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(kTestInterfaceIndex, bssid, _))
+      .WillOnce(DoAll(SetArgPointee<2>(station_info), Return(true)));
+
+  vector<int32_t> signal_poll_results;
+  EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+  ASSERT_EQ(3u, signal_poll_results.size());
+  EXPECT_EQ(-60, signal_poll_results[0]);
+  EXPECT_EQ(65, signal_poll_results[1]);
+  vector<int32_t> packet_counters;
+  EXPECT_TRUE(client_interface_->GetPacketCounters(&packet_counters));
+  EXPECT_EQ(vector<int32_t>({100, 5}), packet_counters);
+}
+
+TEST_F(ClientInterfaceImplTest, QueriesStationInfoAgainAfterRoam) {
+  Connect(kFakeBssid);
+  const vector<uint8_t> bssid(kFakeBssid, kFakeBssid + ETH_ALEN);
+  const vector<uint8_t> bssid1(kFakeBssid1, kFakeBssid1 + ETH_ALEN);
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(kTestInterfaceIndex, bssid, _))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(kTestInterfaceIndex, bssid1, _))
+      .WillOnce(Return(true));
+
+  vector<int32_t> signal_poll_results;
+  EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+  Roam(kFakeBssid1);
+  signal_poll_results.clear();
+  EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+}
+
+TEST_F(ClientInterfaceImplTest, DoesNotReportStaleAssociateFreq) {
+  const uint32_t kFakeFrequency = 5180;
+  vector<NativeScanResult> scan_results(1);
+  scan_results[0].associated = true;
+  scan_results[0].frequency = kFakeFrequency;
+  EXPECT_CALL(*scan_utils_, GetScanResult(kTestInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(scan_results), Return(true)))
+      .WillOnce(Return(false));
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(kTestInterfaceIndex, _, _))
+      .WillRepeatedly(Return(true));
+
+  Connect(kFakeBssid);
+  vector<int32_t> signal_poll_results;
+  EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+  ASSERT_EQ(3u, signal_poll_results.size());
+  EXPECT_EQ(static_cast<int32_t>(kFakeFrequency), signal_poll_results[2]);
+
+  // The frequency of the previous BSS doesn't outlive a failed refresh.
+  Roam(kFakeBssid1);
+  signal_poll_results.clear();
+  EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+  ASSERT_EQ(3u, signal_poll_results.size());
+  EXPECT_EQ(0, signal_poll_results[2]);
+}
+
+TEST_F(ClientInterfaceImplTest, DoesNotCacheStationInfoFailure) {
+  Connect(kFakeBssid);
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(kTestInterfaceIndex, _, _))
+      .WillOnce(Return(false))
+      .WillOnce(Return(true));
+
+  vector<int32_t> signal_poll_results;
+  EXPECT_FALSE(client_interface_->SignalPoll(&signal_poll_results));
+  EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+}
+
+TEST_F(ClientInterfaceImplTest, SamplesLinkQualityOnlyWhileAssociated) {
+  const uint32_t kSamplingIntervalMs = 1000;
+  std::function<void()> sampling_task;
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, _)).Times(0);
+  EXPECT_TRUE(client_interface_->StartLinkQualitySampling(
+      kSamplingIntervalMs));
+  testing::Mock::VerifyAndClearExpectations(&event_loop_);
+
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, kSamplingIntervalMs))
+      .WillRepeatedly(SaveArg<0>(&sampling_task));
+  Connect(kFakeBssid);
+  ASSERT_TRUE(sampling_task != nullptr);
+  StationInfo station_info(100, 5, 650, -60);
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(kTestInterfaceIndex, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(station_info), Return(true)));
+  sampling_task();
+  ASSERT_EQ(1u, client_interface_->GetLinkQualityHistory().size());
+  EXPECT_EQ(-60, client_interface_->GetLinkQualityHistory()[0].rssi);
+  // The sample also serves signal polls.
+  vector<int32_t> signal_poll_results;
+  EXPECT_TRUE(client_interface_->SignalPoll(&signal_poll_results));
+
+  Disconnect();
+  EXPECT_CALL(*netlink_utils_, GetStationInfo(_, _, _)).Times(0);
+  sampling_task();
+  EXPECT_EQ(1u, client_interface_->GetLinkQualityHistory().size());
+}
+
+TEST_F(ClientInterfaceImplTest, RejectsTooShortLinkQualitySamplingInterval) {
+  EXPECT_FALSE(client_interface_->StartLinkQualitySampling(
+      LinkQualitySampler::kMinIntervalMs - 1));
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/hidden_ssid_scheduler.h"
+
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const vector<uint8_t> kFakeSsid1 = {'a', 'p', '1'};
+const vector<uint8_t> kFakeSsid2 = {'a', 'p', '2'};
+const vector<uint8_t> kFakeSsid3 = {'a', 'p', '3'};
+constexpr uint64_t kFakeTimestampMs = 1000;
+
+}  // namespace
+
+TEST(HiddenSsidSchedulerTest, KeepsOrderOfNetworksNeverProbed) {
+  HiddenSsidScheduler scheduler;
+  const vector<vector<uint8_t>> expected = {kFakeSsid1, kFakeSsid2, kFakeSsid3};
+  EXPECT_EQ(expected, scheduler.Prioritize(
+      {kFakeSsid1, kFakeSsid2, kFakeSsid1, kFakeSsid3}));
+}
+
+TEST(HiddenSsidSchedulerTest, PrioritizesLeastRecentlyProbedNetworks) {
+  HiddenSsidScheduler scheduler;
+  scheduler.MarkProbed({kFakeSsid1}, kFakeTimestampMs + 1);
+  scheduler.MarkProbed({kFakeSsid2}, kFakeTimestampMs);
+  const vector<vector<uint8_t>> expected = {kFakeSsid3, kFakeSsid2, kFakeSsid1};
+  EXPECT_EQ(expected, scheduler.Prioritize(
+      {kFakeSsid1, kFakeSsid2, kFakeSsid3}));
+}
+
+TEST(HiddenSsidSchedulerTest, RotatesThroughAllNetworks) {
+  HiddenSsidScheduler scheduler;
+  const vector<vector<uint8_t>> ssids = {kFakeSsid1, kFakeSsid2, kFakeSsid3};
+  // Probe a single network at a time.
+  vector<vector<uint8_t>> probed_ssids;
+  for (uint64_t i = 0; i < ssids.size(); i++) {
+    vector<uint8_t> ssid = scheduler.Prioritize(ssids).front();
+    scheduler.MarkProbed({ssid}, kFakeTimestampMs + i);
+    probed_ssids.push_back(ssid);
+  }
+  EXPECT_EQ(ssids, probed_ssids);
+  EXPECT_EQ(kFakeSsid1, scheduler.Prioritize(ssids).front());
+}
+
+TEST(HiddenSsidSchedulerTest, ExposesLastProbedTimes) {
+  HiddenSsidScheduler scheduler;
+  scheduler.MarkProbed({{}, kFakeSsid1}, kFakeTimestampMs);
+  const auto& last_probed_times = scheduler.GetLastProbedTimes();
+  // The wildcard ssid is not tracked.
+  ASSERT_EQ(1u, last_probed_times.size());
+  EXPECT_EQ(kFakeTimestampMs, last_probed_times.at(kFakeSsid1));
+}
+
+TEST(HiddenSsidSchedulerTest, ForgetsLeastRecentlyProbedNetworks) {
+  HiddenSsidScheduler scheduler;
+  for (size_t i = 0; i <= kMaxTrackedSsids; i++) {
+    vector<uint8_t> ssid = {static_cast<uint8_t>(i >> 8),
+                            static_cast<uint8_t>(i)};
+    scheduler.MarkProbed({ssid}, kFakeTimestampMs + i);
+  }
+  const auto& last_probed_times = scheduler.GetLastProbedTimes();
+  EXPECT_EQ(kMaxTrackedSsids, last_probed_times.size());
+  EXPECT_EQ(0u, last_probed_times.count(vector<uint8_t>{0, 0}));
+}
+
+}  // namespace wificond
+}  // namespace android
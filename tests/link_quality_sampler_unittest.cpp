@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "wificond/link_quality_sampler.h"
+#include "wificond/tests/mock_event_loop.h"
+
+using com::android::server::wifi::wificond::LinkQualitySample;
+using std::function;
+using std::unique_ptr;
+using std::vector;
+using testing::NiceMock;
+using testing::SaveArg;
+using testing::_;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr uint32_t kFakeIntervalMs = 1000;
+constexpr int8_t kFakeRssi = -60;
+constexpr uint32_t kFakeTxBitrate = 650;
+constexpr uint32_t kFakeTxPackets = 100;
+constexpr uint32_t kFakeTxFailed = 5;
+
+class LinkQualitySamplerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ON_CALL(event_loop_, PostDelayedTask(_, _))
+        .WillByDefault(SaveArg<0>(&pending_task_));
+  }
+
+  bool GetStationInfo(StationInfo* out_station_info) {
+    num_station_info_queries_++;
+    if (!has_station_info_) {
+      return false;
+    }
+    *out_station_info = StationInfo(kFakeTxPackets + num_station_info_queries_,
+                                    kFakeTxFailed,
+                                    kFakeTxBitrate,
+                                    kFakeRssi);
+    return true;
+  }
+
+  // Runs the task last posted to the event loop.
+  void RunPendingTask() {
+    function<void()> task = pending_task_;
+    pending_task_ = nullptr;
+    ASSERT_TRUE(task != nullptr);
+    task();
+  }
+
+  NiceMock<MockEventLoop> event_loop_;
+  function<void()> pending_task_;
+  bool has_station_info_ = true;
+  int num_station_info_queries_ = 0;
+  unique_ptr<LinkQualitySampler> sampler_{new LinkQualitySampler(
+      &event_loop_,
+      std::bind(&LinkQualitySamplerTest::GetStationInfo,
+                this,
+                std::placeholders::_1))};
+};
+
+}  // namespace
+
+TEST_F(LinkQualitySamplerTest, RejectsTooShortInterval) {
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, _)).Times(0);
+  EXPECT_FALSE(sampler_->Start(LinkQualitySampler::kMinIntervalMs - 1));
+  EXPECT_FALSE(sampler_->IsRunning());
+}
+
+TEST_F(LinkQualitySamplerTest, TakesSampleOnEachInterval) {
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, kFakeIntervalMs))
+      .Times(3)
+      .WillRepeatedly(SaveArg<0>(&pending_task_));
+  EXPECT_TRUE(sampler_->Start(kFakeIntervalMs));
+  EXPECT_TRUE(sampler_->IsRunning());
+  EXPECT_TRUE(sampler_->GetHistory().empty());
+
+  RunPendingTask();
+  RunPendingTask();
+  vector<LinkQualitySample> history = sampler_->GetHistory();
+  ASSERT_EQ(2u, history.size());
+  EXPECT_EQ(kFakeRssi, history[0].rssi);
+  // Bitrate is converted from 100kbit/s to Mbps.
+  EXPECT_EQ(static_cast<int32_t>(kFakeTxBitrate / 10),
+            history[0].tx_bitrate_mbps);
+  EXPECT_EQ(kFakeTxPackets + 1, history[0].tx_packets);
+  EXPECT_EQ(kFakeTxFailed, history[0].tx_failed);
+  EXPECT_EQ(kFakeTxPackets + 2, history[1].tx_packets);
+  EXPECT_LE(history[0].timestamp_ms, history[1].timestamp_ms);
+}
+
+TEST_F(LinkQualitySamplerTest, SkipsSampleWithoutStationInfo) {
+  EXPECT_TRUE(sampler_->Start(kFakeIntervalMs));
+  has_station_info_ = false;
+  RunPendingTask();
+  EXPECT_TRUE(sampler_->GetHistory().empty());
+  // Sampling continues on the next interval.
+  has_station_info_ = true;
+  RunPendingTask();
+  EXPECT_EQ(1u, sampler_->GetHistory().size());
+}
+
+TEST_F(LinkQualitySamplerTest, IgnoresPendingTaskAfterStop) {
+  EXPECT_TRUE(sampler_->Start(kFakeIntervalMs));
+  sampler_->Stop();
+  EXPECT_FALSE(sampler_->IsRunning());
+  EXPECT_CALL(event_loop_, PostDelayedTask(_, _)).Times(0);
+  RunPendingTask();
+  EXPECT_EQ(0, num_station_info_queries_);
+}
+
+TEST_F(LinkQualitySamplerTest, IgnoresPendingTaskOfPreviousInterval) {
+  EXPECT_TRUE(sampler_->Start(kFakeIntervalMs));
+  function<void()> previous_task = pending_task_;
+  EXPECT_TRUE(sampler_->Start(kFakeIntervalMs * 2));
+  previous_task();
+  EXPECT_EQ(0, num_station_info_queries_);
+}
+
+TEST_F(LinkQualitySamplerTest, IgnoresPendingTaskAfterDestruction) {
+  EXPECT_TRUE(sampler_->Start(kFakeIntervalMs));
+  sampler_.reset();
+  RunPendingTask();
+  EXPECT_EQ(0, num_station_info_queries_);
+}
+
+TEST_F(LinkQualitySamplerTest, KeepsMostRecentSamplesWhenFull) {
+  const size_t kNumExtraSamples = 5;
+  EXPECT_TRUE(sampler_->Start(kFakeIntervalMs));
+  for (size_t i = 0;
+       i < LinkQualitySampler::kMaxNumSamples + kNumExtraSamples;
+       i++) {
+    RunPendingTask();
+  }
+  vector<LinkQualitySample> history = sampler_->GetHistory();
+  ASSERT_EQ(LinkQualitySampler::kMaxNumSamples, history.size());
+  // The oldest samples are overwritten first.
+  for (size_t i = 0; i < history.size(); i++) {
+    EXPECT_EQ(static_cast<int64_t>(kFakeTxPackets + kNumExtraSamples + i + 1),
+              history[i].tx_packets);
+  }
+}
+
+}  // namespace wificond
+}  // namespace android
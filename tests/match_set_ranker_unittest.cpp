@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/scanning/channel_history.h"
+#include "wificond/scanning/match_set_ranker.h"
+
+using ::com::android::server::wifi::wificond::NativeScanResult;
+using ::com::android::server::wifi::wificond::PnoNetwork;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const vector<uint8_t> kFakeSsid1 = {'a', 'p', '1'};
+const vector<uint8_t> kFakeSsid2 = {'a', 'p', '2'};
+const vector<uint8_t> kFakeSsid3 = {'a', 'p', '3'};
+const vector<uint8_t> kFakeSsid4 = {'a', 'p', '4'};
+const vector<uint8_t> kFakeSsid5 = {'a', 'p', '5'};
+constexpr uint32_t kFakeFrequency = 2412;
+constexpr uint64_t kFakeTimestampMs = 1000;
+
+PnoNetwork CreatePnoNetwork(const vector<uint8_t>& ssid, int32_t priority) {
+  PnoNetwork network;
+  network.is_hidden_ = false;
+  network.ssid_ = ssid;
+  network.priority_ = priority;
+  return network;
+}
+
+vector<vector<uint8_t>> GetSsids(const vector<PnoNetwork>& networks) {
+  vector<vector<uint8_t>> ssids;
+  for (const auto& network : networks) {
+    ssids.push_back(network.ssid_);
+  }
+  return ssids;
+}
+
+}  // namespace
+
+class MatchSetRankerTest : public ::testing::Test {
+ protected:
+  ChannelHistory channel_history_;
+  MatchSetRanker ranker_{&channel_history_};
+};
+
+TEST_F(MatchSetRankerTest, KeepsNetworksWhichFit) {
+  const vector<PnoNetwork> networks = {CreatePnoNetwork(kFakeSsid1, 0),
+                                       CreatePnoNetwork(kFakeSsid2, 1)};
+  EXPECT_EQ(networks, ranker_.Select(networks, 2));
+}
+
+TEST_F(MatchSetRankerTest, RanksByPriorityThenConnectionThenSightings) {
+  NativeScanResult scan_result;
+  scan_result.ssid = kFakeSsid3;
+  scan_result.frequency = kFakeFrequency;
+  scan_result.tsf = 1;
+  channel_history_.Update({scan_result});
+  ranker_.RecordConnected(kFakeSsid2, kFakeTimestampMs);
+
+  const vector<PnoNetwork> networks = {CreatePnoNetwork(kFakeSsid1, 0),
+                                       CreatePnoNetwork(kFakeSsid2, 0),
+                                       CreatePnoNetwork(kFakeSsid3, 0),
+                                       CreatePnoNetwork(kFakeSsid4, 1)};
+  // A single match set isn't rotated.
+  EXPECT_EQ(vector<vector<uint8_t>>({kFakeSsid4}),
+            GetSsids(ranker_.Select(networks, 1)));
+  // The last of the 3 match sets is rotated among the lower ranked networks,
+  // none of which was matched yet.
+  EXPECT_EQ(vector<vector<uint8_t>>({kFakeSsid4, kFakeSsid2, kFakeSsid3}),
+            GetSsids(ranker_.Select(networks, 3)));
+}
+
+TEST_F(MatchSetRankerTest, RotatesLowerRankedNetworks) {
+  const vector<PnoNetwork> networks = {CreatePnoNetwork(kFakeSsid1, 2),
+                                       CreatePnoNetwork(kFakeSsid2, 1),
+                                       CreatePnoNetwork(kFakeSsid3, 0),
+                                       CreatePnoNetwork(kFakeSsid4, 0),
+                                       CreatePnoNetwork(kFakeSsid5, 0)};
+  vector<vector<uint8_t>> rotated_ssids;
+  for (uint64_t i = 0; i < 4; i++) {
+    vector<vector<uint8_t>> ssids = GetSsids(ranker_.Select(networks, 2));
+    ASSERT_EQ(2u, ssids.size());
+    // The best ranked network always has a match set.
+    EXPECT_EQ(kFakeSsid1, ssids[0]);
+    rotated_ssids.push_back(ssids[1]);
+    ranker_.MarkMatched(ssids, kFakeTimestampMs + i);
+  }
+  EXPECT_EQ(vector<vector<uint8_t>>(
+                {kFakeSsid2, kFakeSsid3, kFakeSsid4, kFakeSsid5}),
+            rotated_ssids);
+}
+
+TEST_F(MatchSetRankerTest, ForgetsLeastRecentlyMatchedNetworks) {
+  for (size_t i = 0; i <= kMaxTrackedSsids; i++) {
+    vector<uint8_t> ssid = {static_cast<uint8_t>(i >> 8),
+                            static_cast<uint8_t>(i)};
+    ranker_.MarkMatched({ssid}, kFakeTimestampMs + i);
+  }
+  // The first network is forgotten, so it is rotated in first again.
+  const vector<PnoNetwork> networks = {CreatePnoNetwork({0, 1}, 0),
+                                       CreatePnoNetwork({0, 0}, 0),
+                                       CreatePnoNetwork({0, 2}, 0)};
+  EXPECT_EQ(vector<uint8_t>({0, 0}), ranker_.Select(networks, 2)[1].ssid_);
+}
+
+}  // namespace wificond
+}  // namespace android
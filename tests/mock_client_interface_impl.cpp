@@ -23,6 +23,7 @@
 
 #include "wificond/net/netlink_utils.h"
 #include "wificond/scanning/scan_utils.h"
+#include "wificond/wiphy_info_cache.h"
 
 namespace android {
 namespace wificond {
@@ -35,7 +36,9 @@ const uint32_t kTestWiphyIndex = 2;
 MockClientInterfaceImpl::MockClientInterfaceImpl(
       android::wifi_system::InterfaceTool* interface_tool,
       NetlinkUtils* netlink_utils,
-      ScanUtils* scan_utils)
+      ScanUtils* scan_utils,
+      WiphyInfoCache* wiphy_info_cache,
+      EventLoop* event_loop)
     : ClientInterfaceImpl(
         kTestWiphyIndex,
         kTestInterfaceName,
@@ -45,7 +48,9 @@ MockClientInterfaceImpl::MockClientInterfaceImpl(
             kTestInterfaceMacAddress + arraysize(kTestInterfaceMacAddress)),
         interface_tool,
         netlink_utils,
-        scan_utils) {}
+        scan_utils,
+        wiphy_info_cache,
+        event_loop) {}
 
 }  // namespace wificond
 }  // namespace android
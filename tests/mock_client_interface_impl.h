@@ -30,7 +30,9 @@ class MockClientInterfaceImpl : public ClientInterfaceImpl {
   MockClientInterfaceImpl(
       android::wifi_system::InterfaceTool*,
       NetlinkUtils*,
-      ScanUtils*);
+      ScanUtils*,
+      WiphyInfoCache*,
+      EventLoop*);
   ~MockClientInterfaceImpl() override = default;
 
   MOCK_CONST_METHOD0(IsAssociated, bool());
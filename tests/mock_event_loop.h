@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_TESTS_MOCK_EVENT_LOOP_H_
+#define WIFICOND_TESTS_MOCK_EVENT_LOOP_H_
+
+#include <gmock/gmock.h>
+
+#include "wificond/event_loop.h"
+
+namespace android {
+namespace wificond {
+
+class MockEventLoop : public EventLoop {
+ public:
+  MockEventLoop() = default;
+  ~MockEventLoop() override = default;
+
+  MOCK_METHOD1(PostTask, void(const std::function<void()>& callback));
+  MOCK_METHOD2(PostDelayedTask,
+               void(const std::function<void()>& callback, int64_t delay_ms));
+  MOCK_METHOD3(WatchFileDescriptor,
+               bool(int fd,
+                    ReadyMode mode,
+                    const std::function<void(int)>& callback));
+  MOCK_METHOD1(StopWatchFileDescriptor, bool(int fd));
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_TESTS_MOCK_EVENT_LOOP_H_
@@ -54,6 +54,12 @@ class MockNetlinkUtils : public NetlinkUtils {
   MOCK_METHOD2(GetInterfaces,
                bool(uint32_t wiphy_index,
                     std::vector<InterfaceInfo>* interfaces));
+  MOCK_METHOD3(GetStationInfo,
+               bool(uint32_t interface_index,
+                    const std::vector<uint8_t>& mac_address,
+                    StationInfo* out_station_info));
+  MOCK_METHOD2(GetStationTable,
+               bool(uint32_t interface_index, StationTable* out_stations));
   MOCK_METHOD4(GetWiphyInfo,
                bool(uint32_t wiphy_index,
                     BandInfo* band_info,
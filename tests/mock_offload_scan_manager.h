@@ -32,8 +32,9 @@ class MockOffloadScanManager : public OffloadScanManager {
       std::shared_ptr<OffloadScanCallbackInterface> callback_interface);
   ~MockOffloadScanManager() override = default;
 
-  MOCK_METHOD7(startScan,
-               bool(uint32_t interval_ms, int32_t rssi_threshold,
+  MOCK_METHOD8(startScan,
+               bool(uint32_t interval_ms, int32_t rssi_threshold_2g,
+                    int32_t rssi_threshold_5g,
                     const std::vector<std::vector<uint8_t>>& scan_ssids,
                     const std::vector<std::vector<uint8_t>>& match_ssids,
                     const std::vector<uint8_t>& match_security,
@@ -40,6 +40,10 @@ class MockScanUtils : public ScanUtils {
   MOCK_METHOD2(GetScanResult, bool(
       uint32_t interface_index,
       std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results));
+  MOCK_METHOD3(GetFilteredScanResult, bool(
+      uint32_t interface_index,
+      const ::com::android::server::wifi::wificond::ScanResultFilter& filter,
+      std::vector<::com::android::server::wifi::wificond::NativeScanResult>* out_scan_results));
 
   MOCK_METHOD6(Scan, bool(
       uint32_t interface_index,
@@ -49,15 +53,14 @@ class MockScanUtils : public ScanUtils {
       const std::vector<uint32_t>& freqs,
       int* error_code));
 
-  MOCK_METHOD10(StartScheduledScan, bool(
+  MOCK_METHOD9(StartScheduledScan, bool(
       uint32_t interface_index,
       const SchedScanIntervalSetting& interval_setting,
-      int32_t rssi_threshold_2g,
-      int32_t rssi_threshold_5g,
+      const SchedScanRssiSetting& rssi_setting,
       bool request_random_mac,
       bool request_low_power,
       const std::vector<std::vector<uint8_t>>& scan_ssids,
-      const std::vector<std::vector<uint8_t>>& match_ssids,
+      const std::vector<SchedScanMatchSet>& match_sets,
       const std::vector<uint32_t>& freqs,
       int* error_code));
 
@@ -15,11 +15,28 @@
  */
 
 #include <memory>
+#include <vector>
 
+#include <poll.h>
+
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "wificond/looper_backed_event_loop.h"
+#include "wificond/net/kernel-header-latest/nl80211.h"
 #include "wificond/net/netlink_manager.h"
+#include "wificond/net/nl80211_packet.h"
+#include "wificond/tests/mock_event_loop.h"
+
+using std::function;
+using std::unique_ptr;
+using std::vector;
+using testing::_;
+using testing::DoAll;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
 
 namespace android {
 namespace wificond {
@@ -41,5 +58,160 @@ TEST_F(NetlinkManagerTest, CanSetupNetlinkManagerInARowTest) {
   EXPECT_TRUE(netlink_manager.Start());
 }
 
+TEST_F(NetlinkManagerTest, CanConfigureReceiveBufferSizesTest) {
+  const size_t kDatagramBufferSize = 16 * 1024;
+  NetlinkManager netlink_manager(event_loop_.get(),
+                                 64 * 1024,
+                                 kDatagramBufferSize);
+  EXPECT_TRUE(netlink_manager.Start());
+  const NetlinkReceiveStats& stats = netlink_manager.GetReceiveStats();
+  EXPECT_GE(stats.datagram_buffer_size, kDatagramBufferSize);
+  EXPECT_EQ(0u, stats.num_truncated_datagrams);
+}
+
+TEST_F(NetlinkManagerTest, CanSendPipelinedMessagesTest) {
+  NetlinkManager netlink_manager(event_loop_.get());
+  ASSERT_TRUE(netlink_manager.Start());
+
+  vector<NL80211Packet> packets;
+  for (int i = 0; i < 3; i++) {
+    packets.emplace_back(netlink_manager.GetFamilyId(),
+                         NL80211_CMD_GET_PROTOCOL_FEATURES,
+                         netlink_manager.GetSequenceNumber(),
+                         getpid());
+  }
+  vector<vector<unique_ptr<const NL80211Packet>>> responses;
+  EXPECT_TRUE(netlink_manager.SendMessagesAndGetResponses(packets,
+                                                          &responses));
+  ASSERT_EQ(packets.size(), responses.size());
+  for (size_t i = 0; i < packets.size(); i++) {
+    ASSERT_EQ(1u, responses[i].size());
+    EXPECT_EQ(packets[i].GetMessageSequence(),
+              responses[i][0]->GetMessageSequence());
+  }
+}
+
+TEST_F(NetlinkManagerTest, CanHandleResponsesAsTheyArriveTest) {
+  NetlinkManager netlink_manager(event_loop_.get());
+  ASSERT_TRUE(netlink_manager.Start());
+
+  NL80211Packet packet(netlink_manager.GetFamilyId(),
+                       NL80211_CMD_GET_PROTOCOL_FEATURES,
+                       netlink_manager.GetSequenceNumber(),
+                       getpid());
+  vector<uint32_t> sequences;
+  EXPECT_TRUE(netlink_manager.SendMessageAndHandleResponses(
+      packet,
+      [&sequences](const NL80211PacketView& response) {
+        sequences.push_back(response.GetMessageSequence());
+      }));
+  ASSERT_EQ(1u, sequences.size());
+  EXPECT_EQ(packet.GetMessageSequence(), sequences[0]);
+}
+
+TEST_F(NetlinkManagerTest, DumpWaitsForTimedOutDumpToEndTest) {
+  NiceMock<MockEventLoop> event_loop;
+  int async_fd = -1;
+  function<void(int)> on_async_fd_readable;
+  EXPECT_CALL(event_loop, WatchFileDescriptor(_, _, _))
+      .WillOnce(DoAll(SaveArg<0>(&async_fd),
+                      SaveArg<2>(&on_async_fd_readable),
+                      Return(true)));
+  vector<function<void()>> timeout_tasks;
+  ON_CALL(event_loop, PostDelayedTask(_, _))
+      .WillByDefault(Invoke(
+          [&timeout_tasks](const function<void()>& task, int64_t) {
+            timeout_tasks.push_back(task);
+          }));
+  NetlinkManager netlink_manager(&event_loop);
+  ASSERT_TRUE(netlink_manager.Start());
+
+  vector<DumpResult> results;
+  for (int i = 0; i < 2; i++) {
+    NL80211Packet get_wiphy(netlink_manager.GetFamilyId(),
+                            NL80211_CMD_GET_WIPHY,
+                            netlink_manager.GetSequenceNumber(),
+                            getpid());
+    get_wiphy.AddFlag(NLM_F_DUMP);
+    EXPECT_TRUE(netlink_manager.RegisterHandlerAndSendDumpMessage(
+        get_wiphy,
+        [](const NL80211PacketView& packet) {},
+        [&results](DumpResult result, int error_code) {
+          results.push_back(result);
+        }));
+  }
+  // The second dump is queued behind the first one.
+  ASSERT_EQ(1u, timeout_tasks.size());
+  timeout_tasks[0]();
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ(DUMP_TIMEOUT, results[0]);
+  // The first dump still holds the socket until its replies are read.
+  // Only its second deadline is scheduled, the second dump isn't sent yet.
+  EXPECT_EQ(2u, timeout_tasks.size());
+
+  struct pollfd fd = {async_fd, POLLIN, 0};
+  while (results.size() < 2 && poll(&fd, 1, 1000) == 1) {
+    on_async_fd_readable(async_fd);
+  }
+  EXPECT_EQ(3u, timeout_tasks.size());
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(DUMP_DONE, results[1]);
+  // The second deadline of the first dump no longer matters.
+  timeout_tasks[1]();
+  EXPECT_EQ(2u, results.size());
+}
+
+TEST_F(NetlinkManagerTest, TimedOutDumpReleasesSocketAfterSecondDeadline) {
+  NiceMock<MockEventLoop> event_loop;
+  int async_fd = -1;
+  function<void(int)> on_async_fd_readable;
+  EXPECT_CALL(event_loop, WatchFileDescriptor(_, _, _))
+      .WillOnce(DoAll(SaveArg<0>(&async_fd),
+                      SaveArg<2>(&on_async_fd_readable),
+                      Return(true)));
+  vector<function<void()>> timeout_tasks;
+  ON_CALL(event_loop, PostDelayedTask(_, _))
+      .WillByDefault(Invoke(
+          [&timeout_tasks](const function<void()>& task, int64_t) {
+            timeout_tasks.push_back(task);
+          }));
+  NetlinkManager netlink_manager(&event_loop);
+  ASSERT_TRUE(netlink_manager.Start());
+
+  vector<DumpResult> results;
+  for (int i = 0; i < 2; i++) {
+    NL80211Packet get_wiphy(netlink_manager.GetFamilyId(),
+                            NL80211_CMD_GET_WIPHY,
+                            netlink_manager.GetSequenceNumber(),
+                            getpid());
+    get_wiphy.AddFlag(NLM_F_DUMP);
+    EXPECT_TRUE(netlink_manager.RegisterHandlerAndSendDumpMessage(
+        get_wiphy,
+        [](const NL80211PacketView& packet) {},
+        [&results](DumpResult result, int error_code) {
+          results.push_back(result);
+        }));
+  }
+  ASSERT_EQ(1u, timeout_tasks.size());
+  timeout_tasks[0]();
+  ASSERT_EQ(2u, timeout_tasks.size());
+  // Pretend the end of the first dump was lost. The second deadline sends
+  // the queued dump without any reply being read.
+  timeout_tasks[1]();
+  EXPECT_EQ(3u, timeout_tasks.size());
+  EXPECT_EQ(1u, results.size());
+
+  // Late replies of the first dump are ignored. Kernel may still refuse the
+  // second dump while it runs the first one, but either way the second dump
+  // completes instead of waiting forever.
+  struct pollfd fd = {async_fd, POLLIN, 0};
+  while (results.size() < 2 && poll(&fd, 1, 1000) == 1) {
+    on_async_fd_readable(async_fd);
+  }
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(DUMP_TIMEOUT, results[0]);
+  EXPECT_NE(DUMP_TIMEOUT, results[1]);
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 
+#include <linux/if_ether.h>
 #include <linux/netlink.h>
 
 #include <gtest/gtest.h>
@@ -29,9 +30,13 @@
 using std::string;
 using std::unique_ptr;
 using std::vector;
+using std::placeholders::_1;
+using std::placeholders::_2;
 using testing::DoAll;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::SaveArg;
 using testing::_;
 
 namespace android {
@@ -71,6 +76,17 @@ const uint8_t kFakeExtFeaturesForLowSpanScan[] = {0x0, 0x0, 0x40};
 const uint8_t kFakeExtFeaturesForLowPowerScan[] = {0x0, 0x0, 0x80};
 const uint8_t kFakeExtFeaturesForHighAccuracy[] = {0x0, 0x0, 0x0, 0x1};
 const uint8_t kFakeExtFeaturesForAllScanType[] = {0x0, 0x0, 0xC0, 0x1};
+// Counters larger than INT32_MAX must not be truncated.
+constexpr uint32_t kFakeTxPackets = 0x80000001;
+constexpr uint32_t kFakeTxFailed = 20;
+constexpr uint32_t kFakeTxBitrate = 8667;
+constexpr int8_t kFakeRssi = -55;
+constexpr int8_t kFakeAverageRssi = -57;
+constexpr uint32_t kFakeRxBitrate = 5850;
+constexpr uint32_t kFakeInactiveTimeMs = 300;
+constexpr uint32_t kFakeRxBytes = 4000;
+// Byte counters larger than UINT32_MAX are only reported as 64 bit values.
+constexpr uint64_t kFakeTxBytes64 = 0x100000002;
 
 // Currently, control messages are only created by the kernel and sent to us.
 // Therefore NL80211Packet doesn't have corresponding constructor.
@@ -269,6 +285,59 @@ void VerifyWiphyFeatures(const WiphyFeatures& wiphy_features) {
   EXPECT_FALSE(wiphy_features.supports_random_mac_sched_scan);
 }
 
+// Station dump reply for the station with MAC address |mac_address|.
+NL80211Packet CreateNewStationMessage(const uint8_t* mac_address) {
+  NL80211Packet new_station(
+      kFakeFamilyId,
+      NL80211_CMD_NEW_STATION,
+      kFakeSequenceNumber,
+      getpid());
+  new_station.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_ATTR_MAC,
+      vector<uint8_t>(mac_address, mac_address + ETH_ALEN)));
+  NL80211NestedAttr tx_bitrate(NL80211_STA_INFO_TX_BITRATE);
+  tx_bitrate.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_RATE_INFO_BITRATE32, kFakeTxBitrate));
+  NL80211NestedAttr rx_bitrate(NL80211_STA_INFO_RX_BITRATE);
+  rx_bitrate.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_RATE_INFO_BITRATE32, kFakeRxBitrate));
+  NL80211NestedAttr sta_info(NL80211_ATTR_STA_INFO);
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_PACKETS, kFakeTxPackets));
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_FAILED, kFakeTxFailed));
+  sta_info.AddAttribute(
+      NL80211Attr<int8_t>(NL80211_STA_INFO_SIGNAL, kFakeRssi));
+  sta_info.AddAttribute(
+      NL80211Attr<int8_t>(NL80211_STA_INFO_SIGNAL_AVG, kFakeAverageRssi));
+  sta_info.AddAttribute(NL80211Attr<uint32_t>(
+      NL80211_STA_INFO_INACTIVE_TIME, kFakeInactiveTimeMs));
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_RX_BYTES, kFakeRxBytes));
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_BYTES,
+                            static_cast<uint32_t>(kFakeTxBytes64)));
+  sta_info.AddAttribute(
+      NL80211Attr<uint64_t>(NL80211_STA_INFO_TX_BYTES64, kFakeTxBytes64));
+  sta_info.AddAttribute(tx_bitrate);
+  sta_info.AddAttribute(rx_bitrate);
+  new_station.AddAttribute(sta_info);
+  return new_station;
+}
+
+// This mocks the behavior of SendMessageAndHandleResponses(), which passes
+// each packet of the response to |handler|.
+bool HandleMessagesAndReturn(
+    const vector<NL80211Packet>& mock_responses,
+    bool mock_return_value,
+    const NL80211Packet& request_message,
+    std::function<void(const NL80211PacketView&)> handler) {
+  for (const auto& mock_response : mock_responses) {
+    handler(NL80211PacketView(mock_response));
+  }
+  return mock_return_value;
+}
+
 }  // namespace
 
 // This mocks the behavior of SendMessageAndGetResponses(), which returns a
@@ -297,11 +366,22 @@ class NetlinkUtilsTest : public ::testing::Test {
 
   void SetSplitWiphyDumpSupported(bool supported) {
     netlink_utils_->supports_split_wiphy_dump_ = supported;
+    netlink_utils_->has_protocol_features_ = true;
   }
 
 };
 
+TEST(NetlinkUtilsBandTest, ClassifiesFrequenciesByBand) {
+  EXPECT_TRUE(Is2GHzFrequency(2412));
+  EXPECT_FALSE(Is5GHzFrequency(2412));
+  EXPECT_TRUE(Is5GHzFrequency(5180));
+  EXPECT_FALSE(Is2GHzFrequency(5180));
+  // 802.11p channels for vehicular communication systems are excluded.
+  EXPECT_FALSE(Is5GHzFrequency(5900));
+}
+
 TEST_F(NetlinkUtilsTest, CanGetWiphyIndex) {
+  SetSplitWiphyDumpSupported(false);
   NL80211Packet new_wiphy(
       netlink_manager_->GetFamilyId(),
       NL80211_CMD_NEW_WIPHY,
@@ -322,6 +402,7 @@ TEST_F(NetlinkUtilsTest, CanGetWiphyIndex) {
 }
 
 TEST_F(NetlinkUtilsTest, CanHandleGetWiphyIndexError) {
+  SetSplitWiphyDumpSupported(false);
   // Mock an error response from kernel.
   vector<NL80211Packet> response = {CreateControlMessageError(kFakeErrorCode)};
 
@@ -332,6 +413,48 @@ TEST_F(NetlinkUtilsTest, CanHandleGetWiphyIndexError) {
   EXPECT_FALSE(netlink_utils_->GetWiphyIndex(&wiphy_index));
 }
 
+TEST_F(NetlinkUtilsTest, PipelinesProtocolFeaturesWithFirstWiphyDump) {
+  NL80211Packet new_wiphy(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_WIPHY,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  new_wiphy.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY, kFakeWiphyIndex));
+  NL80211Packet protocol_features(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_GET_PROTOCOL_FEATURES,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  protocol_features.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_ATTR_PROTOCOL_FEATURES,
+                            NL80211_PROTOCOL_FEATURE_SPLIT_WIPHY_DUMP));
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).Times(0);
+  EXPECT_CALL(*netlink_manager_, SendMessagesAndGetResponses(_, _)).
+      WillOnce(Invoke([&](
+          const vector<NL80211Packet>& packets,
+          vector<vector<unique_ptr<const NL80211Packet>>>* responses) {
+        EXPECT_EQ(2u, packets.size());
+        EXPECT_EQ(NL80211_CMD_GET_PROTOCOL_FEATURES, packets[0].GetCommand());
+        EXPECT_EQ(NL80211_CMD_GET_WIPHY, packets[1].GetCommand());
+        responses->resize(2);
+        (*responses)[0].emplace_back(new NL80211Packet(protocol_features));
+        (*responses)[1].emplace_back(new NL80211Packet(new_wiphy));
+        return true;
+      }));
+
+  uint32_t wiphy_index;
+  EXPECT_TRUE(netlink_utils_->GetWiphyIndex(&wiphy_index));
+  EXPECT_EQ(kFakeWiphyIndex, wiphy_index);
+  EXPECT_TRUE(netlink_utils_->supports_split_wiphy_dump_);
+  // Later dumps don't ask for the protocol features again.
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(vector<NL80211Packet>{new_wiphy}),
+                     Return(true)));
+  EXPECT_TRUE(netlink_utils_->GetWiphyIndex(&wiphy_index));
+}
+
 TEST_F(NetlinkUtilsTest, CanSetIntrerfaceMode) {
   // Mock a ACK response from kernel.
   vector<NL80211Packet> response = {CreateControlMessageAck()};
@@ -430,6 +553,67 @@ TEST_F(NetlinkUtilsTest, SkipsPseudoDevicesWhenGetInterfaces) {
   EXPECT_EQ(if_mac_addr, interfaces[0].mac_address);
 }
 
+TEST_F(NetlinkUtilsTest, CanGetInterfacesAsync) {
+  NL80211Packet new_interface(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_INTERFACE,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  new_interface.AddAttribute(NL80211Attr<string>(
+      NL80211_ATTR_IFNAME, string(kFakeInterfaceName)));
+  new_interface.AddAttribute(NL80211Attr<uint32_t>(
+      NL80211_ATTR_IFINDEX, kFakeInterfaceIndex));
+  std::vector<uint8_t> if_mac_addr(
+      kFakeInterfaceMacAddress,
+      kFakeInterfaceMacAddress + sizeof(kFakeInterfaceMacAddress));
+  new_interface.AddAttribute(
+      NL80211Attr<vector<uint8_t>>(NL80211_ATTR_MAC, if_mac_addr));
+
+  std::function<void(const NL80211PacketView&)> message_handler;
+  OnDumpCompleteHandler complete_handler;
+  EXPECT_CALL(*netlink_manager_, RegisterHandlerAndSendDumpMessage(_, _, _)).
+      WillOnce(DoAll(SaveArg<1>(&message_handler),
+                     SaveArg<2>(&complete_handler),
+                     Return(true)));
+
+  bool handler_called = false;
+  vector<InterfaceInfo> interfaces;
+  EXPECT_TRUE(netlink_utils_->GetInterfacesAsync(
+      kFakeWiphyIndex,
+      [&handler_called, &interfaces](bool success,
+                                     vector<InterfaceInfo>& interface_info) {
+        handler_called = true;
+        EXPECT_TRUE(success);
+        interfaces = interface_info;
+      }));
+  // Nothing is reported before the dump is complete.
+  message_handler(NL80211PacketView(new_interface));
+  EXPECT_FALSE(handler_called);
+
+  complete_handler(DUMP_DONE, 0);
+  EXPECT_TRUE(handler_called);
+  EXPECT_EQ(1u, interfaces.size());
+  EXPECT_EQ(kFakeInterfaceIndex, interfaces[0].index);
+  EXPECT_EQ(string(kFakeInterfaceName), interfaces[0].name);
+  EXPECT_EQ(if_mac_addr, interfaces[0].mac_address);
+}
+
+TEST_F(NetlinkUtilsTest, CanHandleGetInterfacesAsyncTimeout) {
+  OnDumpCompleteHandler complete_handler;
+  EXPECT_CALL(*netlink_manager_, RegisterHandlerAndSendDumpMessage(_, _, _)).
+      WillOnce(DoAll(SaveArg<2>(&complete_handler), Return(true)));
+
+  bool handler_called = false;
+  EXPECT_TRUE(netlink_utils_->GetInterfacesAsync(
+      kFakeWiphyIndex,
+      [&handler_called](bool success, vector<InterfaceInfo>& interface_info) {
+        handler_called = true;
+        EXPECT_FALSE(success);
+      }));
+  complete_handler(DUMP_TIMEOUT, 0);
+  EXPECT_TRUE(handler_called);
+}
+
 TEST_F(NetlinkUtilsTest, HandleP2p0WhenGetInterfaces) {
   NL80211Packet new_interface(
       netlink_manager_->GetFamilyId(),
@@ -778,6 +962,57 @@ TEST_F(NetlinkUtilsTest, CanGetWiphyInfoSplitDump) {
 }
 
 
+TEST_F(NetlinkUtilsTest, CanMergeInterleavedSplitWiphyDump) {
+  SetSplitWiphyDumpSupported(true);
+
+  // Every attribute is in its own message, and the messages of another
+  // wiphy are interleaved with them.
+  vector<NL80211Packet> get_wiphy_response;
+  for (int i = 0; i < 4; i++) {
+    NL80211Packet packet(
+        netlink_manager_->GetFamilyId(),
+        NL80211_CMD_NEW_WIPHY,
+        netlink_manager_->GetSequenceNumber(),
+        getpid());
+    packet.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY,
+                                              kFakeWiphyIndex));
+    if (i == 0) {
+      packet.AddAttribute(GenerateBandsAttributeFor5gAndDfs());
+    } else if (i == 1) {
+      packet.AddAttribute(GenerateBandsAttributeFor2g());
+    } else if (i == 2) {
+      AppendScanCapabilitiesAttributes(&packet, false);
+    } else {
+      AppendWiphyFeaturesAttributes(&packet);
+    }
+    get_wiphy_response.push_back(std::move(packet));
+
+    NL80211Packet other_packet(
+        netlink_manager_->GetFamilyId(),
+        NL80211_CMD_NEW_WIPHY,
+        netlink_manager_->GetSequenceNumber(),
+        getpid());
+    other_packet.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_WIPHY,
+                                                    kFakeWiphyIndex1));
+    AppendBandInfoAttributes(&other_packet);
+    get_wiphy_response.push_back(std::move(other_packet));
+  }
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(get_wiphy_response), Return(true)));
+
+  BandInfo band_info;
+  ScanCapabilities scan_capabilities;
+  WiphyFeatures wiphy_features;
+  EXPECT_TRUE(netlink_utils_->GetWiphyInfo(kFakeWiphyIndex,
+                                           &band_info,
+                                           &scan_capabilities,
+                                           &wiphy_features));
+  VerifyBandInfo(band_info);
+  VerifyScanCapabilities(scan_capabilities, false);
+  VerifyWiphyFeatures(wiphy_features);
+}
+
 TEST_F(NetlinkUtilsTest, CanHandleGetWiphyInfoError) {
   SetSplitWiphyDumpSupported(false);
 
@@ -862,5 +1097,138 @@ TEST_F(NetlinkUtilsTest, CanHandleGetCountryCodeError) {
   EXPECT_FALSE(netlink_utils_->GetCountryCode(&country_code_ignored));
 }
 
+TEST_F(NetlinkUtilsTest, CanGetStationInfo) {
+  NL80211Packet new_station(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_STATION,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  NL80211NestedAttr tx_bitrate(NL80211_STA_INFO_TX_BITRATE);
+  tx_bitrate.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_RATE_INFO_BITRATE32, kFakeTxBitrate));
+  NL80211NestedAttr sta_info(NL80211_ATTR_STA_INFO);
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_PACKETS, kFakeTxPackets));
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_FAILED, kFakeTxFailed));
+  sta_info.AddAttribute(
+      NL80211Attr<int8_t>(NL80211_STA_INFO_SIGNAL, kFakeRssi));
+  sta_info.AddAttribute(tx_bitrate);
+  new_station.AddAttribute(sta_info);
+  vector<NL80211Packet> response = {new_station};
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(response), Return(true)));
+
+  StationInfo station_info;
+  vector<uint8_t> mac_address(
+      kFakeInterfaceMacAddress,
+      kFakeInterfaceMacAddress + sizeof(kFakeInterfaceMacAddress));
+  EXPECT_TRUE(netlink_utils_->GetStationInfo(
+      kFakeInterfaceIndex, mac_address, &station_info));
+  EXPECT_EQ(kFakeTxPackets, station_info.station_tx_packets);
+  EXPECT_EQ(kFakeTxFailed, station_info.station_tx_failed);
+  EXPECT_EQ(kFakeTxBitrate, station_info.station_tx_bitrate);
+  EXPECT_EQ(kFakeRssi, station_info.current_rssi);
+}
+
+TEST_F(NetlinkUtilsTest, CanHandleStationInfoWithWrongAttributeType) {
+  NL80211Packet new_station(
+      netlink_manager_->GetFamilyId(),
+      NL80211_CMD_NEW_STATION,
+      netlink_manager_->GetSequenceNumber(),
+      getpid());
+  NL80211NestedAttr sta_info(NL80211_ATTR_STA_INFO);
+  // NL80211_STA_INFO_TX_PACKETS is supposed to be a u32.
+  sta_info.AddAttribute(
+      NL80211Attr<uint64_t>(NL80211_STA_INFO_TX_PACKETS, kFakeTxPackets));
+  new_station.AddAttribute(sta_info);
+  vector<NL80211Packet> response = {new_station};
+
+  EXPECT_CALL(*netlink_manager_, SendMessageAndGetResponses(_, _)).
+      WillOnce(DoAll(MakeupResponse(response), Return(true)));
+
+  StationInfo station_info;
+  vector<uint8_t> mac_address(
+      kFakeInterfaceMacAddress,
+      kFakeInterfaceMacAddress + sizeof(kFakeInterfaceMacAddress));
+  EXPECT_FALSE(netlink_utils_->GetStationInfo(
+      kFakeInterfaceIndex, mac_address, &station_info));
+}
+
+TEST_F(NetlinkUtilsTest, CanGetStationTable) {
+  vector<NL80211Packet> response = {
+      CreateNewStationMessage(kFakeInterfaceMacAddress),
+      CreateNewStationMessage(kFakeInterfaceMacAddress1)};
+  EXPECT_CALL(*netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessagesAndReturn, response, true, _1, _2)));
+
+  StationTable stations;
+  EXPECT_TRUE(netlink_utils_->GetStationTable(kFakeInterfaceIndex,
+                                              &stations));
+  ASSERT_EQ(2u, stations.size());
+  vector<uint8_t> mac_address(
+      kFakeInterfaceMacAddress,
+      kFakeInterfaceMacAddress + sizeof(kFakeInterfaceMacAddress));
+  ASSERT_EQ(1u, stations.count(mac_address));
+  const StationInfo& station_info = stations[mac_address];
+  EXPECT_EQ(kFakeTxPackets, station_info.station_tx_packets);
+  EXPECT_EQ(kFakeTxFailed, station_info.station_tx_failed);
+  EXPECT_EQ(kFakeTxBitrate, station_info.station_tx_bitrate);
+  EXPECT_EQ(kFakeRssi, station_info.current_rssi);
+  EXPECT_EQ(kFakeRxBitrate, station_info.station_rx_bitrate);
+  EXPECT_EQ(kFakeAverageRssi, station_info.average_rssi);
+  EXPECT_EQ(kFakeInactiveTimeMs, station_info.inactive_time_ms);
+  EXPECT_EQ(kFakeRxBytes, station_info.station_rx_bytes);
+  EXPECT_EQ(kFakeTxBytes64, station_info.station_tx_bytes);
+}
+
+TEST_F(NetlinkUtilsTest, SkipsIncompleteStationInStationTable) {
+  // This station has no NL80211_STA_INFO_TX_BITRATE.
+  NL80211Packet incomplete_station(
+      kFakeFamilyId,
+      NL80211_CMD_NEW_STATION,
+      kFakeSequenceNumber,
+      getpid());
+  incomplete_station.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_ATTR_MAC,
+      vector<uint8_t>(kFakeInterfaceMacAddress1,
+                      kFakeInterfaceMacAddress1 + ETH_ALEN)));
+  NL80211NestedAttr sta_info(NL80211_ATTR_STA_INFO);
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_PACKETS, kFakeTxPackets));
+  sta_info.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_STA_INFO_TX_FAILED, kFakeTxFailed));
+  sta_info.AddAttribute(
+      NL80211Attr<int8_t>(NL80211_STA_INFO_SIGNAL, kFakeRssi));
+  incomplete_station.AddAttribute(sta_info);
+  vector<NL80211Packet> response = {
+      incomplete_station,
+      CreateNewStationMessage(kFakeInterfaceMacAddress)};
+  EXPECT_CALL(*netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessagesAndReturn, response, true, _1, _2)));
+
+  StationTable stations;
+  EXPECT_TRUE(netlink_utils_->GetStationTable(kFakeInterfaceIndex,
+                                              &stations));
+  ASSERT_EQ(1u, stations.size());
+  EXPECT_EQ(1u, stations.count(vector<uint8_t>(
+      kFakeInterfaceMacAddress,
+      kFakeInterfaceMacAddress + sizeof(kFakeInterfaceMacAddress))));
+}
+
+TEST_F(NetlinkUtilsTest, CanHandleGetStationTableError) {
+  vector<NL80211Packet> response = {
+      CreateNewStationMessage(kFakeInterfaceMacAddress),
+      CreateControlMessageError(kFakeErrorCode)};
+  EXPECT_CALL(*netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessagesAndReturn, response, true, _1, _2)));
+
+  StationTable stations;
+  EXPECT_FALSE(netlink_utils_->GetStationTable(kFakeInterfaceIndex,
+                                               &stations));
+  EXPECT_TRUE(stations.empty());
+}
+
 }  // namespace wificond
 }  // namespace android
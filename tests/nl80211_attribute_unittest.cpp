@@ -338,5 +338,134 @@ TEST(NL80211AttributeTest, MergeNestedAttributes) {
   EXPECT_TRUE(value2 == kU32Value2);
 }
 
+TEST(NL80211AttributeTest, AttrViewGetValueFromBuffer) {
+  NL80211AttrView view(kValidU32AttrBuffer, sizeof(kValidU32AttrBuffer));
+  EXPECT_TRUE(view.IsValid());
+  EXPECT_EQ(1, view.GetAttributeId());
+  uint32_t value;
+  EXPECT_TRUE(view.GetValue(&value));
+  EXPECT_EQ(0x2a1212f1u, value);
+  // The payload size doesn't match a uint16_t.
+  uint16_t wrong_size_value;
+  EXPECT_FALSE(view.GetValue(&wrong_size_value));
+}
+
+TEST(NL80211AttributeTest, AttrViewCannotGetValueFromBrokenBuffer) {
+  NL80211AttrView view(kBrokenBuffer, sizeof(kBrokenBuffer));
+  EXPECT_FALSE(view.IsValid());
+  std::vector<uint8_t> value;
+  EXPECT_FALSE(view.GetValue(&value));
+}
+
+TEST(NL80211AttributeTest, AttrViewGetStringWithTrailingZeros) {
+  NL80211AttrView view(kBufferContainsStringWithTrailingZeros,
+                       sizeof(kBufferContainsStringWithTrailingZeros));
+  std::string value;
+  EXPECT_TRUE(view.GetValue(&value));
+  EXPECT_EQ("wlan0", value);
+}
+
+TEST(NL80211AttributeTest, AttrViewGetListOfAttributesFromBuffer) {
+  NL80211AttrView view(kBufferContainsListOfAttributes,
+                       sizeof(kBufferContainsListOfAttributes));
+  std::vector<NL80211AttrView> attrs;
+  EXPECT_TRUE(view.GetListOfAttributes(&attrs));
+  ASSERT_EQ(3u, attrs.size());
+  std::string value;
+  EXPECT_EQ(2, attrs[2].GetAttributeId());
+  EXPECT_TRUE(attrs[2].GetValue(&value));
+  EXPECT_EQ("third", value);
+
+  std::vector<std::string> strs;
+  std::vector<std::string> expected_strs = {"first", "second", "third"};
+  EXPECT_TRUE(view.GetListOfAttributeValues(&strs));
+  EXPECT_EQ(expected_strs, strs);
+}
+
+TEST(NL80211AttributeTest, AttrViewGetNestedAttributes) {
+  NL80211NestedAttr nested_attr(1);
+  NL80211NestedAttr deeper_nested_attr(2);
+  deeper_nested_attr.AddAttribute(NL80211Attr<uint32_t>(3, kU32Value1));
+  nested_attr.AddAttribute(deeper_nested_attr);
+  nested_attr.AddAttribute(
+      NL80211Attr<std::vector<uint8_t>>(4, std::vector<uint8_t>(
+          kMacAddress, kMacAddress + sizeof(kMacAddress))));
+
+  NL80211AttrView view(nested_attr);
+  EXPECT_TRUE(view.HasAttribute(2));
+  EXPECT_FALSE(view.HasAttribute(3));
+  NL80211AttrView deeper_view;
+  ASSERT_TRUE(view.GetAttribute(2, &deeper_view));
+  uint32_t value;
+  EXPECT_TRUE(deeper_view.GetAttributeValue(3, &value));
+  EXPECT_EQ(kU32Value1, value);
+  std::vector<uint8_t> mac_address;
+  EXPECT_TRUE(view.GetAttributeValue(4, &mac_address));
+  EXPECT_EQ(std::vector<uint8_t>(kMacAddress,
+                                 kMacAddress + sizeof(kMacAddress)),
+            mac_address);
+
+  // A copy owns its data and can be parsed in the same way.
+  NL80211NestedAttr copy = view.ToNestedAttr();
+  EXPECT_EQ(nested_attr.GetConstData(), copy.GetConstData());
+}
+
+TEST(NL80211AttributeTest, IndexNestedAttributes) {
+  NL80211NestedAttr nested_attr(1);
+  nested_attr.AddAttribute(NL80211Attr<uint32_t>(1, kU32Value1));
+  nested_attr.AddAttribute(NL80211Attr<uint16_t>(3, kU16Value1));
+  nested_attr.AddAttribute(NL80211Attr<std::string>(4, kIFName));
+  // Only the first attribute is used if an id appears more than once.
+  nested_attr.AddAttribute(NL80211Attr<uint32_t>(1, kU32Value2));
+
+  NL80211AttrIndex<4> index;
+  ASSERT_TRUE(NL80211AttrView(nested_attr).IndexAttributes(&index));
+  EXPECT_TRUE(index.HasAttribute(1));
+  EXPECT_FALSE(index.HasAttribute(2));
+  uint32_t u32_value;
+  EXPECT_TRUE(index.GetAttributeValue(1, &u32_value));
+  EXPECT_EQ(kU32Value1, u32_value);
+  uint16_t u16_value;
+  EXPECT_TRUE(index.GetAttributeValue(3, &u16_value));
+  EXPECT_EQ(kU16Value1, u16_value);
+  std::string str_value;
+  EXPECT_TRUE(index.GetAttributeValue(4, &str_value));
+  EXPECT_EQ(kIFName, str_value);
+  ASSERT_EQ(3u, index.GetNumIndexedIds());
+  EXPECT_EQ(1, index.GetIndexedId(0));
+  EXPECT_EQ(3, index.GetIndexedId(1));
+  EXPECT_EQ(4, index.GetIndexedId(2));
+
+  index.RemoveAttribute(3);
+  EXPECT_FALSE(index.HasAttribute(3));
+}
+
+TEST(NL80211AttributeTest, IndexFindsAttributesBeyondMaxId) {
+  NL80211NestedAttr nested_attr(1);
+  nested_attr.AddAttribute(NL80211Attr<uint32_t>(1, kU32Value1));
+  nested_attr.AddAttribute(NL80211Attr<uint32_t>(10, kU32Value2));
+
+  NL80211AttrIndex<2> index;
+  ASSERT_TRUE(NL80211AttrView(nested_attr).IndexAttributes(&index));
+  uint32_t value;
+  EXPECT_TRUE(index.GetAttributeValue(10, &value));
+  EXPECT_EQ(kU32Value2, value);
+  EXPECT_FALSE(index.HasAttribute(11));
+}
+
+TEST(NL80211AttributeTest, CannotIndexBrokenAttributes) {
+  std::vector<uint8_t> buffer(
+      kValidU32AttrBuffer,
+      kValidU32AttrBuffer + sizeof(kValidU32AttrBuffer));
+  buffer.insert(buffer.end(),
+                kBrokenBuffer, kBrokenBuffer + sizeof(kBrokenBuffer));
+  NL80211AttrIndex<2> index;
+  EXPECT_FALSE(index.Build(buffer.data(), buffer.size()));
+  // Attributes before the broken one are still indexed.
+  uint32_t value;
+  EXPECT_TRUE(index.GetAttributeValue(1, &value));
+  EXPECT_EQ(0x2a1212f1u, value);
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -278,5 +278,60 @@ TEST(NL80211PacketTest, ParseCMDNewStation) {
   EXPECT_EQ(kNewStationExpectedGeneration, value);
 }
 
+TEST(NL80211PacketTest, ParseCMDAssociateFromPacketView) {
+  NL80211PacketView packet_view(kNL80211_CMD_ASSOCIATE,
+                                sizeof(kNL80211_CMD_ASSOCIATE));
+  EXPECT_TRUE(packet_view.IsValid());
+  EXPECT_EQ(kNL80211FamilyId, packet_view.GetMessageType());
+  EXPECT_EQ(NL80211_CMD_ASSOCIATE, packet_view.GetCommand());
+  uint32_t value;
+  EXPECT_TRUE(packet_view.GetAttributeValue(NL80211_ATTR_WIPHY, &value));
+  EXPECT_EQ(kWiPhy, value);
+  EXPECT_TRUE(packet_view.GetAttributeValue(NL80211_ATTR_IFINDEX, &value));
+  EXPECT_EQ(kExpectedIfIndex, value);
+  NL80211AttrView frame;
+  EXPECT_TRUE(packet_view.GetAttribute(NL80211_ATTR_FRAME, &frame));
+  EXPECT_GT(frame.GetPayloadLength(), 0u);
+
+  std::unique_ptr<NL80211Packet> packet = packet_view.ToPacket();
+  EXPECT_EQ(std::vector<uint8_t>(
+                kNL80211_CMD_ASSOCIATE,
+                kNL80211_CMD_ASSOCIATE + sizeof(kNL80211_CMD_ASSOCIATE)),
+            packet->GetConstData());
+}
+
+TEST(NL80211PacketTest, CannotParseTruncatedPacketView) {
+  // The buffer is shorter than the length in netlink header.
+  NL80211PacketView packet_view(kNL80211_CMD_ASSOCIATE,
+                                sizeof(kNL80211_CMD_ASSOCIATE) - 8);
+  EXPECT_FALSE(packet_view.IsValid());
+}
+
+TEST(NL80211PacketTest, GetNestedAttributesFromPacketView) {
+  NL80211Packet netlink_packet(kNLMsgType,
+                               kGenNLCommand,
+                               kNLMsgSequenceNumber,
+                               kPortId);
+  NL80211NestedAttr nested_attr(1);
+  nested_attr.AddAttribute(NL80211Attr<uint16_t>(2, kU16Value1));
+  netlink_packet.AddAttribute(nested_attr);
+  netlink_packet.AddAttribute(NL80211Attr<uint32_t>(4, kU32Value2));
+
+  NL80211PacketView packet_view(netlink_packet);
+  EXPECT_TRUE(packet_view.IsValid());
+  EXPECT_EQ(kNLMsgSequenceNumber, packet_view.GetMessageSequence());
+  EXPECT_EQ(kPortId, packet_view.GetPortId());
+  EXPECT_TRUE(packet_view.HasAttribute(1));
+  EXPECT_FALSE(packet_view.HasAttribute(2));
+  uint32_t u32_value;
+  EXPECT_TRUE(packet_view.GetAttributeValue(4, &u32_value));
+  EXPECT_EQ(kU32Value2, u32_value);
+  NL80211AttrView nested_view;
+  ASSERT_TRUE(packet_view.GetAttribute(1, &nested_view));
+  uint16_t u16_value;
+  EXPECT_TRUE(nested_view.GetAttributeValue(2, &u16_value));
+  EXPECT_EQ(kU16Value1, u16_value);
+}
+
 }  // namespace wificond
 }  // namespace android
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2017, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "wificond/net/kernel-header-latest/nl80211.h"
+#include "wificond/net/nl80211_attribute.h"
+#include "wificond/net/nl80211_packet.h"
+#include "wificond/net/nl80211_policy.h"
+
+using std::string;
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+const uint8_t kFakeBssid[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+const uint32_t kFakeFrequency = 5180;
+const int32_t kFakeSignalMbm = -5000;
+const uint32_t kFakeBitrate = 8667;
+const uint16_t kFakePacketType = 4000;
+const uint32_t kFakeSequenceNumber = 70000;
+const uint32_t kFakePortId = 123;
+const uint8_t kFakeMaxNumScanSsids = 10;
+const char kFakeWiphyName[] = "phy0";
+
+}  // namespace
+
+TEST(NL80211PolicyTest, PolicyTableIsIndexedByAttributeId) {
+  EXPECT_EQ(NL80211AttrType::kU32,
+            NL80211BssPolicy::kPolicy.policies[NL80211_BSS_FREQUENCY].type);
+  EXPECT_EQ(NL80211AttrType::kUnspec,
+            NL80211BssPolicy::kPolicy.policies[NL80211_BSS_PAD].type);
+  EXPECT_EQ(NL80211AttrType::kU32,
+            NL80211StaInfoPolicy::kPolicy.policies[
+                NL80211_STA_INFO_TX_PACKETS].type);
+}
+
+TEST(NL80211PolicyTest, ValidateAttributeLength) {
+  NL80211Attr<uint32_t> u32_attr(1, kFakeFrequency);
+  EXPECT_TRUE(ValidateAttribute(NL80211AttrView(u32_attr),
+                                {1, NL80211AttrType::kU32, 0}));
+  EXPECT_FALSE(ValidateAttribute(NL80211AttrView(u32_attr),
+                                 {1, NL80211AttrType::kU16, 0}));
+  EXPECT_FALSE(ValidateAttribute(NL80211AttrView(u32_attr),
+                                 {1, NL80211AttrType::kFlag, 0}));
+
+  NL80211Attr<vector<uint8_t>> binary_attr(
+      1, vector<uint8_t>(kFakeBssid, kFakeBssid + sizeof(kFakeBssid)));
+  EXPECT_TRUE(ValidateAttribute(NL80211AttrView(binary_attr),
+                                {1, NL80211AttrType::kBinary, 6}));
+  EXPECT_TRUE(ValidateAttribute(NL80211AttrView(binary_attr),
+                                {1, NL80211AttrType::kBinary, 0}));
+  EXPECT_FALSE(ValidateAttribute(NL80211AttrView(binary_attr),
+                                 {1, NL80211AttrType::kBinary, 4}));
+}
+
+TEST(NL80211PolicyTest, CanParseBssAttributes) {
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_BSSID,
+      vector<uint8_t>(kFakeBssid, kFakeBssid + sizeof(kFakeBssid))));
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_FREQUENCY,
+                                         kFakeFrequency));
+  bss.AddAttribute(NL80211Attr<int32_t>(NL80211_BSS_SIGNAL_MBM,
+                                        kFakeSignalMbm));
+  bss.AddAttribute(NL80211NestedAttr(NL80211_BSS_CHAIN_SIGNAL));
+
+  NL80211AttrSet<NL80211BssPolicy> bss_attributes;
+  ASSERT_TRUE(bss_attributes.Parse(NL80211AttrView(bss)));
+  vector<uint8_t> bssid;
+  EXPECT_TRUE(bss_attributes.Get<NL80211_BSS_BSSID>(&bssid));
+  EXPECT_EQ(vector<uint8_t>(kFakeBssid, kFakeBssid + sizeof(kFakeBssid)),
+            bssid);
+  uint32_t frequency;
+  EXPECT_TRUE(bss_attributes.Get<NL80211_BSS_FREQUENCY>(&frequency));
+  EXPECT_EQ(kFakeFrequency, frequency);
+  int32_t signal;
+  EXPECT_TRUE(bss_attributes.Get<NL80211_BSS_SIGNAL_MBM>(&signal));
+  EXPECT_EQ(kFakeSignalMbm, signal);
+  NL80211AttrView chain_signal;
+  EXPECT_TRUE(bss_attributes.GetNested<NL80211_BSS_CHAIN_SIGNAL>(
+      &chain_signal));
+  NL80211AttrView bssid_view;
+  EXPECT_TRUE(bss_attributes.GetView<NL80211_BSS_BSSID>(&bssid_view));
+  EXPECT_EQ(sizeof(kFakeBssid), bssid_view.GetPayloadLength());
+  EXPECT_FALSE(bss_attributes.Has<NL80211_BSS_TSF>());
+}
+
+TEST(NL80211PolicyTest, DropsAttributesViolatingPolicy) {
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_FREQUENCY,
+                                         kFakeFrequency));
+  // NL80211_BSS_CAPABILITY is supposed to be a u16.
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_CAPABILITY, 0));
+
+  NL80211AttrSet<NL80211BssPolicy> bss_attributes;
+  ASSERT_TRUE(bss_attributes.Parse(NL80211AttrView(bss)));
+  // The malformed attribute reads as missing, the others are still there.
+  EXPECT_FALSE(bss_attributes.Has<NL80211_BSS_CAPABILITY>());
+  uint16_t capability;
+  EXPECT_FALSE(bss_attributes.Get<NL80211_BSS_CAPABILITY>(&capability));
+  uint32_t frequency;
+  EXPECT_TRUE(bss_attributes.Get<NL80211_BSS_FREQUENCY>(&frequency));
+  EXPECT_EQ(kFakeFrequency, frequency);
+}
+
+TEST(NL80211PolicyTest, CannotParseBrokenAttributes) {
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_FREQUENCY,
+                                         kFakeFrequency));
+  vector<uint8_t> data = bss.GetConstData();
+  // Claim that the frequency attribute is longer than the nested one.
+  reinterpret_cast<nlattr*>(data.data() + NLA_HDRLEN)->nla_len = 0xff;
+
+  NL80211AttrSet<NL80211BssPolicy> bss_attributes;
+  EXPECT_FALSE(bss_attributes.Parse(NL80211AttrView(data.data(),
+                                                    data.size())));
+}
+
+TEST(NL80211PolicyTest, CanParseNestedRateInfo) {
+  NL80211NestedAttr sta_info(NL80211_ATTR_STA_INFO);
+  NL80211NestedAttr tx_bitrate(NL80211_STA_INFO_TX_BITRATE);
+  tx_bitrate.AddAttribute(
+      NL80211Attr<uint32_t>(NL80211_RATE_INFO_BITRATE32, kFakeBitrate));
+  tx_bitrate.AddFlagAttribute(NL80211_RATE_INFO_SHORT_GI);
+  sta_info.AddAttribute(tx_bitrate);
+
+  NL80211AttrSet<NL80211StaInfoPolicy> sta_info_attributes;
+  ASSERT_TRUE(sta_info_attributes.Parse(NL80211AttrView(sta_info)));
+  NL80211AttrView tx_bitrate_attr;
+  ASSERT_TRUE(sta_info_attributes.GetNested<NL80211_STA_INFO_TX_BITRATE>(
+      &tx_bitrate_attr));
+  NL80211AttrSet<NL80211RateInfoPolicy> rate_info;
+  ASSERT_TRUE(rate_info.Parse(tx_bitrate_attr));
+  uint32_t bitrate;
+  EXPECT_TRUE(rate_info.Get<NL80211_RATE_INFO_BITRATE32>(&bitrate));
+  EXPECT_EQ(kFakeBitrate, bitrate);
+  EXPECT_TRUE(rate_info.Has<NL80211_RATE_INFO_SHORT_GI>());
+  EXPECT_FALSE(rate_info.Has<NL80211_RATE_INFO_40_MHZ_WIDTH>());
+}
+
+TEST(NL80211PolicyTest, CanParseWiphyPacket) {
+  NL80211Packet packet(kFakePacketType,
+                       NL80211_CMD_NEW_WIPHY,
+                       kFakeSequenceNumber,
+                       kFakePortId);
+  packet.AddAttribute(NL80211Attr<string>(NL80211_ATTR_WIPHY_NAME,
+                                          kFakeWiphyName));
+  packet.AddAttribute(NL80211Attr<uint8_t>(NL80211_ATTR_MAX_NUM_SCAN_SSIDS,
+                                           kFakeMaxNumScanSsids));
+
+  NL80211AttrSet<NL80211WiphyPolicy> wiphy;
+  ASSERT_TRUE(wiphy.Parse(NL80211PacketView(packet)));
+  string wiphy_name;
+  EXPECT_TRUE(wiphy.Get<NL80211_ATTR_WIPHY_NAME>(&wiphy_name));
+  EXPECT_EQ(kFakeWiphyName, wiphy_name);
+  uint8_t max_num_scan_ssids;
+  EXPECT_TRUE(wiphy.Get<NL80211_ATTR_MAX_NUM_SCAN_SSIDS>(&max_num_scan_ssids));
+  EXPECT_EQ(kFakeMaxNumScanSsids, max_num_scan_ssids);
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -242,8 +242,8 @@ TEST_F(OffloadScanManagerTest, StartScanTestWhenServiceIsOk) {
   EXPECT_CALL(*mock_offload_, configureScans(_, _, _));
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, true);
 }
 
@@ -259,8 +259,8 @@ TEST_F(OffloadScanManagerTest, StartScanTestWhenServiceIsNotAvailable) {
       mock_offload_service_utils_, mock_offload_scan_callback_interface_));
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, false);
   EXPECT_EQ(reason_code, OffloadScanManager::kNotAvailable);
 }
@@ -282,8 +282,8 @@ TEST_F(OffloadScanManagerTest, StartScanTestWhenServiceIsNotConnected) {
   offload_callback_->onError(status);
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, false);
   EXPECT_EQ(reason_code, OffloadScanManager::kNotAvailable);
 }
@@ -304,12 +304,12 @@ TEST_F(OffloadScanManagerTest, StartScanTwiceTestWhenServiceIsOk) {
   EXPECT_CALL(*mock_offload_, configureScans(_, _, _)).Times(2);
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, true);
   result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, true);
 }
 
@@ -330,8 +330,8 @@ TEST_F(OffloadScanManagerTest, StopScanTestWhenServiceIsOk) {
   EXPECT_CALL(*mock_offload_, unsubscribeScanResults());
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, true);
   result = offload_scan_manager_->stopScan(&reason_code);
   EXPECT_EQ(result, true);
@@ -352,8 +352,8 @@ TEST_F(OffloadScanManagerTest, StopScanTestWhenServiceIsNotConnectedAnymore) {
   EXPECT_CALL(*mock_offload_, configureScans(_, _, _));
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, true);
   OffloadStatus status =
       OffloadTestUtils::createOffloadStatus(OffloadStatusCode::NO_CONNECTION);
@@ -418,8 +418,8 @@ TEST_F(OffloadScanManagerTest, StartScanFailedTest) {
   status = OffloadTestUtils::createOffloadStatus(OffloadStatusCode::ERROR);
   OffloadScanManager::ReasonCode reason_code = OffloadScanManager::kNone;
   bool result = offload_scan_manager_->startScan(
-      kDisconnectedModeScanIntervalMs, kRssiThreshold, scan_ssids, match_ssids,
-      security_flags, frequencies, &reason_code);
+      kDisconnectedModeScanIntervalMs, kRssiThreshold, kRssiThreshold,
+      scan_ssids, match_ssids, security_flags, frequencies, &reason_code);
   EXPECT_EQ(result, false);
   EXPECT_EQ(reason_code, OffloadScanManager::kOperationFailed);
 }
@@ -90,7 +90,7 @@ TEST_F(OffloadScanUtilsTest, verifyScanFilter) {
   vector<vector<uint8_t>> match_ssids{kSsid1, kSsid2};
   vector<uint8_t> security_flags{kNetworkFlags, kNetworkFlags};
   ScanFilter scanFilter = OffloadScanUtils::createScanFilter(
-      match_ssids, security_flags, kRssiThreshold);
+      match_ssids, security_flags, kRssiThreshold, kRssiThreshold);
   EXPECT_EQ(kRssiThreshold, scanFilter.rssiThreshold);
   EXPECT_FALSE(scanFilter.preferredNetworkInfoList.size() == 0);
   for (size_t i = 0; i < security_flags.size(); ++i) {
@@ -104,6 +104,18 @@ TEST_F(OffloadScanUtilsTest, verifyScanFilter) {
   }
 }
 
+TEST_F(OffloadScanUtilsTest, verifyScanFilterUsesLowerRssiThreshold) {
+  vector<vector<uint8_t>> match_ssids{
+      vector<uint8_t>(kSsid1, kSsid1 + kSsid1_size)};
+  vector<uint8_t> security_flags{kNetworkFlags};
+  ScanFilter scanFilter = OffloadScanUtils::createScanFilter(
+      match_ssids, security_flags, kRssiThreshold - 3, kRssiThreshold);
+  EXPECT_EQ(kRssiThreshold - 3, scanFilter.rssiThreshold);
+  scanFilter = OffloadScanUtils::createScanFilter(
+      match_ssids, security_flags, kRssiThreshold, kRssiThreshold - 3);
+  EXPECT_EQ(kRssiThreshold - 3, scanFilter.rssiThreshold);
+}
+
 TEST_F(OffloadScanUtilsTest, verifyScanStats) {
   NativeScanStats stats_expected;
   ScanStats offload_scan_stats =
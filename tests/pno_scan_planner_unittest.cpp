@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "android/net/wifi/IWifiScannerImpl.h"
+#include "wificond/scanning/pno_scan_planner.h"
+
+using ::android::net::wifi::IWifiScannerImpl;
+using ::com::android::server::wifi::wificond::PnoSettings;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr uint32_t kFakeScanIntervalMs = 10000;
+constexpr uint64_t kFakeNowMs = 1000 * 1000;
+
+ScanCapabilities CreateScanCapabilities(uint32_t max_num_scan_plans,
+                                        uint32_t max_scan_plan_interval,
+                                        uint32_t max_scan_plan_iterations) {
+  return ScanCapabilities(0 /* max_num_scan_ssids */,
+                          0 /* max_num_sched_scan_ssids */,
+                          0 /* max_match_sets */,
+                          max_num_scan_plans,
+                          max_scan_plan_interval,
+                          max_scan_plan_iterations);
+}
+
+PnoSettings CreatePnoSettings(int32_t mobility_hint, bool is_screen_on) {
+  PnoSettings pno_settings;
+  pno_settings.interval_ms_ = kFakeScanIntervalMs;
+  pno_settings.mobility_hint_ = mobility_hint;
+  pno_settings.is_screen_on_ = is_screen_on;
+  return pno_settings;
+}
+
+}  // namespace
+
+TEST(PnoScanPlannerTest, GeneratesDefaultScheduleWithoutHints) {
+  PnoScanPlanner planner(CreateScanCapabilities(8, 3600, 100));
+  SchedScanIntervalSetting setting = planner.GeneratePlans(
+      CreatePnoSettings(IWifiScannerImpl::MOBILITY_UNKNOWN, true),
+      kFakeNowMs);
+  ASSERT_EQ(1u, setting.plans.size());
+  EXPECT_EQ(kFakeScanIntervalMs, setting.plans[0].interval_ms);
+  EXPECT_EQ(PnoSettings::kFastScanIterations, setting.plans[0].n_iterations);
+  EXPECT_EQ(kFakeScanIntervalMs * PnoSettings::kSlowScanIntervalMultiplier,
+            setting.final_interval_ms);
+}
+
+TEST(PnoScanPlannerTest, SlowsDownWhenStationaryWithScreenOff) {
+  PnoScanPlanner planner(CreateScanCapabilities(8, 3600, 100));
+  SchedScanIntervalSetting setting = planner.GeneratePlans(
+      CreatePnoSettings(IWifiScannerImpl::MOBILITY_STATIONARY, false),
+      kFakeNowMs);
+  // Screen off and stationary slow scans down by a factor of 8.
+  EXPECT_EQ(kFakeScanIntervalMs * PnoSettings::kSlowScanIntervalMultiplier * 8,
+            setting.final_interval_ms);
+  // The default slow interval is doubled on the way there.
+  ASSERT_EQ(4u, setting.plans.size());
+  EXPECT_EQ(kFakeScanIntervalMs * PnoSettings::kSlowScanIntervalMultiplier,
+            setting.plans[1].interval_ms);
+  EXPECT_EQ(kFakeScanIntervalMs * PnoSettings::kSlowScanIntervalMultiplier * 4,
+            setting.plans[3].interval_ms);
+}
+
+TEST(PnoScanPlannerTest, ScansFastForLongerWithHighMobility) {
+  PnoScanPlanner planner(CreateScanCapabilities(8, 3600, 100));
+  SchedScanIntervalSetting setting = planner.GeneratePlans(
+      CreatePnoSettings(IWifiScannerImpl::MOBILITY_HIGH, true),
+      kFakeNowMs);
+  ASSERT_FALSE(setting.plans.empty());
+  EXPECT_EQ(PnoSettings::kFastScanIterations * 2,
+            setting.plans[0].n_iterations);
+}
+
+TEST(PnoScanPlannerTest, RecentNetworkFoundKeepsScansFast) {
+  PnoScanPlanner planner(CreateScanCapabilities(8, 3600, 100));
+  PnoSettings pno_settings =
+      CreatePnoSettings(IWifiScannerImpl::MOBILITY_STATIONARY, false);
+  planner.RecordNetworkFound(kFakeNowMs);
+  EXPECT_EQ(kFakeScanIntervalMs * PnoSettings::kSlowScanIntervalMultiplier,
+            planner.GeneratePlans(pno_settings, kFakeNowMs + 1000)
+                .final_interval_ms);
+  // The network found is no longer recent.
+  EXPECT_EQ(kFakeScanIntervalMs * PnoSettings::kSlowScanIntervalMultiplier * 8,
+            planner.GeneratePlans(
+                pno_settings,
+                kFakeNowMs + PnoScanPlanner::kRecentNetworkFoundWindowMs)
+                .final_interval_ms);
+}
+
+TEST(PnoScanPlannerTest, CapsIntervalsToDeviceLimits) {
+  // At most 60 seconds between scans and 4 iterations per scan plan.
+  PnoScanPlanner planner(CreateScanCapabilities(8, 60, 4));
+  SchedScanIntervalSetting setting = planner.GeneratePlans(
+      CreatePnoSettings(IWifiScannerImpl::MOBILITY_STATIONARY, false),
+      kFakeNowMs);
+  EXPECT_EQ(60u * 1000, setting.final_interval_ms);
+  for (const auto& plan : setting.plans) {
+    EXPECT_LT(plan.interval_ms, 60u * 1000);
+  }
+  setting = planner.GeneratePlans(
+      CreatePnoSettings(IWifiScannerImpl::MOBILITY_HIGH, true),
+      kFakeNowMs);
+  ASSERT_FALSE(setting.plans.empty());
+  EXPECT_EQ(4u, setting.plans[0].n_iterations);
+}
+
+TEST(PnoScanPlannerTest, GeneratesSingleIntervalWithoutScanPlanSupport) {
+  PnoScanPlanner planner(CreateScanCapabilities(1, 0, 0));
+  SchedScanIntervalSetting setting = planner.GeneratePlans(
+      CreatePnoSettings(IWifiScannerImpl::MOBILITY_LOW, true),
+      kFakeNowMs);
+  EXPECT_TRUE(setting.plans.empty());
+  EXPECT_EQ(kFakeScanIntervalMs * 2, setting.final_interval_ms);
+}
+
+}  // namespace wificond
+}  // namespace android
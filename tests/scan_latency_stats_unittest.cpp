@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "android/net/wifi/IWifiScannerImpl.h"
+#include "wificond/scanning/scan_latency_stats.h"
+
+using ::android::net::wifi::IWifiScannerImpl;
+using std::stringstream;
+
+namespace android {
+namespace wificond {
+
+TEST(LatencyHistogramTest, AddsLatenciesToPowerOfTwoBuckets) {
+  LatencyHistogram histogram;
+  histogram.Add(500);          // 0.5ms
+  histogram.Add(1000);         // 1ms
+  histogram.Add(3000);         // 3ms
+  histogram.Add(3999);         // 3.999ms
+  histogram.Add(1000 * 1000);  // 1s
+  EXPECT_EQ(5u, histogram.GetCount());
+  const auto& buckets = histogram.GetBuckets();
+  EXPECT_EQ(1u, buckets[0]);
+  EXPECT_EQ(1u, buckets[1]);
+  EXPECT_EQ(2u, buckets[2]);
+  // 1000ms is in [512, 1024).
+  EXPECT_EQ(1u, buckets[10]);
+}
+
+TEST(LatencyHistogramTest, AddsVeryLongLatenciesToLastBucket) {
+  LatencyHistogram histogram;
+  histogram.Add(3600ull * 1000 * 1000);
+  EXPECT_EQ(1u, histogram.GetBuckets()[LatencyHistogram::kNumBuckets - 1]);
+}
+
+TEST(ScanLatencyStatsTest, KeepsHistogramsPerScanTypeAndPhase) {
+  ScanLatencyStats stats;
+  EXPECT_EQ(nullptr, stats.GetHistogram(IWifiScannerImpl::SCAN_TYPE_LOW_SPAN,
+                                        ScanLatencyStats::kPhaseScan));
+  stats.Add(IWifiScannerImpl::SCAN_TYPE_LOW_SPAN,
+            ScanLatencyStats::kPhaseScan, 2000);
+  stats.Add(IWifiScannerImpl::SCAN_TYPE_LOW_POWER,
+            ScanLatencyStats::kPhaseDump, 2000);
+
+  const LatencyHistogram* histogram = stats.GetHistogram(
+      IWifiScannerImpl::SCAN_TYPE_LOW_SPAN, ScanLatencyStats::kPhaseScan);
+  ASSERT_NE(nullptr, histogram);
+  EXPECT_EQ(1u, histogram->GetCount());
+  histogram = stats.GetHistogram(
+      IWifiScannerImpl::SCAN_TYPE_LOW_SPAN, ScanLatencyStats::kPhaseDump);
+  ASSERT_NE(nullptr, histogram);
+  EXPECT_EQ(0u, histogram->GetCount());
+
+  stringstream ss;
+  stats.Dump(&ss);
+  EXPECT_NE(std::string::npos, ss.str().find("LOW_SPAN"));
+  EXPECT_NE(std::string::npos, ss.str().find("LOW_POWER"));
+}
+
+}  // namespace wificond
+}  // namespace android
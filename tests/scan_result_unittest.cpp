@@ -14,13 +14,19 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
 #include <vector>
 
 #include <gtest/gtest.h>
 
 #include "wificond/scanning/scan_result.h"
+#include "wificond/scanning/scan_result_buffer.h"
+#include "wificond/scanning/scan_result_delta.h"
 
 using ::com::android::server::wifi::wificond::NativeScanResult;
+using ::com::android::server::wifi::wificond::NativeScanResultBuffer;
+using ::com::android::server::wifi::wificond::NativeScanResultDelta;
 using ::com::android::server::wifi::wificond::RadioChainInfo;
 using std::vector;
 
@@ -41,6 +47,8 @@ constexpr int16_t kFakeCapability = 0;
 constexpr bool kFakeAssociated = true;
 constexpr int32_t kFakeRadioChainIds[] = { 0, 1 };
 constexpr int32_t kFakeRadioChainLevels[] = { -56, -64};
+const uint8_t kFakeExpiredBssid[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+constexpr int64_t kFakeCursor = 123456789;
 
 }  // namespace
 
@@ -83,5 +91,139 @@ TEST_F(ScanResultTest, ParcelableTest) {
   EXPECT_EQ(kFakeRadioChainLevels[1], scan_result_copy.radio_chain_infos[1].level);
 }
 
+TEST_F(ScanResultTest, DeltaParcelableTest) {
+  std::vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  std::vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  std::vector<uint8_t> ie(kFakeIE, kFakeIE + sizeof(kFakeIE));
+  std::vector<uint8_t> expired_bssid(
+      kFakeExpiredBssid, kFakeExpiredBssid + sizeof(kFakeExpiredBssid));
+  std::vector<RadioChainInfo> radio_chain_infos;
+
+  NativeScanResultDelta delta;
+  delta.cursor = kFakeCursor;
+  delta.is_full_update = false;
+  delta.changed_scan_results.emplace_back(ssid, bssid, ie, kFakeFrequency,
+      kFakeSignalMbm, kFakeTsf, kFakeCapability, kFakeAssociated,
+      radio_chain_infos);
+  delta.expired_bssids.push_back(expired_bssid);
+
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, delta.writeToParcel(&parcel));
+
+  NativeScanResultDelta delta_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, delta_copy.readFromParcel(&parcel));
+
+  EXPECT_EQ(kFakeCursor, delta_copy.cursor);
+  EXPECT_FALSE(delta_copy.is_full_update);
+  ASSERT_EQ(1u, delta_copy.changed_scan_results.size());
+  EXPECT_EQ(bssid, delta_copy.changed_scan_results[0].bssid);
+  EXPECT_EQ(ie, delta_copy.changed_scan_results[0].info_element);
+  EXPECT_EQ(kFakeTsf, delta_copy.changed_scan_results[0].tsf);
+  ASSERT_EQ(1u, delta_copy.expired_bssids.size());
+  EXPECT_EQ(expired_bssid, delta_copy.expired_bssids[0]);
+}
+
+TEST_F(ScanResultTest, SharedMemoryBufferTest) {
+  std::vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  std::vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  std::vector<uint8_t> ie(kFakeIE, kFakeIE + sizeof(kFakeIE));
+  std::vector<RadioChainInfo> radio_chain_infos;
+  radio_chain_infos.emplace_back(
+      kFakeRadioChainIds[0], kFakeRadioChainLevels[0]);
+  radio_chain_infos.emplace_back(
+      kFakeRadioChainIds[1], kFakeRadioChainLevels[1]);
+  std::vector<RadioChainInfo> no_radio_chain_infos;
+  std::vector<NativeScanResult> scan_results;
+  scan_results.emplace_back(ssid, bssid, ie, kFakeFrequency,
+      kFakeSignalMbm, kFakeTsf, kFakeCapability, kFakeAssociated,
+      radio_chain_infos);
+  scan_results.emplace_back(ssid, bssid, ie, kFakeFrequency,
+      kFakeSignalMbm, kFakeTsf + 1, kFakeCapability, !kFakeAssociated,
+      no_radio_chain_infos);
+
+  NativeScanResultBuffer buffer;
+  ASSERT_TRUE(buffer.Write(scan_results));
+  // The shared memory region is sealed against modification.
+  EXPECT_GT(0, write(buffer.fd.get(), kFakeIE, sizeof(kFakeIE)));
+
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, buffer.writeToParcel(&parcel));
+  NativeScanResultBuffer buffer_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, buffer_copy.readFromParcel(&parcel));
+  EXPECT_EQ(buffer.size, buffer_copy.size);
+  EXPECT_EQ(buffer.offsets, buffer_copy.offsets);
+
+  std::vector<NativeScanResult> scan_results_copy;
+  ASSERT_TRUE(buffer_copy.Read(&scan_results_copy));
+  ASSERT_EQ(2u, scan_results_copy.size());
+  EXPECT_EQ(ssid, scan_results_copy[0].ssid);
+  EXPECT_EQ(bssid, scan_results_copy[0].bssid);
+  EXPECT_EQ(ie, scan_results_copy[0].info_element);
+  EXPECT_EQ(kFakeFrequency, scan_results_copy[0].frequency);
+  EXPECT_EQ(kFakeSignalMbm, scan_results_copy[0].signal_mbm);
+  EXPECT_EQ(kFakeTsf, scan_results_copy[0].tsf);
+  EXPECT_EQ(kFakeCapability, scan_results_copy[0].capability);
+  EXPECT_EQ(kFakeAssociated, scan_results_copy[0].associated);
+  ASSERT_EQ(2u, scan_results_copy[0].radio_chain_infos.size());
+  EXPECT_EQ(kFakeRadioChainIds[1],
+            scan_results_copy[0].radio_chain_infos[1].chain_id);
+  EXPECT_EQ(kFakeRadioChainLevels[1],
+            scan_results_copy[0].radio_chain_infos[1].level);
+  EXPECT_EQ(kFakeTsf + 1, scan_results_copy[1].tsf);
+  EXPECT_EQ(!kFakeAssociated, scan_results_copy[1].associated);
+  EXPECT_TRUE(scan_results_copy[1].radio_chain_infos.empty());
+}
+
+TEST_F(ScanResultTest, SharedMemoryBufferRejectsInvalidOffsets) {
+  std::vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  std::vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  std::vector<uint8_t> ie(kFakeIE, kFakeIE + sizeof(kFakeIE));
+  std::vector<RadioChainInfo> radio_chain_infos;
+  std::vector<NativeScanResult> scan_results;
+  scan_results.emplace_back(ssid, bssid, ie, kFakeFrequency,
+      kFakeSignalMbm, kFakeTsf, kFakeCapability, kFakeAssociated,
+      radio_chain_infos);
+
+  NativeScanResultBuffer buffer;
+  ASSERT_TRUE(buffer.Write(scan_results));
+  buffer.offsets[0] = buffer.size - 8;
+  std::vector<NativeScanResult> scan_results_copy;
+  EXPECT_FALSE(buffer.Read(&scan_results_copy));
+  EXPECT_TRUE(scan_results_copy.empty());
+}
+
+TEST_F(ScanResultTest, SharedMemoryBufferRejectsSizeBeyondRegion) {
+  std::vector<uint8_t> ssid(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  std::vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  std::vector<uint8_t> ie(kFakeIE, kFakeIE + sizeof(kFakeIE));
+  std::vector<RadioChainInfo> radio_chain_infos;
+  std::vector<NativeScanResult> scan_results;
+  scan_results.emplace_back(ssid, bssid, ie, kFakeFrequency,
+      kFakeSignalMbm, kFakeTsf, kFakeCapability, kFakeAssociated,
+      radio_chain_infos);
+
+  NativeScanResultBuffer buffer;
+  ASSERT_TRUE(buffer.Write(scan_results));
+  // Reading past the end of the memfd would raise SIGBUS.
+  buffer.size += 4096;
+  std::vector<NativeScanResult> scan_results_copy;
+  EXPECT_FALSE(buffer.Read(&scan_results_copy));
+  EXPECT_TRUE(scan_results_copy.empty());
+}
+
+TEST_F(ScanResultTest, EmptySharedMemoryBufferTest) {
+  NativeScanResultBuffer buffer;
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, buffer.writeToParcel(&parcel));
+  NativeScanResultBuffer buffer_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, buffer_copy.readFromParcel(&parcel));
+  std::vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(buffer_copy.Read(&scan_results));
+  EXPECT_TRUE(scan_results.empty());
+}
+
 }  // namespace wificond
 }  // namespace android
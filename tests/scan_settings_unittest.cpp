@@ -21,15 +21,19 @@
 #include "android/net/wifi/IWifiScannerImpl.h"
 #include "wificond/scanning/channel_settings.h"
 #include "wificond/scanning/hidden_network.h"
+#include "wificond/scanning/partial_scan_settings.h"
 #include "wificond/scanning/pno_network.h"
 #include "wificond/scanning/pno_settings.h"
+#include "wificond/scanning/scan_result_filter.h"
 #include "wificond/scanning/single_scan_settings.h"
 
 using ::android::net::wifi::IWifiScannerImpl;
 using ::com::android::server::wifi::wificond::ChannelSettings;
 using ::com::android::server::wifi::wificond::HiddenNetwork;
+using ::com::android::server::wifi::wificond::PartialScanSettings;
 using ::com::android::server::wifi::wificond::PnoNetwork;
 using ::com::android::server::wifi::wificond::PnoSettings;
+using ::com::android::server::wifi::wificond::ScanResultFilter;
 using ::com::android::server::wifi::wificond::SingleScanSettings;
 using std::vector;
 
@@ -46,6 +50,12 @@ const uint8_t kFakeSsid1[] =
 constexpr int32_t kFakePnoIntervalMs = 20000;
 constexpr int32_t kFakePnoMin2gRssi = -80;
 constexpr int32_t kFakePnoMin5gRssi = -85;
+constexpr int32_t kFakePnoRelativeRssi = -5;
+constexpr int32_t kFakeMinSignalMbm = -7000;
+constexpr int64_t kFakeMaxAgeMs = 5000;
+constexpr int32_t kFakeMaxNumResults = 20;
+constexpr int32_t kFakeFullScanInterval = 4;
+constexpr int32_t kFakeMaxChannelAgeMs = 3000;
 
 constexpr uint32_t kFakeFrequency = 5260;
 constexpr uint32_t kFakeFrequency1 = 2460;
@@ -100,6 +110,7 @@ TEST_F(ScanSettingsTest, SingleScanSettingsParcelableTest) {
 
   scan_settings.channel_settings_ = {channel, channel1, channel2};
   scan_settings.hidden_networks_ = {network};
+  scan_settings.max_channel_age_ms_ = kFakeMaxChannelAgeMs;
 
   Parcel parcel;
   EXPECT_EQ(::android::OK, scan_settings.writeToParcel(&parcel));
@@ -111,6 +122,23 @@ TEST_F(ScanSettingsTest, SingleScanSettingsParcelableTest) {
   EXPECT_EQ(scan_settings, scan_settings_copy);
 }
 
+TEST_F(ScanSettingsTest, SingleScanSettingsParcelableWithoutMaxChannelAge) {
+  // Frameworks which predate the max channel age write the other fields
+  // only.
+  Parcel parcel;
+  parcel.writeInt32(IWifiScannerImpl::SCAN_TYPE_LOW_SPAN);
+  parcel.writeInt32(0);
+  parcel.writeInt32(0);
+
+  SingleScanSettings scan_settings;
+  scan_settings.max_channel_age_ms_ = kFakeMaxChannelAgeMs;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, scan_settings.readFromParcel(&parcel));
+
+  EXPECT_EQ(IWifiScannerImpl::SCAN_TYPE_LOW_SPAN, scan_settings.scan_type_);
+  EXPECT_EQ(0, scan_settings.max_channel_age_ms_);
+}
+
 TEST_F(ScanSettingsTest, SingleScanSettingsParcelableWriteInvalidScanType) {
   SingleScanSettings scan_settings;
 
@@ -158,10 +186,15 @@ TEST_F(ScanSettingsTest, PnoSettingsParcelableTest) {
   network1.ssid_ =
       vector<uint8_t>(kFakeSsid1, kFakeSsid1 + sizeof(kFakeSsid1));
   network1.is_hidden_ = false;
+  network1.priority_ = 2;
 
   pno_settings.interval_ms_ = kFakePnoIntervalMs;
   pno_settings.min_2g_rssi_ = kFakePnoMin2gRssi;
   pno_settings.min_5g_rssi_ = kFakePnoMin5gRssi;
+  pno_settings.mobility_hint_ = IWifiScannerImpl::MOBILITY_STATIONARY;
+  pno_settings.is_screen_on_ = false;
+  pno_settings.relative_rssi_set_ = true;
+  pno_settings.relative_rssi_ = kFakePnoRelativeRssi;
 
   pno_settings.pno_networks_ = {network, network1};
 
@@ -175,6 +208,100 @@ TEST_F(ScanSettingsTest, PnoSettingsParcelableTest) {
   EXPECT_EQ(pno_settings, pno_settings_copy);
 }
 
+TEST_F(ScanSettingsTest, PnoSettingsParcelableWithoutOptionalFields) {
+  // Frameworks which predate the hints and relative rssi write the other
+  // fields only.
+  Parcel parcel;
+  parcel.writeInt32(kFakePnoIntervalMs);
+  parcel.writeInt32(kFakePnoMin2gRssi);
+  parcel.writeInt32(kFakePnoMin5gRssi);
+  parcel.writeInt32(0);
+
+  PnoSettings pno_settings;
+  pno_settings.mobility_hint_ = IWifiScannerImpl::MOBILITY_STATIONARY;
+  pno_settings.is_screen_on_ = false;
+  pno_settings.relative_rssi_set_ = true;
+  pno_settings.relative_rssi_ = kFakePnoRelativeRssi;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, pno_settings.readFromParcel(&parcel));
+
+  EXPECT_EQ(kFakePnoIntervalMs, pno_settings.interval_ms_);
+  EXPECT_EQ(IWifiScannerImpl::MOBILITY_UNKNOWN, pno_settings.mobility_hint_);
+  EXPECT_TRUE(pno_settings.is_screen_on_);
+  EXPECT_FALSE(pno_settings.relative_rssi_set_);
+}
+
+TEST_F(ScanSettingsTest, PnoSettingsParcelableWithoutNetworkPriorities) {
+  PnoNetwork network, network1;
+  network.ssid_ =
+      vector<uint8_t>(kFakeSsid, kFakeSsid + sizeof(kFakeSsid));
+  network1.ssid_ =
+      vector<uint8_t>(kFakeSsid1, kFakeSsid1 + sizeof(kFakeSsid1));
+  PnoSettings pno_settings;
+  pno_settings.pno_networks_ = {network, network1};
+
+  // Frameworks which predate network priorities stop after relative rssi.
+  Parcel parcel;
+  parcel.writeInt32(kFakePnoIntervalMs);
+  parcel.writeInt32(kFakePnoMin2gRssi);
+  parcel.writeInt32(kFakePnoMin5gRssi);
+  parcel.writeInt32(pno_settings.pno_networks_.size());
+  for (const auto& pno_network : pno_settings.pno_networks_) {
+    parcel.writeInt32(1);
+    EXPECT_EQ(::android::OK, pno_network.writeToParcel(&parcel));
+  }
+  parcel.writeInt32(IWifiScannerImpl::MOBILITY_UNKNOWN);
+  parcel.writeBool(true);
+  parcel.writeBool(false);
+  parcel.writeInt32(0);
+
+  PnoSettings pno_settings_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, pno_settings_copy.readFromParcel(&parcel));
+
+  ASSERT_EQ(2u, pno_settings_copy.pno_networks_.size());
+  EXPECT_EQ(0, pno_settings_copy.pno_networks_[0].priority_);
+  EXPECT_EQ(0, pno_settings_copy.pno_networks_[1].priority_);
+  EXPECT_EQ(pno_settings.pno_networks_[1].ssid_,
+            pno_settings_copy.pno_networks_[1].ssid_);
+}
+
+TEST_F(ScanSettingsTest, ScanResultFilterParcelableTest) {
+  ScanResultFilter filter;
+  filter.band_mask_ = IWifiScannerImpl::BAND_2_4_GHZ |
+      IWifiScannerImpl::BAND_5_GHZ;
+  filter.min_signal_mbm_ = kFakeMinSignalMbm;
+  filter.ssids_ = {vector<uint8_t>(kFakeSsid, kFakeSsid + sizeof(kFakeSsid)),
+                   vector<uint8_t>(kFakeSsid1, kFakeSsid1 + sizeof(kFakeSsid1))};
+  filter.max_age_ms_ = kFakeMaxAgeMs;
+  filter.max_num_results_ = kFakeMaxNumResults;
+
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, filter.writeToParcel(&parcel));
+
+  ScanResultFilter filter_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, filter_copy.readFromParcel(&parcel));
+
+  EXPECT_EQ(filter, filter_copy);
+}
+
+TEST_F(ScanSettingsTest, PartialScanSettingsParcelableTest) {
+  PartialScanSettings settings;
+  settings.ssids_ = {
+      vector<uint8_t>(kFakeSsid, kFakeSsid + sizeof(kFakeSsid)),
+      vector<uint8_t>(kFakeSsid1, kFakeSsid1 + sizeof(kFakeSsid1))};
+  settings.full_scan_interval_ = kFakeFullScanInterval;
+
+  Parcel parcel;
+  EXPECT_EQ(::android::OK, settings.writeToParcel(&parcel));
+
+  PartialScanSettings settings_copy;
+  parcel.setDataPosition(0);
+  EXPECT_EQ(::android::OK, settings_copy.readFromParcel(&parcel));
+
+  EXPECT_EQ(settings, settings_copy);
+}
 
 
 }  // namespace wificond
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include <linux/netlink.h>
+#include <time.h>
 
 #include <gtest/gtest.h>
 
@@ -34,20 +35,24 @@ using std::placeholders::_2;
 using std::unique_ptr;
 using std::vector;
 using testing::AllOf;
+using testing::DoAll;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Not;
 using testing::Return;
+using testing::SaveArg;
 using testing::_;
 
 using android::net::wifi::IWifiScannerImpl;
 using com::android::server::wifi::wificond::NativeScanResult;
+using com::android::server::wifi::wificond::ScanResultFilter;
 
 namespace android {
 namespace wificond {
 
 namespace {
 
+constexpr uint16_t kFakeFamilyId = 14;
 constexpr uint32_t kFakeInterfaceIndex = 12;
 constexpr uint32_t kFakeScheduledScanIntervalMs = 20000;
 constexpr uint32_t kFakeSequenceNumber = 1984;
@@ -57,6 +62,16 @@ constexpr int32_t kFake5gRssiThreshold = -77;
 constexpr bool kFakeUseRandomMAC = true;
 constexpr bool kFakeRequestLowPower = true;
 constexpr int kFakeScanType = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
+constexpr uint8_t kFakeBssid[] = {0xc0, 0x3f, 0x0e, 0x77, 0xe8, 0x7f};
+constexpr uint8_t kFakeIe[] = {0x00, 0x04, 't', 'e', 's', 't'};
+constexpr uint32_t kFakeFrequency = 5180;
+constexpr int32_t kFakeSignalMbm = -5000;
+constexpr uint64_t kFakeTsf = 1234567;
+constexpr uint32_t kFakeGeneration = 42;
+constexpr uint32_t kFake2gFrequency = 2412;
+constexpr int64_t kFakeMaxAgeMs = 1000;
+const vector<uint8_t> kFakeSsid = {'t', 'e', 's', 't'};
+const vector<uint8_t> kFakeOtherSsid = {'o', 't', 'h', 'e', 'r'};
 
 // Currently, control messages are only created by the kernel and sent to us.
 // Therefore NL80211Packet doesn't have corresponding constructor.
@@ -80,6 +95,71 @@ NL80211Packet CreateControlMessageAck() {
   return CreateControlMessageError(0);
 }
 
+// Creates the attributes of a BSS with |kFakeBssid|.
+NL80211NestedAttr CreateBssAttribute(uint64_t tsf, int32_t signal_mbm) {
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_BSSID,
+      vector<uint8_t>(kFakeBssid, kFakeBssid + sizeof(kFakeBssid))));
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_FREQUENCY,
+                                         kFakeFrequency));
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_INFORMATION_ELEMENTS,
+      vector<uint8_t>(kFakeIe, kFakeIe + sizeof(kFakeIe))));
+  bss.AddAttribute(NL80211Attr<uint64_t>(NL80211_BSS_TSF, tsf));
+  bss.AddAttribute(NL80211Attr<int32_t>(NL80211_BSS_SIGNAL_MBM, signal_mbm));
+  bss.AddAttribute(NL80211Attr<uint16_t>(NL80211_BSS_CAPABILITY, 0));
+  return bss;
+}
+
+uint64_t GetBoottimeNanoseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+// Creates the attributes of a BSS whose BSSID ends with |bssid_suffix|.
+// The BSS was last seen at |last_seen_boottime_ns|, or just now by default.
+NL80211NestedAttr CreateBssAttribute(uint8_t bssid_suffix,
+                                     uint32_t frequency,
+                                     int32_t signal_mbm,
+                                     const vector<uint8_t>& ssid,
+                                     uint64_t last_seen_boottime_ns =
+                                         GetBoottimeNanoseconds()) {
+  vector<uint8_t> bssid(kFakeBssid, kFakeBssid + sizeof(kFakeBssid));
+  bssid.back() = bssid_suffix;
+  vector<uint8_t> ie = {0x00, static_cast<uint8_t>(ssid.size())};
+  ie.insert(ie.end(), ssid.begin(), ssid.end());
+  NL80211NestedAttr bss(NL80211_ATTR_BSS);
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(NL80211_BSS_BSSID, bssid));
+  bss.AddAttribute(NL80211Attr<uint32_t>(NL80211_BSS_FREQUENCY, frequency));
+  bss.AddAttribute(NL80211Attr<vector<uint8_t>>(
+      NL80211_BSS_INFORMATION_ELEMENTS, ie));
+  bss.AddAttribute(NL80211Attr<uint64_t>(NL80211_BSS_TSF, kFakeTsf));
+  bss.AddAttribute(NL80211Attr<int32_t>(NL80211_BSS_SIGNAL_MBM, signal_mbm));
+  bss.AddAttribute(NL80211Attr<uint16_t>(NL80211_BSS_CAPABILITY, 0));
+  bss.AddAttribute(NL80211Attr<uint64_t>(NL80211_BSS_LAST_SEEN_BOOTTIME,
+                                         last_seen_boottime_ns));
+  return bss;
+}
+
+// Creates a scan dump reply carrying |bss|.
+NL80211Packet CreateScanResultMessage(uint32_t generation,
+                                      const NL80211NestedAttr& bss) {
+  NL80211Packet packet(
+      kFakeFamilyId,
+      NL80211_CMD_NEW_SCAN_RESULTS,
+      kFakeSequenceNumber,
+      getpid());
+  packet.AddFlag(NLM_F_MULTI);
+  packet.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_GENERATION,
+                                            generation));
+  packet.AddAttribute(NL80211Attr<uint32_t>(NL80211_ATTR_IFINDEX,
+                                            kFakeInterfaceIndex));
+  packet.AddAttribute(bss);
+  return packet;
+}
+
 // This is a helper function to mock the behavior of NetlinkManager::
 // SendMessageAndGetResponses() when we expect a single packet response.
 // |request_message| and |response| are mapped to existing parameters of
@@ -95,6 +175,61 @@ bool AppendMessageAndReturn(
   return mock_return_value;
 }
 
+// Same as AppendMessageAndReturn(), but for a multi-packet response.
+bool AppendMessagesAndReturn(
+    vector<NL80211Packet>& mock_responses,
+    bool mock_return_value,
+    const NL80211Packet& request_message,
+    vector<std::unique_ptr<const NL80211Packet>>* response) {
+  for (const auto& mock_response : mock_responses) {
+    response->push_back(std::make_unique<NL80211Packet>(mock_response));
+  }
+  return mock_return_value;
+}
+
+// This is a helper function to mock the behavior of NetlinkManager::
+// SendMessageAndHandleResponses() when we expect a single packet response.
+// |request_message| and |handler| are mapped to existing parameters of
+// SendMessageAndHandleResponses().
+bool HandleMessageAndReturn(
+    NL80211Packet& mock_response,
+    bool mock_return_value,
+    const NL80211Packet& request_message,
+    std::function<void(const NL80211PacketView&)> handler) {
+  handler(NL80211PacketView(mock_response));
+  return mock_return_value;
+}
+
+// Same as HandleMessageAndReturn(), but for a multi-packet response.
+bool HandleMessagesAndReturn(
+    vector<NL80211Packet>& mock_responses,
+    bool mock_return_value,
+    const NL80211Packet& request_message,
+    std::function<void(const NL80211PacketView&)> handler) {
+  for (const auto& mock_response : mock_responses) {
+    handler(NL80211PacketView(mock_response));
+  }
+  return mock_return_value;
+}
+
+// Scan dump reply with BSSs on different bands, with different signal
+// strength and SSIDs.
+vector<NL80211Packet> CreateScanResultMessagesForFiltering() {
+  // Last seen right after boot.
+  NL80211NestedAttr stale_bss =
+      CreateBssAttribute(5, kFakeFrequency, -4000, kFakeSsid, 0);
+  return {
+      CreateScanResultMessage(kFakeGeneration, CreateBssAttribute(
+          1, kFake2gFrequency, -5000, kFakeSsid)),
+      CreateScanResultMessage(kFakeGeneration, CreateBssAttribute(
+          2, kFakeFrequency, -6000, kFakeSsid)),
+      CreateScanResultMessage(kFakeGeneration, CreateBssAttribute(
+          3, kFakeFrequency, -9000, kFakeSsid)),
+      CreateScanResultMessage(kFakeGeneration, CreateBssAttribute(
+          4, kFakeFrequency, -5500, kFakeOtherSsid)),
+      CreateScanResultMessage(kFakeGeneration, stale_bss)};
+}
+
 }  // namespace
 
 class ScanUtilsTest : public ::testing::Test {
@@ -102,6 +237,10 @@ class ScanUtilsTest : public ::testing::Test {
   virtual void SetUp() {
     ON_CALL(netlink_manager_,
             SendMessageAndGetResponses(_, _)).WillByDefault(Return(true));
+    ON_CALL(netlink_manager_,
+            SendMessageAndHandleResponses(_, _)).WillByDefault(Return(true));
+    ON_CALL(netlink_manager_,
+            GetFamilyId()).WillByDefault(Return(kFakeFamilyId));
   }
 
   NiceMock<MockNetlinkManager> netlink_manager_;
@@ -132,7 +271,7 @@ TEST_F(ScanUtilsTest, CanGetScanResult) {
   vector<NativeScanResult> scan_results;
   EXPECT_CALL(
       netlink_manager_,
-      SendMessageAndGetResponses(
+      SendMessageAndHandleResponses(
           DoesNL80211PacketMatchCommand(NL80211_CMD_GET_SCAN), _));
 
   // We don't use EXPECT_TRUE here because we need to mock a complete
@@ -143,6 +282,309 @@ TEST_F(ScanUtilsTest, CanGetScanResult) {
   scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results);
 }
 
+TEST_F(ScanUtilsTest, CanServeScanResultsFromCache) {
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _));
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [](uint32_t, bool, vector<vector<uint8_t>>&, vector<uint32_t>&) {});
+
+  NL80211Packet response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm));
+  // Only the first read dumps scan results from kernel.
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessageAndReturn, response, true, _1, _2)));
+  for (int i = 0; i < 2; i++) {
+    vector<NativeScanResult> scan_results;
+    EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex,
+                                          &scan_results));
+    ASSERT_EQ(1u, scan_results.size());
+    EXPECT_EQ(vector<uint8_t>(kFakeBssid, kFakeBssid + sizeof(kFakeBssid)),
+              scan_results[0].bssid);
+    EXPECT_EQ(kFakeSignalMbm, scan_results[0].signal_mbm);
+  }
+}
+
+TEST_F(ScanUtilsTest, CanReportDumpTiming) {
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _));
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [](uint32_t, bool, vector<vector<uint8_t>>&, vector<uint32_t>&) {});
+
+  ScanResultDumpTiming timing;
+  EXPECT_FALSE(scan_utils_.GetLastDumpTiming(kFakeInterfaceIndex, &timing));
+  NL80211Packet response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm));
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessageAndReturn, response, true, _1, _2)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  EXPECT_TRUE(scan_utils_.GetLastDumpTiming(kFakeInterfaceIndex, &timing));
+
+  // Scan results served from the cache are not dumped.
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  EXPECT_FALSE(scan_utils_.GetLastDumpTiming(kFakeInterfaceIndex, &timing));
+}
+
+TEST_F(ScanUtilsTest, CanRefreshScanResultCacheOnNotification) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  bool handler_called = false;
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [&handler_called](uint32_t, bool, vector<vector<uint8_t>>&,
+                        vector<uint32_t>&) {
+        handler_called = true;
+      });
+
+  NL80211Packet response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm));
+  NL80211Packet new_response = CreateScanResultMessage(
+      kFakeGeneration + 1,
+      CreateBssAttribute(kFakeTsf + 1, kFakeSignalMbm + 100));
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessageAndReturn, response, true, _1, _2))).
+      WillOnce(Invoke(bind(
+          HandleMessageAndReturn, new_response, true, _1, _2)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+  EXPECT_TRUE(handler_called);
+
+  scan_results.clear();
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(kFakeSignalMbm + 100, scan_results[0].signal_mbm);
+  EXPECT_EQ(kFakeTsf + 1, scan_results[0].tsf);
+}
+
+TEST_F(ScanUtilsTest, CanReuseUnchangedBssWhenRefreshingScanResultCache) {
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _));
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [](uint32_t, bool, vector<vector<uint8_t>>&, vector<uint32_t>&) {});
+
+  NL80211Packet response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm));
+  // Same timestamp and IEs, so the BSS isn't parsed again.
+  NL80211Packet new_response = CreateScanResultMessage(
+      kFakeGeneration + 1, CreateBssAttribute(kFakeTsf, kFakeSignalMbm + 100));
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessageAndReturn, response, true, _1, _2))).
+      WillOnce(Invoke(bind(
+          HandleMessageAndReturn, new_response, true, _1, _2)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+
+  scan_utils_.InvalidateScanResultCache(kFakeInterfaceIndex);
+  scan_results.clear();
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(kFakeSignalMbm, scan_results[0].signal_mbm);
+}
+
+TEST_F(ScanUtilsTest, CanExpireScanResultCache) {
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _));
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [](uint32_t, bool, vector<vector<uint8_t>>&, vector<uint32_t>&) {});
+
+  // A BSS last seen right after boot has long been expired by the kernel.
+  NL80211NestedAttr bss = CreateBssAttribute(kFakeTsf, kFakeSignalMbm);
+  bss.AddAttribute(
+      NL80211Attr<uint64_t>(NL80211_BSS_LAST_SEEN_BOOTTIME, 0));
+  NL80211Packet expired_response =
+      CreateScanResultMessage(kFakeGeneration, bss);
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      Times(2).
+      WillRepeatedly(Invoke(bind(
+          HandleMessageAndReturn, expired_response, true, _1, _2)));
+  for (int i = 0; i < 2; i++) {
+    vector<NativeScanResult> scan_results;
+    EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex,
+                                          &scan_results));
+    EXPECT_EQ(1u, scan_results.size());
+  }
+}
+
+TEST_F(ScanUtilsTest, DiscardsScanResultCacheOnDumpFailure) {
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _));
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [](uint32_t, bool, vector<vector<uint8_t>>&, vector<uint32_t>&) {});
+
+  NL80211Packet response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm));
+  // Same generation, which would let a stale cache be reused.
+  NL80211Packet new_response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm + 100));
+  // The failed dump has already handled part of the reply, so the cache
+  // can't be trusted afterwards.
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessageAndReturn, response, true, _1, _2))).
+      WillOnce(Invoke(bind(HandleMessageAndReturn, response, false, _1, _2))).
+      WillOnce(Invoke(bind(
+          HandleMessageAndReturn, new_response, true, _1, _2)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  scan_utils_.InvalidateScanResultCache(kFakeInterfaceIndex);
+  scan_results.clear();
+  EXPECT_FALSE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  EXPECT_TRUE(scan_results.empty());
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(kFakeSignalMbm + 100, scan_results[0].signal_mbm);
+}
+
+TEST_F(ScanUtilsTest, DoesNotCacheScanResultsOfDumpWithError) {
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _));
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [](uint32_t, bool, vector<vector<uint8_t>>&, vector<uint32_t>&) {});
+
+  NL80211Packet response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm));
+  // The dump itself succeeds, but kernel ends it with an error.
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(HandleMessageAndReturn,
+                           CreateControlMessageError(kFakeErrorCode),
+                           true, _1, _2))).
+      WillOnce(Invoke(bind(HandleMessageAndReturn, response, true, _1, _2)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_FALSE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  EXPECT_TRUE(scan_results.empty());
+  // The next read dumps again instead of serving an empty cache.
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  EXPECT_EQ(1u, scan_results.size());
+}
+
+TEST_F(ScanUtilsTest, DoesNotCacheScanResultsWithoutSubscription) {
+  NL80211Packet response = CreateScanResultMessage(
+      kFakeGeneration, CreateBssAttribute(kFakeTsf, kFakeSignalMbm));
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      Times(2).
+      WillRepeatedly(Invoke(bind(
+          HandleMessageAndReturn, response, true, _1, _2)));
+  for (int i = 0; i < 2; i++) {
+    vector<NativeScanResult> scan_results;
+    EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex,
+                                          &scan_results));
+    EXPECT_EQ(1u, scan_results.size());
+  }
+}
+
+TEST_F(ScanUtilsTest, CanFilterScanResults) {
+  vector<NL80211Packet> responses = CreateScanResultMessagesForFiltering();
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(
+          HandleMessagesAndReturn, responses, true, _1, _2)));
+  ScanResultFilter filter;
+  filter.band_mask_ = IWifiScannerImpl::BAND_5_GHZ;
+  filter.min_signal_mbm_ = -8000;
+  filter.ssids_ = {kFakeSsid};
+  filter.max_age_ms_ = kFakeMaxAgeMs;
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(kFakeInterfaceIndex,
+                                                filter,
+                                                &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(2, scan_results[0].bssid.back());
+}
+
+TEST_F(ScanUtilsTest, CanSelectScanResultsWithStrongestSignal) {
+  vector<NL80211Packet> responses = CreateScanResultMessagesForFiltering();
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(
+          HandleMessagesAndReturn, responses, true, _1, _2)));
+  ScanResultFilter filter;
+  filter.max_num_results_ = 3;
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(kFakeInterfaceIndex,
+                                                filter,
+                                                &scan_results));
+  ASSERT_EQ(3u, scan_results.size());
+  EXPECT_EQ(5, scan_results[0].bssid.back());
+  EXPECT_EQ(1, scan_results[1].bssid.back());
+  EXPECT_EQ(4, scan_results[2].bssid.back());
+}
+
+TEST_F(ScanUtilsTest, CanFilterCachedScanResults) {
+  EXPECT_CALL(netlink_manager_, SubscribeScanResultNotification(_, _));
+  scan_utils_.SubscribeScanResultNotification(
+      kFakeInterfaceIndex,
+      [](uint32_t, bool, vector<vector<uint8_t>>&, vector<uint32_t>&) {});
+
+  // The cache holds every BSS, and is filtered on each read.
+  vector<NL80211Packet> responses = {
+      CreateScanResultMessage(kFakeGeneration, CreateBssAttribute(
+          1, kFake2gFrequency, -5000, kFakeSsid)),
+      CreateScanResultMessage(kFakeGeneration, CreateBssAttribute(
+          2, kFakeFrequency, -6000, kFakeOtherSsid))};
+  EXPECT_CALL(netlink_manager_, SendMessageAndHandleResponses(_, _)).
+      WillOnce(Invoke(bind(
+          HandleMessagesAndReturn, responses, true, _1, _2)));
+  ScanResultFilter filter;
+  filter.band_mask_ = IWifiScannerImpl::BAND_5_GHZ;
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(kFakeInterfaceIndex,
+                                                filter,
+                                                &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(2, scan_results[0].bssid.back());
+
+  filter.band_mask_ = IWifiScannerImpl::BAND_2_4_GHZ;
+  scan_results.clear();
+  EXPECT_TRUE(scan_utils_.GetFilteredScanResult(kFakeInterfaceIndex,
+                                                filter,
+                                                &scan_results));
+  ASSERT_EQ(1u, scan_results.size());
+  EXPECT_EQ(1, scan_results[0].bssid.back());
+
+  scan_results.clear();
+  EXPECT_TRUE(scan_utils_.GetScanResult(kFakeInterfaceIndex, &scan_results));
+  EXPECT_EQ(2u, scan_results.size());
+}
+
+TEST_F(ScanUtilsTest, CanGetScanResultAsync) {
+  OnDumpCompleteHandler complete_handler;
+  EXPECT_CALL(
+      netlink_manager_,
+      RegisterHandlerAndSendDumpMessage(
+          DoesNL80211PacketMatchCommand(NL80211_CMD_GET_SCAN), _, _)).
+      WillOnce(DoAll(SaveArg<2>(&complete_handler), Return(true)));
+
+  bool handler_called = false;
+  EXPECT_TRUE(scan_utils_.GetScanResultAsync(
+      kFakeInterfaceIndex,
+      [&handler_called](bool success, vector<NativeScanResult>& scan_results) {
+        handler_called = true;
+        EXPECT_TRUE(success);
+        EXPECT_TRUE(scan_results.empty());
+      }));
+  EXPECT_FALSE(handler_called);
+  complete_handler(DUMP_DONE, 0);
+  EXPECT_TRUE(handler_called);
+}
+
+TEST_F(ScanUtilsTest, CanHandleGetScanResultAsyncError) {
+  OnDumpCompleteHandler complete_handler;
+  EXPECT_CALL(netlink_manager_, RegisterHandlerAndSendDumpMessage(_, _, _)).
+      WillOnce(DoAll(SaveArg<2>(&complete_handler), Return(true)));
+
+  bool handler_called = false;
+  EXPECT_TRUE(scan_utils_.GetScanResultAsync(
+      kFakeInterfaceIndex,
+      [&handler_called](bool success, vector<NativeScanResult>& scan_results) {
+        handler_called = true;
+        EXPECT_FALSE(success);
+      }));
+  complete_handler(DUMP_ERROR, kFakeErrorCode);
+  EXPECT_TRUE(handler_called);
+}
+
 TEST_F(ScanUtilsTest, CanSendScanRequest) {
   NL80211Packet response = CreateControlMessageAck();
   EXPECT_CALL(
@@ -277,7 +719,7 @@ TEST_F(ScanUtilsTest, CanSendSchedScanRequest) {
   EXPECT_TRUE(scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       SchedScanIntervalSetting(),
-      kFake2gRssiThreshold, kFake5gRssiThreshold,
+      SchedScanRssiSetting{kFake2gRssiThreshold, kFake5gRssiThreshold},
       kFakeUseRandomMAC, kFakeRequestLowPower, {}, {}, {}, &errno_ignored));
   // TODO(b/34231420): Add validation of requested scan ssids, threshold,
   // and frequencies.
@@ -295,7 +737,7 @@ TEST_F(ScanUtilsTest, CanHandleSchedScanRequestFailure) {
   EXPECT_FALSE(scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       SchedScanIntervalSetting(),
-      kFake2gRssiThreshold, kFake5gRssiThreshold,
+      SchedScanRssiSetting{kFake2gRssiThreshold, kFake5gRssiThreshold},
       kFakeUseRandomMAC, kFakeRequestLowPower, {}, {}, {}, &error_code));
   EXPECT_EQ(kFakeErrorCode, error_code);
 }
@@ -314,7 +756,7 @@ TEST_F(ScanUtilsTest, CanSendSchedScanRequestForLowPowerScan) {
   scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       SchedScanIntervalSetting(),
-      kFake2gRssiThreshold, kFake5gRssiThreshold,
+      SchedScanRssiSetting{kFake2gRssiThreshold, kFake5gRssiThreshold},
       false, true, {}, {}, {}, &errno_ignored);
 }
 
@@ -336,7 +778,7 @@ TEST_F(ScanUtilsTest, CanSpecifyScanPlansForSchedScanRequest) {
   scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       interval_setting,
-      kFake2gRssiThreshold, kFake5gRssiThreshold,
+      SchedScanRssiSetting{kFake2gRssiThreshold, kFake5gRssiThreshold},
       kFakeUseRandomMAC, kFakeRequestLowPower, {}, {}, {}, &errno_ignored);
 }
 
@@ -356,10 +798,36 @@ TEST_F(ScanUtilsTest, CanSpecifySingleIntervalForSchedScanRequest) {
   scan_utils_.StartScheduledScan(
       kFakeInterfaceIndex,
       interval_setting,
-      kFake2gRssiThreshold, kFake5gRssiThreshold,
+      SchedScanRssiSetting{kFake2gRssiThreshold, kFake5gRssiThreshold},
       kFakeUseRandomMAC, kFakeRequestLowPower, {}, {}, {}, &errno_ignored);
 }
 
+TEST_F(ScanUtilsTest, CanSpecifyRelativeRssiForSchedScanRequest) {
+  EXPECT_CALL(
+      netlink_manager_,
+       SendMessageAndGetResponses(
+           AllOf(
+               DoesNL80211PacketMatchCommand(NL80211_CMD_START_SCHED_SCAN),
+               DoesNL80211PacketHaveAttribute(
+                   NL80211_ATTR_SCHED_SCAN_RELATIVE_RSSI),
+               DoesNL80211PacketHaveAttribute(
+                   NL80211_ATTR_SCHED_SCAN_RSSI_ADJUST)),
+           _));
+  int errno_ignored;
+  SchedScanRssiSetting rssi_setting{kFake2gRssiThreshold,
+                                    kFake5gRssiThreshold};
+  rssi_setting.relative_rssi_set = true;
+  rssi_setting.relative_rssi = 5;
+
+  scan_utils_.StartScheduledScan(
+      kFakeInterfaceIndex,
+      SchedScanIntervalSetting(),
+      rssi_setting,
+      kFakeUseRandomMAC, kFakeRequestLowPower, {},
+      {{kFakeSsid, kFake2gRssiThreshold}},
+      {}, &errno_ignored);
+}
+
 TEST_F(ScanUtilsTest, CanPrioritizeLastSeenSinceBootNetlinkAttribute) {
   constexpr uint64_t kLastSeenTimestampNanoSeconds = 123456;
   constexpr uint64_t kBssTsfTimestampMicroSeconds = 654321;
@@ -25,24 +25,38 @@
 #include "wificond/scanning/offload/offload_scan_utils.h"
 #include "wificond/scanning/scanner_impl.h"
 #include "wificond/tests/mock_client_interface_impl.h"
+#include "wificond/tests/mock_event_loop.h"
 #include "wificond/tests/mock_netlink_manager.h"
 #include "wificond/tests/mock_netlink_utils.h"
 #include "wificond/tests/mock_offload_scan_callback_interface_impl.h"
 #include "wificond/tests/mock_offload_scan_manager.h"
 #include "wificond/tests/mock_offload_service_utils.h"
+#include "wificond/tests/mock_scan_event.h"
 #include "wificond/tests/mock_scan_utils.h"
 #include "wificond/tests/offload_test_utils.h"
+#include "wificond/wiphy_info_cache.h"
 
 using ::android::binder::Status;
 using ::android::net::wifi::IWifiScannerImpl;
 using ::android::wifi_system::MockInterfaceTool;
+using ::com::android::server::wifi::wificond::ChannelSettings;
+using ::com::android::server::wifi::wificond::HiddenNetwork;
 using ::com::android::server::wifi::wificond::SingleScanSettings;
+using ::com::android::server::wifi::wificond::PartialScanSettings;
+using ::com::android::server::wifi::wificond::PnoNetwork;
 using ::com::android::server::wifi::wificond::PnoSettings;
+using ::com::android::server::wifi::wificond::ScanResultFilter;
 using ::com::android::server::wifi::wificond::NativeScanResult;
+using ::com::android::server::wifi::wificond::NativeScanResultBuffer;
+using ::com::android::server::wifi::wificond::NativeScanResultDelta;
 using android::hardware::wifi::offload::V1_0::ScanResult;
 using ::testing::Invoke;
 using ::testing::NiceMock;
+using ::testing::DoAll;
+using ::testing::InSequence;
 using ::testing::Return;
+using ::testing::SaveArg;
+using ::testing::SetArgPointee;
 using ::testing::_;
 using std::shared_ptr;
 using std::unique_ptr;
@@ -57,6 +71,33 @@ namespace {
 
 constexpr uint32_t kFakeInterfaceIndex = 12;
 constexpr uint32_t kFakeScanIntervalMs = 10000;
+const uint8_t kFakeBssid1[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+const uint8_t kFakeBssid2[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbd};
+constexpr uint64_t kFakeTsf = 1200;
+constexpr uint32_t kFakeFrequency1 = 2412;
+constexpr uint32_t kFakeFrequency2 = 5180;
+const vector<uint8_t> kFakeSsid1 = {'a', 'p', '1'};
+const vector<uint8_t> kFakeSsid2 = {'a', 'p', '2'};
+const vector<uint8_t> kFakeSsid3 = {'a', 'p', '3'};
+
+MATCHER_P(HasMatchSsids, ssids, "") {
+  if (arg.size() != ssids.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < arg.size(); i++) {
+    if (arg[i].ssid != ssids[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+NativeScanResult CreateScanResult(const uint8_t* bssid, uint64_t tsf) {
+  NativeScanResult scan_result;
+  scan_result.bssid.assign(bssid, bssid + 6);
+  scan_result.tsf = tsf;
+  return scan_result;
+}
 
 // This is a helper function to mock the behavior of ScanUtils::Scan()
 // when we expect a error code.
@@ -79,12 +120,11 @@ bool ReturnErrorCodeForScanRequest(
 bool CaptureSchedScanIntervalSetting(
     uint32_t /* interface_index */,
     const SchedScanIntervalSetting&  interval_setting,
-    int32_t /* rssi_threshold_2g */,
-    int32_t /* rssi_threshold_5g */,
+    const SchedScanRssiSetting& /* rssi_setting */,
     bool /* request_random_mac */,
     bool /* request_low_power_scan */,
     const  std::vector<std::vector<uint8_t>>& /* scan_ssids */,
-    const std::vector<std::vector<uint8_t>>& /* match_ssids */,
+    const std::vector<SchedScanMatchSet>& /* match_sets */,
     const  std::vector<uint32_t>& /* freqs */,
     int* /* error_code */,
     SchedScanIntervalSetting* out_interval_setting) {
@@ -107,6 +147,20 @@ bool ReturnNetlinkScanResults(
                                                       native_scan_results_);
 }
 
+SingleScanSettings CreateSingleScanSettings(int scan_type,
+                                            uint32_t frequency,
+                                            const vector<uint8_t>& ssid) {
+  SingleScanSettings scan_settings;
+  scan_settings.scan_type_ = scan_type;
+  ChannelSettings channel;
+  channel.frequency_ = frequency;
+  scan_settings.channel_settings_.push_back(channel);
+  HiddenNetwork network;
+  network.ssid_ = ssid;
+  scan_settings.hidden_networks_.push_back(network);
+  return scan_settings;
+}
+
 }  // namespace
 
 class ScannerTest : public ::testing::Test {
@@ -126,8 +180,11 @@ class ScannerTest : public ::testing::Test {
   NiceMock<MockNetlinkUtils> netlink_utils_{&netlink_manager_};
   NiceMock<MockScanUtils> scan_utils_{&netlink_manager_};
   NiceMock<MockInterfaceTool> if_tool_;
+  WiphyInfoCache wiphy_info_cache_{&netlink_utils_};
+  NiceMock<MockEventLoop> event_loop_;
   NiceMock<MockClientInterfaceImpl> client_interface_impl_{
-      &if_tool_, &netlink_utils_, &scan_utils_};
+      &if_tool_, &netlink_utils_, &scan_utils_, &wiphy_info_cache_,
+      &event_loop_};
   shared_ptr<NiceMock<MockOffloadServiceUtils>> offload_service_utils_{
       new NiceMock<MockOffloadServiceUtils>()};
   shared_ptr<NiceMock<MockOffloadScanCallbackInterfaceImpl>>
@@ -150,7 +207,8 @@ TEST_F(ScannerTest, TestSingleScan) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_TRUE(scanner_impl_->scan(SingleScanSettings(), &success).isOk());
   EXPECT_TRUE(success);
 }
@@ -162,7 +220,8 @@ TEST_F(ScannerTest, TestSingleScanForLowSpanScan) {
   wiphy_features_.supports_low_span_oneshot_scan = true;
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   SingleScanSettings settings;
   settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
   bool success = false;
@@ -177,7 +236,8 @@ TEST_F(ScannerTest, TestSingleScanForLowPowerScan) {
   wiphy_features_.supports_low_power_oneshot_scan = true;
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   SingleScanSettings settings;
   settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_POWER;
   bool success = false;
@@ -192,7 +252,8 @@ TEST_F(ScannerTest, TestSingleScanForHighAccuracyScan) {
   wiphy_features_.supports_high_accuracy_oneshot_scan = true;
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   SingleScanSettings settings;
   settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY;
   bool success = false;
@@ -206,7 +267,8 @@ TEST_F(ScannerTest, TestSingleScanForLowSpanScanWithNoWiphySupport) {
       WillOnce(Return(true));
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   SingleScanSettings settings;
   settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
   bool success = false;
@@ -220,7 +282,8 @@ TEST_F(ScannerTest, TestSingleScanForLowPowerScanWithNoWiphySupport) {
       WillOnce(Return(true));
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   SingleScanSettings settings;
   settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_POWER;
   bool success = false;
@@ -234,7 +297,8 @@ TEST_F(ScannerTest, TestSingleScanForHighAccuracyScanWithNoWiphySupport) {
       WillOnce(Return(true));
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   SingleScanSettings settings;
   settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_HIGH_ACCURACY;
   bool success = false;
@@ -246,7 +310,8 @@ TEST_F(ScannerTest, TestSingleScanFailure) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_CALL(
       scan_utils_,
       Scan(_, _, _, _, _, _)).
@@ -263,7 +328,8 @@ TEST_F(ScannerTest, TestProcessAbortsOnScanReturningNoDeviceError) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   ON_CALL(
       scan_utils_,
       Scan(_, _, _, _, _, _)).
@@ -276,12 +342,525 @@ TEST_F(ScannerTest, TestProcessAbortsOnScanReturningNoDeviceError) {
                "Driver is in a bad state*");
 }
 
+TEST_F(ScannerTest, TestScanRequestsAreQueuedWhileScanning) {
+  ScanCapabilities scan_capabilities(
+      4 /* max_num_scan_ssids */,
+      0 /* max_num_sched_scan_ssids */,
+      0 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  EXPECT_TRUE(scanner_impl_->subscribeScanEvents(scan_event).isOk());
+
+  {
+    InSequence s;
+    EXPECT_CALL(scan_utils_, Scan(
+        _, _, _,
+        vector<vector<uint8_t>>{{}, kFakeSsid1},
+        vector<uint32_t>{kFakeFrequency1}, _)).
+        WillOnce(Return(true));
+    // Both queued requests are merged into one.
+    EXPECT_CALL(scan_utils_, Scan(
+        _, _, _,
+        vector<vector<uint8_t>>{{}, kFakeSsid2, kFakeSsid1},
+        vector<uint32_t>{kFakeFrequency1, kFakeFrequency2}, _)).
+        WillOnce(Return(true));
+  }
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(CreateSingleScanSettings(
+      IWifiScannerImpl::SCAN_TYPE_LOW_POWER, kFakeFrequency1, kFakeSsid1),
+      &success).isOk());
+  EXPECT_TRUE(success);
+  success = false;
+  EXPECT_TRUE(scanner_impl_->scan(CreateSingleScanSettings(
+      IWifiScannerImpl::SCAN_TYPE_LOW_SPAN, kFakeFrequency2, kFakeSsid2),
+      &success).isOk());
+  EXPECT_TRUE(success);
+  success = false;
+  EXPECT_TRUE(scanner_impl_->scan(CreateSingleScanSettings(
+      IWifiScannerImpl::SCAN_TYPE_LOW_POWER, kFakeFrequency1, kFakeSsid1),
+      &success).isOk());
+  EXPECT_TRUE(success);
+
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies;
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(1);
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+  testing::Mock::VerifyAndClearExpectations(scan_event.get());
+
+  // Every request merged into the second scan is notified.
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(2);
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+}
+
+TEST_F(ScannerTest, TestQueuedScanRequestsAreAbortedWithOngoingScan) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  EXPECT_TRUE(scanner_impl_->subscribeScanEvents(scan_event).isOk());
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _)).WillOnce(Return(true));
+  bool success = false;
+  SingleScanSettings scan_settings = CreateSingleScanSettings(
+      IWifiScannerImpl::SCAN_TYPE_LOW_SPAN, kFakeFrequency1, kFakeSsid1);
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+
+  EXPECT_CALL(scan_utils_, AbortScan(_)).WillOnce(Return(true));
+  EXPECT_CALL(*scan_event, OnScanFailed()).Times(2);
+  EXPECT_TRUE(scanner_impl_->abortScan().isOk());
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies;
+  scan_results_handler(kFakeInterfaceIndex, true, ssids, frequencies);
+}
+
+TEST_F(ScannerTest, TestHiddenNetworksAreScannedInRounds) {
+  ScanCapabilities scan_capabilities(
+      2 /* max_num_scan_ssids */,
+      0 /* max_num_sched_scan_ssids */,
+      0 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  EXPECT_TRUE(scanner_impl_->subscribeScanEvents(scan_event).isOk());
+
+  SingleScanSettings scan_settings = CreateSingleScanSettings(
+      IWifiScannerImpl::SCAN_TYPE_LOW_SPAN, kFakeFrequency1, kFakeSsid1);
+  for (const auto& ssid : {kFakeSsid2, kFakeSsid3}) {
+    HiddenNetwork network;
+    network.ssid_ = ssid;
+    scan_settings.hidden_networks_.push_back(network);
+  }
+  {
+    InSequence s;
+    EXPECT_CALL(scan_utils_, Scan(
+        _, _, _, vector<vector<uint8_t>>{{}, kFakeSsid1}, _, _)).
+        WillOnce(Return(true));
+    // Later rounds only probe the remaining hidden networks.
+    EXPECT_CALL(scan_utils_, Scan(
+        _, _, _, vector<vector<uint8_t>>{kFakeSsid2, kFakeSsid3},
+        vector<uint32_t>{kFakeFrequency1}, _)).
+        WillOnce(Return(true));
+  }
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies;
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(0);
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+  testing::Mock::VerifyAndClearExpectations(scan_event.get());
+
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(1);
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+  EXPECT_EQ(3u, scanner_impl_->GetHiddenSsidScheduler().
+      GetLastProbedTimes().size());
+}
+
+TEST_F(ScannerTest, TestPnoScanRotatesHiddenNetworks) {
+  ScanCapabilities scan_capabilities(
+      0 /* max_num_scan_ssids */,
+      2 /* max_num_sched_scan_ssids */,
+      3 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
+      .WillRepeatedly(Return(false));
+  ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities,
+                           wiphy_features_, &client_interface_impl_,
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
+  PnoSettings pno_settings;
+  for (const auto& ssid : {kFakeSsid1, kFakeSsid2, kFakeSsid3}) {
+    PnoNetwork network;
+    network.is_hidden_ = true;
+    network.ssid_ = ssid;
+    pno_settings.pno_networks_.push_back(network);
+  }
+  const vector<vector<uint8_t>> kMatchSsids =
+      {kFakeSsid1, kFakeSsid2, kFakeSsid3};
+  {
+    InSequence s;
+    for (const auto& ssid : {kFakeSsid1, kFakeSsid2, kFakeSsid3}) {
+      EXPECT_CALL(scan_utils_, StartScheduledScan(
+          _, _, _, _, _, vector<vector<uint8_t>>{{}, ssid},
+          HasMatchSsids(kMatchSsids), _, _)).
+          WillOnce(Return(true));
+    }
+  }
+  bool success = false;
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(scanner_impl.startPnoScan(pno_settings, &success).isOk());
+    EXPECT_TRUE(success);
+  }
+}
+
+TEST_F(ScannerTest, TestPnoScanRanksAndRotatesMatchSets) {
+  ScanCapabilities scan_capabilities(
+      0 /* max_num_scan_ssids */,
+      0 /* max_num_sched_scan_ssids */,
+      2 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
+      .WillRepeatedly(Return(false));
+  ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities,
+                           wiphy_features_, &client_interface_impl_,
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
+
+  // The device is connected to |kFakeSsid3|.
+  NativeScanResult scan_result = CreateScanResult(kFakeBssid1, kFakeTsf);
+  scan_result.ssid = kFakeSsid3;
+  scan_result.frequency = kFakeFrequency1;
+  scan_result.associated = true;
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(vector<NativeScanResult>{scan_result}),
+                      Return(true)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scanner_impl.getScanResults(&scan_results).isOk());
+
+  PnoSettings pno_settings;
+  for (const auto& ssid : {kFakeSsid1, kFakeSsid2, kFakeSsid3}) {
+    PnoNetwork network;
+    network.is_hidden_ = false;
+    network.ssid_ = ssid;
+    pno_settings.pno_networks_.push_back(network);
+  }
+  {
+    InSequence s;
+    for (const auto& ssid : {kFakeSsid1, kFakeSsid2}) {
+      const vector<vector<uint8_t>> match_ssids = {kFakeSsid3, ssid};
+      EXPECT_CALL(scan_utils_, StartScheduledScan(
+          _, _, _, _, _, _, HasMatchSsids(match_ssids), _, _)).
+          WillOnce(Return(true));
+    }
+  }
+  bool success = false;
+  for (int i = 0; i < 2; i++) {
+    EXPECT_TRUE(scanner_impl.startPnoScan(pno_settings, &success).isOk());
+    EXPECT_TRUE(success);
+  }
+}
+
+TEST_F(ScannerTest, TestPnoScanUsesRssiThresholdOfNetworkBand) {
+  constexpr int32_t kMin2gRssi = -80;
+  constexpr int32_t kMin5gRssi = -70;
+  constexpr int32_t kRelativeRssi = 5;
+  wiphy_features_.supports_relative_rssi_sched_scan = true;
+  ScanCapabilities scan_capabilities(
+      0 /* max_num_scan_ssids */,
+      0 /* max_num_sched_scan_ssids */,
+      3 /* max_match_sets */,
+      0 /* max_num_scan_plans */,
+      0 /* max_scan_plan_interval */,
+      0 /* max_scan_plan_iterations */);
+  EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
+      .WillRepeatedly(Return(false));
+  ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities,
+                           wiphy_features_, &client_interface_impl_,
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
+
+  // |kFakeSsid1| was seen on 2.4GHz and |kFakeSsid2| on 5GHz.
+  NativeScanResult scan_result1 = CreateScanResult(kFakeBssid1, kFakeTsf);
+  scan_result1.ssid = kFakeSsid1;
+  scan_result1.frequency = kFakeFrequency1;
+  NativeScanResult scan_result2 = CreateScanResult(kFakeBssid2, kFakeTsf);
+  scan_result2.ssid = kFakeSsid2;
+  scan_result2.frequency = kFakeFrequency2;
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(vector<NativeScanResult>{
+                          scan_result1, scan_result2}),
+                      Return(true)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scanner_impl.getScanResults(&scan_results).isOk());
+
+  PnoSettings pno_settings;
+  pno_settings.min_2g_rssi_ = kMin2gRssi;
+  pno_settings.min_5g_rssi_ = kMin5gRssi;
+  pno_settings.relative_rssi_set_ = true;
+  pno_settings.relative_rssi_ = kRelativeRssi;
+  for (const auto& ssid : {kFakeSsid1, kFakeSsid2, kFakeSsid3}) {
+    PnoNetwork network;
+    network.is_hidden_ = false;
+    network.ssid_ = ssid;
+    pno_settings.pno_networks_.push_back(network);
+  }
+  ON_CALL(client_interface_impl_, IsAssociated()).WillByDefault(Return(true));
+  SchedScanRssiSetting rssi_setting;
+  vector<SchedScanMatchSet> match_sets;
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
+      .WillOnce(DoAll(SaveArg<2>(&rssi_setting), SaveArg<6>(&match_sets),
+                      Return(true)));
+  bool success = false;
+  EXPECT_TRUE(scanner_impl.startPnoScan(pno_settings, &success).isOk());
+  EXPECT_TRUE(success);
+
+  ASSERT_EQ(3u, match_sets.size());
+  EXPECT_EQ(kMin2gRssi, match_sets[0].rssi_threshold);
+  EXPECT_EQ(kMin5gRssi, match_sets[1].rssi_threshold);
+  // A network which was never seen is matched against the lower threshold.
+  EXPECT_EQ(kMin2gRssi, match_sets[2].rssi_threshold);
+  EXPECT_TRUE(rssi_setting.relative_rssi_set);
+  EXPECT_EQ(kRelativeRssi, rssi_setting.relative_rssi);
+}
+
+TEST_F(ScannerTest, TestPartialScanUsesChannelHistory) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  PartialScanSettings partial_scan_settings;
+  partial_scan_settings.ssids_ = {kFakeSsid1};
+  partial_scan_settings.full_scan_interval_ = 3;
+  EXPECT_TRUE(
+      scanner_impl_->setPartialScanSettings(partial_scan_settings).isOk());
+
+  NativeScanResult scan_result = CreateScanResult(kFakeBssid1, kFakeTsf);
+  scan_result.ssid = kFakeSsid1;
+  scan_result.frequency = kFakeFrequency2;
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(vector<NativeScanResult>{scan_result}),
+                      Return(true)));
+  vector<NativeScanResult> scan_results;
+  EXPECT_TRUE(scanner_impl_->getScanResults(&scan_results).isOk());
+
+  {
+    InSequence s;
+    EXPECT_CALL(scan_utils_, Scan(
+        _, _, _, _, vector<uint32_t>{kFakeFrequency2}, _)).
+        Times(2).WillRepeatedly(Return(true));
+    // Every third scan covers all channels.
+    EXPECT_CALL(scan_utils_, Scan(_, _, _, _, vector<uint32_t>{}, _)).
+        WillOnce(Return(true));
+  }
+  SingleScanSettings scan_settings;
+  scan_settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies;
+  for (int i = 0; i < 3; i++) {
+    bool success = false;
+    EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+    EXPECT_TRUE(success);
+    scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+  }
+}
+
+TEST_F(ScannerTest, TestRecentlyScannedChannelsAreSkipped) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  EXPECT_TRUE(scanner_impl_->subscribeScanEvents(scan_event).isOk());
+
+  // A scan of all channels, which turn out to be |kFakeFrequency1| and
+  // |kFakeFrequency2|.
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, vector<uint32_t>{}, _)).
+      WillOnce(Return(true));
+  SingleScanSettings scan_settings;
+  scan_settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
+  scan_settings.max_channel_age_ms_ = 60 * 1000;
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies = {kFakeFrequency1, kFakeFrequency2};
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+
+  // Only the channel which was not scanned is scanned.
+  const uint32_t kFakeFrequency3 = 5200;
+  EXPECT_CALL(scan_utils_, Scan(
+      _, _, _, _, vector<uint32_t>{kFakeFrequency3}, _)).
+      WillOnce(Return(true));
+  SingleScanSettings partial_scan_settings = scan_settings;
+  for (uint32_t frequency : {kFakeFrequency1, kFakeFrequency3}) {
+    ChannelSettings channel;
+    channel.frequency_ = frequency;
+    partial_scan_settings.channel_settings_.push_back(channel);
+  }
+  EXPECT_TRUE(scanner_impl_->scan(partial_scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  testing::Mock::VerifyAndClearExpectations(&scan_utils_);
+
+  frequencies = {kFakeFrequency3};
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+  testing::Mock::VerifyAndClearExpectations(scan_event.get());
+
+  // Every channel was scanned recently, so no scan is needed. The outcome
+  // is still reported after scan() returns.
+  std::function<void()> notify_task;
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _)).Times(0);
+  EXPECT_CALL(event_loop_, PostTask(_)).WillOnce(SaveArg<0>(&notify_task));
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(0);
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  testing::Mock::VerifyAndClearExpectations(scan_event.get());
+
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(1);
+  ASSERT_TRUE(notify_task);
+  notify_task();
+  testing::Mock::VerifyAndClearExpectations(&scan_utils_);
+
+  // Hidden networks are only found by probing them, so their channels are
+  // scanned regardless.
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, vector<uint32_t>{}, _)).
+      WillOnce(Return(true));
+  SingleScanSettings hidden_scan_settings = scan_settings;
+  HiddenNetwork network;
+  network.ssid_ = kFakeSsid1;
+  hidden_scan_settings.hidden_networks_.push_back(network);
+  EXPECT_TRUE(scanner_impl_->scan(hidden_scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+}
+
+TEST_F(ScannerTest, TestSkippedScanIsNotReportedAfterScannerIsDestroyed) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  EXPECT_TRUE(scanner_impl_->subscribeScanEvents(scan_event).isOk());
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _)).WillOnce(Return(true));
+  SingleScanSettings scan_settings;
+  scan_settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
+  scan_settings.max_channel_age_ms_ = 60 * 1000;
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies = {kFakeFrequency1};
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+
+  std::function<void()> notify_task;
+  EXPECT_CALL(event_loop_, PostTask(_)).WillOnce(SaveArg<0>(&notify_task));
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(0);
+  scanner_impl_.reset();
+  ASSERT_TRUE(notify_task);
+  notify_task();
+}
+
+TEST_F(ScannerTest, TestSkippedScanIsNotReportedAfterScannerIsInvalidated) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  sp<NiceMock<MockScanEvent>> scan_event(new NiceMock<MockScanEvent>());
+  EXPECT_TRUE(scanner_impl_->subscribeScanEvents(scan_event).isOk());
+
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _)).WillOnce(Return(true));
+  SingleScanSettings scan_settings;
+  scan_settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_SPAN;
+  scan_settings.max_channel_age_ms_ = 60 * 1000;
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies = {kFakeFrequency1};
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+
+  std::function<void()> notify_task;
+  EXPECT_CALL(event_loop_, PostTask(_)).WillOnce(SaveArg<0>(&notify_task));
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+
+  EXPECT_CALL(*scan_event, OnScanResultReady()).Times(0);
+  scanner_impl_->Invalidate();
+  ASSERT_TRUE(notify_task);
+  notify_task();
+}
+
+TEST_F(ScannerTest, TestScanLatenciesAreRecorded) {
+  OnScanResultsReadyHandler scan_results_handler;
+  EXPECT_CALL(scan_utils_, SubscribeScanResultNotification(_, _)).
+      WillOnce(SaveArg<1>(&scan_results_handler));
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _)).WillOnce(Return(true));
+  SingleScanSettings scan_settings;
+  scan_settings.scan_type_ = IWifiScannerImpl::SCAN_TYPE_LOW_POWER;
+  bool success = false;
+  EXPECT_TRUE(scanner_impl_->scan(scan_settings, &success).isOk());
+  EXPECT_TRUE(success);
+  vector<vector<uint8_t>> ssids;
+  vector<uint32_t> frequencies;
+  scan_results_handler(kFakeInterfaceIndex, false, ssids, frequencies);
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _)).
+      WillRepeatedly(Return(true));
+  vector<NativeScanResult> scan_results;
+  for (int i = 0; i < 2; i++) {
+    EXPECT_TRUE(scanner_impl_->getScanResults(&scan_results).isOk());
+  }
+
+  const ScanLatencyStats& stats = scanner_impl_->GetScanLatencyStats();
+  for (auto phase : {ScanLatencyStats::kPhaseTrigger,
+                     ScanLatencyStats::kPhaseScan,
+                     ScanLatencyStats::kPhaseResultsPending}) {
+    const LatencyHistogram* histogram =
+        stats.GetHistogram(IWifiScannerImpl::SCAN_TYPE_LOW_POWER, phase);
+    ASSERT_NE(nullptr, histogram);
+    // Only the first read after the scan counts.
+    EXPECT_EQ(1u, histogram->GetCount());
+  }
+}
+
 TEST_F(ScannerTest, TestAbortScan) {
   bool single_scan_success = false;
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_CALL(scan_utils_, Scan(_, _, _, _, _, _))
       .WillOnce(Return(true));
   EXPECT_TRUE(
@@ -296,7 +875,8 @@ TEST_F(ScannerTest, TestAbortScanNotIssuedIfNoOngoingScan) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_CALL(scan_utils_, AbortScan(_)).Times(0);
   EXPECT_TRUE(scanner_impl_->abortScan().isOk());
 }
@@ -306,11 +886,142 @@ TEST_F(ScannerTest, TestGetScanResults) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   EXPECT_CALL(scan_utils_, GetScanResult(_, _)).WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl_->getScanResults(&scan_results).isOk());
 }
 
+TEST_F(ScannerTest, TestGetFilteredScanResults) {
+  vector<NativeScanResult> scan_results;
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  ScanResultFilter filter;
+  filter.band_mask_ = IWifiScannerImpl::BAND_5_GHZ;
+  EXPECT_CALL(scan_utils_,
+              GetFilteredScanResult(kFakeInterfaceIndex, filter, _))
+      .WillOnce(Return(true));
+  EXPECT_TRUE(scanner_impl_->getFilteredScanResults(
+      filter, &scan_results).isOk());
+}
+
+TEST_F(ScannerTest, TestGetScanResultsBuffer) {
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  vector<NativeScanResult> scan_results = {
+      CreateScanResult(kFakeBssid1, kFakeTsf),
+      CreateScanResult(kFakeBssid2, kFakeTsf)};
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(scan_results), Return(true)));
+
+  NativeScanResultBuffer buffer;
+  EXPECT_TRUE(scanner_impl_->getScanResultsBuffer(&buffer).isOk());
+  EXPECT_EQ(2u, buffer.offsets.size());
+  vector<NativeScanResult> shared_scan_results;
+  EXPECT_TRUE(buffer.Read(&shared_scan_results));
+  ASSERT_EQ(2u, shared_scan_results.size());
+  EXPECT_EQ(scan_results[1].bssid, shared_scan_results[1].bssid);
+}
+
+TEST_F(ScannerTest, TestGetScanResultsBufferReportsWriteFailure) {
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  vector<NativeScanResult> scan_results = {
+      CreateScanResult(kFakeBssid1, kFakeTsf)};
+  // A BSSID of the wrong length can't be stored in the flat layout.
+  scan_results[0].bssid.push_back(0);
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillOnce(DoAll(SetArgPointee<1>(scan_results), Return(true)));
+
+  NativeScanResultBuffer buffer;
+  Status status = scanner_impl_->getScanResultsBuffer(&buffer);
+  EXPECT_FALSE(status.isOk());
+  EXPECT_EQ(IWifiScannerImpl::ERROR_SCAN_RESULTS_BUFFER_UNAVAILABLE,
+            status.serviceSpecificErrorCode());
+}
+
+TEST_F(ScannerTest, TestGetScanResultsDelta) {
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  vector<NativeScanResult> scan_results = {
+      CreateScanResult(kFakeBssid1, kFakeTsf),
+      CreateScanResult(kFakeBssid2, kFakeTsf)};
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(scan_results), Return(true)));
+
+  // The first request gets all the scan results.
+  NativeScanResultDelta full_delta;
+  EXPECT_TRUE(scanner_impl_->getScanResultsDelta(0, &full_delta).isOk());
+  EXPECT_TRUE(full_delta.is_full_update);
+  EXPECT_EQ(2u, full_delta.changed_scan_results.size());
+  EXPECT_TRUE(full_delta.expired_bssids.empty());
+
+  // Nothing changed since then.
+  NativeScanResultDelta empty_delta;
+  EXPECT_TRUE(scanner_impl_->getScanResultsDelta(
+      full_delta.cursor, &empty_delta).isOk());
+  EXPECT_FALSE(empty_delta.is_full_update);
+  EXPECT_EQ(full_delta.cursor, empty_delta.cursor);
+  EXPECT_TRUE(empty_delta.changed_scan_results.empty());
+  EXPECT_TRUE(empty_delta.expired_bssids.empty());
+
+  // One scan result is updated and the other one expires.
+  vector<NativeScanResult> updated_scan_results = {
+      CreateScanResult(kFakeBssid1, kFakeTsf + 1)};
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<1>(updated_scan_results), Return(true)));
+  NativeScanResultDelta delta;
+  EXPECT_TRUE(scanner_impl_->getScanResultsDelta(
+      full_delta.cursor, &delta).isOk());
+  EXPECT_FALSE(delta.is_full_update);
+  EXPECT_GT(delta.cursor, full_delta.cursor);
+  ASSERT_EQ(1u, delta.changed_scan_results.size());
+  EXPECT_EQ(kFakeTsf + 1, delta.changed_scan_results[0].tsf);
+  ASSERT_EQ(1u, delta.expired_bssids.size());
+  EXPECT_EQ(vector<uint8_t>(kFakeBssid2, kFakeBssid2 + sizeof(kFakeBssid2)),
+            delta.expired_bssids[0]);
+}
+
+TEST_F(ScannerTest, TestGetScanResultsDeltaWithUnknownCursor) {
+  scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
+                                      scan_capabilities_, wiphy_features_,
+                                      &client_interface_impl_,
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  vector<NativeScanResult> scan_results = {
+      CreateScanResult(kFakeBssid1, kFakeTsf)};
+  EXPECT_CALL(scan_utils_, GetScanResult(kFakeInterfaceIndex, _))
+      .WillRepeatedly(DoAll(SetArgPointee<1>(scan_results), Return(true)));
+
+  NativeScanResultDelta delta;
+  EXPECT_TRUE(scanner_impl_->getScanResultsDelta(0, &delta).isOk());
+  // A cursor from the future, e.g. from before a reboot, can't be trusted.
+  NativeScanResultDelta future_delta;
+  EXPECT_TRUE(scanner_impl_->getScanResultsDelta(
+      delta.cursor + 1, &future_delta).isOk());
+  EXPECT_TRUE(future_delta.is_full_update);
+  EXPECT_EQ(delta.cursor, future_delta.cursor);
+  EXPECT_EQ(1u, future_delta.changed_scan_results.size());
+  // Neither can a cursor older than this scanner.
+  NativeScanResultDelta stale_delta;
+  EXPECT_TRUE(scanner_impl_->getScanResultsDelta(1, &stale_delta).isOk());
+  EXPECT_TRUE(stale_delta.is_full_update);
+  EXPECT_EQ(1u, stale_delta.changed_scan_results.size());
+}
+
 TEST_F(ScannerTest, TestStartPnoScanViaNetlink) {
   bool success = false;
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
@@ -318,10 +1029,11 @@ TEST_F(ScannerTest, TestStartPnoScanViaNetlink) {
       .WillRepeatedly(Return(false));
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   EXPECT_CALL(
       scan_utils_,
-      StartScheduledScan(_, _, _, _, _, false, _, _, _, _)).
+      StartScheduledScan(_, _, _, _, false, _, _, _, _)).
           WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl.startPnoScan(PnoSettings(), &success).isOk());
   EXPECT_TRUE(success);
@@ -335,10 +1047,11 @@ TEST_F(ScannerTest, TestStartPnoScanViaNetlinkWithLowPowerScanWiphySupport) {
   wiphy_features_.supports_low_power_oneshot_scan = true;
   ScannerImpl scanner_impl(kFakeInterfaceIndex, scan_capabilities_,
                            wiphy_features_, &client_interface_impl_,
-                           &scan_utils_, offload_service_utils_);
+                           &scan_utils_, offload_service_utils_,
+                           &event_loop_);
   EXPECT_CALL(
       scan_utils_,
-      StartScheduledScan(_, _, _, _, _, true, _, _, _, _)).
+      StartScheduledScan(_, _, _, _, true, _, _, _, _)).
           WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl.startPnoScan(PnoSettings(), &success).isOk());
   EXPECT_TRUE(success);
@@ -352,7 +1065,8 @@ TEST_F(ScannerTest, TestStopPnoScanViaNetlink) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   // StopScheduledScan() will be called no matter if there is an ongoing
   // scheduled scan or not. This is for making the system more robust.
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
@@ -365,7 +1079,7 @@ TEST_F(ScannerTest, TestStartScanOverOffload) {
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_))
@@ -374,7 +1088,8 @@ TEST_F(ScannerTest, TestStartScanOverOffload) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   scanner_impl_->startPnoScan(PnoSettings(), &success);
   EXPECT_TRUE(success);
   scanner_impl_->stopPnoScan(&success);
@@ -388,11 +1103,12 @@ TEST_F(ScannerTest, TestStartScanOverNetlinkFallback) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .WillOnce(Return(false));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_)).Times(0);
-  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _, _))
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
       .WillOnce(Return(true));
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl_->startPnoScan(PnoSettings(), &success).isOk());
@@ -406,7 +1122,7 @@ TEST_F(ScannerTest, TestAsyncErrorOverOffload) {
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_))
@@ -415,8 +1131,9 @@ TEST_F(ScannerTest, TestAsyncErrorOverOffload) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _, _))
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
       .WillOnce(Return(true));
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
   scanner_impl_->startPnoScan(PnoSettings(), &success);
@@ -432,7 +1149,7 @@ TEST_F(ScannerTest, TestGetScanResultsFromOffload) {
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, getScanResults(_))
@@ -445,7 +1162,8 @@ TEST_F(ScannerTest, TestGetScanResultsFromOffload) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
   scanner_impl_->startPnoScan(PnoSettings(), &success);
   EXPECT_TRUE(success);
   scanner_impl_->OnOffloadScanResult();
@@ -461,7 +1179,7 @@ TEST_F(ScannerTest, TestGetScanResultsWhenOffloadFails) {
   EXPECT_CALL(*offload_service_utils_, IsOffloadScanSupported())
       .Times(1)
       .WillRepeatedly(Return(true));
-  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _))
+  EXPECT_CALL(*offload_scan_manager_, startScan(_, _, _, _, _, _, _, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_CALL(*offload_scan_manager_, stopScan(_))
@@ -475,8 +1193,9 @@ TEST_F(ScannerTest, TestGetScanResultsWhenOffloadFails) {
   scanner_impl_.reset(new ScannerImpl(kFakeInterfaceIndex,
                                       scan_capabilities_, wiphy_features_,
                                       &client_interface_impl_,
-                                      &scan_utils_, offload_service_utils_));
-  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _, _))
+                                      &scan_utils_, offload_service_utils_,
+                                      &event_loop_));
+  EXPECT_CALL(scan_utils_, StartScheduledScan(_, _, _, _, _, _, _, _, _))
       .WillOnce(Return(true));
   EXPECT_CALL(scan_utils_, StopScheduledScan(_)).WillOnce(Return(true));
   EXPECT_TRUE(scanner_impl_->startPnoScan(PnoSettings(), &success).isOk());
@@ -503,7 +1222,8 @@ TEST_F(ScannerTest, TestGenerateScanPlansIfDeviceSupports) {
       kFakeInterfaceIndex,
       scan_capabilities_scan_plan_supported, wiphy_features_,
       &client_interface_impl_,
-      &scan_utils_, offload_service_utils_);
+      &scan_utils_, offload_service_utils_,
+      &event_loop_);
 
   PnoSettings pno_settings;
   pno_settings.interval_ms_ = kFakeScanIntervalMs;
@@ -511,10 +1231,10 @@ TEST_F(ScannerTest, TestGenerateScanPlansIfDeviceSupports) {
   SchedScanIntervalSetting interval_setting;
   EXPECT_CALL(
       scan_utils_,
-      StartScheduledScan(_, _, _, _, _, _, _, _, _, _)).
+      StartScheduledScan(_, _, _, _, _, _, _, _, _)).
               WillOnce(Invoke(bind(
                   CaptureSchedScanIntervalSetting,
-                  _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, &interval_setting)));
+                  _1, _2, _3, _4, _5, _6, _7, _8, _9, &interval_setting)));
 
   bool success_ignored = 0;
   EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success_ignored).isOk());
@@ -537,17 +1257,18 @@ TEST_F(ScannerTest, TestGenerateSingleIntervalIfDeviceDoesNotSupportScanPlan) {
       kFakeInterfaceIndex,
       scan_capabilities_no_scan_plan_support, wiphy_features_,
       &client_interface_impl_,
-      &scan_utils_, offload_service_utils_);
+      &scan_utils_, offload_service_utils_,
+      &event_loop_);
   PnoSettings pno_settings;
   pno_settings.interval_ms_ = kFakeScanIntervalMs;
 
   SchedScanIntervalSetting interval_setting;
   EXPECT_CALL(
       scan_utils_,
-      StartScheduledScan(_, _, _, _, _, _, _, _, _, _)).
+      StartScheduledScan(_, _, _, _, _, _, _, _, _)).
               WillOnce(Invoke(bind(
                   CaptureSchedScanIntervalSetting,
-                  _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, &interval_setting)));
+                  _1, _2, _3, _4, _5, _6, _7, _8, _9, &interval_setting)));
 
   bool success_ignored = 0;
   EXPECT_TRUE(scanner.startPnoScan(pno_settings, &success_ignored).isOk());
@@ -23,6 +23,7 @@
 #include <wifi_system_test/mock_supplicant_manager.h>
 
 #include "android/net/wifi/IApInterface.h"
+#include "wificond/tests/mock_event_loop.h"
 #include "wificond/tests/mock_netlink_manager.h"
 #include "wificond/tests/mock_netlink_utils.h"
 #include "wificond/tests/mock_scan_utils.h"
@@ -38,11 +39,14 @@ using android::wifi_system::MockSupplicantManager;
 using android::wifi_system::SupplicantManager;
 using std::unique_ptr;
 using std::vector;
+using testing::DoAll;
 using testing::Eq;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::SaveArg;
 using testing::Sequence;
+using testing::SetArgPointee;
 using testing::StrEq;
 using testing::_;
 
@@ -103,6 +107,7 @@ class ServerTest : public ::testing::Test {
       new NiceMock<MockNetlinkUtils>(netlink_manager_.get())};
   unique_ptr<NiceMock<MockScanUtils>> scan_utils_{
       new NiceMock<MockScanUtils>(netlink_manager_.get())};
+  NiceMock<MockEventLoop> event_loop_;
   const vector<InterfaceInfo> mock_interfaces = {
       // Client interface
       InterfaceInfo(
@@ -131,7 +136,8 @@ class ServerTest : public ::testing::Test {
                  unique_ptr<SupplicantManager>(supplicant_manager_),
                  unique_ptr<HostapdManager>(hostapd_manager_),
                  netlink_utils_.get(),
-                 scan_utils_.get()};
+                 scan_utils_.get(),
+                 &event_loop_};
 };  // class ServerTest
 
 }  // namespace
@@ -209,6 +215,60 @@ TEST_F(ServerTest, CanTeardownClientInterface) {
   EXPECT_TRUE(success);
 }
 
+TEST_F(ServerTest, CanAnswerChannelQueriesFromWiphyInfoCache) {
+  vector<uint32_t> band_2g = {2412, 2437};
+  vector<uint32_t> band_5g = {5180};
+  vector<uint32_t> band_dfs = {5260, 5280};
+  BandInfo band_info(band_2g, band_5g, band_dfs);
+  OnRegDomainChangedHandler reg_domain_changed_handler;
+  EXPECT_CALL(*netlink_utils_, SubscribeRegDomainChange(_, _))
+      .WillOnce(SaveArg<1>(&reg_domain_changed_handler));
+  // The wiphy is dumped when the client interface is created, and again
+  // after the regulatory domain changes.
+  EXPECT_CALL(*netlink_utils_, GetWiphyInfo(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(DoAll(SetArgPointee<1>(band_info), Return(true)));
+  sp<IClientInterface> client_if;
+  EXPECT_TRUE(server_.createClientInterface(
+      kFakeInterfaceName, &client_if).isOk());
+
+  unique_ptr<vector<int32_t>> frequencies;
+  for (int i = 0; i < 2; i++) {
+    EXPECT_TRUE(server_.getAvailable2gChannels(&frequencies).isOk());
+    ASSERT_NE(nullptr, frequencies);
+    EXPECT_EQ(vector<int32_t>({2412, 2437}), *frequencies);
+    EXPECT_TRUE(server_.getAvailable5gNonDFSChannels(&frequencies).isOk());
+    ASSERT_NE(nullptr, frequencies);
+    EXPECT_EQ(vector<int32_t>({5180}), *frequencies);
+    EXPECT_TRUE(server_.getAvailableDFSChannels(&frequencies).isOk());
+    ASSERT_NE(nullptr, frequencies);
+    EXPECT_EQ(vector<int32_t>({5260, 5280}), *frequencies);
+  }
+
+  std::string country_code = "US";
+  reg_domain_changed_handler(country_code);
+  EXPECT_TRUE(server_.getAvailable2gChannels(&frequencies).isOk());
+  ASSERT_NE(nullptr, frequencies);
+}
+
+TEST_F(ServerTest, DoesNotCacheWiphyInfoWithoutInterface) {
+  // Nothing is subscribed to regulatory domain changes yet.
+  EXPECT_CALL(*netlink_utils_, GetWiphyInfo(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+  unique_ptr<vector<int32_t>> frequencies;
+  EXPECT_TRUE(server_.getAvailable2gChannels(&frequencies).isOk());
+  EXPECT_TRUE(server_.getAvailable2gChannels(&frequencies).isOk());
+}
+
+TEST_F(ServerTest, ReportsNoChannelsWithoutWiphyInfo) {
+  EXPECT_CALL(*netlink_utils_, GetWiphyInfo(_, _, _, _))
+      .WillRepeatedly(Return(false));
+  unique_ptr<vector<int32_t>> frequencies(new vector<int32_t>());
+  EXPECT_TRUE(server_.getAvailable2gChannels(&frequencies).isOk());
+  EXPECT_EQ(nullptr, frequencies);
+}
+
 TEST_F(ServerTest, ShouldReportEnableFailure) {
   EXPECT_CALL(*supplicant_manager_, StartSupplicant())
       .WillOnce(Return(false));
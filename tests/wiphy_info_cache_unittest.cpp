@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "wificond/tests/mock_netlink_manager.h"
+#include "wificond/tests/mock_netlink_utils.h"
+#include "wificond/wiphy_info_cache.h"
+
+using std::vector;
+using testing::DoAll;
+using testing::NiceMock;
+using testing::Return;
+using testing::SetArgPointee;
+using testing::_;
+
+namespace android {
+namespace wificond {
+
+namespace {
+
+constexpr uint32_t kFakeWiphyIndex = 3;
+constexpr uint32_t kFakeOtherWiphyIndex = 4;
+
+}  // namespace
+
+class WiphyInfoCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    vector<uint32_t> band_2g = {2412, 2437, 2462};
+    vector<uint32_t> band_5g = {5180, 5200};
+    vector<uint32_t> band_dfs = {5260};
+    band_info_ = BandInfo(band_2g, band_5g, band_dfs);
+    scan_capabilities_.max_match_sets = 16;
+    wiphy_features_.supports_random_mac_sched_scan = true;
+    wiphy_info_cache_.SetEnabled(true);
+  }
+
+  void ExpectWiphyDumps(int times) {
+    EXPECT_CALL(netlink_utils_, GetWiphyInfo(_, _, _, _))
+        .Times(times)
+        .WillRepeatedly(DoAll(SetArgPointee<1>(band_info_),
+                              SetArgPointee<2>(scan_capabilities_),
+                              SetArgPointee<3>(wiphy_features_),
+                              Return(true)));
+  }
+
+  NiceMock<MockNetlinkManager> netlink_manager_;
+  NiceMock<MockNetlinkUtils> netlink_utils_{&netlink_manager_};
+  WiphyInfoCache wiphy_info_cache_{&netlink_utils_};
+  BandInfo band_info_;
+  ScanCapabilities scan_capabilities_;
+  WiphyFeatures wiphy_features_;
+};
+
+TEST_F(WiphyInfoCacheTest, DumpsWiphyOnlyOnce) {
+  ExpectWiphyDumps(1);
+  for (int i = 0; i < 2; i++) {
+    BandInfo band_info;
+    ScanCapabilities scan_capabilities;
+    WiphyFeatures wiphy_features;
+    EXPECT_TRUE(wiphy_info_cache_.GetWiphyInfo(kFakeWiphyIndex,
+                                               &band_info,
+                                               &scan_capabilities,
+                                               &wiphy_features));
+    EXPECT_EQ(band_info_.band_2g, band_info.band_2g);
+    EXPECT_EQ(16, scan_capabilities.max_match_sets);
+    EXPECT_TRUE(wiphy_features.supports_random_mac_sched_scan);
+  }
+  const vector<int32_t>* frequencies =
+      wiphy_info_cache_.Get2gFrequencies(kFakeWiphyIndex);
+  ASSERT_NE(nullptr, frequencies);
+  EXPECT_EQ(vector<int32_t>({2412, 2437, 2462}), *frequencies);
+  frequencies = wiphy_info_cache_.Get5gNonDfsFrequencies(kFakeWiphyIndex);
+  ASSERT_NE(nullptr, frequencies);
+  EXPECT_EQ(vector<int32_t>({5180, 5200}), *frequencies);
+  frequencies = wiphy_info_cache_.GetDfsFrequencies(kFakeWiphyIndex);
+  ASSERT_NE(nullptr, frequencies);
+  EXPECT_EQ(vector<int32_t>({5260}), *frequencies);
+}
+
+TEST_F(WiphyInfoCacheTest, DumpsWiphyAgainAfterInvalidation) {
+  ExpectWiphyDumps(2);
+  EXPECT_NE(nullptr, wiphy_info_cache_.Get2gFrequencies(kFakeWiphyIndex));
+  wiphy_info_cache_.Invalidate();
+  EXPECT_NE(nullptr, wiphy_info_cache_.Get2gFrequencies(kFakeWiphyIndex));
+}
+
+TEST_F(WiphyInfoCacheTest, DumpsWiphyAgainForNewWiphyIndex) {
+  ExpectWiphyDumps(2);
+  EXPECT_NE(nullptr, wiphy_info_cache_.Get2gFrequencies(kFakeWiphyIndex));
+  EXPECT_NE(nullptr,
+            wiphy_info_cache_.Get2gFrequencies(kFakeOtherWiphyIndex));
+}
+
+TEST_F(WiphyInfoCacheTest, DumpsWiphyOnEveryQueryWhileDisabled) {
+  ExpectWiphyDumps(3);
+  EXPECT_NE(nullptr, wiphy_info_cache_.Get2gFrequencies(kFakeWiphyIndex));
+  wiphy_info_cache_.SetEnabled(false);
+  EXPECT_NE(nullptr, wiphy_info_cache_.Get2gFrequencies(kFakeWiphyIndex));
+  const vector<int32_t>* frequencies =
+      wiphy_info_cache_.GetDfsFrequencies(kFakeWiphyIndex);
+  ASSERT_NE(nullptr, frequencies);
+  EXPECT_EQ(vector<int32_t>({5260}), *frequencies);
+}
+
+TEST_F(WiphyInfoCacheTest, DoesNotCacheFailure) {
+  EXPECT_CALL(netlink_utils_, GetWiphyInfo(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Return(false));
+  EXPECT_EQ(nullptr, wiphy_info_cache_.Get2gFrequencies(kFakeWiphyIndex));
+  EXPECT_EQ(nullptr, wiphy_info_cache_.GetDfsFrequencies(kFakeWiphyIndex));
+}
+
+}  // namespace wificond
+}  // namespace android
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "wificond/time_utils.h"
+
+#include <utils/Timers.h>
+
+namespace android {
+namespace wificond {
+
+uint64_t TimeUtils::GetBoottimeMs() {
+  return static_cast<uint64_t>(
+      nanoseconds_to_milliseconds(systemTime(SYSTEM_TIME_BOOTTIME)));
+}
+
+uint64_t TimeUtils::GetBoottimeUs() {
+  return static_cast<uint64_t>(
+      nanoseconds_to_microseconds(systemTime(SYSTEM_TIME_BOOTTIME)));
+}
+
+}  // namespace wificond
+}  // namespace android
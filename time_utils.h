@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WIFICOND_TIME_UTILS_H_
+#define WIFICOND_TIME_UTILS_H_
+
+#include <stdint.h>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace wificond {
+
+// Timestamps in wificond use CLOCK_BOOTTIME, the clock the kernel uses for
+// scan results, so that they keep counting while the device suspends.
+class TimeUtils {
+ public:
+  TimeUtils() = default;
+  static uint64_t GetBoottimeMs();
+  static uint64_t GetBoottimeUs();
+
+ private:
+
+  DISALLOW_COPY_AND_ASSIGN(TimeUtils);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_TIME_UTILS_H_
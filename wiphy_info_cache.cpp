@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "wificond/wiphy_info_cache.h"
+
+#include <android-base/logging.h>
+
+using std::vector;
+
+namespace android {
+namespace wificond {
+
+WiphyInfoCache::WiphyInfoCache(NetlinkUtils* netlink_utils)
+    : netlink_utils_(netlink_utils) {
+}
+
+bool WiphyInfoCache::GetWiphyInfo(uint32_t wiphy_index,
+                                  BandInfo* out_band_info,
+                                  ScanCapabilities* out_scan_capabilities,
+                                  WiphyFeatures* out_wiphy_features) {
+  if (!Refresh(wiphy_index)) {
+    return false;
+  }
+  *out_band_info = band_info_;
+  *out_scan_capabilities = scan_capabilities_;
+  *out_wiphy_features = wiphy_features_;
+  return true;
+}
+
+const vector<int32_t>* WiphyInfoCache::Get2gFrequencies(uint32_t wiphy_index) {
+  return Refresh(wiphy_index) ? &frequencies_2g_ : nullptr;
+}
+
+const vector<int32_t>* WiphyInfoCache::Get5gNonDfsFrequencies(
+    uint32_t wiphy_index) {
+  return Refresh(wiphy_index) ? &frequencies_5g_ : nullptr;
+}
+
+const vector<int32_t>* WiphyInfoCache::GetDfsFrequencies(
+    uint32_t wiphy_index) {
+  return Refresh(wiphy_index) ? &frequencies_dfs_ : nullptr;
+}
+
+void WiphyInfoCache::Invalidate() {
+  valid_ = false;
+}
+
+void WiphyInfoCache::SetEnabled(bool enabled) {
+  enabled_ = enabled;
+  if (!enabled_) {
+    Invalidate();
+  }
+}
+
+bool WiphyInfoCache::Refresh(uint32_t wiphy_index) {
+  // A wiphy which is removed and added again gets a new index, so the cache
+  // doesn't outlive it.
+  if (valid_ && wiphy_index == wiphy_index_) {
+    return true;
+  }
+  BandInfo band_info;
+  ScanCapabilities scan_capabilities;
+  WiphyFeatures wiphy_features;
+  if (!netlink_utils_->GetWiphyInfo(wiphy_index,
+                                    &band_info,
+                                    &scan_capabilities,
+                                    &wiphy_features)) {
+    LOG(ERROR) << "Failed to get wiphy info from kernel";
+    valid_ = false;
+    return false;
+  }
+  band_info_ = std::move(band_info);
+  scan_capabilities_ = scan_capabilities;
+  wiphy_features_ = wiphy_features;
+  frequencies_2g_.assign(band_info_.band_2g.begin(), band_info_.band_2g.end());
+  frequencies_5g_.assign(band_info_.band_5g.begin(), band_info_.band_5g.end());
+  frequencies_dfs_.assign(band_info_.band_dfs.begin(),
+                          band_info_.band_dfs.end());
+  wiphy_index_ = wiphy_index;
+  // Without a regulatory domain change subscription nothing would tell when
+  // this goes stale.
+  valid_ = enabled_;
+  return true;
+}
+
+}  // namespace wificond
+}  // namespace android
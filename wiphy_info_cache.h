@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WIFICOND_WIPHY_INFO_CACHE_H_
+#define WIFICOND_WIPHY_INFO_CACHE_H_
+
+#include <vector>
+
+#include <android-base/macros.h>
+
+#include "wificond/net/netlink_utils.h"
+
+namespace android {
+namespace wificond {
+
+// Caches the capabilities of a wiphy, so that they are dumped from kernel
+// once instead of on every interface setup and channel query.
+// Band and feature information only changes with the regulatory domain or
+// the wiphy itself, and the owner is expected to invalidate the cache then.
+// Caching is therefore only enabled while the owner is subscribed to
+// regulatory domain changes. Until then every query dumps from kernel.
+class WiphyInfoCache {
+ public:
+  explicit WiphyInfoCache(NetlinkUtils* netlink_utils);
+  virtual ~WiphyInfoCache() = default;
+
+  // Gets the capabilities of wiphy |wiphy_index|, dumping them from kernel
+  // if they are not cached.
+  // Returns true on success.
+  virtual bool GetWiphyInfo(uint32_t wiphy_index,
+                            BandInfo* out_band_info,
+                            ScanCapabilities* out_scan_capabilities,
+                            WiphyFeatures* out_wiphy_features);
+  // Gets the available frequencies of a band of wiphy |wiphy_index|.
+  // Returns nullptr if the capabilities of the wiphy can't be retrieved.
+  // The returned vector is only valid until the cache is invalidated or,
+  // while caching is disabled, until the next query.
+  virtual const std::vector<int32_t>* Get2gFrequencies(uint32_t wiphy_index);
+  virtual const std::vector<int32_t>* Get5gNonDfsFrequencies(
+      uint32_t wiphy_index);
+  virtual const std::vector<int32_t>* GetDfsFrequencies(uint32_t wiphy_index);
+  // Drops the cached capabilities, so that the next query dumps them again.
+  virtual void Invalidate();
+  // Enables or disables caching. Disabling it also drops the cached
+  // capabilities.
+  virtual void SetEnabled(bool enabled);
+
+ private:
+  // Returns true if the capabilities of wiphy |wiphy_index| are available,
+  // dumping them from kernel if they are not cached.
+  bool Refresh(uint32_t wiphy_index);
+
+  NetlinkUtils* const netlink_utils_;
+  bool enabled_{false};
+  bool valid_{false};
+  uint32_t wiphy_index_{0};
+  BandInfo band_info_;
+  ScanCapabilities scan_capabilities_;
+  WiphyFeatures wiphy_features_;
+  // Frequencies of |band_info_| in the form the binder interface returns.
+  std::vector<int32_t> frequencies_2g_;
+  std::vector<int32_t> frequencies_5g_;
+  std::vector<int32_t> frequencies_dfs_;
+
+  DISALLOW_COPY_AND_ASSIGN(WiphyInfoCache);
+};
+
+}  // namespace wificond
+}  // namespace android
+
+#endif  // WIFICOND_WIPHY_INFO_CACHE_H_